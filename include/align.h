@@ -0,0 +1,81 @@
+/**
+ * @file align.h
+ * @brief Alignment and odd-size transfer grid
+ *
+ * Every other mode moves 1 MB blocks from an aligned buffer at 1 MB file
+ * offsets. Real tools are not that tidy, and some adapters slow down or
+ * corrupt data on unaligned or odd-sized transfers. The grid runs on a
+ * region of test file 1 that the write phase has filled with the normal
+ * pattern. Each case writes F3V_ALIGN_BYTES sequentially with one layout
+ * (transfer size, buffer address offset, file offset), syncs, then reads
+ * the same range back the same way and checks it against the pattern:
+ *
+ * - baseline: 1 MB transfers, buffer on an F3V_ALIGN_BASE boundary, file
+ *   offset 0
+ * - buffer: 1 MB transfers from base + 1 B up to base + 4 KB
+ * - file offset: 1 MB transfers starting 1 B, 512 B and 4 KB into the file
+ * - size: transfers that are not a power of two
+ * - all three off at once
+ *
+ * Only the time spent in read, write and sync calls counts, so pattern
+ * generation and checking do not dilute the differences.
+ */
+
+#ifndef F3VITA_ALIGN_H
+#define F3VITA_ALIGN_H
+
+#include "types.h"
+
+/* Bytes each case writes and reads back */
+#define F3V_ALIGN_BYTES (8ULL * 1024 * 1024)
+
+/* Region of test file 1 prefilled (room for the largest file offset) */
+#define F3V_ALIGN_REGION (F3V_ALIGN_BYTES + F3V_BLOCK_SIZE)
+
+/* Baseline buffer alignment (larger than any offset tried) */
+#define F3V_ALIGN_BASE 8192
+
+/* Bytes transferred per session step */
+#define F3V_ALIGN_STEP_BYTES F3V_BLOCK_SIZE
+
+/**
+ * Set up the grid for a session
+ * Fills in the cases to run (run.align.total). The state is freed by
+ * f3v_align_stop().
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_align_start(TestContext *ctx);
+
+/**
+ * Advance the grid (called from the session step)
+ *
+ * Moves up to F3V_ALIGN_STEP_BYTES of the running case, and stores the
+ * case's throughput in ctx->run.align.result once its read-back is done.
+ *
+ * @param ctx Session context
+ * @return 1 while cases remain, 0 once all are done
+ */
+int f3v_align_step(TestContext *ctx);
+
+/**
+ * Release the grid state (safe to call when not running the grid)
+ * @param ctx Session context
+ */
+void f3v_align_stop(TestContext *ctx);
+
+/**
+ * Format a transfer size ("1 MB", "64 KB" or "4095 B")
+ * @return buf
+ */
+char *f3v_align_size_name(uint32_t size, char *buf, size_t buf_size);
+
+/**
+ * Throughput change against the baseline in percent (negative = slower)
+ * @param kbs Case throughput in KB/s
+ * @param base_kbs Baseline throughput in KB/s
+ * @return Change in percent, 0 without a baseline
+ */
+int f3v_align_change(uint32_t kbs, uint32_t base_kbs);
+
+#endif /* F3VITA_ALIGN_H */
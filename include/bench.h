@@ -0,0 +1,78 @@
+/**
+ * @file bench.h
+ * @brief Random small-block IOPS and latency benchmark
+ *
+ * Games and the LiveArea mostly issue small random reads, which 1 MB
+ * sequential throughput says little about. The benchmark runs on a region
+ * of test file 1 that the write phase has filled with the normal pattern:
+ * for each transfer size (4K, 16K, 64K) and queue depth (1, 2, 4, ... up to
+ * run.bench.depth) it runs random reads and then random writes for
+ * F3V_BENCH_SECONDS. sceIo calls block, so the queue depth is made of that
+ * many threads with their own file handles, each keeping one positional
+ * transfer in flight.
+ *
+ * Writes store the pattern bytes of the range they cover and reads are
+ * checked against the pattern, so the region stays verifiable throughout.
+ * Each thread fills its own latency histogram; they are merged when the
+ * setting ends.
+ */
+
+#ifndef F3VITA_BENCH_H
+#define F3VITA_BENCH_H
+
+#include "types.h"
+
+/* Region of test file 1 that is prefilled and tested (less if space is short) */
+#define F3V_BENCH_REGION (256ULL * 1024 * 1024)
+
+/* Smallest region worth testing */
+#define F3V_BENCH_MIN_REGION (16ULL * 1024 * 1024)
+
+/* Highest selectable queue depth */
+#define F3V_BENCH_MAX_DEPTH 8
+
+/* Run time of each setting */
+#define F3V_BENCH_SECONDS 3
+
+/* How often a session step checks whether the running setting is done */
+#define F3V_BENCH_POLL_US 20000
+
+/**
+ * Set up the benchmark for a session
+ * run.bench.depth must be set; fills in the settings to run (run.bench.total).
+ * The state is freed by f3v_bench_stop().
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_bench_start(TestContext *ctx);
+
+/**
+ * Advance the benchmark (called from the session step)
+ *
+ * Starts the threads of the next setting, or, once the running setting has
+ * had its time, stops them and stores its result in ctx->run.bench.result. In
+ * between it sleeps for F3V_BENCH_POLL_US so the engine worker stays idle.
+ * run.bench.region must be set before the first call.
+ *
+ * @param ctx Session context
+ * @return 1 while settings remain, 0 once all are done
+ */
+int f3v_bench_step(TestContext *ctx);
+
+/**
+ * Stop any running setting and release the benchmark state (safe to call
+ * when not benchmarking)
+ * @param ctx Session context
+ */
+void f3v_bench_stop(TestContext *ctx);
+
+/**
+ * Describe a benchmark setting (e.g., "4K read QD4")
+ * @param result Setting
+ * @param buf Output buffer
+ * @param buf_size Buffer size
+ * @return Pointer to buf
+ */
+char *f3v_bench_name(const BenchResult *result, char *buf, size_t buf_size);
+
+#endif /* F3VITA_BENCH_H */
@@ -0,0 +1,75 @@
+/**
+ * @file conform.h
+ * @brief Speed-class conformance from sustained write windows
+ *
+ * SD speed classes (C10, U3, V30, ...) promise a minimum sustained write
+ * speed, which an average over the whole run cannot show: a card that
+ * averages 40 MB/s can still stall below 30 MB/s every few hundred MB. The
+ * conformance mode writes sequentially and syncs every F3V_CONFORM_WINDOW
+ * bytes; each window's throughput counts only the time spent in its write
+ * and sync calls. Windows below the class speed are merged into runs with
+ * their file offsets.
+ *
+ * Verdict: PASS if no window falls below the class speed, MARGINAL if at
+ * most 1% do (stalls the file system or a controller hiccup may cause),
+ * FAIL otherwise.
+ *
+ * Pure C with no Vita dependencies, so it is unit-tested on the host.
+ */
+
+#ifndef F3VITA_CONFORM_H
+#define F3VITA_CONFORM_H
+
+#include "types.h"
+
+/* Bytes per throughput window (divides F3V_FILE_SIZE, so a window never spans two files) */
+#define F3V_CONFORM_WINDOW (4 * F3V_BLOCK_SIZE)
+
+/* Region written: one window per slot of ConformResult.window_kbs */
+#define F3V_CONFORM_REGION ((uint64_t)F3V_CONFORM_WINDOWS * F3V_CONFORM_WINDOW)
+
+/* Smallest region worth judging */
+#define F3V_CONFORM_MIN_REGION (256ULL * 1024 * 1024)
+
+typedef enum {
+    CONFORM_PASS,
+    CONFORM_MARGINAL,
+    CONFORM_FAIL
+} ConformVerdict;
+
+/**
+ * Start a conformance result
+ * @param result Result to reset
+ * @param class_mbps Class speed in MB/s as the SD specification counts
+ *        them (1 MB = 1,000,000 bytes)
+ */
+void f3v_conform_init(ConformResult *result, uint32_t class_mbps);
+
+/**
+ * Record one window
+ * Windows past F3V_CONFORM_WINDOWS are ignored.
+ * @param result Conformance result
+ * @param offset Offset of the window's first byte in the data written
+ * @param usec Time spent writing and syncing the window
+ */
+void f3v_conform_add(ConformResult *result, uint64_t offset, uint64_t usec);
+
+/**
+ * Compute the slowest and low-percentile window speeds
+ * Sorts window_kbs, so call it once after the last window.
+ * @param result Conformance result
+ */
+void f3v_conform_finish(ConformResult *result);
+
+/**
+ * Judge a finished result against its class
+ * @return CONFORM_FAIL as well if no window was recorded
+ */
+ConformVerdict f3v_conform_verdict(const ConformResult *result);
+
+/**
+ * Verdict name ("PASS", "MARGINAL", "FAIL")
+ */
+const char *f3v_conform_verdict_name(ConformVerdict verdict);
+
+#endif /* F3VITA_CONFORM_H */
@@ -0,0 +1,103 @@
+/**
+ * @file digest.h
+ * @brief 64-bit content hash (XXH64) and tree digests of whole files
+ *
+ * The hash is XXH64: four independent 64-bit lanes per 32-byte stripe,
+ * which the compiler keeps in registers and which runs at memory speed on
+ * the Vita's Cortex-A9 without any SIMD code.
+ *
+ * A file is hashed as a two-level tree so that its blocks can be hashed in
+ * parallel: every F3V_DIGEST_LEAF bytes are one leaf, hashed with its leaf
+ * number as seed, and the file digest is the hash of the leaf digests (as
+ * little-endian 64-bit words) seeded with the file size. Leaves of one
+ * block are independent, so the stripe pool hashes them at the same time
+ * (see f3v_pool_hash()).
+ *
+ * Pure C with no Vita dependencies.
+ */
+
+#ifndef F3VITA_DIGEST_H
+#define F3VITA_DIGEST_H
+
+#include "types.h"
+
+/* Leaf size of a file digest (one pool stripe) */
+#define F3V_DIGEST_LEAF (64 * 1024)
+
+/* Leaves in one block */
+#define F3V_DIGEST_LEAVES (F3V_BLOCK_SIZE / F3V_DIGEST_LEAF)
+
+/* Streaming hash state */
+typedef struct {
+    uint64_t v[4];              /* Lane accumulators */
+    uint64_t seed;
+    uint64_t total;             /* Bytes hashed so far */
+    uint8_t mem[32];            /* Bytes not yet forming a whole stripe */
+    uint32_t mem_len;
+} F3vHash64;
+
+/**
+ * Start a hash
+ * @param hash State to initialize
+ * @param seed Seed
+ */
+void f3v_hash64_init(F3vHash64 *hash, uint64_t seed);
+
+/**
+ * Hash more data
+ * @param hash Hash state
+ * @param data Data
+ * @param len Bytes of data
+ */
+void f3v_hash64_update(F3vHash64 *hash, const void *data, size_t len);
+
+/**
+ * Hash of everything added so far (the state is left unchanged)
+ * @param hash Hash state
+ * @return XXH64 of the data
+ */
+uint64_t f3v_hash64_final(const F3vHash64 *hash);
+
+/**
+ * Hash a buffer in one call
+ * @param data Data
+ * @param len Bytes of data
+ * @param seed Seed
+ * @return XXH64 of the data
+ */
+uint64_t f3v_hash64(const void *data, size_t len, uint64_t seed);
+
+/**
+ * Hash the leaves of one block of a file on the calling thread
+ * @param buf Block data
+ * @param len Bytes in the block (up to F3V_BLOCK_SIZE; short at the end of a file)
+ * @param first_leaf Number of the block's first leaf within the file
+ * @param out Output: one digest per leaf (up to F3V_DIGEST_LEAVES)
+ * @return Number of leaves hashed
+ */
+uint32_t f3v_digest_leaves(const uint8_t *buf, uint32_t len, uint64_t first_leaf, uint64_t *out);
+
+/**
+ * Start a file digest
+ * @param hash State to initialize
+ * @param size File size
+ */
+void f3v_digest_begin(F3vHash64 *hash, uint64_t size);
+
+/**
+ * Add leaf digests to a file digest, in leaf order
+ * @param hash File digest state
+ * @param leaves Leaf digests
+ * @param count Number of leaves
+ */
+void f3v_digest_add(F3vHash64 *hash, const uint64_t *leaves, uint32_t count);
+
+/**
+ * Digest of a whole file held in memory (single-threaded reference)
+ * @param buf File contents
+ * @param size File size
+ * @return File digest
+ */
+uint64_t f3v_digest_buffer(const uint8_t *buf, uint64_t size);
+
+#endif /* F3VITA_DIGEST_H */
@@ -0,0 +1,118 @@
+/**
+ * @file discover.h
+ * @brief Timing-based erase-block and open-segment discovery
+ *
+ * The card's erase block (allocation unit) and the number of segments it
+ * can keep open for writing are not reported by the system, but both show
+ * in write timing, as flashbench does on Linux:
+ *
+ * 1. Boundary scan: small synced writes straddle positions every
+ *    F3V_DISCOVER_GRAIN bytes. Writes across an erase-block boundary touch
+ *    two blocks and cost more, so the expensive positions repeat with the
+ *    erase-block size, offset by where the blocks start within the file.
+ *    Each position keeps its cheapest of F3V_DISCOVER_PASSES timings so
+ *    one-off stalls do not count.
+ * 2. Open segments: writes go round-robin to N erase blocks. Once N exceeds
+ *    what the card keeps open, every write has to close a segment first and
+ *    the median time jumps (the median ignores stalls, unlike the average).
+ *
+ * The algorithm only sees a write callback that returns the time taken, so
+ * the unit tests run it against a simulated card. Pure C with no Vita
+ * dependencies.
+ */
+
+#ifndef F3VITA_DISCOVER_H
+#define F3VITA_DISCOVER_H
+
+#include "types.h"
+
+/* Probe write size (straddles each scanned position by half) */
+#define F3V_DISCOVER_PROBE (16 * 1024)
+
+/* Distance between scanned positions (erase blocks from twice this size are found) */
+#define F3V_DISCOVER_GRAIN (64 * 1024)
+
+/* Window scanned for boundaries (at least two of the largest erase blocks) */
+#define F3V_DISCOVER_SCAN (64ULL * 1024 * 1024)
+#define F3V_DISCOVER_POSITIONS (uint32_t)(F3V_DISCOVER_SCAN / F3V_DISCOVER_GRAIN)
+#define F3V_DISCOVER_PASSES 2
+
+/* Largest erase block considered */
+#define F3V_DISCOVER_MAX_ERASE (16 * 1024 * 1024)
+
+/* Open-segment test: most segments tried, rounds per count (first is warm-up) */
+#define F3V_DISCOVER_MAX_OPEN 16
+#define F3V_DISCOVER_ROUNDS 6
+
+/* Boundary writes must cost this much more than average to count (percent) */
+#define F3V_DISCOVER_MIN_SCORE 120
+
+/* A segment count is over the limit once its median write is this much slower (percent) */
+#define F3V_DISCOVER_OPEN_JUMP 150
+
+/* Largest transfer size recommended */
+#define F3V_DISCOVER_MAX_TRANSFER (4 * 1024 * 1024)
+
+/* Region of the test file discovery writes in */
+#define F3V_DISCOVER_REGION (256ULL * 1024 * 1024)
+
+/* Device access: a test file on the card, or a simulation in the unit tests */
+typedef struct {
+    /**
+     * Write len bytes at a byte offset and wait until they are on the device
+     * @return Microseconds the write took, or negative on error
+     */
+    int64_t (*write_at)(void *handle, uint64_t offset, uint32_t len);
+    void *handle;
+} DiscoverDevice;
+
+/* Discovery stages */
+typedef enum {
+    DISCOVER_SCAN,              /* Boundary scan */
+    DISCOVER_OPEN,              /* Open-segment rounds */
+    DISCOVER_DONE
+} DiscoverStage;
+
+/* Discovery progress and result */
+struct DiscoverState {
+    uint64_t region;            /* Bytes writable from offset 0 */
+    DiscoverStage stage;
+    uint32_t pass;
+    uint32_t pos;
+    uint32_t open_n;            /* Segments in the current open-segment round */
+    uint32_t open_limit;        /* Most segments that fit the region */
+    uint32_t round;
+    uint32_t seg;
+    uint64_t open_base;         /* First erase block used by the open-segment test */
+    uint32_t open_count;
+
+    uint32_t cost[F3V_DISCOVER_POSITIONS];      /* Cheapest write at each position */
+    uint32_t open_usec[F3V_DISCOVER_MAX_OPEN];  /* Median write at 1..N segments */
+
+    /* Timed writes of the current segment count */
+    uint32_t open_sample[F3V_DISCOVER_MAX_OPEN * (F3V_DISCOVER_ROUNDS - 1)];
+
+    uint32_t writes;            /* Probe writes done */
+    uint32_t total_writes;      /* Estimate, refined once the erase block is known */
+
+    DiscoverResult result;
+};
+
+/**
+ * Prepare discovery
+ * @param state State to initialize
+ * @param region Bytes the device callback may write (offset 0 onwards)
+ * @return 0 on success, negative if the region is too small
+ */
+int f3v_discover_init(struct DiscoverState *state, uint64_t region);
+
+/**
+ * Do the next probe write
+ * @param state Discovery state
+ * @param dev Device to probe
+ * @return 1 while more writes follow, 0 once state->result is complete,
+ *         negative on a write error
+ */
+int f3v_discover_step(struct DiscoverState *state, const DiscoverDevice *dev);
+
+#endif /* F3VITA_DISCOVER_H */
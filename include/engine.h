@@ -0,0 +1,49 @@
+/**
+ * @file engine.h
+ * @brief Worker pool that runs test sessions on several devices at once
+ *
+ * Each running session is represented by a single work token. Tokens are
+ * spread over per-worker deques; a worker runs a quantum of blocks for the
+ * session at the top of its own deque and pushes it back at the bottom, so
+ * every session a worker holds advances in turn. An idle worker steals the
+ * longest-waiting token of another worker. A fast card thus keeps a worker
+ * busy while a slow one is stuck in I/O, and no session is ever stepped by
+ * two threads at once.
+ */
+
+#ifndef F3VITA_ENGINE_H
+#define F3VITA_ENGINE_H
+
+#include "types.h"
+
+/* Worker threads (the Vita gives homebrew three usable cores) */
+#define F3V_ENGINE_WORKERS  3
+
+/* Blocks a worker runs for one session before requeueing it */
+#define F3V_ENGINE_QUANTUM  8
+
+/**
+ * Start running sessions on the worker pool
+ * @param sessions Sessions already prepared with f3v_session_start()
+ * @param count Number of sessions
+ * @return 0 on success, negative on error
+ */
+int f3v_engine_start(TestContext *sessions, int count);
+
+/**
+ * Check whether any session still has work
+ * @return 1 while running, 0 once every session is done
+ */
+int f3v_engine_busy(void);
+
+/**
+ * Ask every running session to stop at its next block
+ */
+void f3v_engine_cancel(void);
+
+/**
+ * Wait for the workers to exit and release engine resources
+ */
+void f3v_engine_stop(void);
+
+#endif /* F3VITA_ENGINE_H */
@@ -0,0 +1,61 @@
+/**
+ * @file faillist.h
+ * @brief List of corrupted regions, persisted for targeted re-tests
+ */
+
+#ifndef F3VITA_FAILLIST_H
+#define F3VITA_FAILLIST_H
+
+#include "types.h"
+
+/**
+ * Record a corrupted block
+ *
+ * Consecutive blocks of the same file are merged into one region and blocks
+ * already listed are ignored. Once the list is full further regions are
+ * dropped and fail_truncated is set.
+ *
+ * @param ctx Session context
+ * @param file_idx File index
+ * @param block_idx Block index within the file
+ * @param offset First corrupted byte within the block
+ */
+void f3v_fail_note(TestContext *ctx, uint32_t file_idx, uint32_t block_idx, uint32_t offset);
+
+/**
+ * Save the region list to the test directory
+ * An empty list removes the saved file.
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_fail_save(const TestContext *ctx);
+
+/**
+ * Load the region list saved by an earlier run
+ * @param ctx Session context (test_dir must be set)
+ * @return Number of regions loaded, or negative if none were saved
+ */
+int f3v_fail_load(TestContext *ctx);
+
+/**
+ * Get the blocks a re-test covers for a region (region plus margin)
+ *
+ * The span is clamped to the blocks that exist in the file, based on the
+ * session's bytes_written.
+ *
+ * @param ctx Session context
+ * @param region Region to expand
+ * @param start Output first block
+ * @return Number of blocks in the span
+ */
+uint32_t f3v_fail_span(const TestContext *ctx, const FailRegion *region, uint32_t *start);
+
+/**
+ * Describe a region's re-test outcome
+ * @param region Region after re-testing
+ * @param passes Number of re-test passes run
+ * @return "persistent", "intermittent" or "not reproduced"
+ */
+const char *f3v_fail_class(const FailRegion *region, uint32_t passes);
+
+#endif /* F3VITA_FAILLIST_H */
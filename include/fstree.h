@@ -0,0 +1,162 @@
+/**
+ * @file fstree.h
+ * @brief Small-file and directory workload
+ *
+ * Installing a game creates thousands of small files in nested directories,
+ * which is limited by how fast the card handles file system metadata rather
+ * than by its sequential speed. The workload builds a tree of the given
+ * shape under the test directory and takes it through four stages:
+ *
+ * 1. Create: each directory in level order, then its files. Every file is
+ *    created, written in one call and closed.
+ * 2. Stat: every file's size is checked.
+ * 3. Read: every file is opened, read whole and checked against the test
+ *    pattern.
+ * 4. Delete: deepest directories first, each directory's files and then
+ *    the directory itself.
+ *
+ * File sizes are drawn from the shape's size ranges by a seeded hash of the
+ * file number, so a run can be repeated. File n holds the pattern of block
+ * n / 255 of pattern file 1 + n % 255, which keeps every file distinct.
+ * Every operation is timed into its own latency histogram.
+ *
+ * The workload only sees file system callbacks, so the unit tests run it
+ * against a simulated file system. Pure C with no Vita dependencies.
+ */
+
+#ifndef F3VITA_FSTREE_H
+#define F3VITA_FSTREE_H
+
+#include "types.h"
+#include "stats.h"
+
+/* Largest file (the step buffer must hold one) */
+#define F3V_FSTREE_MAX_FILE F3V_BLOCK_SIZE
+
+/* Most files in a tree */
+#define F3V_FSTREE_MAX_FILES 8192
+
+/* Directory under the test directory that holds the tree */
+#define F3V_FSTREE_ROOT "tree"
+
+/* File system access: the card, or a simulation in the unit tests */
+typedef struct {
+    int (*mkdir)(void *handle, const char *path);
+    int (*rmdir)(void *handle, const char *path);
+
+    /**
+     * Create or truncate a file, write len bytes and close it
+     * @return Bytes written, or negative on error
+     */
+    int (*write_file)(void *handle, const char *path, const uint8_t *buf, uint32_t len);
+
+    /**
+     * Open a file, read up to len bytes and close it
+     * @return Bytes read, or negative on error
+     */
+    int (*read_file)(void *handle, const char *path, uint8_t *buf, uint32_t len);
+
+    /** @return File size, or negative on error */
+    int64_t (*stat)(void *handle, const char *path);
+
+    int (*remove)(void *handle, const char *path);
+
+    /** Clock for the latencies, in microseconds */
+    uint64_t (*now_usec)(void *handle);
+
+    void *handle;
+} FsTreeDevice;
+
+/* Workload stages */
+typedef enum {
+    FSTREE_CREATE,
+    FSTREE_STAT,
+    FSTREE_READ,
+    FSTREE_DELETE,
+    FSTREE_DONE
+} FsTreeStage;
+
+/* Workload progress and result */
+struct FsTreeState {
+    FsTreeShape shape;
+    char root[96];              /* Path of the tree's top directory */
+    uint32_t seed;
+    FsTreeStage stage;
+    uint32_t dir;               /* Directory being worked on */
+    uint32_t pos;               /* Operation within it (see stage_positions() in fstree.c) */
+
+    uint32_t ops;               /* Operations done */
+    uint32_t total_ops;
+    uint64_t written;           /* File bytes written and read back so far */
+    uint64_t verified;
+
+    LatencyHist hist[FS_OP_COUNT];
+    FsTreeResult result;
+};
+
+/**
+ * Number of directories in a tree, root included
+ * @param shape Tree shape
+ * @return Directory count (0 if the tree is too big to count)
+ */
+uint32_t f3v_fstree_dirs(const FsTreeShape *shape);
+
+/**
+ * Size of one file of a tree
+ * @param shape Tree shape
+ * @param seed Run seed
+ * @param file File number (0-based, directories in level order)
+ * @return Size in bytes, within one of the shape's ranges
+ */
+uint32_t f3v_fstree_file_size(const FsTreeShape *shape, uint32_t seed, uint32_t file);
+
+/**
+ * Prepare the workload
+ * @param state State to initialize
+ * @param shape Tree shape (sizes at most F3V_FSTREE_MAX_FILE)
+ * @param root Path of the tree's top directory (created by the first step)
+ * @param seed Run seed for the file sizes
+ * @return 0 on success, negative if the shape is invalid or too big
+ */
+int f3v_fstree_init(struct FsTreeState *state, const FsTreeShape *shape, const char *root,
+                    uint32_t seed);
+
+/**
+ * Do the next file system operation
+ *
+ * Failed operations are counted and the workload goes on, except a root
+ * directory that cannot be created, which ends it.
+ *
+ * @param state Workload state
+ * @param dev File system to work on
+ * @param buf Buffer of at least F3V_FSTREE_MAX_FILE bytes
+ * @return 1 while more operations follow, 0 once state->result is
+ *         complete, negative if the tree cannot be created
+ */
+int f3v_fstree_step(struct FsTreeState *state, const FsTreeDevice *dev, uint8_t *buf);
+
+/**
+ * Delete whatever is left of the tree without timing it (after a cancel)
+ * @param state Workload state
+ * @param dev File system to work on
+ */
+void f3v_fstree_cleanup(struct FsTreeState *state, const FsTreeDevice *dev);
+
+/**
+ * Name of an operation type (e.g., "mkdir")
+ */
+const char *f3v_fstree_op_name(FsOp op);
+
+/**
+ * Name of a stage (e.g., "create")
+ */
+const char *f3v_fstree_stage_name(FsTreeStage stage);
+
+/**
+ * Operations of one type per second of time spent in them
+ * @param stats Operation statistics
+ * @return Operations per second (0 if none were timed)
+ */
+uint32_t f3v_fstree_ops_per_sec(const FsOpStats *stats);
+
+#endif /* F3VITA_FSTREE_H */
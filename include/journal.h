@@ -0,0 +1,115 @@
+/**
+ * @file journal.h
+ * @brief Crash-safe checkpoint journal for interrupted runs
+ *
+ * The journal lives in the test directory as two slots that are written
+ * alternately. Each record carries a sequence number and checksum, so a
+ * power loss during an update leaves the previous slot intact and loading
+ * simply picks the newest valid record.
+ */
+
+#ifndef F3VITA_JOURNAL_H
+#define F3VITA_JOURNAL_H
+
+#include "types.h"
+
+/* Checkpoint cadence (a multiple of it falls on every file boundary) */
+#define F3V_JOURNAL_INTERVAL (256ULL * 1024 * 1024)
+#define F3V_JOURNAL_NAME     "f3vita.journal"
+
+/* On-disk checkpoint record */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t session_nonce;
+    uint32_t seq;
+
+    /* Progress */
+    uint32_t phase;
+    uint32_t files_written;
+    uint64_t bytes_written;
+    uint64_t bytes_verified;
+    uint64_t total_expected;
+    uint64_t verify_index;      /* Next position in the verify order */
+    uint32_t verify_order;
+    uint32_t verify_seed;
+
+    /* Settings the run's checks depend on (a resume keeps them) */
+    uint32_t readback;
+    uint32_t abort_policy;
+    uint32_t abort_param;
+    uint32_t pattern_variant;
+
+    /* Corruption summary */
+    uint64_t bytes_corrupted;
+    uint32_t has_first_error;
+    uint32_t first_error_file;
+    uint32_t first_error_block;
+    uint32_t first_error_offset;
+
+    /* What the read-back stream had checked (see ReadbackTotals) */
+    uint64_t raw_verified;
+    uint64_t raw_corrupted;
+    uint64_t raw_error_written;
+    uint32_t raw_has_error;
+    uint32_t raw_error_file;
+    uint32_t raw_error_block;
+    uint32_t raw_error_offset;
+
+    /* Pattern parameters the files were written with */
+    uint32_t pattern_version;
+    uint32_t block_size;
+    uint32_t file_size;
+
+    uint32_t checksum;          /* FNV-1a of everything above */
+} JournalRecord;
+
+/**
+ * Write a checkpoint of the session's progress
+ * Data written so far must already be synced (see f3v_sync()).
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_journal_save(TestContext *ctx);
+
+/**
+ * Load the newest valid checkpoint from the session's test directory
+ * @param ctx Session context (test_dir must be set)
+ * @param rec Output record
+ * @return 0 if a checkpoint was found, negative otherwise
+ */
+int f3v_journal_load(const TestContext *ctx, JournalRecord *rec);
+
+/**
+ * Cheaply check that the test files still match a checkpoint
+ *
+ * Compares file sizes and re-verifies the last checkpointed block.
+ *
+ * @param ctx Session context
+ * @param rec Checkpoint to check
+ * @param buf Scratch buffer (F3V_BLOCK_SIZE bytes)
+ * @return 0 if consistent, negative otherwise
+ */
+int f3v_journal_check(const TestContext *ctx, const JournalRecord *rec, uint8_t *buf);
+
+/**
+ * Restore session progress from a checkpoint
+ *
+ * The read-back schedule, abort policy and pattern variant are those of the
+ * interrupted run, whatever the menu now says: the data already written and
+ * checked was handled under them. So are the read-back totals; the stream
+ * picks up where it had got to, so data written before the interruption but
+ * not yet read back is still checked (the per-file closing pass relies on it).
+ *
+ * @param ctx Session context (already started with f3v_session_start())
+ * @param rec Checkpoint to resume from
+ */
+void f3v_journal_apply(TestContext *ctx, const JournalRecord *rec);
+
+/**
+ * Delete the journal from the session's test directory
+ * @param ctx Session context
+ */
+void f3v_journal_clear(const TestContext *ctx);
+
+#endif /* F3VITA_JOURNAL_H */
@@ -0,0 +1,83 @@
+/**
+ * @file mixed.h
+ * @brief Random reads under a concurrent sequential write stream
+ *
+ * A game reading its data while a save or download is written sees read
+ * latency that a read-only benchmark never shows: many cards stall reads
+ * while they program or garbage-collect. The mixed workload runs on a
+ * region of test file 1 that the write phase has filled with the normal
+ * pattern, in three stages:
+ *
+ * 1. Read alone: one thread reads F3V_MIXED_READ_SIZE at random offsets in
+ *    the region for F3V_MIXED_SECONDS, checking each read against the
+ *    pattern.
+ * 2. Read + write: the same reader runs next to a second thread writing
+ *    new pattern blocks sequentially to test file 2 (wrapping inside a
+ *    region of the same size). Each thread waits for the other when it gets
+ *    ahead of the selected read/write byte ratio, so the card sees that mix.
+ * 3. Check: the blocks the writer stored are read back and verified, and
+ *    test file 2 is deleted.
+ *
+ * Only read and write calls are timed; each stage keeps its own latency
+ * histograms so the read distribution under writes can be compared with
+ * the read-only one.
+ */
+
+#ifndef F3VITA_MIXED_H
+#define F3VITA_MIXED_H
+
+#include "types.h"
+
+/* Region of test file 1 read from, and of test file 2 written (less if space is short) */
+#define F3V_MIXED_REGION (256ULL * 1024 * 1024)
+
+/* Smallest region worth testing */
+#define F3V_MIXED_MIN_REGION (16ULL * 1024 * 1024)
+
+/* Random read size (divides F3V_BLOCK_SIZE) */
+#define F3V_MIXED_READ_SIZE (64 * 1024)
+
+/* Run time of each timed stage */
+#define F3V_MIXED_SECONDS 10
+
+/* How often a session step checks whether the running stage is done */
+#define F3V_MIXED_POLL_US 20000
+
+/* How long a thread that is ahead of the ratio waits before looking again */
+#define F3V_MIXED_WAIT_US 1000
+
+/**
+ * Set up the mixed workload for a session
+ * run.mixed.read_pct must be set. The state is freed by f3v_mixed_stop().
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_mixed_start(TestContext *ctx);
+
+/**
+ * Advance the mixed workload (called from the session step)
+ *
+ * Starts the threads of the next timed stage, or, once the running stage
+ * has had its time, stops them and stores its latencies in
+ * ctx->run.mixed.result. In between it sleeps for F3V_MIXED_POLL_US so the
+ * engine worker stays idle. The check stage verifies one written block per
+ * call. run.mixed.region must be set before the first call.
+ *
+ * @param ctx Session context
+ * @return 1 while stages remain, 0 once all are done
+ */
+int f3v_mixed_step(TestContext *ctx);
+
+/**
+ * Stop any running stage and release the workload state (safe to call
+ * when not running the mixed workload)
+ * @param ctx Session context
+ */
+void f3v_mixed_stop(TestContext *ctx);
+
+/**
+ * Name of a stage (e.g., "read + write")
+ */
+const char *f3v_mixed_stage_name(MixedStage stage);
+
+#endif /* F3VITA_MIXED_H */
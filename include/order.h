@@ -0,0 +1,58 @@
+/**
+ * @file order.h
+ * @brief Block orders for the verify pass
+ *
+ * Reading back in write order lets controller caches and readahead flatter
+ * the card, and some aliasing faults only show when reads jump around. The
+ * shuffled orders come from a seeded permutation that is computed per index
+ * (a Feistel network with cycle walking), so no index array is allocated.
+ *
+ * Pure C with no Vita dependencies, so it is unit-tested on the host.
+ */
+
+#ifndef F3VITA_ORDER_H
+#define F3VITA_ORDER_H
+
+#include "types.h"
+
+/**
+ * Seeded permutation of [0, count)
+ * @param index Position in the permuted sequence (< count)
+ * @param count Size of the range (> 0)
+ * @param seed Permutation seed
+ * @return The value at that position; each value appears exactly once
+ */
+uint64_t f3v_permute(uint64_t index, uint64_t count, uint32_t seed);
+
+/**
+ * Number of positions an order steps through for a set of blocks
+ *
+ * The file-shuffled order gives every file F3V_BLOCKS_PER_FILE positions, so
+ * a short last file leaves some positions empty.
+ *
+ * @param order Verify order
+ * @param blocks Blocks written
+ * @return Number of positions
+ */
+uint64_t f3v_order_slots(VerifyOrder order, uint64_t blocks);
+
+/**
+ * Map a position in the verify order to a block
+ * @param order Verify order
+ * @param seed Permutation seed (shuffled orders)
+ * @param index Position, below f3v_order_slots()
+ * @param blocks Blocks written
+ * @param block Output block number (file = block / F3V_BLOCKS_PER_FILE + 1)
+ * @return 1 if the position holds a block, 0 if it is empty
+ */
+int f3v_order_block(VerifyOrder order, uint32_t seed, uint64_t index, uint64_t blocks,
+                    uint64_t *block);
+
+/**
+ * Get the display name of a verify order
+ * @param order Verify order
+ * @return Static string
+ */
+const char *f3v_order_name(VerifyOrder order);
+
+#endif /* F3VITA_ORDER_H */
@@ -8,6 +8,9 @@
 
 #include "types.h"
 
+/* Bump when the pattern formula changes (stored in checkpoints) */
+#define F3V_PATTERN_VERSION 1
+
 /**
  * Fill a buffer with the test pattern for a specific block
  *
@@ -20,6 +23,21 @@
  */
 void f3v_fill_pattern(uint8_t *buf, uint32_t file_idx, uint32_t block_idx);
 
+/**
+ * Fill part of a block with the test pattern
+ *
+ * Produces the same bytes as f3v_fill_pattern() for [offset, offset + len),
+ * so a block can be generated in independent slices.
+ *
+ * @param buf Buffer receiving the bytes at [offset, offset + len) of the block
+ * @param file_idx File index (1-based)
+ * @param block_idx Block index within file (0-based)
+ * @param offset Byte offset within the block of buf[0]
+ * @param len Number of bytes to fill (offset + len <= F3V_BLOCK_SIZE)
+ */
+void f3v_fill_pattern_range(uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                            uint32_t offset, uint32_t len);
+
 /**
  * Verify a buffer against the expected pattern
  *
@@ -32,4 +50,141 @@ void f3v_fill_pattern(uint8_t *buf, uint32_t file_idx, uint32_t block_idx);
 uint32_t f3v_verify_pattern(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
                             uint32_t *first_error_offset);
 
+/**
+ * Verify part of a block against the expected pattern
+ *
+ * Used when only a slice of a block is available, e.g. the short tail of
+ * a truncated file or a stripe handed to a worker thread.
+ *
+ * @param buf Buffer holding the bytes at [offset, offset + len) of the block
+ * @param file_idx File index (1-based)
+ * @param block_idx Block index within file (0-based)
+ * @param offset Byte offset within the block of buf[0]
+ * @param len Number of bytes to verify (offset + len <= F3V_BLOCK_SIZE)
+ * @param first_error_offset Output: block offset of first mismatched byte (if any)
+ * @return Number of corrupted bytes (0 = perfect match)
+ */
+uint32_t f3v_verify_pattern_range(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                                  uint32_t offset, uint32_t len, uint32_t *first_error_offset);
+
+/**
+ * Fill a byte range of a test file with the test pattern
+ *
+ * Unlike f3v_fill_pattern_range() the range may start anywhere in the file
+ * and cross block boundaries, for transfers that are not block-aligned.
+ *
+ * @param buf Buffer receiving the bytes at [offset, offset + len) of the file
+ * @param file_idx File index (1-based)
+ * @param offset Byte offset within the file of buf[0]
+ * @param len Number of bytes to fill
+ */
+void f3v_fill_file_range(uint8_t *buf, uint32_t file_idx, uint64_t offset, uint32_t len);
+
+/**
+ * Verify a byte range of a test file against the test pattern
+ * See f3v_fill_file_range().
+ * @return Number of corrupted bytes (0 = perfect match)
+ */
+uint32_t f3v_verify_file_range(const uint8_t *buf, uint32_t file_idx, uint64_t offset,
+                               uint32_t len);
+
+/**
+ * Identify which block's pattern a buffer holds
+ *
+ * Recovers the pattern base from the first four bytes and checks that the
+ * whole block matches it. A block that fails verification but identifies as
+ * another location is the signature of address aliasing (e.g. a fake-
+ * capacity card wrapping writes onto earlier data).
+ *
+ * Locations whose bases are equal produce identical data; the candidate
+ * with the lowest block index in [1, max_files] is returned.
+ *
+ * @param buf Buffer to identify (must be F3V_BLOCK_SIZE bytes)
+ * @param max_files Highest plausible file index
+ * @param file_idx Output: file index of the matching pattern
+ * @param block_idx Output: block index of the matching pattern
+ * @return 1 if buf is an intact pattern block, 0 otherwise
+ */
+int f3v_identify_pattern(const uint8_t *buf, uint32_t max_files, uint32_t *file_idx,
+                         uint32_t *block_idx);
+
+/**
+ * Fill part of a block with a variant of the test pattern
+ *
+ * Variant 0 is the normal pattern. Odd variants invert every bit of the
+ * variant before them, and each pair after the first XORs a new seed into
+ * the pattern base: 0 normal, 1 inverted, 2 shifted seed, 3 shifted seed
+ * inverted, and so on. Consecutive variants therefore flip every bit, and
+ * no two variants agree on a whole block.
+ *
+ * @param buf Buffer receiving the bytes at [offset, offset + len) of the block
+ * @param file_idx File index (1-based)
+ * @param block_idx Block index within file (0-based)
+ * @param variant Pattern variant (0 = normal)
+ * @param offset Byte offset within the block of buf[0]
+ * @param len Number of bytes to fill (offset + len <= F3V_BLOCK_SIZE)
+ */
+void f3v_fill_variant_range(uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                            uint32_t variant, uint32_t offset, uint32_t len);
+
+/**
+ * Verify part of a block against a variant of the test pattern
+ * See f3v_fill_variant_range() and f3v_verify_pattern_range().
+ * @return Number of corrupted bytes (0 = perfect match)
+ */
+uint32_t f3v_verify_variant_range(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                                  uint32_t variant, uint32_t offset, uint32_t len,
+                                  uint32_t *first_error_offset);
+
+/**
+ * Identify which block's pattern a buffer holds, for a pattern variant
+ * See f3v_identify_pattern().
+ * @return 1 if buf is an intact block of that variant, 0 otherwise
+ */
+int f3v_identify_variant(const uint8_t *buf, uint32_t variant, uint32_t max_files,
+                         uint32_t *file_idx, uint32_t *block_idx);
+
+/**
+ * Fill part of a block with pseudo-random noise
+ *
+ * Each 32-bit word is a hash of the seed, the block and the word's offset,
+ * so slices can be generated independently and read-back data checked
+ * without storing it. Unlike the test pattern the data does not compress.
+ *
+ * @param buf Buffer receiving the bytes at [offset, offset + len) of the block
+ * @param seed Noise seed
+ * @param file_idx File index (1-based)
+ * @param block_idx Block index within file (0-based)
+ * @param offset Byte offset within the block of buf[0]
+ * @param len Number of bytes to fill (offset + len <= F3V_BLOCK_SIZE)
+ */
+void f3v_fill_noise_range(uint8_t *buf, uint32_t seed, uint32_t file_idx, uint32_t block_idx,
+                          uint32_t offset, uint32_t len);
+
+/**
+ * Verify part of a block against its noise
+ * See f3v_fill_noise_range() and f3v_verify_pattern_range().
+ * @return Number of corrupted bytes (0 = perfect match)
+ */
+uint32_t f3v_verify_noise_range(const uint8_t *buf, uint32_t seed, uint32_t file_idx,
+                                uint32_t block_idx, uint32_t offset, uint32_t len,
+                                uint32_t *first_error_offset);
+
+/**
+ * Per-byte majority vote over three reads of the same data
+ *
+ * Used to re-check a block that failed verification: a byte takes the
+ * value at least two reads agree on, or the first read's value if all
+ * three differ.
+ *
+ * @param out Output buffer (may be the same buffer as a)
+ * @param a First read
+ * @param b Second read
+ * @param c Third read
+ * @param len Number of bytes
+ * @return Number of bytes on which the reads did not all agree
+ */
+uint32_t f3v_vote_bytes(uint8_t *out, const uint8_t *a, const uint8_t *b, const uint8_t *c,
+                        uint32_t len);
+
 #endif /* F3VITA_PATTERN_H */
\ No newline at end of file
@@ -0,0 +1,95 @@
+/**
+ * @file pool.h
+ * @brief Persistent thread pool for stripe-parallel pattern fill/verify and hashing
+ *
+ * A block is split into cache-sized stripes that the calling thread and the
+ * pool's helper threads work through together. Verify results are merged
+ * in stripe order, so corruption counts and the first error offset are the
+ * same as a single-threaded f3v_verify_pattern() no matter which thread
+ * finished first. Several threads may submit blocks at the same time.
+ * Hash jobs give each stripe one digest leaf (see digest.h).
+ */
+
+#ifndef F3VITA_POOL_H
+#define F3VITA_POOL_H
+
+#include "types.h"
+
+/* Default pool size including the submitting thread */
+#define F3V_POOL_THREADS     3
+#define F3V_POOL_MAX_THREADS 8
+
+/* Stripe size: small enough to stay cache-resident while it is checked */
+#define F3V_STRIPE_SIZE      (64 * 1024)
+#define F3V_POOL_STRIPES     (F3V_BLOCK_SIZE / F3V_STRIPE_SIZE)
+
+/**
+ * Start the pool
+ * @param threads Total threads sharing a block, including the caller
+ *                (1 = no helpers, everything runs inline)
+ * @return 0 on success, negative on error
+ */
+int f3v_pool_init(int threads);
+
+/**
+ * Stop the helper threads (the pool may be re-initialized afterwards)
+ */
+void f3v_pool_shutdown(void);
+
+/**
+ * Get the number of threads sharing each block
+ * @return Helper threads + 1
+ */
+int f3v_pool_threads(void);
+
+/**
+ * Fill a block with the test pattern in parallel
+ * Same result as f3v_fill_pattern().
+ */
+void f3v_pool_fill(uint8_t *buf, uint32_t file_idx, uint32_t block_idx);
+
+/**
+ * Verify a block against the test pattern in parallel
+ * Same result as f3v_verify_pattern().
+ */
+uint32_t f3v_pool_verify(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                         uint32_t *first_error_offset);
+
+/**
+ * Fill a block with a pattern variant in parallel
+ * Same result as f3v_fill_variant_range() over the whole block.
+ */
+void f3v_pool_fill_variant(uint8_t *buf, uint32_t file_idx, uint32_t block_idx, uint32_t variant);
+
+/**
+ * Verify a block against a pattern variant in parallel
+ * Same result as f3v_verify_variant_range() over the whole block.
+ */
+uint32_t f3v_pool_verify_variant(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                                 uint32_t variant, uint32_t *first_error_offset);
+
+/**
+ * Fill a block with noise in parallel
+ * Same result as f3v_fill_noise_range() over the whole block.
+ */
+void f3v_pool_fill_noise(uint8_t *buf, uint32_t seed, uint32_t file_idx, uint32_t block_idx);
+
+/**
+ * Verify a block against its noise in parallel
+ * Same result as f3v_verify_noise_range() over the whole block.
+ */
+uint32_t f3v_pool_verify_noise(const uint8_t *buf, uint32_t seed, uint32_t file_idx,
+                               uint32_t block_idx, uint32_t *first_error_offset);
+
+/**
+ * Hash the digest leaves of a block in parallel
+ * Same result as f3v_digest_leaves().
+ * @param buf Block data
+ * @param len Bytes in the block (up to F3V_BLOCK_SIZE)
+ * @param first_leaf Number of the block's first leaf within its file
+ * @param out Output: one digest per leaf
+ * @return Number of leaves hashed
+ */
+uint32_t f3v_pool_hash(const uint8_t *buf, uint32_t len, uint64_t first_leaf, uint64_t *out);
+
+#endif /* F3VITA_POOL_H */
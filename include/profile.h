@@ -0,0 +1,57 @@
+/**
+ * @file profile.h
+ * @brief Thread scheduling profiles (priority and CPU affinity per role)
+ *
+ * Every thread belongs to a role. The active profile decides the priority
+ * and core mask of each role; threads pick up a profile change the next
+ * time they call f3v_profile_refresh().
+ */
+
+#ifndef F3VITA_PROFILE_H
+#define F3VITA_PROFILE_H
+
+#include "types.h"
+
+/* Named scheduling profiles */
+typedef enum {
+    PROFILE_MAX_THROUGHPUT, /* I/O and compute on every core, ahead of the UI */
+    PROFILE_BALANCED,       /* UI keeps core 0; workers share cores 1-2 */
+    PROFILE_LOW_IMPACT,     /* One core each for I/O and compute, lowest priority */
+    PROFILE_COUNT
+} SchedProfile;
+
+/* Thread roles */
+typedef enum {
+    ROLE_UI,        /* Main loop: drawing, vblank wait, input sampling */
+    ROLE_IO,        /* Engine workers (blocking sceIo calls) */
+    ROLE_COMPUTE,   /* Pattern pool helpers */
+    ROLE_COUNT
+} ThreadRole;
+
+#define F3V_PROFILE_DEFAULT PROFILE_BALANCED
+
+/**
+ * Get a profile's display name
+ */
+const char *f3v_profile_name(SchedProfile profile);
+
+/**
+ * Select the active profile and apply it to the calling (UI) thread
+ * @param profile Profile to activate
+ */
+void f3v_profile_set(SchedProfile profile);
+
+/**
+ * Get the active profile
+ */
+SchedProfile f3v_profile_get(void);
+
+/**
+ * Apply the active profile to the calling thread if it changed
+ * @param role Role of the calling thread
+ * @param applied In/out: profile generation last applied by this thread
+ *                (initialize to -1 to force the first apply)
+ */
+void f3v_profile_refresh(ThreadRole role, int *applied);
+
+#endif /* F3VITA_PROFILE_H */
@@ -0,0 +1,85 @@
+/**
+ * @file readback.h
+ * @brief Pipelined read-after-write checking during the write phase
+ *
+ * A helper thread per session reads back and verifies each group of blocks
+ * once the writer has synced it, so corruption shows up minutes into a run
+ * instead of after the card is full. Its reads overlap with the writer's
+ * next group. The full verify pass still runs afterwards to catch aliasing
+ * that only appears once later data lands.
+ *
+ * With the per-file schedule (READBACK_FILE) each completed file is handed
+ * over instead, so file N is verified while file N+1 is written. Its
+ * results count towards the final result and the closing pass is shortened
+ * (see F3V_CLOSING_FILES).
+ */
+
+#ifndef F3VITA_READBACK_H
+#define F3VITA_READBACK_H
+
+#include "types.h"
+
+/* Blocks the writer syncs and hands over at a time (divides a file) */
+#define F3V_READBACK_GROUP 8
+
+/*
+ * Per-file schedule: the closing verify pass re-reads these earliest files
+ * in full (where wrap-around on fake-capacity cards lands first) and only
+ * the first block of every later file, plus a short last block, which the
+ * stream never checks.
+ */
+#define F3V_CLOSING_FILES 2
+
+/**
+ * Create the lock the read-back totals are published under
+ * Call once at startup, before any session starts.
+ * @return 0 on success, negative on error (read-back is then unavailable)
+ */
+int f3v_readback_init(void);
+
+/**
+ * Release the lock created by f3v_readback_init()
+ */
+void f3v_readback_shutdown(void);
+
+/**
+ * Start the read-back thread for a session
+ *
+ * Checking starts at the session's current bytes_written. A resumed run
+ * starts where its stream had got to (ctx->raw.verified, restored from the
+ * checkpoint), so nothing written before the interruption goes unchecked.
+ *
+ * @param ctx Session context
+ * @return 0 on success, negative on error (the run continues without it)
+ */
+int f3v_readback_start(TestContext *ctx);
+
+/**
+ * Hand everything written so far to the read-back thread
+ * The caller must have synced the data (see f3v_sync()).
+ * @param ctx Session context
+ */
+void f3v_readback_submit(TestContext *ctx);
+
+/**
+ * Stop the read-back thread and release it
+ *
+ * Waits until all submitted data has been checked, unless the session was
+ * cancelled or aborted.
+ *
+ * @param ctx Session context
+ */
+void f3v_readback_stop(TestContext *ctx);
+
+/**
+ * Copy a session's read-back totals
+ *
+ * Safe while the reader runs (the UI and checkpoints use this); once
+ * f3v_readback_stop() has returned, ctx->raw may be read directly.
+ *
+ * @param ctx Session context
+ * @param out Receives a consistent copy of ctx->raw
+ */
+void f3v_readback_totals(const TestContext *ctx, ReadbackTotals *out);
+
+#endif /* F3VITA_READBACK_H */
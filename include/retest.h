@@ -0,0 +1,28 @@
+/**
+ * @file retest.h
+ * @brief Targeted re-test of the regions that failed an earlier verify
+ *
+ * Each saved region, widened by run.retest.margin blocks on both sides, is
+ * rewritten and synced, then read back and verified, once per pass. A
+ * region's failed_passes then tells a persistent failure from an
+ * intermittent one.
+ */
+
+#ifndef F3VITA_RETEST_H
+#define F3VITA_RETEST_H
+
+#include "types.h"
+
+/**
+ * Rewrite the next block of the current region, or read it back
+ * (called from the session step)
+ *
+ * The region list must be loaded and run.retest.passes set.
+ *
+ * @param ctx Session context
+ * @param buf Scratch buffer (F3V_BLOCK_SIZE bytes)
+ * @return 1 while passes remain, 0 once the re-test is done
+ */
+int f3v_retest_step(TestContext *ctx, uint8_t *buf);
+
+#endif /* F3VITA_RETEST_H */
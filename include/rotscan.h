@@ -0,0 +1,249 @@
+/**
+ * @file rotscan.h
+ * @brief Scans of existing files: bit-rot check against a stored digest
+ *        manifest, or a read-only surface scan
+ *
+ * The other modes test free space; this one checks the games and saves
+ * already on the card. It walks a directory tree, hashes every file (see
+ * digest.h) and compares the digests with the manifest the previous scan
+ * left in the test directory:
+ *
+ * - A file whose size and modification time are unchanged must still have
+ *   the manifest's digest. A different one is silent corruption.
+ * - A file that is new, or whose size or time changed, was written since;
+ *   its digest is only recorded.
+ * - A file in the manifest that is not found any more is counted missing.
+ *
+ * The scan then replaces the manifest. It runs in four stages: load the
+ * manifest, walk the tree, hash the files in path order, save.
+ *
+ * Hashing is pipelined: a reader thread reads the files block by block
+ * into a ring of F3V_ROTSCAN_DEPTH buffers while the stepping thread hashes
+ * the blocks already read, spread over the stripe pool (f3v_pool_hash()).
+ * The card and the CPUs work at the same time, and each step hashes one
+ * block.
+ *
+ * The manifest is sorted by path, with each path stored as the length it
+ * shares with the one before plus the rest, and sizes and times as
+ * variable-length integers: about 20 bytes per file plus its name. A
+ * trailing hash detects a damaged manifest, which is then ignored.
+ *
+ * A surface scan (f3v_rotscan_init_surface()) walks and reads the same
+ * way, but only times each read: no digests, no manifest, nothing written.
+ * It reads F3V_SURFACE_READ bytes at a time. A failed read is retried one
+ * block at a time so that only the blocks that fail are reported, and the
+ * file is read on past them. Unreadable bytes and block-sized reads slower
+ * than F3V_SURFACE_SLOW_KBS are merged into regions by file and offset, and
+ * every read's time goes into a latency histogram.
+ *
+ * The scan only sees file system callbacks, so the unit tests run it
+ * against a simulated file system. Pure C with no Vita dependencies.
+ */
+
+#ifndef F3VITA_ROTSCAN_H
+#define F3VITA_ROTSCAN_H
+
+#include "types.h"
+#include "digest.h"
+#include "stats.h"
+
+/* Reads queued ahead of the hashing */
+#define F3V_ROTSCAN_DEPTH 3
+
+/* Most files in one scan (more are counted as skipped) */
+#define F3V_ROTSCAN_MAX_FILES 131072
+
+/* Deepest directory nesting walked below the root */
+#define F3V_ROTSCAN_MAX_DEPTH 16
+
+/* Longest path below the root, terminator included */
+#define F3V_ROTSCAN_PATH 256
+
+/* Directory entries read per step while walking */
+#define F3V_ROTSCAN_WALK_BATCH 64
+
+/* Bytes per read of a surface scan */
+#define F3V_SURFACE_READ (4 * F3V_BLOCK_SIZE)
+
+/* Reads of a block or more slower than this are listed as slow regions */
+#define F3V_SURFACE_SLOW_KBS 2048
+
+/* One directory entry as the file system reports it */
+typedef struct {
+    char name[F3V_ROTSCAN_PATH];
+    int is_dir;
+    uint64_t size;
+    uint64_t mtime;             /* Any encoding; only compared for equality */
+} RotDirEntry;
+
+/* File system access: the card, or a simulation in the unit tests */
+typedef struct {
+    /** @return Directory handle, or negative on error */
+    int (*dir_open)(void *handle, const char *path);
+
+    /**
+     * Read the next entry of a directory ("." and ".." may be included)
+     * @return 1 for an entry, 0 at the end, negative on error
+     */
+    int (*dir_read)(void *handle, int dir, RotDirEntry *entry);
+
+    void (*dir_close)(void *handle, int dir);
+
+    /** @return File handle, or negative on error */
+    int (*open_read)(void *handle, const char *path);
+
+    /**
+     * Read at a byte offset; called from the reader thread
+     * @return Bytes read, or negative on error
+     */
+    int (*read_at)(void *handle, int fd, uint8_t *buf, uint32_t len, uint64_t offset);
+
+    void (*close)(void *handle, int fd);
+
+    /**
+     * Create or truncate a file, write len bytes and close it
+     * @return Bytes written, or negative on error
+     */
+    int (*write_file)(void *handle, const char *path, const uint8_t *buf, uint32_t len);
+
+    int (*rename)(void *handle, const char *from, const char *to);
+    int (*remove)(void *handle, const char *path);
+
+    /** Clock for the hashing time, in microseconds */
+    uint64_t (*now_usec)(void *handle);
+
+    void *handle;
+} RotScanDevice;
+
+/* Scan stages */
+typedef enum {
+    ROTSCAN_LOAD,
+    ROTSCAN_WALK,
+    ROTSCAN_HASH,
+    ROTSCAN_SAVE,
+    ROTSCAN_DONE
+} RotScanStage;
+
+/* What is known about a file before and after hashing it */
+typedef enum {
+    ROT_FILE_NEW,           /* Not in the manifest */
+    ROT_FILE_CHANGED,       /* Size or time differs from the manifest */
+    ROT_FILE_CHECK,         /* Unchanged: the digest must match */
+    ROT_FILE_MATCHED,
+    ROT_FILE_MISMATCHED,
+    ROT_FILE_UNREADABLE
+} RotFileStatus;
+
+/* A file found by the walk, or an entry of the manifest */
+typedef struct {
+    uint32_t path_off;          /* Offset of the path in its arena */
+    const char *path;           /* Set once the arena stops growing */
+    uint64_t size;
+    uint64_t mtime;
+    uint64_t digest;            /* Digest found by this scan */
+    uint64_t expect;            /* Manifest's digest (ROT_FILE_CHECK and after) */
+    RotFileStatus status;
+} RotFile;
+
+/* Reader thread and ring of block buffers (private to rotscan.c) */
+struct RotPipe;
+
+/* Scan progress and result */
+struct RotScanState {
+    char root[128];             /* Directory scanned */
+    char exclude[128];          /* Directory skipped (the test directory) */
+    char manifest[128];         /* Manifest path */
+    int surface;                /* Surface scan: reads timed, no digests */
+    uint32_t read_size;         /* Bytes per read */
+    RotScanStage stage;
+
+    /* Walk: open directories from the root down */
+    int dir[F3V_ROTSCAN_MAX_DEPTH + 1];
+    uint32_t dir_path_len[F3V_ROTSCAN_MAX_DEPTH + 1];
+    uint32_t depth;             /* Directories open */
+    char path[F3V_ROTSCAN_PATH];    /* Path of the innermost one below the root */
+
+    /* Files found, sorted by path once the walk is done */
+    RotFile *files;
+    uint32_t count;
+    uint32_t capacity;
+    char *arena;
+    uint32_t arena_len;
+    uint32_t arena_capacity;
+
+    /* Manifest of the previous scan (released after the walk) */
+    RotFile *old;
+    uint32_t old_count;
+    char *old_arena;
+
+    /* Hashing */
+    struct RotPipe *pipe;
+    uint32_t file;              /* File being hashed */
+    F3vHash64 hash;
+    int file_failed;
+    uint64_t hashed;            /* Bytes hashed (or read) so far */
+    uint64_t hash_start;
+    LatencyHist lat;            /* Read calls */
+
+    /* Last region noted, extended while the next one follows on */
+    uint32_t region_file;
+    RotBadKind region_kind;
+    uint64_t region_end;
+    int region_listed;          /* Index in result.bad, or -1 */
+
+    RotScanResult result;
+};
+
+/**
+ * Prepare a scan
+ * @param state State to initialize
+ * @param root Directory to scan (e.g., "ux0:app")
+ * @param exclude Full path of a directory below root to skip, or ""
+ * @param manifest Path of the manifest to compare with and replace
+ * @return 0 on success, negative on error
+ */
+int f3v_rotscan_init(struct RotScanState *state, const char *root, const char *exclude,
+                     const char *manifest);
+
+/**
+ * Prepare a surface scan
+ * @param state State to initialize
+ * @param root Directory to scan (e.g., "ux0:")
+ * @param exclude Full path of a directory below root to skip, or ""
+ * @return 0 on success, negative on error
+ */
+int f3v_rotscan_init_surface(struct RotScanState *state, const char *root, const char *exclude);
+
+/**
+ * Do the next part of the scan
+ *
+ * Loading and saving the manifest take one step each, walking reads up to
+ * F3V_ROTSCAN_WALK_BATCH directory entries and hashing one read. Files
+ * that cannot be read are counted and the scan goes on.
+ *
+ * @param state Scan state
+ * @param dev File system to scan
+ * @return 1 while more steps follow, 0 once state->result is complete,
+ *         negative if the root cannot be read or the scan runs out of memory
+ */
+int f3v_rotscan_step(struct RotScanState *state, const RotScanDevice *dev);
+
+/**
+ * Stop the reader and release everything the scan holds (at any stage)
+ * A scan stopped before ROTSCAN_DONE leaves the manifest as it was.
+ * @param state Scan state
+ * @param dev File system being scanned
+ */
+void f3v_rotscan_free(struct RotScanState *state, const RotScanDevice *dev);
+
+/**
+ * Name of a stage (e.g., "walk")
+ */
+const char *f3v_rotscan_stage_name(RotScanStage stage);
+
+/**
+ * Name of what is wrong with a listed file or region (e.g., "unreadable")
+ */
+const char *f3v_rotscan_bad_name(RotBadKind kind);
+
+#endif /* F3VITA_ROTSCAN_H */
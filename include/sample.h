@@ -0,0 +1,90 @@
+/**
+ * @file sample.h
+ * @brief Stratified random block selection for sampling mode
+ *
+ * The free space is laid out exactly as a full run would fill it (1 GB test
+ * files of 1 MB blocks) and split into equal zones. Blocks are drawn at
+ * random within zones picked by weighted round-robin, so every zone is
+ * covered evenly; zones where a sample failed or wrote slowly get a larger
+ * weight and therefore extra samples. Blocks are handed out in batches,
+ * written first and then read back, and each block is only sampled once.
+ *
+ * The reported bound treats the samples as one uniform sample. Extra
+ * samples in bad zones only raise the observed bad fraction, so the bound
+ * errs on the pessimistic side.
+ */
+
+#ifndef F3VITA_SAMPLE_H
+#define F3VITA_SAMPLE_H
+
+#include "types.h"
+
+/* Equal-sized zones the free space is split into */
+#define F3V_SAMPLE_ZONES 64
+
+/* Blocks written before they are synced and read back */
+#define F3V_SAMPLE_BATCH 16
+
+/* Free space left untouched for file system metadata */
+#define F3V_SAMPLE_RESERVE (16ULL * 1024 * 1024)
+
+/**
+ * Set up sampling for a session
+ * run.sample.total_blocks must be set; the state is freed by f3v_sample_stop().
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_sample_start(TestContext *ctx);
+
+/**
+ * Get the next block to write or read back
+ *
+ * A new batch is only started while the time budget lasts, the confidence
+ * target has not been reached and unsampled blocks remain.
+ *
+ * @param ctx Session context
+ * @param file_idx Output file index
+ * @param block_idx Output block index within the file
+ * @param reading Output 0 to write the block, 1 to read it back
+ * @return 1 if a block was returned, 0 once sampling is complete
+ */
+int f3v_sample_next(TestContext *ctx, uint32_t *file_idx, uint32_t *block_idx, int *reading);
+
+/**
+ * Record the write of the block last returned by f3v_sample_next()
+ * A failed write counts as a bad sample and the block is not read back.
+ * @param ctx Session context
+ * @param usec Time the write took
+ * @param failed 1 if the write failed
+ * @param extended 1 if the write went past the end of the file; its time
+ *        includes allocating the gap and is left out of the slow-zone check
+ */
+void f3v_sample_wrote(TestContext *ctx, uint32_t usec, int failed, int extended);
+
+/**
+ * Record the check of the block last returned by f3v_sample_next()
+ * @param ctx Session context
+ * @param bad 1 if the block read back corrupted or failed to read
+ */
+void f3v_sample_checked(TestContext *ctx, int bad);
+
+/**
+ * Write the next sampled block, or read it back (called from the session step)
+ *
+ * Blocks are written a batch at a time with positional writes, synced, then
+ * read back and verified.
+ *
+ * @param ctx Session context
+ * @param buf Scratch buffer (F3V_BLOCK_SIZE bytes)
+ * @return 1 while sampling continues, 0 once it is complete or the abort
+ *         policy stopped it (ctx->aborted set)
+ */
+int f3v_sample_step(TestContext *ctx, uint8_t *buf);
+
+/**
+ * Release the sampling state (safe to call when not sampling)
+ * @param ctx Session context
+ */
+void f3v_sample_stop(TestContext *ctx);
+
+#endif /* F3VITA_SAMPLE_H */
@@ -0,0 +1,340 @@
+/**
+ * @file session.h
+ * @brief Per-device test session (write and verify phases)
+ */
+
+#ifndef F3VITA_SESSION_H
+#define F3VITA_SESSION_H
+
+#include "types.h"
+
+/* Window over which ABORT_BAD_RATIO is evaluated */
+#define F3V_ABORT_WINDOW (64ULL * 1024 * 1024)
+
+/*
+ * A block that fails verification is re-read three times, a slice at a
+ * time, and voted per byte (f3v_vote_bytes()). If the vote matches the
+ * pattern the mismatch was transient and is not counted as corruption.
+ */
+#define F3V_VOTE_SLICE (64 * 1024)
+
+/**
+ * Start a test session on a device
+ *
+ * Resets the context, creates the test directory and enters the write phase.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @return 0 on success, negative on error
+ */
+int f3v_session_start(TestContext *ctx, const StorageDevice *device);
+
+/**
+ * Start a verify-only session on files left by an earlier run
+ *
+ * Scans the device's test directory for existing test files and enters the
+ * verify phase directly; nothing is written. When the session finishes, a
+ * timestamped line is appended to the test directory's log so repeated
+ * retention checks can be compared.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @return 0 on success, negative if no test files were found
+ */
+int f3v_session_start_verify(TestContext *ctx, const StorageDevice *device);
+
+/**
+ * Start a re-test of the regions that failed in an earlier verify
+ *
+ * Loads the saved region list and, for each pass, rewrites every region
+ * (widened by the margin) and reads it back. Afterwards each region's
+ * failed_passes tells whether the failure is persistent or intermittent.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param passes Number of rewrite/verify passes
+ * @param margin Extra blocks tested on each side of a region
+ * @return 0 on success, negative if no failed regions were saved
+ */
+int f3v_session_start_retest(TestContext *ctx, const StorageDevice *device, uint32_t passes,
+                             uint32_t margin);
+
+/**
+ * Start a burn-in session
+ *
+ * Runs full write/verify passes back to back. Pass N writes pattern variant
+ * N (normal, inverted, shifted seed, ...; see f3v_fill_variant_range()), so
+ * every bit is flipped between consecutive passes. Each finished pass is
+ * kept in ctx->run.burn with its throughput and the corruption it found, and
+ * logged to the test directory.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param passes Passes to run (0 = until the duration ends)
+ * @param duration_sec No new pass starts after this many seconds (0 = no limit)
+ * @return 0 on success, negative on error
+ */
+int f3v_session_start_burnin(TestContext *ctx, const StorageDevice *device, uint32_t passes,
+                             uint32_t duration_sec);
+
+/**
+ * Start a benchmark session
+ *
+ * The write phase fills up to F3V_BENCH_REGION of test file 1 with the
+ * normal pattern, then random 4K/16K/64K reads and writes run at queue
+ * depths 1, 2, 4, ... up to max_depth (see bench.h). Results go to
+ * ctx->run.bench.result and the test directory log.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param max_depth Highest queue depth (at most F3V_BENCH_MAX_DEPTH)
+ * @return 0 on success, negative on error (including too little free space)
+ */
+int f3v_session_start_bench(TestContext *ctx, const StorageDevice *device, uint32_t max_depth);
+
+/**
+ * Start a mixed workload session
+ *
+ * The write phase fills up to F3V_MIXED_REGION of test file 1 with the
+ * normal pattern. Random reads then run alone and next to a sequential
+ * write stream to test file 2 at the given read/write byte ratio, and the
+ * written blocks are verified (see mixed.h). Latencies go to
+ * ctx->run.mixed.result and the test directory log.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param read_pct Share of the bytes moved that are read (1-99)
+ * @return 0 on success, negative on error (including too little free space)
+ */
+int f3v_session_start_mixed(TestContext *ctx, const StorageDevice *device, uint32_t read_pct);
+
+/**
+ * Start a small-file workload session
+ *
+ * Builds a tree of the given shape under the test directory, then stats,
+ * reads back and deletes every file and directory (see fstree.h). Counts
+ * and latencies go to ctx->run.fstree.result and the test directory log.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param shape Tree shape and file size ranges
+ * @return 0 on success, negative on error (including an invalid shape or
+ *         too little free space)
+ */
+int f3v_session_start_fstree(TestContext *ctx, const StorageDevice *device,
+                             const FsTreeShape *shape);
+
+/**
+ * Start a bit-rot scan session
+ *
+ * Walks a directory of the device, hashes every file and compares the
+ * digests with the manifest the last scan of that directory left in the
+ * test directory, which it then replaces (see rotscan.h). Nothing is
+ * written but the manifest and the log; the test directory itself is not
+ * scanned. Counts and the corrupted files go to ctx->run.scan.result and
+ * the test directory log.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param subdir Directory below the device root (e.g., "app"), or "" for all
+ * @return 0 on success, negative on error
+ */
+int f3v_session_start_rotscan(TestContext *ctx, const StorageDevice *device, const char *subdir);
+
+/**
+ * Start a read-only surface scan session
+ *
+ * Walks a directory of the device like the bit-rot scan and reads every
+ * file through the same read-ahead pipeline in large reads, timing each
+ * one (see rotscan.h). Unreadable and slow regions are recorded by file and
+ * offset; no digests are kept and nothing is written but the log. Counts,
+ * read latency and the regions go to ctx->run.scan.result and the test
+ * directory log.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param subdir Directory below the device root (e.g., "app"), or "" for all
+ * @return 0 on success, negative on error
+ */
+int f3v_session_start_surface(TestContext *ctx, const StorageDevice *device, const char *subdir);
+
+/**
+ * Start a free-space wipe session
+ *
+ * Picks the fastest fill kernel, then runs the normal write phase with the
+ * chosen data until the card is full, tuning the transfer size over the
+ * first blocks, and fills the last partial block (see wipe.h). With verify
+ * set everything but that tail is read back as usual. The test files are
+ * deleted when the session ends, whether finished or cancelled.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param fill What to write
+ * @param verify Read the data back before deleting it
+ * @return 0 on success, negative on error (including no memory for the buffer)
+ */
+int f3v_session_start_wipe(TestContext *ctx, const StorageDevice *device, WipeFill fill,
+                           int verify);
+
+/**
+ * Start a stream sweep session
+ *
+ * Round N writes N test files of F3V_STREAM_BYTES at the same time, one
+ * thread per file, then reads them back the same way (see stream.h). Each
+ * round records the aggregate and the slowest and fastest single-stream
+ * throughput in ctx->run.stream.result.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param max_streams Streams in the last round (at most F3V_STREAM_MAX)
+ * @return 0 on success, negative on error (including too little free space)
+ */
+int f3v_session_start_streams(TestContext *ctx, const StorageDevice *device,
+                              uint32_t max_streams);
+
+/**
+ * Start an erase-block discovery session
+ *
+ * The write phase fills up to F3V_DISCOVER_REGION of test file 1 with the
+ * normal pattern, then timed probe writes rewrite parts of it to find the
+ * erase-block size and phase and the number of open segments (see
+ * discover.h). The result and the transfer size, alignment and stream
+ * count it suggests go to ctx->run.discover.result and the test directory log.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @return 0 on success, negative on error (including too little free space)
+ */
+int f3v_session_start_discover(TestContext *ctx, const StorageDevice *device);
+
+/**
+ * Start a speed-class conformance session
+ *
+ * Writes up to F3V_CONFORM_REGION sequentially, syncing and timing every
+ * F3V_CONFORM_WINDOW (see conform.h), then verifies it like a full test.
+ * The window speeds and the runs below the class go to ctx->run.conform.
+ * Set no rate limit: it would slow the windows down.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param class_mbps Speed class in MB/s (1 MB = 1,000,000 bytes)
+ * @return 0 on success, negative on error (including too little free space)
+ */
+int f3v_session_start_conform(TestContext *ctx, const StorageDevice *device,
+                              uint32_t class_mbps);
+
+/**
+ * Start an alignment grid session
+ *
+ * The write phase fills F3V_ALIGN_REGION of test file 1 with the normal
+ * pattern, then each case writes and reads back part of it with unaligned
+ * buffers, unaligned file offsets or odd transfer sizes (see align.h).
+ * Throughput goes to ctx->run.align.result, to compare with the aligned
+ * baseline in result[0].
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @return 0 on success, negative on error (including too little free space)
+ */
+int f3v_session_start_align(TestContext *ctx, const StorageDevice *device);
+
+/**
+ * Start a sampling session
+ *
+ * Writes and verifies a stratified random sample of blocks spread over the
+ * device's free space (see sample.h) until the time budget runs out, the
+ * bad fraction is proven below the target at 95% confidence, or every block
+ * has been sampled. At least one of budget_sec and target_ppm should be set.
+ *
+ * @param ctx Session context to initialize
+ * @param device Target device
+ * @param budget_sec Time budget in seconds (0 = none)
+ * @param target_ppm Bad-block fraction to prove, in parts per million (0 = none)
+ * @return 0 on success, negative on error
+ */
+int f3v_session_start_sample(TestContext *ctx, const StorageDevice *device, uint32_t budget_sec,
+                             uint32_t target_ppm);
+
+/**
+ * Run one block of work for a session
+ *
+ * Writes or verifies the next 1 MB block depending on the session phase and
+ * advances to the next phase when the current one completes. A session must
+ * only be stepped by one thread at a time.
+ *
+ * @param ctx Session context
+ * @param buf Scratch buffer owned by the caller (F3V_BLOCK_SIZE bytes)
+ * @return 1 if the session has more work, 0 once it is done
+ */
+int f3v_session_step(TestContext *ctx, uint8_t *buf);
+
+/**
+ * Release a started session that will not run
+ *
+ * Frees what its mode set up and closes its file without logging a result
+ * or touching the journal and fail list. Safe on a session that failed to
+ * start or has already finished.
+ *
+ * @param ctx Session context
+ */
+void f3v_session_discard(TestContext *ctx);
+
+/**
+ * Get the outcome of a session
+ * @param ctx Session context
+ * @return PASS/FAIL/CANCELLED
+ */
+TestResult f3v_session_result(const TestContext *ctx);
+
+/*
+ * Bookkeeping shared with the per-mode step functions (f3v_retest_step(),
+ * f3v_sample_step(), ...). These run on the thread stepping the session.
+ */
+
+/**
+ * Close the session's open test file, if any
+ * @param ctx Session context
+ */
+void f3v_session_close_file(TestContext *ctx);
+
+/**
+ * Record the first corrupted location (later ones are ignored)
+ * @param ctx Session context
+ * @param file_idx Test file index
+ * @param block_idx Block within the file
+ * @param offset First corrupted byte within the block
+ */
+void f3v_session_note_first_error(TestContext *ctx, uint32_t file_idx, uint32_t block_idx,
+                                  uint32_t offset);
+
+/**
+ * Record a corrupted location in the first error and the region list
+ * @param ctx Session context
+ * @param file_idx Test file index
+ * @param block_idx Block within the file
+ * @param offset First corrupted byte within the block
+ */
+void f3v_session_note_error(TestContext *ctx, uint32_t file_idx, uint32_t block_idx,
+                            uint32_t offset);
+
+/**
+ * Check whether a corrupted block holds another location's pattern
+ * @param ctx Session context
+ * @param buf Block as read
+ * @param file_idx Test file index the block was read from
+ * @param block_idx Block within the file
+ * @return 1 if the block is aliased (the first one is recorded)
+ */
+int f3v_session_note_alias(TestContext *ctx, const uint8_t *buf, uint32_t file_idx,
+                           uint32_t block_idx);
+
+/**
+ * Apply the abort policy after a verified block
+ * @param ctx Session context
+ * @param corrupted Corrupted bytes in the block
+ * @param aliased Whether the block was aliased
+ * @return 1 if verification should stop with a partial result
+ */
+int f3v_session_check_abort(TestContext *ctx, uint32_t corrupted, int aliased);
+
+#endif /* F3VITA_SESSION_H */
@@ -0,0 +1,80 @@
+/**
+ * @file stats.h
+ * @brief Statistics helpers: confidence bounds and latency percentiles
+ *
+ * Pure C with no Vita dependencies, so it is unit-tested on the host.
+ */
+
+#ifndef F3VITA_STATS_H
+#define F3VITA_STATS_H
+
+#include <stdint.h>
+
+/* Latency histogram: linear sub-buckets per power of two (1/16 = 6.25% steps) */
+#define F3V_HIST_SUB_BITS 4
+#define F3V_HIST_SUB      (1u << F3V_HIST_SUB_BITS)
+#define F3V_HIST_BUCKETS  ((32 - F3V_HIST_SUB_BITS + 1) * F3V_HIST_SUB)
+
+/* One-sided z-scores */
+#define F3V_Z_95 1.6449
+#define F3V_Z_99 2.3263
+
+/**
+ * Upper Wilson score bound on a failure fraction
+ *
+ * Unlike the normal approximation this stays meaningful with zero or very
+ * few failures, which is the usual case for a good card.
+ *
+ * @param bad Failed samples
+ * @param n Total samples
+ * @param z One-sided z-score for the confidence level (e.g. F3V_Z_95)
+ * @return Upper bound on the true failure fraction (1.0 if n == 0)
+ */
+double f3v_wilson_upper(uint64_t bad, uint64_t n, double z);
+
+/**
+ * Samples needed to bound the failure fraction if none of them fail
+ * @param target Failure fraction to prove the card is under (0 < target < 1)
+ * @param z One-sided z-score for the confidence level
+ * @return Smallest n with f3v_wilson_upper(0, n, z) <= target
+ */
+uint64_t f3v_wilson_samples_needed(double target, double z);
+
+/*
+ * Log-linear latency histogram
+ *
+ * Fixed size and lock-free to fill, so every I/O thread keeps its own and
+ * they are merged afterwards. Values below F3V_HIST_SUB microseconds are
+ * exact; larger ones land in buckets at most 1/F3V_HIST_SUB wide.
+ */
+typedef struct {
+    uint32_t count[F3V_HIST_BUCKETS];
+    uint64_t total;             /* Values added */
+    uint64_t sum_usec;
+    uint32_t max_usec;
+} LatencyHist;
+
+/**
+ * Add a latency to a histogram
+ * @param hist Histogram (zero-initialized before first use)
+ * @param usec Latency in microseconds
+ */
+void f3v_hist_add(LatencyHist *hist, uint32_t usec);
+
+/**
+ * Add all values of one histogram to another
+ * @param dst Histogram to add to
+ * @param src Histogram to add
+ */
+void f3v_hist_merge(LatencyHist *dst, const LatencyHist *src);
+
+/**
+ * Latency percentile
+ * @param hist Histogram
+ * @param q Quantile (e.g. 0.99 for p99)
+ * @return Upper edge of the bucket holding the quantile, capped at the
+ *         largest value added (0 if empty)
+ */
+uint32_t f3v_hist_percentile(const LatencyHist *hist, double q);
+
+#endif /* F3VITA_STATS_H */
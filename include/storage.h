@@ -8,6 +8,10 @@
 
 #include "types.h"
 
+/* Bounded retry policy for I/O errors and short transfers */
+#define F3V_IO_RETRIES    3
+#define F3V_IO_BACKOFF_US 2000
+
 /**
  * Enumerate available storage devices
  * @param devices Array to fill with device info
@@ -47,6 +51,30 @@ char *f3v_get_test_filename(TestContext *ctx, uint32_t index, char *buf, size_t
  */
 int f3v_open_write(const char *path);
 
+/**
+ * Reopen a partly written test file to continue writing
+ * @param path Full path to file
+ * @param offset Byte offset to continue from (data before it is kept)
+ * @return File descriptor or negative on error
+ */
+int f3v_open_resume(const char *path, uint64_t offset);
+
+/**
+ * Open a test file for positional reads and writes
+ * Existing data is kept either way.
+ * @param path Full path to file
+ * @param create 1 to create the file if missing, 0 to require it
+ * @return File descriptor or negative on error
+ */
+int f3v_open_rw(const char *path, int create);
+
+/**
+ * Open a file for appending (created if missing)
+ * @param path Full path to file
+ * @return File descriptor or negative on error
+ */
+int f3v_open_append(const char *path);
+
 /**
  * Open test file for reading
  * @param path Full path to file
@@ -72,6 +100,160 @@ int f3v_write_block(int fd, const void *buf, size_t size);
  */
 int f3v_read_block(int fd, void *buf, size_t size);
 
+/**
+ * Write a block at a byte offset (file position unchanged)
+ * @param fd File descriptor
+ * @param buf Buffer to write
+ * @param size Number of bytes to write
+ * @param offset Byte offset in the file
+ * @return Bytes written or negative on error
+ */
+int f3v_write_at(int fd, const void *buf, size_t size, uint64_t offset);
+
+/**
+ * Read a block at a byte offset (file position unchanged)
+ * @param fd File descriptor
+ * @param buf Buffer to read into
+ * @param size Number of bytes to read
+ * @param offset Byte offset in the file
+ * @return Bytes read or negative on error
+ */
+int f3v_read_at(int fd, void *buf, size_t size, uint64_t offset);
+
+/**
+ * Write at a byte offset, retrying errors and short writes
+ *
+ * A short write continues with the remainder straight away; an error or
+ * zero-byte write is retried after a backoff that starts at
+ * F3V_IO_BACKOFF_US and quadruples. At most F3V_IO_RETRIES extra calls are
+ * made, so a clean transfer costs nothing extra.
+ *
+ * @param fd File descriptor
+ * @param buf Buffer to write
+ * @param size Number of bytes to write
+ * @param offset Byte offset in the file
+ * @param retries Incremented for every extra call
+ * @return Bytes written (size unless retries ran out) or negative on error
+ */
+int f3v_write_retry(int fd, const void *buf, size_t size, uint64_t offset, uint32_t *retries);
+
+/**
+ * Read at a byte offset, retrying errors and short reads
+ * Same policy as f3v_write_retry().
+ * @param fd File descriptor
+ * @param buf Buffer to read into
+ * @param size Number of bytes to read
+ * @param offset Byte offset in the file
+ * @param retries Incremented for every extra call
+ * @return Bytes read (size unless retries ran out) or negative on error
+ */
+int f3v_read_retry(int fd, void *buf, size_t size, uint64_t offset, uint32_t *retries);
+
+/**
+ * Move the file position
+ * @param fd File descriptor
+ * @param offset Absolute byte offset
+ * @return 0 on success, negative on error
+ */
+int f3v_seek(int fd, uint64_t offset);
+
+/**
+ * Flush a file's written data to the device
+ * @param fd File descriptor
+ * @return 0 on success, negative on error
+ */
+int f3v_sync(int fd);
+
+/**
+ * Get the size of a file
+ * @param path Full path to file
+ * @return Size in bytes, or negative if the file cannot be stat'ed
+ */
+int64_t f3v_get_file_size(const char *path);
+
+/**
+ * Delete a file
+ * @param path Full path to file
+ * @return 0 on success, negative on error
+ */
+int f3v_remove(const char *path);
+
+/**
+ * Create a directory
+ * @param path Full path to directory
+ * @return 0 on success or if it already exists, negative on error
+ */
+int f3v_mkdir(const char *path);
+
+/**
+ * Delete an empty directory
+ * @param path Full path to directory
+ * @return 0 on success, negative on error
+ */
+int f3v_rmdir(const char *path);
+
+/**
+ * Rename a file
+ * @param from Full path of the file
+ * @param to Full path it gets (must not exist)
+ * @return 0 on success, negative on error
+ */
+int f3v_rename(const char *from, const char *to);
+
+/**
+ * Open a directory for listing
+ * @param path Full path to directory
+ * @return Directory handle, or negative on error
+ */
+int f3v_dir_open(const char *path);
+
+/**
+ * Read the next directory entry
+ * @param dir Directory handle
+ * @param name Output: entry name
+ * @param name_size Size of name
+ * @param is_dir Output: 1 for a directory
+ * @param size Output: file size
+ * @param mtime Output: modification time, packed so that equal times compare equal
+ * @return 1 for an entry, 0 at the end, negative on error
+ */
+int f3v_dir_read(int dir, char *name, size_t name_size, int *is_dir, uint64_t *size,
+                 uint64_t *mtime);
+
+/**
+ * Close a directory handle
+ * @param dir Directory handle
+ */
+void f3v_dir_close(int dir);
+
+/**
+ * Configure a rate limiter
+ * @param throttle Limiter to initialize
+ * @param rate_mbps Target rate in MB/s (0 = disabled)
+ * @param burst_mb Bucket depth in MB
+ */
+void f3v_throttle_init(IoThrottle *throttle, uint32_t rate_mbps, uint32_t burst_mb);
+
+/**
+ * Take tokens for a transfer, sleeping until the bucket allows it
+ * Call through f3v_throttle_io() so the disabled case stays a single test.
+ * The limiter itself is in throttle.h.
+ * @param throttle Enabled limiter
+ * @param bytes Transfer size
+ */
+void f3v_throttle_wait(IoThrottle *throttle, size_t bytes);
+
+/**
+ * Rate-limit a transfer (no-op when the limiter is disabled)
+ */
+static inline void f3v_throttle_io(IoThrottle *throttle, size_t bytes)
+{
+    if (throttle->rate_bps != 0)
+    {
+        f3v_throttle_wait(throttle, bytes);
+    }
+}
+
 /**
  * Close file
  * @param fd File descriptor
@@ -86,6 +268,18 @@ int f3v_close(int fd);
  */
 int f3v_cleanup_files(TestContext *ctx);
 
+/**
+ * Find test files left by an earlier run
+ *
+ * Scans the test directory and sets files_written and bytes_written from
+ * the consecutive files starting at index 1. A short file ends the set and
+ * a trailing partial block is not counted.
+ *
+ * @param ctx Test context (test_dir must be set)
+ * @return Number of files found, or negative on error
+ */
+int f3v_scan_test_files(TestContext *ctx);
+
 /**
  * Check if there's enough space to write (at least 1 block)
  * @param ctx Test context
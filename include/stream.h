@@ -0,0 +1,55 @@
+/**
+ * @file stream.h
+ * @brief Parallel sequential streams to measure controller concurrency
+ *
+ * Some cards keep up with several files being written at once and others
+ * collapse, e.g. when a game installs while another downloads. For each
+ * stream count N from 1 to run.stream.max, N test files of F3V_STREAM_BYTES
+ * are written at the same time, each by its own thread with its own
+ * handle, buffer and offset cursor, and then read back and verified the
+ * same way. Each thread makes and checks its own patterns rather than using
+ * the shared stripe pool, so streams only contend for the card. File k
+ * always holds the pattern of test file k, so each stream keeps its own
+ * pattern indices. The files are deleted before the next stream count
+ * starts.
+ */
+
+#ifndef F3VITA_STREAM_H
+#define F3VITA_STREAM_H
+
+#include "types.h"
+
+/* Bytes written per stream (whole blocks) */
+#define F3V_STREAM_BYTES (32ULL * 1024 * 1024)
+
+/* How often a session step checks whether the streams are done */
+#define F3V_STREAM_POLL_US 20000
+
+/**
+ * Set up the stream sweep for a session
+ * run.stream.max must be set; the state is freed by f3v_stream_stop().
+ * @param ctx Session context
+ * @return 0 on success, negative on error
+ */
+int f3v_stream_start(TestContext *ctx);
+
+/**
+ * Advance the sweep (called from the session step)
+ *
+ * Starts the write or read threads of the next round, or, once they have
+ * all finished, joins them and stores the round's throughput in
+ * ctx->run.stream.result. Sleeps F3V_STREAM_POLL_US while threads run.
+ *
+ * @param ctx Session context
+ * @return 1 while rounds remain, 0 once the sweep is done
+ */
+int f3v_stream_step(TestContext *ctx);
+
+/**
+ * Stop running streams and release the state (safe to call when not
+ * running the sweep)
+ * @param ctx Session context
+ */
+void f3v_stream_stop(TestContext *ctx);
+
+#endif /* F3VITA_STREAM_H */
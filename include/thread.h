@@ -0,0 +1,77 @@
+/**
+ * @file thread.h
+ * @brief Minimal threading primitives (Vita kernel objects or pthreads)
+ *
+ * On the Vita these wrap sceKernel thread, mutex and semaphore objects.
+ * Host builds (unit tests, tools) fall back to pthreads.
+ */
+
+#ifndef F3VITA_THREAD_H
+#define F3VITA_THREAD_H
+
+#include "types.h"
+
+#ifdef __vita__
+#include <psp2/kernel/threadmgr.h>
+
+typedef SceUID F3vThread;
+typedef SceUID F3vMutex;
+typedef SceUID F3vSema;
+#else
+#include <pthread.h>
+
+typedef pthread_t F3vThread;
+typedef pthread_mutex_t F3vMutex;
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;
+} F3vSema;
+#endif
+
+/* Thread entry point */
+typedef int (*F3vThreadFunc)(void *arg);
+
+/**
+ * Create and start a thread
+ * @param thread Output thread handle
+ * @param name Thread name (shown in Vita debug tools)
+ * @param func Entry point
+ * @param arg Argument passed to func
+ * @return 0 on success, negative on error
+ */
+int f3v_thread_create(F3vThread *thread, const char *name, F3vThreadFunc func, void *arg);
+
+/**
+ * Wait for a thread to exit and release it
+ * @param thread Thread handle
+ * @return 0 on success, negative on error
+ */
+int f3v_thread_join(F3vThread *thread);
+
+/**
+ * Sleep the calling thread
+ * @param usec Microseconds to sleep
+ */
+void f3v_thread_sleep_usec(uint32_t usec);
+
+/**
+ * Create a mutex
+ * @return 0 on success, negative on error
+ */
+int f3v_mutex_init(F3vMutex *mutex, const char *name);
+void f3v_mutex_lock(F3vMutex *mutex);
+void f3v_mutex_unlock(F3vMutex *mutex);
+void f3v_mutex_destroy(F3vMutex *mutex);
+
+/**
+ * Create a counting semaphore
+ * @param initial Initial count
+ * @return 0 on success, negative on error
+ */
+int f3v_sema_init(F3vSema *sema, const char *name, int initial);
+void f3v_sema_wait(F3vSema *sema);
+void f3v_sema_signal(F3vSema *sema, int count);
+void f3v_sema_destroy(F3vSema *sema);
+
+#endif /* F3VITA_THREAD_H */
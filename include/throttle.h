@@ -0,0 +1,50 @@
+/**
+ * @file throttle.h
+ * @brief Token-bucket rate limiter and its rate-compliance windows
+ *
+ * Transfers take tokens from a bucket refilled at the target rate and
+ * capped at the burst size; a transfer that leaves the bucket in debt waits
+ * until the debt is paid off.
+ *
+ * Alongside, the bytes asked for are counted in fixed windows of
+ * F3V_THROTTLE_WINDOW_USEC. A window is judged once its full length has
+ * passed, against what the target rate allows in one window. Windows stay
+ * on a fixed grid from the start, so an idle gap does not shift them.
+ * Windows inside a gap of a whole window or more are neither counted nor
+ * missed, and neither is the one the gap ends in, which began idle.
+ *
+ * Time is passed in, so the arithmetic runs on any host; storage.h wraps
+ * it with the Vita clock and sleep. Pure C with no Vita dependencies.
+ */
+
+#ifndef F3VITA_THROTTLE_H
+#define F3VITA_THROTTLE_H
+
+#include "types.h"
+
+/* Length of a rate-compliance window */
+#define F3V_THROTTLE_WINDOW_USEC 1000000
+
+/* A window is missed below this share of the target rate */
+#define F3V_THROTTLE_TARGET_PCT 95
+
+/**
+ * Configure a rate limiter
+ * @param throttle Limiter to initialize
+ * @param rate_mbps Target rate in MB/s (0 = disabled)
+ * @param burst_mb Bucket depth in MB
+ * @param now Current time (usec)
+ */
+void f3v_throttle_setup(IoThrottle *throttle, uint32_t rate_mbps, uint32_t burst_mb,
+                        uint64_t now);
+
+/**
+ * Take tokens for a transfer and count it in the compliance window
+ * @param throttle Enabled limiter
+ * @param bytes Transfer size
+ * @param now Current time (usec)
+ * @return Microseconds to wait before the transfer (0 = none)
+ */
+uint64_t f3v_throttle_take(IoThrottle *throttle, size_t bytes, uint64_t now);
+
+#endif /* F3VITA_THROTTLE_H */
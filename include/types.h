@@ -17,17 +17,68 @@
 #define F3V_TEST_DIR        "data/f3vita"
 #define F3V_FILE_PREFIX     "f3vita_"
 #define F3V_FILE_EXT        ".dat"
+#define F3V_LOG_NAME        "f3vita.log"
+#define F3V_FAIL_NAME       "f3vita.fail"
+#define F3V_WIPE_DIR        "wipe"      /* Wipe files, apart from a kept run's files */
+#define F3V_DIGEST_PREFIX   "digests_"  /* Bit-rot scan manifests: digests_<scope>.f3m */
+#define F3V_DIGEST_EXT      ".f3m"
+#define F3V_MAX_FAIL_REGIONS 32
+#define F3V_BURN_HISTORY    16
+#define F3V_BENCH_RESULTS   24  /* 3 sizes x 4 queue depths x read/write */
+#define F3V_STREAM_MAX      8   /* Most parallel write streams swept */
+#define F3V_ALIGN_RESULTS   14  /* Alignment grid cases (see align.c) */
+#define F3V_CONFORM_WINDOWS 1024 /* Throughput windows of a conformance run */
+#define F3V_CONFORM_DROPS   8   /* Runs of slow windows listed */
+#define F3V_FSTREE_BUCKETS  4   /* Size ranges of a file size distribution */
+#define F3V_WIPE_SIZES      4   /* Transfer sizes tried by a wipe (1, 2, 4, 8 blocks) */
+#define F3V_ROTSCAN_BAD     8   /* Bad files or regions listed by a bit-rot or surface scan */
 
 /* Application states */
 typedef enum {
     STATE_MENU,     /* Storage selection */
-    STATE_WRITE,    /* Writing test files */
-    STATE_VERIFY,   /* Reading and verifying */
+    STATE_RESUME,   /* Offer to resume interrupted runs */
+    STATE_RUN,      /* Sessions running on the engine */
     STATE_RESULTS,  /* Showing summary */
     STATE_CLEANUP,  /* Deleting files */
     STATE_EXIT      /* Clean exit */
 } AppState;
 
+/* What a session does */
+typedef enum {
+    MODE_FULL,          /* Write test files, then verify them */
+    MODE_VERIFY_ONLY,   /* Re-verify files left by an earlier run */
+    MODE_RETEST,        /* Rewrite and re-verify regions that failed before */
+    MODE_SAMPLE,        /* Write and verify a random sample of blocks */
+    MODE_BURNIN,        /* Repeat full passes with changing pattern variants */
+    MODE_BENCH,         /* Random small-block IOPS and latency benchmark */
+    MODE_STREAMS,       /* Write and verify 1..N files at once */
+    MODE_DISCOVER,      /* Infer erase-block size and open segments from timing */
+    MODE_ALIGN,         /* Unaligned and odd-sized transfer grid */
+    MODE_CONFORM,       /* Sustained write windows against a speed class, then verify */
+    MODE_MIXED,         /* Random reads alone, then under a sequential write stream */
+    MODE_FSTREE,        /* Create, stat, read and delete a tree of small files */
+    MODE_WIPE,          /* Overwrite all free space as fast as possible, then delete */
+    MODE_ROTSCAN,       /* Hash existing files and compare with the last scan's digests */
+    MODE_SURFACE,       /* Read every existing file, timing each read; nothing written */
+    MODE_COUNT
+} TestMode;
+
+/* Per-device session phases */
+typedef enum {
+    PHASE_WRITE,    /* Writing test files */
+    PHASE_VERIFY,   /* Reading and verifying */
+    PHASE_RETEST,   /* Rewriting and re-verifying failed regions */
+    PHASE_SAMPLE,   /* Writing and verifying sampled blocks */
+    PHASE_BENCH,    /* Random I/O on the prefilled benchmark region */
+    PHASE_STREAMS,  /* Parallel stream rounds */
+    PHASE_DISCOVER, /* Timed probe writes in the prefilled region */
+    PHASE_ALIGN,    /* Alignment grid cases in the prefilled region */
+    PHASE_MIXED,    /* Random reads with and without a write stream */
+    PHASE_FSTREE,   /* Small-file tree operations */
+    PHASE_ROTSCAN,  /* Walking and reading existing files (bit-rot or surface scan) */
+    PHASE_DONE      /* Finished, cancelled or failed */
+} SessionPhase;
+
 /* Storage device info */
 typedef struct {
     char path[16];          /* "ux0:", "uma0:", etc. */
@@ -37,11 +88,455 @@ typedef struct {
     int writable;           /* 1 if writable, 0 otherwise */
 } StorageDevice;
 
+/* Corrupted region found by verify (consecutive blocks of one file) */
+typedef struct {
+    uint32_t file;
+    uint32_t block;             /* First corrupted block */
+    uint32_t block_count;
+    uint32_t first_offset;      /* First corrupted byte within the first block */
+
+    /* Re-test outcome */
+    uint32_t failed_passes;     /* Passes that found corruption in the region */
+    uint32_t last_failed_pass;  /* 1-based pass that last counted, 0 = none */
+} FailRegion;
+
+/* One completed burn-in pass */
+typedef struct {
+    uint32_t pass;              /* 1-based */
+    uint32_t variant;           /* Pattern variant written */
+    uint64_t bytes_written;
+    uint32_t write_ms;
+    uint32_t verify_ms;
+    uint64_t bytes_corrupted;   /* Found in this pass */
+} BurnPass;
+
+/* One benchmark setting: transfer size, queue depth and direction */
+typedef struct {
+    uint32_t size;              /* Bytes per transfer */
+    uint32_t depth;             /* Transfers in flight (one thread each) */
+    int writing;                /* 0 = random reads, 1 = random writes */
+    uint32_t ops;               /* Transfers completed */
+    uint32_t iops;
+    uint32_t lat_p50_us;
+    uint32_t lat_p99_us;
+    uint32_t lat_p999_us;
+    uint32_t lat_max_us;
+    uint32_t bad;               /* Failed transfers and reads not matching the pattern */
+} BenchResult;
+
+/* One round of the stream sweep: N files written, then verified, at once */
+typedef struct {
+    uint32_t write_kbs;         /* Aggregate over all streams */
+    uint32_t write_min_kbs;     /* Slowest and fastest single stream */
+    uint32_t write_max_kbs;
+    uint32_t read_kbs;
+    uint32_t read_min_kbs;
+    uint32_t read_max_kbs;
+    uint64_t corrupted;
+} StreamResult;
+
+/* One alignment grid case: a transfer layout, written then read back */
+typedef struct {
+    uint32_t size;              /* Bytes per transfer */
+    uint32_t buf_offset;        /* Buffer address past an F3V_ALIGN_BASE boundary */
+    uint32_t file_offset;       /* First transfer's offset in the file */
+    uint32_t write_kbs;
+    uint32_t read_kbs;
+    uint32_t bad;               /* Failed transfers and reads not matching the pattern */
+    uint64_t corrupted;
+} AlignResult;
+
+/* A run of consecutive windows below the class speed */
+typedef struct {
+    uint64_t offset;            /* Offset of the first slow byte in the data written */
+    uint64_t length;
+    uint32_t min_kbs;           /* Slowest window in the run */
+} ConformDrop;
+
+/* Speed-class conformance windows (see conform.h) */
+typedef struct {
+    uint32_t class_mbps;        /* Class speed, 1 MB = 1,000,000 bytes */
+    uint32_t class_kbs;         /* The same in KB/s */
+    uint32_t window_kbs[F3V_CONFORM_WINDOWS];   /* In write order, sorted once finished */
+    uint32_t windows;
+    uint32_t below;             /* Windows slower than the class */
+    uint64_t total_usec;
+    ConformDrop drop[F3V_CONFORM_DROPS];
+    uint32_t drop_count;
+    uint32_t drops_lost;        /* Further runs not listed */
+
+    /* Set by f3v_conform_finish() */
+    uint32_t min_kbs;
+    uint32_t p1_kbs;            /* 1% of windows are slower */
+    uint32_t p5_kbs;
+    uint32_t avg_kbs;
+} ConformResult;
+
+/* Stages of the mixed workload (see mixed.h) */
+typedef enum {
+    MIXED_READ_ALONE,   /* Random reads only */
+    MIXED_READ_WRITE,   /* Random reads next to a sequential writer */
+    MIXED_CHECK,        /* Verifying what the writer stored */
+    MIXED_DONE
+} MixedStage;
+
+/* Latency of one kind of transfer during a mixed workload stage */
+typedef struct {
+    uint32_t ops;               /* Transfers completed */
+    uint32_t iops;
+    uint32_t lat_p50_us;
+    uint32_t lat_p99_us;
+    uint32_t lat_p999_us;
+    uint32_t lat_max_us;
+} MixedLatency;
+
+/* Mixed workload result */
+typedef struct {
+    MixedLatency read_alone;    /* Random reads with nothing else running */
+    MixedLatency read_mixed;    /* The same reads next to the write stream */
+    MixedLatency write;         /* The write stream's 1 MB blocks */
+    uint32_t write_kbs;         /* Write stream throughput over the stage */
+    uint64_t write_bytes;
+    uint32_t bad;               /* Failed transfers and reads not matching the pattern */
+} MixedResult;
+
+/* Share of a small-file tree's files with sizes in one range */
+typedef struct {
+    uint32_t weight;            /* Relative to the other ranges */
+    uint32_t min_size;          /* Bytes, inclusive */
+    uint32_t max_size;
+} FsSizeBucket;
+
+/* Shape of a small-file tree: directories and how big their files are */
+typedef struct {
+    uint32_t fanout;            /* Subdirectories per directory */
+    uint32_t depth;             /* Levels below the root (0 = root only) */
+    uint32_t files_per_dir;
+    FsSizeBucket bucket[F3V_FSTREE_BUCKETS];
+    uint32_t bucket_count;
+} FsTreeShape;
+
+/* File system operations timed by the small-file workload */
+typedef enum {
+    FS_OP_MKDIR,
+    FS_OP_CREATE,       /* Create, write and close a file */
+    FS_OP_STAT,
+    FS_OP_READ,         /* Open, read, close and verify a file */
+    FS_OP_DELETE,
+    FS_OP_RMDIR,
+    FS_OP_COUNT
+} FsOp;
+
+/* Count and latency of one operation type */
+typedef struct {
+    uint32_t count;             /* Done, including failed ones */
+    uint32_t failed;            /* Errors, and stats that found the wrong size */
+    uint64_t usec;              /* Total time spent in them */
+    uint32_t lat_p50_us;
+    uint32_t lat_p99_us;
+    uint32_t lat_max_us;
+} FsOpStats;
+
+/* Small-file workload result */
+typedef struct {
+    uint32_t dirs;
+    uint32_t files;
+    uint64_t bytes;             /* Total size of the files */
+    FsOpStats op[FS_OP_COUNT];
+    uint32_t bad_files;         /* Read back short or not matching the pattern */
+    uint64_t corrupted;         /* Bytes not matching, or lost to failed reads */
+} FsTreeResult;
+
+/* What a wipe writes */
+typedef enum {
+    WIPE_ZEROS,
+    WIPE_RANDOM,        /* Seeded noise that does not compress */
+    WIPE_PATTERN,       /* The normal test pattern */
+    WIPE_FILL_COUNT
+} WipeFill;
+
+/* How a wipe generates its data */
+typedef enum {
+    WIPE_KERNEL_ONCE,   /* Filled once and rewritten unchanged (zeros) */
+    WIPE_KERNEL_INLINE, /* Each block generated by the writing thread */
+    WIPE_KERNEL_POOL,   /* Each block generated in stripes across the pool */
+    WIPE_KERNEL_COUNT
+} WipeKernel;
+
+/* Transfer size tuning during the first part of a wipe */
+typedef struct {
+    uint32_t size;              /* Index of the size being tried, F3V_WIPE_SIZES once done */
+    uint32_t best;              /* Index of the size used after tuning */
+    uint64_t bytes[F3V_WIPE_SIZES];
+    uint64_t usec[F3V_WIPE_SIZES];  /* Time spent in write calls */
+} WipeTuner;
+
+/* What is wrong with a listed file or region */
+typedef enum {
+    ROT_BAD_MISMATCH,           /* Digest differs though size and time do not */
+    ROT_BAD_UNREADABLE,         /* Open or read failed */
+    ROT_BAD_SLOW                /* Read below F3V_SURFACE_SLOW_KBS (surface scan) */
+} RotBadKind;
+
+/* A file or region of one that a scan found bad */
+typedef struct {
+    char path[96];              /* Relative to the scanned directory (tail kept if longer) */
+    RotBadKind kind;
+    uint64_t offset;            /* Region within the file (the whole file for a bit-rot scan) */
+    uint64_t length;
+    uint32_t min_kbs;           /* Slowest read in a slow region */
+} RotBadRegion;
+
+/* Bit-rot or surface scan result */
+typedef struct {
+    char root[64];              /* Directory scanned */
+    uint32_t files;             /* Files found */
+    uint64_t bytes;
+    uint32_t skipped;           /* Past the file limit, too deep or path too long */
+    int manifest;               /* Earlier manifest: 1 = loaded, 0 = none, -1 = damaged */
+    uint32_t matched;           /* Unchanged size and time, same digest */
+    uint32_t mismatched;        /* Unchanged size and time, different digest (bit rot) */
+    uint32_t unreadable;        /* Files where an open or read failed */
+    uint32_t added;             /* Not in the manifest */
+    uint32_t changed;           /* Size or time changed since the manifest: digest replaced */
+    uint32_t missing;           /* In the manifest, not found any more */
+    uint64_t bad_bytes;         /* Mismatched files and unreadable bytes */
+    uint64_t hash_usec;         /* Time from the first block read to the last hashed */
+    int saved;                  /* New manifest written */
+
+    /* Reads */
+    uint32_t read_kbs;          /* Bytes read over hash_usec */
+    uint32_t lat_p50_us;        /* Per read call */
+    uint32_t lat_p99_us;
+    uint32_t lat_max_us;
+    uint32_t error_regions;     /* Runs of unreadable bytes */
+    uint64_t error_bytes;
+    uint32_t slow_regions;      /* Runs of slow reads (surface scan) */
+    uint64_t slow_bytes;
+
+    RotBadRegion bad[F3V_ROTSCAN_BAD];
+    uint32_t bad_count;         /* Entries of bad[] used */
+    uint32_t bad_lost;          /* Further files or regions not listed */
+} RotScanResult;
+
+/* What erase-block discovery found (0 = not detected) */
+typedef struct {
+    uint32_t erase_size;        /* Erase block (allocation unit) in bytes */
+    uint32_t erase_phase;       /* File offset of the first boundary, modulo erase_size */
+    uint32_t erase_score;       /* Boundary write cost vs. average (percent) */
+    uint32_t open_max;          /* Segments written round-robin without slowing down */
+    int open_limited;           /* 0 if no limit was hit up to open_max */
+
+    /* Recommendations for the other modes */
+    uint32_t transfer;          /* Transfer size */
+    uint32_t alignment;         /* File offset transfers should be aligned to */
+    uint32_t streams;           /* Parallel write streams (one segment left for the FS) */
+} DiscoverResult;
+
+/* Token-bucket rate limiter state (rate_bps == 0 = disabled) */
+typedef struct {
+    uint64_t rate_bps;      /* Target rate in bytes per second */
+    uint64_t burst_bytes;   /* Bucket depth */
+    int64_t tokens;         /* Available bytes (negative = in debt) */
+    uint64_t last_refill;   /* Time of last refill (usec) */
+
+    /* Rate compliance, measured over one-second windows (see throttle.h) */
+    uint64_t window_start;
+    uint64_t window_bytes;
+    uint32_t windows;
+    uint32_t windows_missed; /* Device delivered under 95% of the target */
+    int window_partial;     /* Current window began idle: not judged */
+} IoThrottle;
+
+/* When to stop verifying early (triage) */
+typedef enum {
+    ABORT_NEVER,        /* Verify everything */
+    ABORT_FIRST_BAD,    /* First corrupted block */
+    ABORT_BAD_MB,       /* abort_param MB corrupted */
+    ABORT_BAD_RATIO,    /* Over abort_param % bad within one window */
+    ABORT_ALIASING,     /* A block holds another location's data */
+    ABORT_COUNT
+} AbortPolicy;
+
+/* Checking done while the write phase runs */
+typedef enum {
+    READBACK_OFF,       /* Verify only after the card is full */
+    READBACK_BLOCK,     /* Read back each group of blocks right after writing */
+    READBACK_FILE,      /* Verify file N while file N+1 is written */
+    READBACK_COUNT
+} ReadbackMode;
+
+/* What the read-back stream has checked (published under the read-back lock) */
+typedef struct {
+    uint64_t verified;
+    uint64_t corrupted;
+    int has_error;
+    uint32_t error_file;
+    uint32_t error_block;
+    uint32_t error_offset;
+    uint64_t error_written;     /* Bytes written when the first error was caught */
+} ReadbackTotals;
+
+/* Order in which the verify pass reads blocks */
+typedef enum {
+    ORDER_SEQUENTIAL,       /* Write order */
+    ORDER_REVERSE,          /* Last block first */
+    ORDER_FILE_SHUFFLE,     /* Files in seeded random order, blocks in order */
+    ORDER_BLOCK_SHUFFLE,    /* Every block in seeded random order */
+    ORDER_COUNT
+} VerifyOrder;
+
+/* Read-after-write pipeline (private to readback.c) */
+struct ReadbackPipe;
+
+/* Sample selection state (private to sample.c) */
+struct SampleState;
+
+/* Benchmark threads and histograms (private to bench.c) */
+struct BenchState;
+
+/* Stream sweep threads (private to stream.c) */
+struct StreamState;
+
+/* Discovery progress (see discover.h) */
+struct DiscoverState;
+
+/* Alignment grid file and buffer (private to align.c) */
+struct AlignState;
+
+/* Mixed workload threads and histograms (private to mixed.c) */
+struct MixedState;
+
+/* Small-file workload progress (see fstree.h) */
+struct FsTreeState;
+
+/* Bit-rot scan progress (see rotscan.h) */
+struct RotScanState;
+
+/*
+ * Per-mode session state. Each session uses only the member of
+ * TestContext.run that belongs to its mode; the module named in the comment
+ * owns it.
+ */
+
+/* Re-test cursor (retest.c) */
+typedef struct {
+    uint32_t passes;
+    uint32_t margin;            /* Extra blocks around each region */
+    uint32_t pass;              /* Current pass (0-based) */
+    uint32_t region;
+    uint32_t block;             /* Block within the expanded region */
+    int reading;                /* 0 = rewriting the region, 1 = reading back */
+} RetestRun;
+
+/* Sampling mode (sample.c; 0 = no time budget / no confidence target) */
+typedef struct {
+    uint32_t budget_sec;
+    uint32_t target_ppm;        /* Stop once bad blocks are proven below this */
+    struct SampleState *state;
+    int reading;                /* 0 = writing the batch, 1 = reading it back */
+    uint64_t total_blocks;      /* Blocks of free space sampled from */
+    uint64_t count;             /* Blocks written and checked */
+    uint64_t bad;
+    uint64_t extra;             /* Samples taken in zones flagged by errors or slow writes */
+    uint32_t upper_ppm;         /* Upper bound on bad blocks at 95% confidence */
+} SampleRun;
+
+/* Burn-in: repeated passes, each with the next pattern variant (session.c) */
+typedef struct {
+    uint32_t passes;            /* Passes to run (0 = until the duration ends) */
+    uint32_t duration_sec;      /* No new pass starts after this (0 = no limit) */
+    uint32_t pass;              /* Current pass (0-based) */
+    uint64_t pass_start;        /* Start of the current pass (usec) */
+    uint64_t corrupted_start;   /* bytes_corrupted when the pass began */
+    BurnPass history[F3V_BURN_HISTORY]; /* First pass and the most recent ones */
+    uint32_t count;
+} BurnRun;
+
+/* Benchmark: random I/O on a prefilled region of test file 1 (bench.c) */
+typedef struct {
+    uint32_t depth;             /* Highest queue depth (1, 2, 4, ... up to this) */
+    uint64_t region;            /* Bytes prefilled and tested */
+    struct BenchState *state;
+    BenchResult result[F3V_BENCH_RESULTS];
+    uint32_t count;             /* Settings completed */
+    uint32_t total;             /* Settings to run */
+} BenchRun;
+
+/* Stream sweep: round N runs N streams, result[N - 1] (stream.c) */
+typedef struct {
+    uint32_t max;               /* Most streams at once */
+    struct StreamState *state;
+    StreamResult result[F3V_STREAM_MAX];
+    uint32_t count;             /* Rounds completed */
+    int reading;                /* 0 = writing the round's files, 1 = verifying them */
+} StreamRun;
+
+/* Erase-block discovery in the prefilled region of test file 1 (discover.c) */
+typedef struct {
+    struct DiscoverState *state;
+    DiscoverResult result;
+} DiscoverRun;
+
+/* Alignment grid in the prefilled region of test file 1 (align.c) */
+typedef struct {
+    struct AlignState *state;
+    AlignResult result[F3V_ALIGN_RESULTS];
+    uint32_t count;             /* Cases completed */
+    uint32_t total;             /* Cases to run */
+} AlignRun;
+
+/* Mixed workload: reads in the prefilled region of file 1, writes to file 2 (mixed.c) */
+typedef struct {
+    uint32_t read_pct;          /* Share of the bytes moved that are read */
+    uint64_t region;            /* Bytes prefilled and read from */
+    struct MixedState *state;
+    MixedStage stage;
+    MixedResult result;
+} MixedRun;
+
+/* Small-file tree in the test directory (fstree.c) */
+typedef struct {
+    struct FsTreeState *state;
+    FsTreeResult result;
+} FsTreeRun;
+
+/* Wipe: the write phase fills all free space with the chosen data (wipe.c) */
+typedef struct {
+    WipeFill fill;
+    int verify;                 /* Read everything back before deleting it */
+    WipeKernel kernel;          /* Fastest generator for fill */
+    uint32_t kernel_kbs[WIPE_KERNEL_COUNT];     /* Measured speeds (0 = not tried) */
+    WipeTuner tune;
+    uint8_t *mem;               /* Transfer buffer */
+    uint8_t *buf;               /* mem aligned to 64 bytes */
+    uint64_t tail;              /* Bytes written below one block at the end */
+    int deleted;                /* Files deleted when the wipe finished */
+} WipeRun;
+
+/* Bit-rot or surface scan of existing files; manifests live in the test directory (rotscan.c) */
+typedef struct {
+    struct RotScanState *state;
+    RotScanResult result;
+} ScanRun;
+
+/* Speed-class conformance during the write phase (conform.c) */
+typedef struct {
+    ConformResult result;
+    uint64_t usec;              /* Write time of the current window so far */
+} ConformRun;
+
 /* Test context tracking all state */
 typedef struct {
     /* Target storage */
     StorageDevice target;
     char test_dir[64];      /* Full path to test directory */
+
+    /* Session progress (one context per device under test) */
+    TestMode mode;
+    SessionPhase phase;
+    int fd;                 /* Open test file, or -1 */
+    uint32_t fd_file_idx;   /* Index of the open test file (0 = none) */
     
     /* Write phase tracking */
     uint32_t files_written;
@@ -54,18 +549,89 @@ typedef struct {
     uint32_t current_block;
     uint64_t bytes_verified;
     uint64_t bytes_corrupted;
+    VerifyOrder verify_order;
+    uint32_t verify_seed;       /* Permutation seed for the shuffled orders */
+    uint64_t verify_index;      /* Next position in the verify order */
+
+    /* Error classification (transient = cleared on retry or re-read) */
+    uint32_t io_retries;        /* Extra I/O calls after errors or short transfers */
+    uint32_t io_recovered;      /* Transfers completed after retrying */
+    uint32_t io_failed;         /* Transfers that failed every retry */
+    uint32_t vote_transient;    /* Mismatched blocks that read back clean */
+    uint32_t vote_persistent;   /* Mismatched blocks confirmed by the re-read vote */
+    uint64_t vote_unstable;     /* Bytes the re-reads disagreed on */
     
     /* First error location */
     int has_first_error;
     uint32_t first_error_file;
     uint32_t first_error_block;
     uint32_t first_error_offset;
+
+    /* First block found holding another location's data */
+    int has_alias;
+    uint32_t alias_file;
+    uint32_t alias_block;
+    uint32_t alias_src_file;
+    uint32_t alias_src_block;
+
+    /* Early abort policy (results are partial once aborted) */
+    AbortPolicy abort_policy;
+    uint32_t abort_param;
+    int aborted;
+    uint64_t window_bytes;      /* Verified in the current ratio window */
+    uint64_t window_bad;
     
     /* Timing (microseconds since epoch) */
     uint64_t start_time;
     uint64_t phase_start_time;
     uint64_t end_time;
     
+    /* Corrupted regions (persisted for re-test mode) */
+    FailRegion fail[F3V_MAX_FAIL_REGIONS];
+    uint32_t fail_count;
+    int fail_truncated;         /* More regions failed than fit the list */
+
+    /* Pattern variant written and expected (0 = normal; burn-in changes it per pass) */
+    uint32_t pattern_variant;
+
+    /* Settings, state and results of ctx->mode (no other member is valid) */
+    union {
+        RetestRun retest;
+        SampleRun sample;
+        BurnRun burn;
+        BenchRun bench;
+        StreamRun stream;
+        DiscoverRun discover;
+        AlignRun align;
+        MixedRun mixed;
+        FsTreeRun fstree;
+        WipeRun wipe;
+        ScanRun scan;           /* Bit-rot and surface scans */
+        ConformRun conform;
+    } run;
+
+    /* Read-after-write checking during the write phase */
+    ReadbackMode readback;
+    struct ReadbackPipe *raw_pipe;  /* NULL until the first write */
+    ReadbackTotals raw;             /* Read live with f3v_readback_totals() */
+    uint64_t verify_skipped;        /* Bytes the closing pass did not re-read */
+    uint64_t raw_fed;               /* Stream bytes the abort policy has seen */
+    uint64_t raw_fed_bad;           /* Corrupted among them, until added to bytes_corrupted */
+
+    /* Checkpoint journal */
+    uint32_t session_nonce;     /* Identifies this run in the journal */
+    uint32_t journal_seq;       /* Last checkpoint sequence number */
+    uint64_t last_checkpoint;   /* Bytes (written or verified) at last checkpoint */
+    int resumed;                /* 1 if continued from a checkpoint */
+
+    /* Optional I/O rate limit for writes and reads */
+    IoThrottle throttle;
+
+    /* Scheduling profile and UI frame pacing during the run */
+    int profile;
+    uint32_t ui_frame_avg_us;
+    uint32_t ui_frame_max_us;
+
     /* User preferences */
     int cleanup_requested;
     int cancelled;
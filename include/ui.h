@@ -7,6 +7,7 @@
 #define F3VITA_UI_H
 
 #include "types.h"
+#include "journal.h"
 
 /* Button masks */
 #define F3V_BTN_CROSS (1 << 0)  /* X / Confirm */
@@ -16,8 +17,17 @@
 #define F3V_BTN_LEFT (1 << 4)
 #define F3V_BTN_RIGHT (1 << 5)
 #define F3V_BTN_START (1 << 6)
+#define F3V_BTN_SQUARE (1 << 7)
 #define F3V_BTN_ANY (0xFF)
 
+/* Setting row shown under the device list */
+typedef struct {
+    const char *label;
+    const char *value;
+    int hidden;     /* Not used by the selected mode: not drawn */
+    int fixed;      /* Overridden by the selected mode: drawn gray, cannot be changed */
+} MenuOption;
+
 /**
  * Initialize the debug screen
  */
@@ -38,9 +48,13 @@ void f3v_ui_header(const char *title);
  * Draw storage selection menu
  * @param devices Array of storage devices
  * @param count Number of devices
- * @param selected Currently selected index
+ * @param selected Cursor index (devices first, then option rows)
+ * @param marked Per-device flags, 1 = include in the test run
+ * @param options Setting rows (changed with Left/Right; hidden rows are skipped)
+ * @param option_count Number of setting rows
  */
-void f3v_ui_menu(const StorageDevice *devices, int count, int selected);
+void f3v_ui_menu(const StorageDevice *devices, int count, int selected, const int *marked,
+                 const MenuOption *options, int option_count);
 
 /**
  * Draw progress display
@@ -53,6 +67,71 @@ void f3v_ui_menu(const StorageDevice *devices, int count, int selected);
 void f3v_ui_progress(const char *phase, uint64_t current_mb, uint64_t total_mb,
                      uint64_t errors, uint32_t elapsed_secs);
 
+/**
+ * Draw one progress row per session (multi-device runs)
+ * @param sessions Session contexts
+ * @param count Number of sessions
+ */
+void f3v_ui_sessions(const TestContext *sessions, int count);
+
+/**
+ * Draw benchmark progress and the results so far (single-device runs)
+ * @param ctx Session context in PHASE_BENCH
+ */
+void f3v_ui_bench(const TestContext *ctx);
+
+/**
+ * Draw mixed workload progress and the stages so far (single-device runs)
+ * @param ctx Session context in PHASE_MIXED
+ */
+void f3v_ui_mixed(const TestContext *ctx);
+
+/**
+ * Draw small-file workload progress and the operations so far
+ * (single-device runs)
+ * @param ctx Session context in PHASE_FSTREE
+ */
+void f3v_ui_fstree(const TestContext *ctx);
+
+/**
+ * Draw stream sweep progress and the rounds so far (single-device runs)
+ * @param ctx Session context in PHASE_STREAMS
+ */
+void f3v_ui_streams(const TestContext *ctx);
+
+/**
+ * Draw erase-block discovery progress and findings (single-device runs)
+ * @param ctx Session context in PHASE_DISCOVER
+ */
+void f3v_ui_discover(const TestContext *ctx);
+
+/**
+ * Draw alignment grid progress and the cases so far (single-device runs)
+ * @param ctx Session context in PHASE_ALIGN
+ */
+void f3v_ui_align(const TestContext *ctx);
+
+/**
+ * Draw speed-class windows so far below the write progress (single-device
+ * runs)
+ * @param ctx Session context of a conformance run
+ */
+void f3v_ui_conform(const TestContext *ctx);
+
+/**
+ * Draw the wipe's fill kernel and transfer size tuning below the write
+ * progress (single-device runs)
+ * @param ctx Session context of a wipe
+ */
+void f3v_ui_wipe(const TestContext *ctx);
+
+/**
+ * Draw bit-rot scan progress and the files judged so far (single-device
+ * runs)
+ * @param ctx Session context in PHASE_ROTSCAN
+ */
+void f3v_ui_rotscan(const TestContext *ctx);
+
 /**
  * Draw results screen
  * @param ctx Test context with results
@@ -60,6 +139,13 @@ void f3v_ui_progress(const char *phase, uint64_t current_mb, uint64_t total_mb,
  */
 void f3v_ui_results(const TestContext *ctx, TestResult result);
 
+/**
+ * Draw the resume prompt for an interrupted run
+ * @param ctx Session context of the device
+ * @param rec Newest valid checkpoint found on the device
+ */
+void f3v_ui_resume(const TestContext *ctx, const JournalRecord *rec);
+
 /**
  * Draw a confirmation prompt
  * @param message Prompt message
@@ -114,4 +200,31 @@ char *f3v_format_bytes(uint64_t bytes, char *buf, size_t buf_size);
  */
 char *f3v_format_duration(uint32_t seconds, char *buf, size_t buf_size);
 
+/**
+ * Describe a pattern variant (e.g., "inverted", "seed 2 inverted")
+ * @param variant Pattern variant
+ * @param buf Output buffer
+ * @param buf_size Buffer size
+ * @return Pointer to buf
+ */
+char *f3v_format_variant(uint32_t variant, char *buf, size_t buf_size);
+
+/**
+ * Describe an abort policy (e.g., "16 MB bad")
+ * @param policy Abort policy
+ * @param param Policy parameter (MB or percent)
+ * @param buf Output buffer
+ * @param buf_size Buffer size
+ * @return Pointer to buf
+ */
+char *f3v_format_abort(AbortPolicy policy, uint32_t param, char *buf, size_t buf_size);
+
+/**
+ * Format the current local time as YYYY-MM-DD HH:MM:SS
+ * @param buf Output buffer
+ * @param buf_size Buffer size
+ * @return Pointer to buf
+ */
+char *f3v_format_timestamp(char *buf, size_t buf_size);
+
 #endif /* F3VITA_UI_H */
\ No newline at end of file
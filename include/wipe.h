@@ -0,0 +1,127 @@
+/**
+ * @file wipe.h
+ * @brief Free-space wipe: fill kernels and transfer size tuning
+ *
+ * A wipe reuses the write phase to overwrite all free space, so the only
+ * thing that matters is wall-clock time. Two choices are made for it:
+ *
+ * - Fill kernel: zeros are generated once and the same buffer is written
+ *   over and over. Noise and the test pattern change with every block; the
+ *   session times generating a few blocks on the writing thread and across
+ *   the stripe pool, and keeps the faster one.
+ * - Transfer size: the first F3V_WIPE_TUNE_BYTES of the wipe are written at
+ *   each of 1, 2, 4 and 8 blocks per call in turn. The rest uses the size
+ *   whose write calls moved data fastest, preferring the smaller of two
+ *   sizes within F3V_WIPE_TUNE_GAIN_PCT of each other.
+ *
+ * Pure C with no Vita dependencies (the pool falls back to pthreads).
+ */
+
+#ifndef F3VITA_WIPE_H
+#define F3VITA_WIPE_H
+
+#include "types.h"
+
+/* Largest transfer (blocks), and so the size of the wipe buffer */
+#define F3V_WIPE_MAX_BLOCKS (1U << (F3V_WIPE_SIZES - 1))
+
+/* Bytes written at each transfer size while tuning */
+#define F3V_WIPE_TUNE_BYTES (16ULL * 1024 * 1024)
+
+/* A larger transfer must be this much faster to be chosen */
+#define F3V_WIPE_TUNE_GAIN_PCT 3
+
+/* Blocks generated with each kernel when picking one */
+#define F3V_WIPE_CALIBRATE_BLOCKS 4
+
+/* Smallest write used to fill the space left below one block */
+#define F3V_WIPE_TAIL_MIN 512
+
+/**
+ * Start tuning with one block per transfer
+ * @param tuner Tuner to initialize
+ */
+void f3v_wipe_tune_init(WipeTuner *tuner);
+
+/**
+ * Blocks to write in the next transfer
+ * @param tuner Transfer size tuner
+ * @return 1 to F3V_WIPE_MAX_BLOCKS (a power of two)
+ */
+uint32_t f3v_wipe_tune_blocks(const WipeTuner *tuner);
+
+/**
+ * Count a finished transfer; moves to the next size once the current one
+ * has written F3V_WIPE_TUNE_BYTES, and picks the best after the last
+ * @param tuner Transfer size tuner
+ * @param bytes Bytes the write call stored
+ * @param usec Time spent in the write call
+ */
+void f3v_wipe_tune_add(WipeTuner *tuner, uint32_t bytes, uint64_t usec);
+
+/**
+ * Write speed measured at one transfer size
+ * @param tuner Transfer size tuner
+ * @param size Size index (transfers of 1 << size blocks)
+ * @return Speed in KB/s (0 if not measured)
+ */
+uint32_t f3v_wipe_tune_kbs(const WipeTuner *tuner, uint32_t size);
+
+/**
+ * Fill one block with wipe data
+ * @param buf Buffer of F3V_BLOCK_SIZE bytes
+ * @param fill What to write
+ * @param kernel How to generate it (WIPE_KERNEL_ONCE generates it too)
+ * @param seed Noise seed
+ * @param file_idx File index (1-based)
+ * @param block_idx Block index within file (0-based)
+ */
+void f3v_wipe_fill(uint8_t *buf, WipeFill fill, WipeKernel kernel, uint32_t seed,
+                   uint32_t file_idx, uint32_t block_idx);
+
+/**
+ * Verify a block read back from a wipe
+ * Uses the pool for whole blocks when kernel is WIPE_KERNEL_POOL.
+ * @param buf Data read back (len bytes from the start of the block)
+ * @param fill What was written
+ * @param kernel Kernel picked for the wipe
+ * @param seed Noise seed
+ * @param file_idx File index (1-based)
+ * @param block_idx Block index within file (0-based)
+ * @param len Bytes to check
+ * @param first_error_offset Output: block offset of first mismatched byte (if any)
+ * @return Number of corrupted bytes (0 = perfect match)
+ */
+uint32_t f3v_wipe_verify(const uint8_t *buf, WipeFill fill, WipeKernel kernel, uint32_t seed,
+                         uint32_t file_idx, uint32_t block_idx, uint32_t len,
+                         uint32_t *first_error_offset);
+
+/**
+ * Pick the fastest kernel for a fill
+ *
+ * Zeros always use WIPE_KERNEL_ONCE and are written into the whole buffer
+ * here. Other fills time F3V_WIPE_CALIBRATE_BLOCKS blocks with each
+ * per-block kernel; a tie goes to the writing thread, leaving the pool to
+ * other sessions.
+ *
+ * @param fill What the wipe writes
+ * @param buf Wipe buffer of F3V_WIPE_MAX_BLOCKS blocks
+ * @param seed Noise seed
+ * @param now_usec Clock
+ * @param kbs Output: speed of each kernel tried in KB/s (others left alone)
+ * @return Kernel to use
+ */
+WipeKernel f3v_wipe_pick_kernel(WipeFill fill, uint8_t *buf, uint32_t seed,
+                                uint64_t (*now_usec)(void), uint32_t *kbs);
+
+/**
+ * Name of a fill (e.g., "Zeros")
+ */
+const char *f3v_wipe_fill_name(WipeFill fill);
+
+/**
+ * Name of a kernel (e.g., "pool")
+ */
+const char *f3v_wipe_kernel_name(WipeKernel kernel);
+
+#endif /* F3VITA_WIPE_H */
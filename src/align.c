@@ -0,0 +1,241 @@
+/**
+ * @file align.c
+ * @brief Alignment and odd-size transfer grid
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "align.h"
+#include "pattern.h"
+#include "storage.h"
+#include "ui.h"
+
+/* Cases run, baseline first (see align.h) */
+static const struct {
+    uint32_t size;
+    uint32_t buf_offset;
+    uint32_t file_offset;
+} g_align_grid[] = {
+    {F3V_BLOCK_SIZE, 0, 0},
+    {F3V_BLOCK_SIZE, 1, 0},
+    {F3V_BLOCK_SIZE, 4, 0},
+    {F3V_BLOCK_SIZE, 64, 0},
+    {F3V_BLOCK_SIZE, 512, 0},
+    {F3V_BLOCK_SIZE, 4096, 0},
+    {F3V_BLOCK_SIZE, 0, 1},
+    {F3V_BLOCK_SIZE, 0, 512},
+    {F3V_BLOCK_SIZE, 0, 4096},
+    {4095, 0, 0},
+    {65537, 0, 0},
+    {100000, 0, 0},
+    {1000000, 0, 0},
+    {100000, 1, 1},
+};
+#define ALIGN_GRID_COUNT (uint32_t)(sizeof(g_align_grid) / sizeof(g_align_grid[0]))
+
+struct AlignState {
+    int fd;
+    uint8_t *mem;
+    uint8_t *base;          /* mem rounded up to F3V_ALIGN_BASE */
+    int reading;            /* 0 = writing the running case, 1 = reading it back */
+    uint64_t done;          /* Bytes of the running direction moved */
+    uint64_t io_usec;       /* Time spent in I/O calls for it */
+};
+
+/**
+ * Throughput of one direction in KB/s
+ */
+static uint32_t align_kbs(uint64_t usec)
+{
+    return usec > 0 ? (uint32_t)(F3V_ALIGN_BYTES / 1024 * 1000000 / usec) : 0;
+}
+
+/**
+ * Write or read back one transfer of the running case
+ */
+static void align_transfer(TestContext *ctx, struct AlignState *s, AlignResult *result)
+{
+    uint8_t *buf = s->base + result->buf_offset;
+    uint64_t offset = result->file_offset + s->done;
+    uint32_t len = result->size;
+    uint64_t t0;
+    int done;
+
+    if (len > F3V_ALIGN_BYTES - s->done)
+    {
+        len = (uint32_t)(F3V_ALIGN_BYTES - s->done);
+    }
+
+    if (!s->reading)
+    {
+        f3v_fill_file_range(buf, 1, offset, len);
+
+        t0 = f3v_get_time_usec();
+        done = f3v_write_at(s->fd, buf, len, offset);
+        s->io_usec += f3v_get_time_usec() - t0;
+
+        if (done != (int)len)
+        {
+            result->bad++;
+        }
+    }
+    else
+    {
+        t0 = f3v_get_time_usec();
+        done = f3v_read_at(s->fd, buf, len, offset);
+        s->io_usec += f3v_get_time_usec() - t0;
+
+        /* Check outside the timed window */
+        uint32_t corrupted = done == (int)len ? f3v_verify_file_range(buf, 1, offset, len) : len;
+        if (corrupted > 0)
+        {
+            result->bad++;
+            result->corrupted += corrupted;
+            ctx->bytes_corrupted += corrupted;
+        }
+        ctx->bytes_verified += len;
+    }
+
+    s->done += len;
+}
+
+int f3v_align_start(TestContext *ctx)
+{
+    struct AlignState *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+    {
+        return -1;
+    }
+
+    /* Largest transfer at the largest buffer offset */
+    s->mem = malloc(F3V_BLOCK_SIZE + 2 * F3V_ALIGN_BASE);
+    if (s->mem == NULL)
+    {
+        free(s);
+        return -1;
+    }
+    s->base = (uint8_t *)(((uintptr_t)s->mem + F3V_ALIGN_BASE - 1) &
+                          ~(uintptr_t)(F3V_ALIGN_BASE - 1));
+    s->fd = -1;
+
+    ctx->run.align.total = 0;
+    for (uint32_t i = 0; i < ALIGN_GRID_COUNT && i < F3V_ALIGN_RESULTS; i++)
+    {
+        AlignResult *result = &ctx->run.align.result[ctx->run.align.total++];
+        result->size = g_align_grid[i].size;
+        result->buf_offset = g_align_grid[i].buf_offset;
+        result->file_offset = g_align_grid[i].file_offset;
+    }
+
+    ctx->run.align.state = s;
+    return 0;
+}
+
+int f3v_align_step(TestContext *ctx)
+{
+    struct AlignState *s = ctx->run.align.state;
+
+    if (ctx->run.align.count >= ctx->run.align.total)
+    {
+        return 0;
+    }
+    AlignResult *result = &ctx->run.align.result[ctx->run.align.count];
+
+    /* The prefilled file stays open for the whole grid */
+    if (s->fd < 0)
+    {
+        char filename[128];
+
+        f3v_get_test_filename(ctx, 1, filename, sizeof(filename));
+        s->fd = f3v_open_rw(filename, 0);
+        if (s->fd < 0)
+        {
+            /* Nothing to run the grid on */
+            for (uint32_t i = ctx->run.align.count; i < ctx->run.align.total; i++)
+            {
+                ctx->run.align.result[i].bad++;
+            }
+            ctx->run.align.count = ctx->run.align.total;
+            return 0;
+        }
+    }
+
+    for (uint64_t moved = 0; moved < F3V_ALIGN_STEP_BYTES && s->done < F3V_ALIGN_BYTES;
+         moved += result->size)
+    {
+        align_transfer(ctx, s, result);
+    }
+    if (s->done < F3V_ALIGN_BYTES)
+    {
+        return 1;
+    }
+
+    if (!s->reading)
+    {
+        /* The data has to reach the card before the write counts as done */
+        uint64_t t0 = f3v_get_time_usec();
+        if (f3v_sync(s->fd) < 0)
+        {
+            result->bad++;
+        }
+        s->io_usec += f3v_get_time_usec() - t0;
+
+        result->write_kbs = align_kbs(s->io_usec);
+        s->reading = 1;
+    }
+    else
+    {
+        result->read_kbs = align_kbs(s->io_usec);
+        s->reading = 0;
+        ctx->run.align.count++;
+    }
+    s->done = 0;
+    s->io_usec = 0;
+
+    return ctx->run.align.count < ctx->run.align.total;
+}
+
+void f3v_align_stop(TestContext *ctx)
+{
+    struct AlignState *s = ctx->run.align.state;
+
+    if (s == NULL)
+    {
+        return;
+    }
+
+    if (s->fd >= 0)
+    {
+        f3v_close(s->fd);
+    }
+    free(s->mem);
+    free(s);
+    ctx->run.align.state = NULL;
+}
+
+char *f3v_align_size_name(uint32_t size, char *buf, size_t buf_size)
+{
+    if (size % (1024 * 1024) == 0)
+    {
+        snprintf(buf, buf_size, "%u MB", size / (1024 * 1024));
+    }
+    else if (size % 1024 == 0)
+    {
+        snprintf(buf, buf_size, "%u KB", size / 1024);
+    }
+    else
+    {
+        snprintf(buf, buf_size, "%u B", size);
+    }
+    return buf;
+}
+
+int f3v_align_change(uint32_t kbs, uint32_t base_kbs)
+{
+    if (base_kbs == 0)
+    {
+        return 0;
+    }
+    return (int)(((int64_t)kbs - (int64_t)base_kbs) * 100 / (int64_t)base_kbs);
+}
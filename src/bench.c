@@ -0,0 +1,318 @@
+/**
+ * @file bench.c
+ * @brief Random small-block IOPS and latency benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pattern.h"
+#include "profile.h"
+#include "stats.h"
+#include "storage.h"
+#include "thread.h"
+#include "ui.h"
+
+/* Transfer sizes benchmarked (each divides F3V_BLOCK_SIZE) */
+static const uint32_t g_bench_sizes[] = {4 * 1024, 16 * 1024, 64 * 1024};
+#define BENCH_SIZE_COUNT (uint32_t)(sizeof(g_bench_sizes) / sizeof(g_bench_sizes[0]))
+
+/* One queue slot: a thread keeping one transfer in flight */
+typedef struct {
+    struct BenchState *state;
+    F3vThread thread;
+    int fd;
+    uint8_t *buf;
+    uint64_t rng;
+
+    /* Owned by the thread until it is joined */
+    LatencyHist hist;
+    uint32_t ops;
+    uint32_t bad;
+    uint64_t corrupted;     /* Bytes not matching, or lost to failed transfers */
+    uint64_t checked;       /* Bytes read and checked */
+} BenchWorker;
+
+struct BenchState {
+    TestContext *ctx;
+    BenchWorker worker[F3V_BENCH_MAX_DEPTH];
+    uint32_t running;       /* Threads of the current setting (0 = idle) */
+    uint64_t started;       /* Start of the current setting (usec) */
+    volatile int stop;
+};
+
+/**
+ * xorshift64* step
+ */
+static uint64_t next_random(BenchWorker *w)
+{
+    w->rng ^= w->rng >> 12;
+    w->rng ^= w->rng << 25;
+    w->rng ^= w->rng >> 27;
+    return w->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Queue slot thread: random positional transfers until told to stop
+ */
+static int bench_thread(void *arg)
+{
+    BenchWorker *w = (BenchWorker *)arg;
+    struct BenchState *s = w->state;
+    TestContext *ctx = s->ctx;
+    const BenchResult *setting = &ctx->run.bench.result[ctx->run.bench.count];
+    uint32_t size = setting->size;
+    uint64_t slots = ctx->run.bench.region / size;
+    int profile_applied = -1;
+
+    f3v_profile_refresh(ROLE_IO, &profile_applied);
+
+    while (!s->stop && !ctx->cancelled)
+    {
+        uint64_t offset = next_random(w) % slots * size;
+        uint32_t block_idx = (uint32_t)(offset / F3V_BLOCK_SIZE);
+        uint32_t in_block = (uint32_t)(offset % F3V_BLOCK_SIZE);
+        int done;
+
+        if (setting->writing)
+        {
+            f3v_fill_pattern_range(w->buf, 1, block_idx, in_block, size);
+
+            uint64_t t0 = f3v_get_time_usec();
+            done = f3v_write_at(w->fd, w->buf, size, offset);
+            f3v_hist_add(&w->hist, (uint32_t)(f3v_get_time_usec() - t0));
+        }
+        else
+        {
+            uint64_t t0 = f3v_get_time_usec();
+            done = f3v_read_at(w->fd, w->buf, size, offset);
+            f3v_hist_add(&w->hist, (uint32_t)(f3v_get_time_usec() - t0));
+
+            /* Check outside the timed window */
+            if (done == (int)size)
+            {
+                uint32_t corrupted =
+                    f3v_verify_pattern_range(w->buf, 1, block_idx, in_block, size, NULL);
+                if (corrupted > 0)
+                {
+                    w->bad++;
+                    w->corrupted += corrupted;
+                }
+                w->checked += size;
+            }
+        }
+
+        if (done != (int)size)
+        {
+            w->bad++;
+            w->corrupted += size;
+        }
+        w->ops++;
+    }
+
+    return 0;
+}
+
+/**
+ * Stop the running setting's threads and release their handles
+ */
+static void stop_threads(struct BenchState *s)
+{
+    s->stop = 1;
+    for (uint32_t i = 0; i < s->running; i++)
+    {
+        BenchWorker *w = &s->worker[i];
+
+        f3v_thread_join(&w->thread);
+        f3v_close(w->fd);
+        w->fd = -1;
+    }
+}
+
+/**
+ * Start the threads for the next setting
+ * @return 0 on success, negative on error
+ */
+static int start_setting(struct BenchState *s)
+{
+    TestContext *ctx = s->ctx;
+    const BenchResult *setting = &ctx->run.bench.result[ctx->run.bench.count];
+    char filename[128];
+
+    f3v_get_test_filename(ctx, 1, filename, sizeof(filename));
+    s->stop = 0;
+    s->running = 0;
+
+    for (uint32_t i = 0; i < setting->depth; i++)
+    {
+        BenchWorker *w = &s->worker[i];
+
+        w->state = s;
+        w->rng = ((uint64_t)ctx->session_nonce << 32 | (ctx->run.bench.count << 8) | i) ^
+                 0x9E3779B97F4A7C15ULL;
+        w->ops = 0;
+        w->bad = 0;
+        w->corrupted = 0;
+        w->checked = 0;
+        memset(&w->hist, 0, sizeof(w->hist));
+
+        /* Own handle per thread so transfers never share a file position */
+        w->fd = f3v_open_rw(filename, 0);
+        if (w->fd >= 0 && f3v_thread_create(&w->thread, "f3v_bench", bench_thread, w) < 0)
+        {
+            f3v_close(w->fd);
+            w->fd = -1;
+        }
+        if (w->fd < 0)
+        {
+            stop_threads(s);
+            s->running = 0;
+            return -1;
+        }
+        s->running++;
+    }
+
+    s->started = f3v_get_time_usec();
+    return 0;
+}
+
+/**
+ * Stop the running setting and store its result
+ */
+static void end_setting(struct BenchState *s)
+{
+    TestContext *ctx = s->ctx;
+    BenchResult *result = &ctx->run.bench.result[ctx->run.bench.count];
+    LatencyHist *hist = &s->worker[0].hist;
+
+    stop_threads(s);
+    uint64_t elapsed = f3v_get_time_usec() - s->started;
+
+    /* Merge into the first slot's histogram */
+    result->ops = 0;
+    result->bad = 0;
+    for (uint32_t i = 0; i < s->running; i++)
+    {
+        BenchWorker *w = &s->worker[i];
+
+        if (i > 0)
+        {
+            f3v_hist_merge(hist, &w->hist);
+        }
+        result->ops += w->ops;
+        result->bad += w->bad;
+        ctx->bytes_corrupted += w->corrupted;
+        ctx->bytes_verified += w->checked;
+    }
+
+    result->iops = elapsed > 0 ? (uint32_t)((uint64_t)result->ops * 1000000 / elapsed) : 0;
+    result->lat_p50_us = f3v_hist_percentile(hist, 0.50);
+    result->lat_p99_us = f3v_hist_percentile(hist, 0.99);
+    result->lat_p999_us = f3v_hist_percentile(hist, 0.999);
+    result->lat_max_us = hist->max_usec;
+
+    s->running = 0;
+    ctx->run.bench.count++;
+}
+
+int f3v_bench_start(TestContext *ctx)
+{
+    struct BenchState *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+    {
+        return -1;
+    }
+    s->ctx = ctx;
+
+    /* Each slot gets a buffer for the largest transfer */
+    for (uint32_t i = 0; i < F3V_BENCH_MAX_DEPTH; i++)
+    {
+        s->worker[i].fd = -1;
+        s->worker[i].buf = malloc(g_bench_sizes[BENCH_SIZE_COUNT - 1]);
+        if (s->worker[i].buf == NULL)
+        {
+            for (uint32_t j = 0; j < i; j++)
+            {
+                free(s->worker[j].buf);
+            }
+            free(s);
+            return -1;
+        }
+    }
+
+    /* Reads then writes for every size and queue depth */
+    ctx->run.bench.total = 0;
+    for (uint32_t i = 0; i < BENCH_SIZE_COUNT; i++)
+    {
+        for (uint32_t depth = 1; depth <= ctx->run.bench.depth && depth <= F3V_BENCH_MAX_DEPTH;
+             depth *= 2)
+        {
+            for (int writing = 0; writing < 2; writing++)
+            {
+                BenchResult *result = &ctx->run.bench.result[ctx->run.bench.total++];
+                result->size = g_bench_sizes[i];
+                result->depth = depth;
+                result->writing = writing;
+            }
+        }
+    }
+
+    ctx->run.bench.state = s;
+    return 0;
+}
+
+int f3v_bench_step(TestContext *ctx)
+{
+    struct BenchState *s = ctx->run.bench.state;
+
+    if (s->running == 0)
+    {
+        if (ctx->run.bench.count >= ctx->run.bench.total)
+        {
+            return 0;
+        }
+        if (start_setting(s) < 0)
+        {
+            /* Count the setting as failed and move on */
+            ctx->run.bench.result[ctx->run.bench.count].bad++;
+            ctx->run.bench.count++;
+        }
+        return 1;
+    }
+
+    if (f3v_get_time_usec() - s->started < F3V_BENCH_SECONDS * 1000000ULL)
+    {
+        f3v_thread_sleep_usec(F3V_BENCH_POLL_US);
+        return 1;
+    }
+
+    end_setting(s);
+    return ctx->run.bench.count < ctx->run.bench.total;
+}
+
+void f3v_bench_stop(TestContext *ctx)
+{
+    struct BenchState *s = ctx->run.bench.state;
+
+    if (s == NULL)
+    {
+        return;
+    }
+
+    stop_threads(s);
+    for (uint32_t i = 0; i < F3V_BENCH_MAX_DEPTH; i++)
+    {
+        free(s->worker[i].buf);
+    }
+    free(s);
+    ctx->run.bench.state = NULL;
+}
+
+char *f3v_bench_name(const BenchResult *result, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "%uK %s QD%u", result->size / 1024,
+             result->writing ? "write" : "read", result->depth);
+    return buf;
+}
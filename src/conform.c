@@ -0,0 +1,105 @@
+/**
+ * @file conform.c
+ * @brief Speed-class conformance from sustained write windows
+ */
+
+#include <string.h>
+
+#include "conform.h"
+
+void f3v_conform_init(ConformResult *result, uint32_t class_mbps)
+{
+    memset(result, 0, sizeof(*result));
+    result->class_mbps = class_mbps;
+    result->class_kbs = (uint32_t)((uint64_t)class_mbps * 1000000 / 1024);
+}
+
+void f3v_conform_add(ConformResult *result, uint64_t offset, uint64_t usec)
+{
+    if (result->windows >= F3V_CONFORM_WINDOWS)
+    {
+        return;
+    }
+
+    uint32_t kbs = (uint32_t)(usec > 0 ? F3V_CONFORM_WINDOW / 1024 * 1000000ULL / usec
+                                       : UINT32_MAX);
+    result->window_kbs[result->windows++] = kbs;
+    result->total_usec += usec;
+
+    if (kbs >= result->class_kbs)
+    {
+        return;
+    }
+    result->below++;
+
+    /* Extend the last run if it ends right here, else start a new one */
+    ConformDrop *last = result->drop_count > 0 ? &result->drop[result->drop_count - 1] : NULL;
+    if (last != NULL && last->offset + last->length == offset)
+    {
+        last->length += F3V_CONFORM_WINDOW;
+        last->min_kbs = kbs < last->min_kbs ? kbs : last->min_kbs;
+    }
+    else if (result->drop_count < F3V_CONFORM_DROPS)
+    {
+        ConformDrop *drop = &result->drop[result->drop_count++];
+        drop->offset = offset;
+        drop->length = F3V_CONFORM_WINDOW;
+        drop->min_kbs = kbs;
+    }
+    else
+    {
+        result->drops_lost++;
+    }
+}
+
+void f3v_conform_finish(ConformResult *result)
+{
+    uint32_t *kbs = result->window_kbs;
+    uint32_t n = result->windows;
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    /* Insertion sort: at most F3V_CONFORM_WINDOWS values, once per run */
+    for (uint32_t i = 1; i < n; i++)
+    {
+        uint32_t v = kbs[i];
+        uint32_t j = i;
+
+        while (j > 0 && kbs[j - 1] > v)
+        {
+            kbs[j] = kbs[j - 1];
+            j--;
+        }
+        kbs[j] = v;
+    }
+
+    result->min_kbs = kbs[0];
+    result->p1_kbs = kbs[n / 100];
+    result->p5_kbs = kbs[n * 5 / 100];
+    result->avg_kbs = result->total_usec > 0
+                          ? (uint32_t)((uint64_t)n * (F3V_CONFORM_WINDOW / 1024) * 1000000 /
+                                       result->total_usec)
+                          : 0;
+}
+
+ConformVerdict f3v_conform_verdict(const ConformResult *result)
+{
+    if (result->windows == 0)
+    {
+        return CONFORM_FAIL;
+    }
+    if (result->below == 0)
+    {
+        return CONFORM_PASS;
+    }
+    return result->p1_kbs >= result->class_kbs ? CONFORM_MARGINAL : CONFORM_FAIL;
+}
+
+const char *f3v_conform_verdict_name(ConformVerdict verdict)
+{
+    static const char *names[] = {"PASS", "MARGINAL", "FAIL"};
+    return names[verdict];
+}
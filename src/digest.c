@@ -0,0 +1,218 @@
+/**
+ * @file digest.c
+ * @brief 64-bit content hash (XXH64) and tree digests of whole files
+ */
+
+#include <string.h>
+
+#include "digest.h"
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/* Little-endian loads at any alignment (compilers merge the bytes into one load) */
+static uint64_t read64(const uint8_t *p)
+{
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+           (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 |
+           (uint64_t)p[7] << 56;
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t merge64(uint64_t acc, uint64_t v)
+{
+    acc ^= round64(0, v);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+/**
+ * Run whole 32-byte stripes through the four lanes
+ * @return Bytes consumed (a multiple of 32)
+ */
+static size_t stripes(uint64_t *v, const uint8_t *p, size_t len)
+{
+    size_t done = 0;
+    uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+
+    /* The lanes do not depend on each other, so their rounds overlap */
+    for (; done + 32 <= len; done += 32)
+    {
+        v1 = round64(v1, read64(p + done));
+        v2 = round64(v2, read64(p + done + 8));
+        v3 = round64(v3, read64(p + done + 16));
+        v4 = round64(v4, read64(p + done + 24));
+    }
+
+    v[0] = v1;
+    v[1] = v2;
+    v[2] = v3;
+    v[3] = v4;
+    return done;
+}
+
+void f3v_hash64_init(F3vHash64 *hash, uint64_t seed)
+{
+    memset(hash, 0, sizeof(*hash));
+    hash->seed = seed;
+    hash->v[0] = seed + PRIME64_1 + PRIME64_2;
+    hash->v[1] = seed + PRIME64_2;
+    hash->v[2] = seed;
+    hash->v[3] = seed - PRIME64_1;
+}
+
+void f3v_hash64_update(F3vHash64 *hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    hash->total += len;
+
+    /* Top up a partial stripe first */
+    if (hash->mem_len > 0)
+    {
+        size_t take = 32 - hash->mem_len;
+
+        if (take > len)
+        {
+            take = len;
+        }
+        memcpy(hash->mem + hash->mem_len, p, take);
+        hash->mem_len += (uint32_t)take;
+        p += take;
+        len -= take;
+
+        if (hash->mem_len < 32)
+        {
+            return;
+        }
+        stripes(hash->v, hash->mem, 32);
+        hash->mem_len = 0;
+    }
+
+    size_t done = stripes(hash->v, p, len);
+    memcpy(hash->mem, p + done, len - done);
+    hash->mem_len = (uint32_t)(len - done);
+}
+
+uint64_t f3v_hash64_final(const F3vHash64 *hash)
+{
+    const uint8_t *p = hash->mem;
+    const uint8_t *end = hash->mem + hash->mem_len;
+    uint64_t h;
+
+    if (hash->total >= 32)
+    {
+        h = rotl64(hash->v[0], 1) + rotl64(hash->v[1], 7) + rotl64(hash->v[2], 12) +
+            rotl64(hash->v[3], 18);
+        for (int i = 0; i < 4; i++)
+        {
+            h = merge64(h, hash->v[i]);
+        }
+    }
+    else
+    {
+        h = hash->seed + PRIME64_5;
+    }
+    h += hash->total;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++)
+    {
+        h ^= *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+
+    /* Avalanche */
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+uint64_t f3v_hash64(const void *data, size_t len, uint64_t seed)
+{
+    F3vHash64 hash;
+
+    f3v_hash64_init(&hash, seed);
+    f3v_hash64_update(&hash, data, len);
+    return f3v_hash64_final(&hash);
+}
+
+uint32_t f3v_digest_leaves(const uint8_t *buf, uint32_t len, uint64_t first_leaf, uint64_t *out)
+{
+    uint32_t count = 0;
+
+    for (uint32_t offset = 0; offset < len; offset += F3V_DIGEST_LEAF)
+    {
+        uint32_t leaf = len - offset < F3V_DIGEST_LEAF ? len - offset : F3V_DIGEST_LEAF;
+
+        out[count] = f3v_hash64(buf + offset, leaf, first_leaf + count);
+        count++;
+    }
+    return count;
+}
+
+void f3v_digest_begin(F3vHash64 *hash, uint64_t size)
+{
+    f3v_hash64_init(hash, size);
+}
+
+void f3v_digest_add(F3vHash64 *hash, const uint64_t *leaves, uint32_t count)
+{
+    uint8_t bytes[8];
+
+    /* Byte order fixed so manifests compare across hosts */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (int b = 0; b < 8; b++)
+        {
+            bytes[b] = (uint8_t)(leaves[i] >> (8 * b));
+        }
+        f3v_hash64_update(hash, bytes, sizeof(bytes));
+    }
+}
+
+uint64_t f3v_digest_buffer(const uint8_t *buf, uint64_t size)
+{
+    uint64_t leaves[F3V_DIGEST_LEAVES];
+    F3vHash64 hash;
+
+    f3v_digest_begin(&hash, size);
+    for (uint64_t offset = 0; offset < size; offset += F3V_BLOCK_SIZE)
+    {
+        uint32_t len = size - offset < F3V_BLOCK_SIZE ? (uint32_t)(size - offset) : F3V_BLOCK_SIZE;
+        uint32_t count = f3v_digest_leaves(buf + offset, len, offset / F3V_DIGEST_LEAF, leaves);
+
+        f3v_digest_add(&hash, leaves, count);
+    }
+    return f3v_hash64_final(&hash);
+}
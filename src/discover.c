@@ -0,0 +1,300 @@
+/**
+ * @file discover.c
+ * @brief Timing-based erase-block and open-segment discovery
+ */
+
+#include <string.h>
+
+#include "discover.h"
+
+/**
+ * Fill in the recommendations and stop
+ */
+static void finish(struct DiscoverState *state)
+{
+    DiscoverResult *result = &state->result;
+
+    if (result->erase_size == 0)
+    {
+        result->transfer = F3V_BLOCK_SIZE;
+    }
+    else if (result->erase_size > F3V_DISCOVER_MAX_TRANSFER)
+    {
+        result->transfer = F3V_DISCOVER_MAX_TRANSFER;
+    }
+    else
+    {
+        result->transfer = result->erase_size;
+    }
+    result->alignment = result->erase_phase;
+
+    /* The file system keeps a segment open for its own metadata */
+    result->streams = result->open_max > 1 ? result->open_max - 1 : 1;
+
+    state->total_writes = state->writes;
+    state->stage = DISCOVER_DONE;
+}
+
+/**
+ * Find the erase-block size and phase in the boundary scan
+ *
+ * For each candidate size and phase the average cost of the positions at
+ * that phase is compared with the overall average. Every multiple of the
+ * real size scores as high as the size itself, while half the size has
+ * only every other position on a boundary and about half the excess cost,
+ * so the smallest candidate with most of the best excess wins.
+ */
+static void analyze_scan(struct DiscoverState *state)
+{
+    uint32_t best_score[32] = {0};
+    uint32_t best_phase[32] = {0};
+    uint32_t top = 0;
+    uint32_t candidates = 0;
+    uint64_t total = 0;
+
+    for (uint32_t q = 0; q < F3V_DISCOVER_POSITIONS; q++)
+    {
+        total += state->cost[q];
+    }
+    if (total == 0)
+    {
+        return;
+    }
+
+    for (uint32_t size = F3V_DISCOVER_GRAIN;
+         size <= F3V_DISCOVER_MAX_ERASE && size * 2ULL <= F3V_DISCOVER_SCAN; size *= 2)
+    {
+        uint32_t period = size / F3V_DISCOVER_GRAIN;
+
+        for (uint32_t r = 0; r < period; r++)
+        {
+            uint64_t sum = 0;
+            uint32_t n = 0;
+
+            /* Position q is at (q + 1) grains */
+            for (uint32_t q = (r + period - 1) % period; q < F3V_DISCOVER_POSITIONS; q += period)
+            {
+                sum += state->cost[q];
+                n++;
+            }
+
+            uint32_t score =
+                (uint32_t)(sum * 100 * F3V_DISCOVER_POSITIONS / ((uint64_t)n * total));
+            if (score > best_score[candidates])
+            {
+                best_score[candidates] = score;
+                best_phase[candidates] = r * F3V_DISCOVER_GRAIN;
+            }
+        }
+
+        if (best_score[candidates] > top)
+        {
+            top = best_score[candidates];
+        }
+        candidates++;
+    }
+
+    if (top < F3V_DISCOVER_MIN_SCORE)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < candidates; i++)
+    {
+        if (best_score[i] > 100 && (best_score[i] - 100) * 4 >= (top - 100) * 3)
+        {
+            state->result.erase_size = F3V_DISCOVER_GRAIN << i;
+            state->result.erase_phase = best_phase[i];
+            state->result.erase_score = best_score[i];
+            return;
+        }
+    }
+}
+
+/**
+ * Set up the open-segment test behind the scanned window
+ */
+static void begin_open(struct DiscoverState *state)
+{
+    uint64_t size = state->result.erase_size;
+
+    if (size == 0)
+    {
+        finish(state);
+        return;
+    }
+
+    /* First erase block past the scan window */
+    uint64_t start = F3V_DISCOVER_SCAN + F3V_DISCOVER_PROBE;
+    uint64_t phase = state->result.erase_phase;
+    state->open_base = phase + (start > phase ? (start - phase + size - 1) / size * size : 0);
+
+    uint64_t fit = state->region > state->open_base ? (state->region - state->open_base) / size
+                                                    : 0;
+    state->open_limit = fit < F3V_DISCOVER_MAX_OPEN ? (uint32_t)fit : F3V_DISCOVER_MAX_OPEN;
+    if (state->open_limit < 2)
+    {
+        finish(state);
+        return;
+    }
+
+    state->open_n = 1;
+    state->round = 0;
+    state->seg = 0;
+    state->open_count = 0;
+    state->total_writes = state->writes + state->open_limit * (state->open_limit + 1) / 2 *
+                                              F3V_DISCOVER_ROUNDS;
+    state->stage = DISCOVER_OPEN;
+}
+
+/**
+ * Median of the timed writes of the current segment count (sorts them)
+ */
+static uint32_t open_median(struct DiscoverState *state)
+{
+    uint32_t *sample = state->open_sample;
+    uint32_t n = state->open_count;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+    for (uint32_t i = 1; i < n; i++)
+    {
+        uint32_t v = sample[i];
+        uint32_t j = i;
+
+        while (j > 0 && sample[j - 1] > v)
+        {
+            sample[j] = sample[j - 1];
+            j--;
+        }
+        sample[j] = v;
+    }
+    return sample[n / 2];
+}
+
+/**
+ * All rounds at one segment count finished: compare with a single segment
+ */
+static void end_open_round(struct DiscoverState *state)
+{
+    DiscoverResult *result = &state->result;
+    uint32_t median = open_median(state);
+
+    state->open_usec[state->open_n - 1] = median;
+
+    if (state->open_n > 1 &&
+        (uint64_t)median * 100 > (uint64_t)state->open_usec[0] * F3V_DISCOVER_OPEN_JUMP)
+    {
+        result->open_max = state->open_n - 1;
+        result->open_limited = 1;
+        finish(state);
+        return;
+    }
+    if (state->open_n == state->open_limit)
+    {
+        result->open_max = state->open_n;
+        result->open_limited = 0;
+        finish(state);
+        return;
+    }
+
+    state->open_n++;
+    state->round = 0;
+    state->seg = 0;
+    state->open_count = 0;
+}
+
+int f3v_discover_init(struct DiscoverState *state, uint64_t region)
+{
+    memset(state, 0, sizeof(*state));
+
+    if (region < F3V_DISCOVER_SCAN + F3V_DISCOVER_PROBE)
+    {
+        return -1;
+    }
+
+    state->region = region;
+    state->stage = DISCOVER_SCAN;
+    for (uint32_t q = 0; q < F3V_DISCOVER_POSITIONS; q++)
+    {
+        state->cost[q] = UINT32_MAX;
+    }
+
+    /* Refined once the erase block is known */
+    state->total_writes = F3V_DISCOVER_POSITIONS * F3V_DISCOVER_PASSES +
+                          F3V_DISCOVER_MAX_OPEN * (F3V_DISCOVER_MAX_OPEN + 1) / 2 *
+                              F3V_DISCOVER_ROUNDS;
+    return 0;
+}
+
+int f3v_discover_step(struct DiscoverState *state, const DiscoverDevice *dev)
+{
+    uint64_t offset;
+    int64_t usec;
+
+    switch (state->stage)
+    {
+    case DISCOVER_SCAN:
+        offset = (uint64_t)(state->pos + 1) * F3V_DISCOVER_GRAIN - F3V_DISCOVER_PROBE / 2;
+        usec = dev->write_at(dev->handle, offset, F3V_DISCOVER_PROBE);
+        if (usec < 0)
+        {
+            return -1;
+        }
+        state->writes++;
+
+        if ((uint64_t)usec < state->cost[state->pos])
+        {
+            state->cost[state->pos] = usec > UINT32_MAX - 1 ? UINT32_MAX - 1 : (uint32_t)usec;
+        }
+        if (++state->pos == F3V_DISCOVER_POSITIONS)
+        {
+            state->pos = 0;
+            if (++state->pass == F3V_DISCOVER_PASSES)
+            {
+                analyze_scan(state);
+                begin_open(state);
+            }
+        }
+        break;
+
+    case DISCOVER_OPEN:
+    {
+        /* Each round moves on through every segment, so writes stay sequential in it */
+        uint32_t size = state->result.erase_size;
+        uint64_t step = (uint64_t)((state->open_n - 1) * F3V_DISCOVER_ROUNDS + state->round) *
+                        F3V_DISCOVER_PROBE;
+
+        offset = state->open_base + (uint64_t)state->seg * size + step % size;
+        usec = dev->write_at(dev->handle, offset, F3V_DISCOVER_PROBE);
+        if (usec < 0)
+        {
+            return -1;
+        }
+        state->writes++;
+
+        /* The first round opens the segments and is not timed */
+        if (state->round > 0)
+        {
+            state->open_sample[state->open_count++] =
+                usec > UINT32_MAX ? UINT32_MAX : (uint32_t)usec;
+        }
+        if (++state->seg == state->open_n)
+        {
+            state->seg = 0;
+            if (++state->round == F3V_DISCOVER_ROUNDS)
+            {
+                end_open_round(state);
+            }
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return state->stage != DISCOVER_DONE;
+}
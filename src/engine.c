@@ -0,0 +1,250 @@
+/**
+ * @file engine.c
+ * @brief Worker pool that runs test sessions on several devices at once
+ */
+
+#include <stdint.h>
+
+#include "engine.h"
+#include "session.h"
+#include "profile.h"
+#include "thread.h"
+
+/* Per-worker queue of session tokens (requeued at the bottom, taken from the top) */
+typedef struct {
+    F3vMutex lock;
+    int tokens[F3V_MAX_DEVICES];
+    int top;
+    int count;
+} WorkDeque;
+
+static TestContext *g_sessions = NULL;
+static int g_session_count = 0;
+
+static WorkDeque g_deques[F3V_ENGINE_WORKERS];
+static F3vThread g_threads[F3V_ENGINE_WORKERS];
+static int g_worker_count = 0;
+static int g_deque_count = 0;
+
+/* One count per queued token, plus one per worker at shutdown */
+static F3vSema g_ready;
+
+/* Sessions that have not finished yet */
+static F3vMutex g_active_lock;
+static volatile int g_active = 0;
+
+/* One block buffer per worker - static to avoid heap fragmentation */
+static uint8_t g_buffers[F3V_ENGINE_WORKERS][F3V_BLOCK_SIZE] __attribute__((aligned(64)));
+
+static void deque_push_bottom(WorkDeque *dq, int token)
+{
+    f3v_mutex_lock(&dq->lock);
+    dq->tokens[(dq->top + dq->count) % F3V_MAX_DEVICES] = token;
+    dq->count++;
+    f3v_mutex_unlock(&dq->lock);
+}
+
+/**
+ * Take the token that has waited longest (the owner and thieves alike)
+ * @return Session index, or -1 if the deque is empty
+ */
+static int deque_take_top(WorkDeque *dq)
+{
+    int token = -1;
+
+    f3v_mutex_lock(&dq->lock);
+    if (dq->count > 0)
+    {
+        token = dq->tokens[dq->top];
+        dq->top = (dq->top + 1) % F3V_MAX_DEVICES;
+        dq->count--;
+    }
+    f3v_mutex_unlock(&dq->lock);
+
+    return token;
+}
+
+/**
+ * Take a token: own deque first, then steal from the others
+ * @return Session index, or -1 once every session is done
+ */
+static int take_token(int self)
+{
+    for (;;)
+    {
+        int token = deque_take_top(&g_deques[self]);
+
+        for (int i = 1; token < 0 && i < g_deque_count; i++)
+        {
+            token = deque_take_top(&g_deques[(self + i) % g_deque_count]);
+        }
+
+        if (token >= 0)
+        {
+            return token;
+        }
+        if (g_active == 0)
+        {
+            return -1;
+        }
+
+        /* A token was counted but is still being pushed - retry */
+        f3v_thread_sleep_usec(100);
+    }
+}
+
+static int worker_main(void *arg)
+{
+    int self = (int)(intptr_t)arg;
+    uint8_t *buf = g_buffers[self];
+    int profile_applied = -1;
+
+    for (;;)
+    {
+        f3v_profile_refresh(ROLE_IO, &profile_applied);
+        f3v_sema_wait(&g_ready);
+
+        int token = take_token(self);
+        if (token < 0)
+        {
+            break;
+        }
+
+        TestContext *ctx = &g_sessions[token];
+        int more = 1;
+
+        for (int q = 0; q < F3V_ENGINE_QUANTUM && more; q++)
+        {
+            more = f3v_session_step(ctx, buf);
+        }
+
+        /* Behind any other token of this worker, so each gets a quantum in turn */
+        if (more)
+        {
+            deque_push_bottom(&g_deques[self], token);
+            f3v_sema_signal(&g_ready, 1);
+            continue;
+        }
+
+        /* Session finished; the last one wakes everybody up to exit */
+        f3v_mutex_lock(&g_active_lock);
+        int remaining = --g_active;
+        f3v_mutex_unlock(&g_active_lock);
+
+        if (remaining == 0)
+        {
+            f3v_sema_signal(&g_ready, g_worker_count);
+        }
+    }
+
+    return 0;
+}
+
+int f3v_engine_start(TestContext *sessions, int count)
+{
+    if (count <= 0 || count > F3V_MAX_DEVICES)
+    {
+        return -1;
+    }
+
+    g_sessions = sessions;
+    g_session_count = count;
+    g_worker_count = count < F3V_ENGINE_WORKERS ? count : F3V_ENGINE_WORKERS;
+    g_deque_count = g_worker_count;
+    g_active = 0;
+
+    if (f3v_sema_init(&g_ready, "f3v_ready", 0) < 0)
+    {
+        return -1;
+    }
+    if (f3v_mutex_init(&g_active_lock, "f3v_active") < 0)
+    {
+        f3v_sema_destroy(&g_ready);
+        return -1;
+    }
+
+    /* Deal session tokens round-robin so every worker starts with a device */
+    for (int w = 0; w < g_worker_count; w++)
+    {
+        g_deques[w].top = 0;
+        g_deques[w].count = 0;
+        if (f3v_mutex_init(&g_deques[w].lock, "f3v_deque") < 0)
+        {
+            /* No workers yet: stop only releases the locks made so far */
+            g_worker_count = 0;
+            g_deque_count = w;
+            f3v_engine_stop();
+            return -1;
+        }
+    }
+
+    for (int s = 0; s < count; s++)
+    {
+        if (sessions[s].phase == PHASE_DONE)
+        {
+            continue;
+        }
+        deque_push_bottom(&g_deques[s % g_worker_count], s);
+        g_active++;
+    }
+
+    if (g_active == 0)
+    {
+        f3v_sema_signal(&g_ready, g_worker_count);
+    }
+    else
+    {
+        f3v_sema_signal(&g_ready, g_active);
+    }
+
+    for (int w = 0; w < g_worker_count; w++)
+    {
+        if (f3v_thread_create(&g_threads[w], "f3v_worker", worker_main, (void *)(intptr_t)w) < 0)
+        {
+            /* Run with however many workers did start; the rest of the
+             * deques are drained by stealing */
+            g_worker_count = w;
+            break;
+        }
+    }
+
+    if (g_worker_count == 0)
+    {
+        f3v_engine_stop();
+        return -1;
+    }
+
+    return 0;
+}
+
+int f3v_engine_busy(void)
+{
+    return g_active > 0;
+}
+
+void f3v_engine_cancel(void)
+{
+    for (int s = 0; s < g_session_count; s++)
+    {
+        g_sessions[s].cancelled = 1;
+    }
+}
+
+void f3v_engine_stop(void)
+{
+    for (int w = 0; w < g_worker_count; w++)
+    {
+        f3v_thread_join(&g_threads[w]);
+    }
+    for (int w = 0; w < g_deque_count; w++)
+    {
+        f3v_mutex_destroy(&g_deques[w].lock);
+    }
+
+    f3v_sema_destroy(&g_ready);
+    f3v_mutex_destroy(&g_active_lock);
+
+    g_worker_count = 0;
+    g_sessions = NULL;
+    g_session_count = 0;
+}
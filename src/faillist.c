@@ -0,0 +1,165 @@
+/**
+ * @file faillist.c
+ * @brief List of corrupted regions, persisted for targeted re-tests
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "faillist.h"
+#include "storage.h"
+#include "pattern.h"
+
+#define FAIL_MAGIC   0x46563346 /* "F3VF" */
+#define FAIL_VERSION 1
+
+/* On-disk layout of the region list */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pattern_version;
+    uint32_t count;
+    uint32_t truncated;
+    FailRegion regions[F3V_MAX_FAIL_REGIONS];
+} FailFile;
+
+/**
+ * Build the path of the saved region list
+ */
+static void fail_path(const TestContext *ctx, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "%s/%s", ctx->test_dir, F3V_FAIL_NAME);
+}
+
+void f3v_fail_note(TestContext *ctx, uint32_t file_idx, uint32_t block_idx, uint32_t offset)
+{
+    for (uint32_t i = 0; i < ctx->fail_count; i++)
+    {
+        FailRegion *region = &ctx->fail[i];
+
+        if (region->file == file_idx && block_idx >= region->block &&
+            block_idx <= region->block + region->block_count)
+        {
+            /* Already listed, or the next block: grow that region */
+            if (block_idx == region->block + region->block_count)
+            {
+                region->block_count++;
+            }
+            return;
+        }
+    }
+
+    if (ctx->fail_count >= F3V_MAX_FAIL_REGIONS)
+    {
+        ctx->fail_truncated = 1;
+        return;
+    }
+
+    FailRegion *region = &ctx->fail[ctx->fail_count++];
+    memset(region, 0, sizeof(*region));
+    region->file = file_idx;
+    region->block = block_idx;
+    region->block_count = 1;
+    region->first_offset = offset;
+}
+
+int f3v_fail_save(const TestContext *ctx)
+{
+    FailFile data;
+    char path[128];
+
+    fail_path(ctx, path, sizeof(path));
+
+    if (ctx->fail_count == 0)
+    {
+        f3v_remove(path);
+        return 0;
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.magic = FAIL_MAGIC;
+    data.version = FAIL_VERSION;
+    data.pattern_version = F3V_PATTERN_VERSION;
+    data.count = ctx->fail_count;
+    data.truncated = (uint32_t)ctx->fail_truncated;
+    memcpy(data.regions, ctx->fail, ctx->fail_count * sizeof(FailRegion));
+
+    int fd = f3v_open_write(path);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    int written = f3v_write_block(fd, &data, sizeof(data));
+    f3v_close(fd);
+
+    return written == (int)sizeof(data) ? 0 : -1;
+}
+
+int f3v_fail_load(TestContext *ctx)
+{
+    FailFile data;
+    char path[128];
+
+    fail_path(ctx, path, sizeof(path));
+
+    int fd = f3v_open_read(path);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    int bytes_read = f3v_read_block(fd, &data, sizeof(data));
+    f3v_close(fd);
+
+    if (bytes_read != (int)sizeof(data) || data.magic != FAIL_MAGIC ||
+        data.version != FAIL_VERSION || data.pattern_version != F3V_PATTERN_VERSION ||
+        data.count == 0 || data.count > F3V_MAX_FAIL_REGIONS)
+    {
+        return -1;
+    }
+
+    ctx->fail_count = data.count;
+    ctx->fail_truncated = (int)data.truncated;
+    for (uint32_t i = 0; i < data.count; i++)
+    {
+        ctx->fail[i] = data.regions[i];
+        ctx->fail[i].failed_passes = 0;
+        ctx->fail[i].last_failed_pass = 0;
+    }
+
+    return (int)ctx->fail_count;
+}
+
+uint32_t f3v_fail_span(const TestContext *ctx, const FailRegion *region, uint32_t *start)
+{
+    /* Blocks present in this file */
+    uint64_t file_start = (uint64_t)(region->file - 1) * F3V_FILE_SIZE;
+    uint64_t file_bytes = ctx->bytes_written > file_start ? ctx->bytes_written - file_start : 0;
+    uint32_t file_blocks = file_bytes >= F3V_FILE_SIZE ? F3V_BLOCKS_PER_FILE
+                                                       : (uint32_t)(file_bytes / F3V_BLOCK_SIZE);
+
+    uint32_t margin = ctx->run.retest.margin;
+    uint32_t first = region->block > margin ? region->block - margin : 0;
+    uint32_t end = region->block + region->block_count + margin;
+    if (end > file_blocks)
+    {
+        end = file_blocks;
+    }
+
+    *start = first;
+    return end > first ? end - first : 0;
+}
+
+const char *f3v_fail_class(const FailRegion *region, uint32_t passes)
+{
+    if (region->failed_passes == 0)
+    {
+        return "not reproduced";
+    }
+    if (region->failed_passes >= passes)
+    {
+        return "persistent";
+    }
+    return "intermittent";
+}
@@ -0,0 +1,387 @@
+/**
+ * @file fstree.c
+ * @brief Small-file and directory workload
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fstree.h"
+#include "pattern.h"
+
+/* Deepest tree accepted (paths grow by one component per level) */
+#define FSTREE_MAX_DEPTH 8
+
+/* Most directories in a tree */
+#define FSTREE_MAX_DIRS 4096
+
+/**
+ * splitmix64 finalizer
+ */
+static uint64_t mix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Path of directory k (level order, root = 0)
+ */
+static char *dir_path(const struct FsTreeState *state, uint32_t k, char *buf, size_t buf_size)
+{
+    uint32_t child[FSTREE_MAX_DEPTH];
+    uint32_t levels = 0;
+    size_t len;
+
+    while (k > 0 && levels < FSTREE_MAX_DEPTH)
+    {
+        child[levels++] = (k - 1) % state->shape.fanout;
+        k = (k - 1) / state->shape.fanout;
+    }
+
+    len = (size_t)snprintf(buf, buf_size, "%s", state->root);
+    while (levels > 0 && len < buf_size)
+    {
+        len += (size_t)snprintf(buf + len, buf_size - len, "/d%u", child[--levels]);
+    }
+    return buf;
+}
+
+/**
+ * Path of file pos of directory k
+ */
+static char *file_path(const struct FsTreeState *state, uint32_t k, uint32_t pos, char *buf,
+                       size_t buf_size)
+{
+    char dir[160];
+
+    snprintf(buf, buf_size, "%s/f%04u.dat", dir_path(state, k, dir, sizeof(dir)), pos);
+    return buf;
+}
+
+/**
+ * Operations a stage does in each directory
+ */
+static uint32_t stage_positions(const struct FsTreeState *state, FsTreeStage stage)
+{
+    /* Creating and deleting also handle the directory itself */
+    if (stage == FSTREE_CREATE || stage == FSTREE_DELETE)
+    {
+        return state->shape.files_per_dir + 1;
+    }
+    return state->shape.files_per_dir;
+}
+
+/**
+ * Percentiles of every operation type so far
+ */
+static void summarize(struct FsTreeState *state)
+{
+    for (uint32_t i = 0; i < FS_OP_COUNT; i++)
+    {
+        FsOpStats *stats = &state->result.op[i];
+
+        stats->lat_p50_us = f3v_hist_percentile(&state->hist[i], 0.50);
+        stats->lat_p99_us = f3v_hist_percentile(&state->hist[i], 0.99);
+        stats->lat_max_us = state->hist[i].max_usec;
+    }
+}
+
+/**
+ * Start a stage, skipping those with nothing to do
+ */
+static void begin_stage(struct FsTreeState *state, FsTreeStage stage)
+{
+    while (stage != FSTREE_DONE && stage_positions(state, stage) == 0)
+    {
+        stage++;
+    }
+
+    state->stage = stage;
+    state->dir = stage == FSTREE_DELETE ? state->result.dirs - 1 : 0;
+    state->pos = 0;
+}
+
+/**
+ * Move to the next operation of the stage, or the next stage
+ */
+static void advance(struct FsTreeState *state)
+{
+    state->ops++;
+    if (++state->pos < stage_positions(state, state->stage))
+    {
+        return;
+    }
+    state->pos = 0;
+
+    /* Deleting goes deepest first, so directories are empty when removed */
+    if (state->stage == FSTREE_DELETE ? state->dir-- > 0 : ++state->dir < state->result.dirs)
+    {
+        return;
+    }
+
+    summarize(state);
+    begin_stage(state, state->stage + 1);
+}
+
+/**
+ * Count a timed operation
+ */
+static void record(struct FsTreeState *state, FsOp op, uint64_t usec, int failed)
+{
+    FsOpStats *stats = &state->result.op[op];
+    uint32_t lat = usec > UINT32_MAX ? UINT32_MAX : (uint32_t)usec;
+
+    stats->count++;
+    stats->usec += usec;
+    if (failed)
+    {
+        stats->failed++;
+    }
+    f3v_hist_add(&state->hist[op], lat);
+}
+
+/**
+ * Read a file back and check it against its pattern
+ */
+static void read_file(struct FsTreeState *state, const FsTreeDevice *dev, const char *path,
+                      uint32_t n, uint8_t *buf)
+{
+    uint32_t size = f3v_fstree_file_size(&state->shape, state->seed, n);
+    uint32_t corrupted;
+
+    uint64_t t0 = dev->now_usec(dev->handle);
+    int got = dev->read_file(dev->handle, path, buf, size);
+    uint64_t usec = dev->now_usec(dev->handle) - t0;
+
+    /* Check outside the timed window */
+    if (got < 0)
+    {
+        corrupted = size;
+    }
+    else
+    {
+        corrupted = size - (uint32_t)got +
+                    f3v_verify_pattern_range(buf, 1 + n % 255, n / 255, 0, (uint32_t)got, NULL);
+    }
+    record(state, FS_OP_READ, usec, got < 0);
+
+    if (corrupted > 0)
+    {
+        state->result.bad_files++;
+        state->result.corrupted += corrupted;
+    }
+    state->verified += size;
+}
+
+uint32_t f3v_fstree_dirs(const FsTreeShape *shape)
+{
+    uint64_t dirs = 1;
+    uint64_t level = 1;
+
+    for (uint32_t d = 0; d < shape->depth; d++)
+    {
+        level *= shape->fanout;
+        dirs += level;
+        if (dirs > FSTREE_MAX_DIRS)
+        {
+            return 0;
+        }
+    }
+    return (uint32_t)dirs;
+}
+
+uint32_t f3v_fstree_file_size(const FsTreeShape *shape, uint32_t seed, uint32_t file)
+{
+    uint64_t r = mix64((uint64_t)seed << 32 | file);
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < shape->bucket_count; i++)
+    {
+        total += shape->bucket[i].weight;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    /* Low bits pick the range, high bits the size within it */
+    uint32_t pick = (uint32_t)(r % total);
+    const FsSizeBucket *bucket = &shape->bucket[0];
+    for (uint32_t i = 0; i < shape->bucket_count; i++)
+    {
+        bucket = &shape->bucket[i];
+        if (pick < bucket->weight)
+        {
+            break;
+        }
+        pick -= bucket->weight;
+    }
+
+    return bucket->min_size + (uint32_t)((r >> 32) % (bucket->max_size - bucket->min_size + 1));
+}
+
+int f3v_fstree_init(struct FsTreeState *state, const FsTreeShape *shape, const char *root,
+                    uint32_t seed)
+{
+    memset(state, 0, sizeof(*state));
+
+    if (shape->depth > FSTREE_MAX_DEPTH || (shape->depth > 0 && shape->fanout == 0) ||
+        shape->bucket_count == 0 || shape->bucket_count > F3V_FSTREE_BUCKETS)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < shape->bucket_count; i++)
+    {
+        if (shape->bucket[i].min_size > shape->bucket[i].max_size ||
+            shape->bucket[i].max_size > F3V_FSTREE_MAX_FILE)
+        {
+            return -1;
+        }
+    }
+
+    state->shape = *shape;
+    state->seed = seed;
+    snprintf(state->root, sizeof(state->root), "%s", root);
+
+    FsTreeResult *result = &state->result;
+    result->dirs = f3v_fstree_dirs(shape);
+    if (result->dirs == 0 ||
+        (uint64_t)result->dirs * shape->files_per_dir > F3V_FSTREE_MAX_FILES)
+    {
+        return -1;
+    }
+    result->files = result->dirs * shape->files_per_dir;
+    for (uint32_t n = 0; n < result->files; n++)
+    {
+        result->bytes += f3v_fstree_file_size(shape, seed, n);
+    }
+
+    state->total_ops = 2 * result->dirs + 4 * result->files;
+    begin_stage(state, FSTREE_CREATE);
+    return 0;
+}
+
+int f3v_fstree_step(struct FsTreeState *state, const FsTreeDevice *dev, uint8_t *buf)
+{
+    uint32_t files = state->shape.files_per_dir;
+    uint32_t n = state->dir * files + state->pos;
+    char path[192];
+    uint64_t t0, usec;
+    int ret;
+
+    switch (state->stage)
+    {
+    case FSTREE_CREATE:
+    {
+        if (state->pos == 0)
+        {
+            dir_path(state, state->dir, path, sizeof(path));
+            t0 = dev->now_usec(dev->handle);
+            ret = dev->mkdir(dev->handle, path);
+            record(state, FS_OP_MKDIR, dev->now_usec(dev->handle) - t0, ret < 0);
+
+            /* Nothing else can be created without the root */
+            if (ret < 0 && state->dir == 0)
+            {
+                return -1;
+            }
+            break;
+        }
+
+        n--;
+        uint32_t size = f3v_fstree_file_size(&state->shape, state->seed, n);
+        f3v_fill_pattern_range(buf, 1 + n % 255, n / 255, 0, size);
+        file_path(state, state->dir, state->pos - 1, path, sizeof(path));
+
+        t0 = dev->now_usec(dev->handle);
+        ret = dev->write_file(dev->handle, path, buf, size);
+        record(state, FS_OP_CREATE, dev->now_usec(dev->handle) - t0, ret != (int)size);
+        state->written += size;
+        break;
+    }
+
+    case FSTREE_STAT:
+    {
+        int64_t expected = f3v_fstree_file_size(&state->shape, state->seed, n);
+        int64_t found;
+
+        file_path(state, state->dir, state->pos, path, sizeof(path));
+        t0 = dev->now_usec(dev->handle);
+        found = dev->stat(dev->handle, path);
+        usec = dev->now_usec(dev->handle) - t0;
+
+        record(state, FS_OP_STAT, usec, found != expected);
+        break;
+    }
+
+    case FSTREE_READ:
+        file_path(state, state->dir, state->pos, path, sizeof(path));
+        read_file(state, dev, path, n, buf);
+        break;
+
+    case FSTREE_DELETE:
+        if (state->pos == files)
+        {
+            dir_path(state, state->dir, path, sizeof(path));
+            t0 = dev->now_usec(dev->handle);
+            ret = dev->rmdir(dev->handle, path);
+            record(state, FS_OP_RMDIR, dev->now_usec(dev->handle) - t0, ret < 0);
+            break;
+        }
+
+        file_path(state, state->dir, state->pos, path, sizeof(path));
+        t0 = dev->now_usec(dev->handle);
+        ret = dev->remove(dev->handle, path);
+        record(state, FS_OP_DELETE, dev->now_usec(dev->handle) - t0, ret < 0);
+        break;
+
+    default:
+        return 0;
+    }
+
+    advance(state);
+    return state->stage != FSTREE_DONE;
+}
+
+void f3v_fstree_cleanup(struct FsTreeState *state, const FsTreeDevice *dev)
+{
+    char path[192];
+
+    if (state->stage == FSTREE_DONE)
+    {
+        return;
+    }
+
+    for (uint32_t k = state->result.dirs; k-- > 0;)
+    {
+        for (uint32_t pos = 0; pos < state->shape.files_per_dir; pos++)
+        {
+            dev->remove(dev->handle, file_path(state, k, pos, path, sizeof(path)));
+        }
+        dev->rmdir(dev->handle, dir_path(state, k, path, sizeof(path)));
+    }
+    state->stage = FSTREE_DONE;
+}
+
+const char *f3v_fstree_op_name(FsOp op)
+{
+    static const char *names[FS_OP_COUNT] = {"mkdir", "create", "stat",
+                                             "read", "delete", "rmdir"};
+
+    return op < FS_OP_COUNT ? names[op] : "?";
+}
+
+const char *f3v_fstree_stage_name(FsTreeStage stage)
+{
+    static const char *names[] = {"create", "stat", "read", "delete", "done"};
+
+    return stage <= FSTREE_DONE ? names[stage] : "?";
+}
+
+uint32_t f3v_fstree_ops_per_sec(const FsOpStats *stats)
+{
+    return stats->usec > 0 ? (uint32_t)((uint64_t)stats->count * 1000000 / stats->usec) : 0;
+}
@@ -0,0 +1,285 @@
+/**
+ * @file journal.c
+ * @brief Crash-safe checkpoint journal for interrupted runs
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "journal.h"
+#include "storage.h"
+#include "pattern.h"
+#include "readback.h"
+#include "ui.h"
+
+#define JOURNAL_MAGIC   0x4A563346 /* "F3VJ" */
+#define JOURNAL_VERSION 4
+#define JOURNAL_SLOTS   2
+
+/**
+ * Build the path of a journal slot
+ */
+static void slot_path(const TestContext *ctx, int slot, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "%s/%s.%d", ctx->test_dir, F3V_JOURNAL_NAME, slot);
+}
+
+/**
+ * FNV-1a over the record, excluding the checksum field
+ */
+static uint32_t record_checksum(const JournalRecord *rec)
+{
+    const uint8_t *p = (const uint8_t *)rec;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(JournalRecord, checksum); i++)
+    {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Check that a record is intact and was written by a compatible build
+ */
+static int record_valid(const JournalRecord *rec)
+{
+    return rec->magic == JOURNAL_MAGIC &&
+           rec->version == JOURNAL_VERSION &&
+           rec->checksum == record_checksum(rec) &&
+           rec->pattern_version == F3V_PATTERN_VERSION &&
+           rec->block_size == F3V_BLOCK_SIZE &&
+           rec->file_size == F3V_FILE_SIZE &&
+           rec->phase <= PHASE_VERIFY &&
+           rec->verify_order < ORDER_COUNT &&
+           rec->readback < READBACK_COUNT &&
+           rec->abort_policy < ABORT_COUNT &&
+           rec->raw_verified <= rec->bytes_written;
+}
+
+int f3v_journal_save(TestContext *ctx)
+{
+    JournalRecord rec;
+    ReadbackTotals raw;
+    char path[128];
+
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = JOURNAL_MAGIC;
+    rec.version = JOURNAL_VERSION;
+    rec.session_nonce = ctx->session_nonce;
+    rec.seq = ctx->journal_seq + 1;
+
+    rec.phase = ctx->phase;
+    rec.files_written = ctx->files_written;
+    rec.bytes_written = ctx->bytes_written;
+    rec.bytes_verified = ctx->bytes_verified;
+    rec.total_expected = ctx->total_expected;
+    rec.verify_index = ctx->verify_index;
+    rec.verify_order = ctx->verify_order;
+    rec.verify_seed = ctx->verify_seed;
+
+    rec.readback = ctx->readback;
+    rec.abort_policy = ctx->abort_policy;
+    rec.abort_param = ctx->abort_param;
+    rec.pattern_variant = ctx->pattern_variant;
+
+    rec.bytes_corrupted = ctx->bytes_corrupted;
+    rec.has_first_error = (uint32_t)ctx->has_first_error;
+    rec.first_error_file = ctx->first_error_file;
+    rec.first_error_block = ctx->first_error_block;
+    rec.first_error_offset = ctx->first_error_offset;
+
+    /* The reader may still be running */
+    f3v_readback_totals(ctx, &raw);
+    rec.raw_verified = raw.verified;
+    rec.raw_corrupted = raw.corrupted;
+    rec.raw_error_written = raw.error_written;
+    rec.raw_has_error = (uint32_t)raw.has_error;
+    rec.raw_error_file = raw.error_file;
+    rec.raw_error_block = raw.error_block;
+    rec.raw_error_offset = raw.error_offset;
+
+    rec.pattern_version = F3V_PATTERN_VERSION;
+    rec.block_size = F3V_BLOCK_SIZE;
+    rec.file_size = F3V_FILE_SIZE;
+    rec.checksum = record_checksum(&rec);
+
+    /* Alternate slots so the previous checkpoint survives a torn write */
+    slot_path(ctx, (int)(rec.seq % JOURNAL_SLOTS), path, sizeof(path));
+
+    int fd = f3v_open_write(path);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    int ret = f3v_write_block(fd, &rec, sizeof(rec));
+    if (ret == (int)sizeof(rec))
+    {
+        ret = f3v_sync(fd);
+    }
+    else
+    {
+        ret = -1;
+    }
+    f3v_close(fd);
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->journal_seq = rec.seq;
+    return 0;
+}
+
+int f3v_journal_load(const TestContext *ctx, JournalRecord *rec)
+{
+    int found = 0;
+
+    for (int slot = 0; slot < JOURNAL_SLOTS; slot++)
+    {
+        JournalRecord candidate;
+        char path[128];
+
+        slot_path(ctx, slot, path, sizeof(path));
+        int fd = f3v_open_read(path);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        int bytes_read = f3v_read_block(fd, &candidate, sizeof(candidate));
+        f3v_close(fd);
+
+        if (bytes_read != (int)sizeof(candidate) || !record_valid(&candidate))
+        {
+            continue;
+        }
+
+        /* Newest valid checkpoint wins */
+        if (!found || candidate.seq > rec->seq)
+        {
+            *rec = candidate;
+            found = 1;
+        }
+    }
+
+    return found ? 0 : -1;
+}
+
+int f3v_journal_check(const TestContext *ctx, const JournalRecord *rec, uint8_t *buf)
+{
+    char filename[128];
+
+    if (rec->bytes_written == 0)
+    {
+        return 0;
+    }
+
+    /* Every checkpointed byte must still be on the card */
+    for (uint32_t i = 1; i <= rec->files_written; i++)
+    {
+        uint64_t file_start = (uint64_t)(i - 1) * F3V_FILE_SIZE;
+        uint64_t expected = rec->bytes_written - file_start;
+        if (expected > F3V_FILE_SIZE)
+        {
+            expected = F3V_FILE_SIZE;
+        }
+
+        f3v_get_test_filename((TestContext *)ctx, i, filename, sizeof(filename));
+        int64_t size = f3v_get_file_size(filename);
+        if (size < 0 || (uint64_t)size < expected)
+        {
+            return -1;
+        }
+    }
+
+    /* Re-verify the last checkpointed block */
+    uint64_t last = rec->bytes_written - F3V_BLOCK_SIZE;
+    uint32_t file_idx = (uint32_t)(last / F3V_FILE_SIZE) + 1;
+    uint32_t block_idx = (uint32_t)((last % F3V_FILE_SIZE) / F3V_BLOCK_SIZE);
+
+    f3v_get_test_filename((TestContext *)ctx, file_idx, filename, sizeof(filename));
+    int fd = f3v_open_read(filename);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    int ret = f3v_seek(fd, (uint64_t)block_idx * F3V_BLOCK_SIZE);
+    if (ret == 0)
+    {
+        int bytes_read = f3v_read_block(fd, buf, F3V_BLOCK_SIZE);
+        if (bytes_read != F3V_BLOCK_SIZE ||
+            f3v_verify_pattern(buf, file_idx, block_idx, NULL) != 0)
+        {
+            ret = -1;
+        }
+    }
+    f3v_close(fd);
+
+    return ret;
+}
+
+void f3v_journal_apply(TestContext *ctx, const JournalRecord *rec)
+{
+    ctx->session_nonce = rec->session_nonce;
+    ctx->journal_seq = rec->seq;
+    ctx->resumed = 1;
+
+    ctx->files_written = rec->files_written;
+    ctx->bytes_written = rec->bytes_written;
+    ctx->bytes_corrupted = rec->bytes_corrupted;
+    ctx->has_first_error = (int)rec->has_first_error;
+    ctx->first_error_file = rec->first_error_file;
+    ctx->first_error_block = rec->first_error_block;
+    ctx->first_error_offset = rec->first_error_offset;
+
+    /* Checks continue as the run started them */
+    ctx->readback = (ReadbackMode)rec->readback;
+    ctx->abort_policy = (AbortPolicy)rec->abort_policy;
+    ctx->abort_param = rec->abort_param;
+    ctx->pattern_variant = rec->pattern_variant;
+
+    /* The session has no reader yet */
+    ctx->raw.verified = rec->raw_verified;
+    ctx->raw.corrupted = rec->raw_corrupted;
+    ctx->raw.error_written = rec->raw_error_written;
+    ctx->raw.has_error = (int)rec->raw_has_error;
+    ctx->raw.error_file = rec->raw_error_file;
+    ctx->raw.error_block = rec->raw_error_block;
+    ctx->raw.error_offset = rec->raw_error_offset;
+
+    /* Free space no longer includes what was already written */
+    ctx->total_expected = ctx->target.free_bytes + rec->bytes_written;
+
+    /* The order a run started verifying in is kept; the menu choice applies
+       to runs still writing */
+    ctx->phase = (SessionPhase)rec->phase;
+    if (ctx->phase == PHASE_VERIFY)
+    {
+        ctx->verify_order = (VerifyOrder)rec->verify_order;
+        ctx->verify_seed = rec->verify_seed;
+        ctx->verify_index = rec->verify_index;
+        ctx->bytes_verified = rec->bytes_verified;
+        ctx->last_checkpoint = rec->bytes_verified;
+    }
+    else
+    {
+        ctx->last_checkpoint = rec->bytes_written;
+    }
+}
+
+void f3v_journal_clear(const TestContext *ctx)
+{
+    char path[128];
+
+    for (int slot = 0; slot < JOURNAL_SLOTS; slot++)
+    {
+        slot_path(ctx, slot, path, sizeof(path));
+        f3v_remove(path);
+    }
+}
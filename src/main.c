@@ -13,23 +13,239 @@
 
 #include "types.h"
 #include "storage.h"
-#include "pattern.h"
+#include "session.h"
+#include "journal.h"
+#include "order.h"
+#include "bench.h"
+#include "stream.h"
+#include "fstree.h"
+#include "wipe.h"
+#include "engine.h"
+#include "pool.h"
+#include "readback.h"
+#include "profile.h"
 #include "ui.h"
 
 /* Global state */
 static AppState g_state = STATE_MENU;
-static TestContext g_ctx;
 static StorageDevice g_devices[F3V_MAX_DEVICES];
 static int g_device_count = 0;
 static int g_selected_device = 0;
-
-/* Work buffer for I/O (1 MB) - static to avoid stack issues */
-static uint8_t g_buffer[F3V_BLOCK_SIZE] __attribute__((aligned(64)));
+static int g_marked[F3V_MAX_DEVICES];
+
+/* Menu cursor: device rows first, then setting rows */
+typedef enum {
+    OPT_MODE,
+    OPT_READBACK,
+    OPT_ORDER,
+    OPT_ABORT,
+    OPT_PROFILE,
+    OPT_RATE,
+    OPT_BURST,
+    OPT_PASSES,
+    OPT_MARGIN,
+    OPT_SAMPLE,
+    OPT_BURNIN,
+    OPT_DEPTH,
+    OPT_STREAMS,
+    OPT_CLASS,
+    OPT_MIX,
+    OPT_TREE,
+    OPT_SIZES,
+    OPT_WIPE,
+    OPT_SCAN,
+    OPT_COUNT
+} MenuOptionId;
+
+/* Selectable I/O rate limits (0 = off) and bucket depths */
+static const uint32_t g_rate_mbps[] = {0, 2, 5, 10, 20, 40};
+static const uint32_t g_burst_mb[] = {1, 4, 16, 64};
+#define RATE_CHOICES  (int)(sizeof(g_rate_mbps) / sizeof(g_rate_mbps[0]))
+#define BURST_CHOICES (int)(sizeof(g_burst_mb) / sizeof(g_burst_mb[0]))
+
+/* Re-test mode: passes over each failed region and blocks of margin */
+static const uint32_t g_passes[] = {1, 3, 5, 10};
+static const uint32_t g_margin[] = {0, 1, 4, 16};
+#define PASS_CHOICES   (int)(sizeof(g_passes) / sizeof(g_passes[0]))
+#define MARGIN_CHOICES (int)(sizeof(g_margin) / sizeof(g_margin[0]))
+
+/* Sampling mode: stop after a time budget or once a bad fraction is proven */
+static const struct {
+    uint32_t budget_sec;
+    uint32_t target_ppm;
+} g_sample[] = {
+    {10 * 60, 0},
+    {30 * 60, 0},
+    {0, 10000},
+    {0, 1000},
+};
+#define SAMPLE_CHOICES (int)(sizeof(g_sample) / sizeof(g_sample[0]))
+
+/* Burn-in mode: a number of passes, or passes until a soak time is up */
+static const struct {
+    uint32_t passes;
+    uint32_t duration_sec;
+} g_burnin[] = {
+    {3, 0},
+    {5, 0},
+    {10, 0},
+    {0, 4 * 3600},
+    {0, 24 * 3600},
+};
+#define BURNIN_CHOICES (int)(sizeof(g_burnin) / sizeof(g_burnin[0]))
+
+/* Benchmark: highest queue depth (depths 1, 2, 4, ... up to it are run) */
+static const uint32_t g_depth[] = {1, 2, 4, F3V_BENCH_MAX_DEPTH};
+#define DEPTH_CHOICES (int)(sizeof(g_depth) / sizeof(g_depth[0]))
+
+/* Stream sweep: most files written at once (rounds 1, 2, ... up to it) */
+static const uint32_t g_streams[] = {2, 4, F3V_STREAM_MAX};
+#define STREAM_CHOICES (int)(sizeof(g_streams) / sizeof(g_streams[0]))
+
+/* Conformance: SD speed classes by their minimum sustained write speed */
+static const struct {
+    const char *name;
+    uint32_t mbps;
+} g_class[] = {
+    {"C4", 4},
+    {"C6", 6},
+    {"C10/U1/V10", 10},
+    {"U3/V30", 30},
+    {"V60", 60},
+    {"V90", 90},
+};
+#define CLASS_CHOICES (int)(sizeof(g_class) / sizeof(g_class[0]))
+
+/* Mixed workload: share of the bytes moved that are random reads */
+static const uint32_t g_mix[] = {90, 75, 50, 25};
+#define MIX_CHOICES (int)(sizeof(g_mix) / sizeof(g_mix[0]))
+
+/* Small files: tree shapes {fanout, depth, files per directory} */
+static const struct {
+    uint32_t fanout;
+    uint32_t depth;
+    uint32_t files_per_dir;
+} g_tree[] = {
+    {0, 0, 2000},
+    {16, 1, 64},
+    {8, 2, 20},
+    {4, 4, 8},
+};
+#define TREE_CHOICES (int)(sizeof(g_tree) / sizeof(g_tree[0]))
+
+/* Small files: file size distributions {weight, min, max} */
+static const struct {
+    const char *name;
+    FsSizeBucket bucket[F3V_FSTREE_BUCKETS];
+    uint32_t bucket_count;
+} g_sizes[] = {
+    {"Game install", {{50, 512, 16384}, {35, 16384, 262144}, {15, 262144, 1048576}}, 3},
+    {"Tiny (0-4 KB)", {{100, 1, 4096}}, 1},
+    {"Saves (16-256 KB)", {{100, 16384, 262144}}, 1},
+    {"Mixed (0-1 MB)",
+     {{40, 1, 4096}, {30, 4096, 65536}, {20, 65536, 262144}, {10, 262144, 1048576}},
+     4},
+};
+#define SIZES_CHOICES (int)(sizeof(g_sizes) / sizeof(g_sizes[0]))
+
+/* Wipe: what to write and whether to read it back before deleting it */
+static const struct {
+    WipeFill fill;
+    int verify;
+} g_wipe[] = {
+    {WIPE_ZEROS, 0},
+    {WIPE_RANDOM, 0},
+    {WIPE_PATTERN, 0},
+    {WIPE_ZEROS, 1},
+    {WIPE_RANDOM, 1},
+    {WIPE_PATTERN, 1},
+};
+#define WIPE_CHOICES (int)(sizeof(g_wipe) / sizeof(g_wipe[0]))
+
+/* Bit-rot and surface scans: which part of the device to read (each keeps its own digests) */
+static const struct {
+    const char *name;
+    const char *subdir;
+} g_scan[] = {
+    {"Games (app)", "app"},
+    {"Game data (data)", "data"},
+    {"Saves (user)", "user"},
+    {"Whole device", ""},
+};
+#define SCAN_CHOICES (int)(sizeof(g_scan) / sizeof(g_scan[0]))
+
+static const char *g_readback_names[READBACK_COUNT] = {"Off", "After each write", "Per file"};
+
+/* Triage presets: stop verifying early and report a partial result */
+static const struct {
+    AbortPolicy policy;
+    uint32_t param;
+} g_abort[] = {
+    {ABORT_NEVER, 0},
+    {ABORT_FIRST_BAD, 0},
+    {ABORT_BAD_MB, 16},
+    {ABORT_BAD_MB, 256},
+    {ABORT_BAD_RATIO, 5},
+    {ABORT_BAD_RATIO, 25},
+    {ABORT_ALIASING, 0},
+};
+#define ABORT_CHOICES (int)(sizeof(g_abort) / sizeof(g_abort[0]))
+
+static const char *g_mode_names[MODE_COUNT] = {"Full test", "Verify only", "Re-test failures",
+                                               "Sample", "Burn-in", "Benchmark",
+                                               "Streams", "Discover", "Alignment",
+                                               "Conformance", "Mixed", "Small files",
+                                               "Wipe free space", "Bit-rot scan",
+                                               "Surface scan"};
+static const char *g_mode_errors[MODE_COUNT] = {"Failed to create test directory!",
+                                                "No test files found to verify!",
+                                                "No failed regions recorded to re-test!",
+                                                "Failed to set up sampling!",
+                                                "Failed to create test directory!",
+                                                "Not enough free space to benchmark!",
+                                                "Not enough free space for all streams!",
+                                                "Not enough free space to probe!",
+                                                "Not enough free space for the grid!",
+                                                "Not enough free space for conformance!",
+                                                "Not enough free space for both streams!",
+                                                "Not enough free space for the tree!",
+                                                "Not enough memory for the wipe buffer!",
+                                                "Failed to set up the scan!",
+                                                "Failed to set up the scan!"};
+
+static int g_menu_cursor = 0;
+static int g_option[OPT_COUNT] = {MODE_FULL, READBACK_OFF, ORDER_SEQUENTIAL, 0,
+                                  F3V_PROFILE_DEFAULT, 0, 1, 1, 1, 0, 0, 2, 2, 3, 1, 2, 0, 1, 0};
+static const int g_option_choices[OPT_COUNT] = {MODE_COUNT, READBACK_COUNT, ORDER_COUNT,
+                                                ABORT_CHOICES, PROFILE_COUNT, RATE_CHOICES,
+                                                BURST_CHOICES, PASS_CHOICES, MARGIN_CHOICES,
+                                                SAMPLE_CHOICES, BURNIN_CHOICES, DEPTH_CHOICES,
+                                                STREAM_CHOICES, CLASS_CHOICES, MIX_CHOICES,
+                                                TREE_CHOICES, SIZES_CHOICES, WIPE_CHOICES,
+                                                SCAN_CHOICES};
+static char g_option_text[OPT_COUNT][24];
+
+/* UI frame pacing while sessions run (input sampling latency) */
+static uint64_t g_frame_last = 0;
+static uint64_t g_frame_total = 0;
+static uint32_t g_frame_count = 0;
+static uint32_t g_frame_max = 0;
+
+/* One session per device under test */
+static TestContext g_sessions[F3V_MAX_DEVICES];
+static int g_session_count = 0;
+static int g_result_view = 0;
+
+/* Checkpoints found on the devices being started */
+static JournalRecord g_resume_rec[F3V_MAX_DEVICES];
+static int g_resume_valid[F3V_MAX_DEVICES];
+static int g_resume_view = 0;
+static uint8_t g_check_buf[F3V_BLOCK_SIZE];
 
 /* Forward declarations */
 static void state_menu(void);
-static void state_write(void);
-static void state_verify(void);
+static void state_resume(void);
+static void state_run(void);
 static void state_results(void);
 static void state_cleanup(void);
 
@@ -44,8 +260,18 @@ int main(void)
     /* Enumerate storage devices */
     g_device_count = f3v_enumerate_storage(g_devices, F3V_MAX_DEVICES);
 
-    /* Clear context */
-    memset(&g_ctx, 0, sizeof(g_ctx));
+    /* Apply the default scheduling profile to the UI thread */
+    f3v_profile_set((SchedProfile)g_option[OPT_PROFILE]);
+
+    /* Start pattern kernel helpers (falls back to inline on failure) */
+    f3v_pool_init(F3V_POOL_THREADS);
+
+    /* Lock for live read-back totals (read-back is off without it) */
+    f3v_readback_init();
+
+    /* Clear sessions */
+    memset(g_sessions, 0, sizeof(g_sessions));
+    memset(g_marked, 0, sizeof(g_marked));
 
     /* Main loop */
     while (g_state != STATE_EXIT)
@@ -62,11 +288,11 @@ int main(void)
         case STATE_MENU:
             state_menu();
             break;
-        case STATE_WRITE:
-            state_write();
+        case STATE_RESUME:
+            state_resume();
             break;
-        case STATE_VERIFY:
-            state_verify();
+        case STATE_RUN:
+            state_run();
             break;
         case STATE_RESULTS:
             state_results();
@@ -84,10 +310,369 @@ int main(void)
     }
 
     /* Clean exit */
+    f3v_pool_shutdown();
+    f3v_readback_shutdown();
     sceKernelExitProcess(0);
     return 0;
 }
 
+/**
+ * Small-file tree shape from the Tree and Sizes settings
+ */
+static void selected_tree(FsTreeShape *shape)
+{
+    memset(shape, 0, sizeof(*shape));
+    shape->fanout = g_tree[g_option[OPT_TREE]].fanout;
+    shape->depth = g_tree[g_option[OPT_TREE]].depth;
+    shape->files_per_dir = g_tree[g_option[OPT_TREE]].files_per_dir;
+    shape->bucket_count = g_sizes[g_option[OPT_SIZES]].bucket_count;
+    memcpy(shape->bucket, g_sizes[g_option[OPT_SIZES]].bucket, sizeof(shape->bucket));
+}
+
+/**
+ * Whether the selected mode uses a setting row (the others are hidden)
+ */
+static int option_used(int opt)
+{
+    int mode = g_option[OPT_MODE];
+    int verifies = mode == MODE_FULL || mode == MODE_VERIFY_ONLY || mode == MODE_BURNIN ||
+                   mode == MODE_CONFORM ||
+                   (mode == MODE_WIPE && g_wipe[g_option[OPT_WIPE]].verify);
+
+    switch (opt)
+    {
+    case OPT_READBACK:
+        return mode == MODE_FULL;
+    case OPT_ORDER:
+        return verifies;
+    case OPT_ABORT:
+        return verifies || mode == MODE_SAMPLE;
+    case OPT_RATE:
+    case OPT_BURST:
+        /* Modes that measure the card run unthrottled (the prefill as well,
+           so it does not skew what follows); conformance shows Rate as off */
+        return mode == MODE_FULL || mode == MODE_VERIFY_ONLY || mode == MODE_RETEST ||
+               mode == MODE_SAMPLE || mode == MODE_BURNIN || mode == MODE_WIPE ||
+               mode == MODE_ROTSCAN || mode == MODE_SURFACE;
+    case OPT_PASSES:
+    case OPT_MARGIN:
+        return mode == MODE_RETEST;
+    case OPT_SAMPLE:
+        return mode == MODE_SAMPLE;
+    case OPT_BURNIN:
+        return mode == MODE_BURNIN;
+    case OPT_DEPTH:
+        return mode == MODE_BENCH;
+    case OPT_STREAMS:
+        return mode == MODE_STREAMS;
+    case OPT_CLASS:
+        return mode == MODE_CONFORM;
+    case OPT_MIX:
+        return mode == MODE_MIXED;
+    case OPT_TREE:
+    case OPT_SIZES:
+        return mode == MODE_FSTREE;
+    case OPT_WIPE:
+        return mode == MODE_WIPE;
+    case OPT_SCAN:
+        return mode == MODE_ROTSCAN || mode == MODE_SURFACE;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Release the prepared sessions when they will not run after all
+ */
+static void discard_sessions(void)
+{
+    for (int i = 0; i < g_session_count; i++)
+    {
+        f3v_session_discard(&g_sessions[i]);
+    }
+    g_session_count = 0;
+}
+
+/**
+ * Prepare sessions on the marked devices (or the highlighted one)
+ * @return 0 on success, negative on error
+ */
+static int start_sessions(void)
+{
+    FsTreeShape shape;
+    int any_marked = 0;
+
+    for (int i = 0; i < g_device_count; i++)
+    {
+        any_marked |= g_marked[i];
+    }
+    selected_tree(&shape);
+
+    g_session_count = 0;
+    memset(g_sessions, 0, sizeof(g_sessions));
+
+    for (int i = 0; i < g_device_count; i++)
+    {
+        if (any_marked ? !g_marked[i] : i != g_selected_device)
+        {
+            continue;
+        }
+
+        TestContext *ctx = &g_sessions[g_session_count];
+        int ret;
+
+        /* Create test directory and reset the session (the other modes
+           pick up files or failed regions of an earlier run instead) */
+        switch (g_option[OPT_MODE])
+        {
+        case MODE_VERIFY_ONLY:
+            ret = f3v_session_start_verify(ctx, &g_devices[i]);
+            break;
+        case MODE_RETEST:
+            ret = f3v_session_start_retest(ctx, &g_devices[i], g_passes[g_option[OPT_PASSES]],
+                                           g_margin[g_option[OPT_MARGIN]]);
+            break;
+        case MODE_SAMPLE:
+            ret = f3v_session_start_sample(ctx, &g_devices[i],
+                                           g_sample[g_option[OPT_SAMPLE]].budget_sec,
+                                           g_sample[g_option[OPT_SAMPLE]].target_ppm);
+            break;
+        case MODE_BURNIN:
+            ret = f3v_session_start_burnin(ctx, &g_devices[i],
+                                           g_burnin[g_option[OPT_BURNIN]].passes,
+                                           g_burnin[g_option[OPT_BURNIN]].duration_sec);
+            break;
+        case MODE_BENCH:
+            ret = f3v_session_start_bench(ctx, &g_devices[i], g_depth[g_option[OPT_DEPTH]]);
+            break;
+        case MODE_STREAMS:
+            ret = f3v_session_start_streams(ctx, &g_devices[i], g_streams[g_option[OPT_STREAMS]]);
+            break;
+        case MODE_DISCOVER:
+            ret = f3v_session_start_discover(ctx, &g_devices[i]);
+            break;
+        case MODE_ALIGN:
+            ret = f3v_session_start_align(ctx, &g_devices[i]);
+            break;
+        case MODE_CONFORM:
+            ret = f3v_session_start_conform(ctx, &g_devices[i], g_class[g_option[OPT_CLASS]].mbps);
+            break;
+        case MODE_MIXED:
+            ret = f3v_session_start_mixed(ctx, &g_devices[i], g_mix[g_option[OPT_MIX]]);
+            break;
+        case MODE_FSTREE:
+            ret = f3v_session_start_fstree(ctx, &g_devices[i], &shape);
+            break;
+        case MODE_WIPE:
+            ret = f3v_session_start_wipe(ctx, &g_devices[i], g_wipe[g_option[OPT_WIPE]].fill,
+                                         g_wipe[g_option[OPT_WIPE]].verify);
+            break;
+        case MODE_ROTSCAN:
+            ret = f3v_session_start_rotscan(ctx, &g_devices[i], g_scan[g_option[OPT_SCAN]].subdir);
+            break;
+        case MODE_SURFACE:
+            ret = f3v_session_start_surface(ctx, &g_devices[i], g_scan[g_option[OPT_SCAN]].subdir);
+            break;
+        default:
+            ret = f3v_session_start(ctx, &g_devices[i]);
+            break;
+        }
+        if (ret < 0)
+        {
+            discard_sessions();
+            return -1;
+        }
+        /* Settings the mode does not use (hidden in the menu) stay at their defaults */
+        ctx->profile = g_option[OPT_PROFILE];
+        ctx->readback =
+            option_used(OPT_READBACK) ? (ReadbackMode)g_option[OPT_READBACK] : READBACK_OFF;
+        ctx->verify_order =
+            option_used(OPT_ORDER) ? (VerifyOrder)g_option[OPT_ORDER] : ORDER_SEQUENTIAL;
+        ctx->verify_seed = ctx->session_nonce;
+        if (option_used(OPT_ABORT))
+        {
+            ctx->abort_policy = g_abort[g_option[OPT_ABORT]].policy;
+            ctx->abort_param = g_abort[g_option[OPT_ABORT]].param;
+        }
+        else
+        {
+            ctx->abort_policy = ABORT_NEVER;
+            ctx->abort_param = 0;
+        }
+        f3v_throttle_init(&ctx->throttle,
+                          option_used(OPT_RATE) ? g_rate_mbps[g_option[OPT_RATE]] : 0,
+                          g_burst_mb[g_option[OPT_BURST]]);
+
+        /* Look for an interrupted run whose files are still intact */
+        g_resume_valid[g_session_count] = 0;
+        if (ctx->mode == MODE_FULL)
+        {
+            JournalRecord *rec = &g_resume_rec[g_session_count];
+            g_resume_valid[g_session_count] = f3v_journal_load(ctx, rec) == 0 &&
+                                              f3v_journal_check(ctx, rec, g_check_buf) == 0;
+            if (!g_resume_valid[g_session_count])
+            {
+                f3v_journal_clear(ctx);
+            }
+        }
+        g_session_count++;
+    }
+
+    return 0;
+}
+
+/**
+ * Hand the prepared sessions to the engine and enter the run state
+ */
+static void launch_sessions(void)
+{
+    if (f3v_engine_start(g_sessions, g_session_count) < 0)
+    {
+        discard_sessions();
+        f3v_ui_error("Failed to start worker threads!");
+        f3v_ui_wait_button(F3V_BTN_ANY);
+        g_state = STATE_MENU;
+        return;
+    }
+
+    g_frame_last = f3v_get_time_usec();
+    g_frame_total = 0;
+    g_frame_count = 0;
+    g_frame_max = 0;
+
+    g_state = STATE_RUN;
+}
+
+/**
+ * Fill the setting rows shown under the device list
+ */
+static void build_options(MenuOption *options)
+{
+    options[OPT_MODE].label = "Mode:";
+    options[OPT_MODE].value = g_mode_names[g_option[OPT_MODE]];
+
+    options[OPT_READBACK].label = "Readback:";
+    options[OPT_READBACK].value = g_readback_names[g_option[OPT_READBACK]];
+
+    options[OPT_ORDER].label = "Order:";
+    options[OPT_ORDER].value = f3v_order_name((VerifyOrder)g_option[OPT_ORDER]);
+
+    options[OPT_ABORT].label = "Abort:";
+    f3v_format_abort(g_abort[g_option[OPT_ABORT]].policy, g_abort[g_option[OPT_ABORT]].param,
+                     g_option_text[OPT_ABORT], sizeof(g_option_text[OPT_ABORT]));
+    options[OPT_ABORT].value = g_option_text[OPT_ABORT];
+
+    options[OPT_PROFILE].label = "Profile:";
+    options[OPT_PROFILE].value = f3v_profile_name((SchedProfile)g_option[OPT_PROFILE]);
+
+    options[OPT_RATE].label = "Rate:";
+    if (g_rate_mbps[g_option[OPT_RATE]] == 0)
+    {
+        snprintf(g_option_text[OPT_RATE], sizeof(g_option_text[OPT_RATE]), "Unlimited");
+    }
+    else
+    {
+        snprintf(g_option_text[OPT_RATE], sizeof(g_option_text[OPT_RATE]), "%u MB/s",
+                 g_rate_mbps[g_option[OPT_RATE]]);
+    }
+    options[OPT_RATE].value = g_option_text[OPT_RATE];
+
+    options[OPT_BURST].label = "Burst:";
+    snprintf(g_option_text[OPT_BURST], sizeof(g_option_text[OPT_BURST]), "%u MB",
+             g_burst_mb[g_option[OPT_BURST]]);
+    options[OPT_BURST].value = g_option_text[OPT_BURST];
+
+    options[OPT_PASSES].label = "Passes:";
+    snprintf(g_option_text[OPT_PASSES], sizeof(g_option_text[OPT_PASSES]), "%u",
+             g_passes[g_option[OPT_PASSES]]);
+    options[OPT_PASSES].value = g_option_text[OPT_PASSES];
+
+    options[OPT_MARGIN].label = "Margin:";
+    snprintf(g_option_text[OPT_MARGIN], sizeof(g_option_text[OPT_MARGIN]), "%u blocks",
+             g_margin[g_option[OPT_MARGIN]]);
+    options[OPT_MARGIN].value = g_option_text[OPT_MARGIN];
+
+    options[OPT_SAMPLE].label = "Sample:";
+    if (g_sample[g_option[OPT_SAMPLE]].budget_sec > 0)
+    {
+        snprintf(g_option_text[OPT_SAMPLE], sizeof(g_option_text[OPT_SAMPLE]), "%u min",
+                 g_sample[g_option[OPT_SAMPLE]].budget_sec / 60);
+    }
+    else
+    {
+        uint32_t ppm = g_sample[g_option[OPT_SAMPLE]].target_ppm;
+        snprintf(g_option_text[OPT_SAMPLE], sizeof(g_option_text[OPT_SAMPLE]),
+                 "95%% sure <%u.%02u%% bad", ppm / 10000, (ppm / 100) % 100);
+    }
+    options[OPT_SAMPLE].value = g_option_text[OPT_SAMPLE];
+
+    options[OPT_BURNIN].label = "Burn-in:";
+    if (g_burnin[g_option[OPT_BURNIN]].passes > 0)
+    {
+        snprintf(g_option_text[OPT_BURNIN], sizeof(g_option_text[OPT_BURNIN]), "%u passes",
+                 g_burnin[g_option[OPT_BURNIN]].passes);
+    }
+    else
+    {
+        snprintf(g_option_text[OPT_BURNIN], sizeof(g_option_text[OPT_BURNIN]), "%u hours",
+                 g_burnin[g_option[OPT_BURNIN]].duration_sec / 3600);
+    }
+    options[OPT_BURNIN].value = g_option_text[OPT_BURNIN];
+
+    options[OPT_DEPTH].label = "Depth:";
+    snprintf(g_option_text[OPT_DEPTH], sizeof(g_option_text[OPT_DEPTH]), "Up to QD %u",
+             g_depth[g_option[OPT_DEPTH]]);
+    options[OPT_DEPTH].value = g_option_text[OPT_DEPTH];
+
+    options[OPT_STREAMS].label = "Streams:";
+    snprintf(g_option_text[OPT_STREAMS], sizeof(g_option_text[OPT_STREAMS]), "1 to %u",
+             g_streams[g_option[OPT_STREAMS]]);
+    options[OPT_STREAMS].value = g_option_text[OPT_STREAMS];
+
+    options[OPT_CLASS].label = "Class:";
+    snprintf(g_option_text[OPT_CLASS], sizeof(g_option_text[OPT_CLASS]), "%s (%u MB/s)",
+             g_class[g_option[OPT_CLASS]].name, g_class[g_option[OPT_CLASS]].mbps);
+    options[OPT_CLASS].value = g_option_text[OPT_CLASS];
+
+    options[OPT_MIX].label = "Mix:";
+    snprintf(g_option_text[OPT_MIX], sizeof(g_option_text[OPT_MIX]), "%u%% read / %u%% write",
+             g_mix[g_option[OPT_MIX]], 100 - g_mix[g_option[OPT_MIX]]);
+    options[OPT_MIX].value = g_option_text[OPT_MIX];
+
+    FsTreeShape shape;
+    selected_tree(&shape);
+    options[OPT_TREE].label = "Tree:";
+    snprintf(g_option_text[OPT_TREE], sizeof(g_option_text[OPT_TREE]), "%u dirs, %u files",
+             f3v_fstree_dirs(&shape), f3v_fstree_dirs(&shape) * shape.files_per_dir);
+    options[OPT_TREE].value = g_option_text[OPT_TREE];
+
+    options[OPT_SIZES].label = "Sizes:";
+    options[OPT_SIZES].value = g_sizes[g_option[OPT_SIZES]].name;
+
+    options[OPT_WIPE].label = "Wipe:";
+    snprintf(g_option_text[OPT_WIPE], sizeof(g_option_text[OPT_WIPE]), "%s, %s",
+             f3v_wipe_fill_name(g_wipe[g_option[OPT_WIPE]].fill),
+             g_wipe[g_option[OPT_WIPE]].verify ? "verify" : "no verify");
+    options[OPT_WIPE].value = g_option_text[OPT_WIPE];
+
+    options[OPT_SCAN].label = "Scan:";
+    options[OPT_SCAN].value = g_scan[g_option[OPT_SCAN]].name;
+
+    for (int i = 0; i < OPT_COUNT; i++)
+    {
+        options[i].hidden = !option_used(i);
+        options[i].fixed = 0;
+    }
+    if (g_option[OPT_MODE] == MODE_CONFORM)
+    {
+        /* A rate limit would hold the conformance windows down: say so
+           rather than drop the user's setting silently */
+        options[OPT_RATE].value = "Off (conformance)";
+        options[OPT_RATE].hidden = 0;
+        options[OPT_RATE].fixed = 1;
+    }
+}
+
 /**
  * Storage selection menu state
  */
@@ -109,48 +694,64 @@ static void state_menu(void)
         return;
     }
 
-    f3v_ui_menu(g_devices, g_device_count, g_selected_device);
-    f3v_ui_prompt("D-Pad: Select | X: Start Test | O: Exit");
+    MenuOption options[OPT_COUNT];
+    build_options(options);
+
+    f3v_ui_menu(g_devices, g_device_count, g_menu_cursor, g_marked, options, OPT_COUNT);
+    f3v_ui_prompt("D-Pad: Select/Change | []: Mark | X: Start Test | O: Exit");
 
     /* Handle input */
     uint32_t btn = f3v_ui_read_buttons();
 
-    if (btn & F3V_BTN_UP)
+    /* Up/Down step over the rows the mode hides or sets itself */
+    int step = (btn & F3V_BTN_DOWN) ? 1 : (btn & F3V_BTN_UP) ? -1 : 0;
+    if (step != 0)
     {
-        if (g_selected_device > 0)
+        int next = g_menu_cursor + step;
+        while (next >= g_device_count && next < g_device_count + OPT_COUNT &&
+               (options[next - g_device_count].hidden || options[next - g_device_count].fixed))
+        {
+            next += step;
+        }
+        if (next >= 0 && next < g_device_count + OPT_COUNT)
         {
-            g_selected_device--;
+            g_menu_cursor = next;
         }
     }
-    if (btn & F3V_BTN_DOWN)
+    if (g_menu_cursor < g_device_count)
+    {
+        g_selected_device = g_menu_cursor;
+    }
+
+    /* Left/Right change the setting under the cursor */
+    int delta = (btn & F3V_BTN_RIGHT) ? 1 : (btn & F3V_BTN_LEFT) ? -1 : 0;
+    int opt = g_menu_cursor - g_device_count;
+    if (delta != 0 && opt >= 0 && !options[opt].hidden && !options[opt].fixed)
     {
-        if (g_selected_device < g_device_count - 1)
+        g_option[opt] = (g_option[opt] + g_option_choices[opt] + delta) % g_option_choices[opt];
+
+        if (opt == OPT_PROFILE)
         {
-            g_selected_device++;
+            f3v_profile_set((SchedProfile)g_option[OPT_PROFILE]);
         }
     }
+
+    if ((btn & F3V_BTN_SQUARE) && g_menu_cursor < g_device_count)
+    {
+        g_marked[g_selected_device] = !g_marked[g_selected_device];
+    }
     if (btn & F3V_BTN_CROSS)
     {
-        /* Start test on selected device */
-        memset(&g_ctx, 0, sizeof(g_ctx));
-        g_ctx.target = g_devices[g_selected_device];
-
-        /* Create test directory */
-        if (f3v_create_test_dir(&g_ctx) < 0)
+        /* Start test on selected devices */
+        if (start_sessions() < 0)
         {
-            f3v_ui_error("Failed to create test directory!");
+            f3v_ui_error(g_mode_errors[g_option[OPT_MODE]]);
             f3v_ui_wait_button(F3V_BTN_ANY);
             return;
         }
 
-        /* Initialize test */
-        g_ctx.total_expected = g_ctx.target.free_bytes;
-        g_ctx.start_time = f3v_get_time_usec();
-        g_ctx.phase_start_time = g_ctx.start_time;
-        g_ctx.files_written = 0;
-        g_ctx.bytes_written = 0;
-
-        g_state = STATE_WRITE;
+        g_resume_view = 0;
+        g_state = STATE_RESUME;
     }
     if (btn & F3V_BTN_CIRCLE)
     {
@@ -159,214 +760,223 @@ static void state_menu(void)
 }
 
 /**
- * Write phase state - write test patterns to storage
+ * Resume state - ask per device whether to continue an interrupted run
  */
-static void state_write(void)
+static void state_resume(void)
 {
-    uint32_t elapsed = (uint32_t)((f3v_get_time_usec() - g_ctx.phase_start_time) / 1000000);
-
-    /* Draw progress */
-    f3v_ui_header("f3vita - Writing");
-    f3v_ui_progress("WRITE",
-                    g_ctx.bytes_written / (1024 * 1024),
-                    g_ctx.total_expected / (1024 * 1024),
-                    0, elapsed);
-    f3v_ui_prompt("Press O to cancel");
-
-    /* Check for cancel */
-    uint32_t btn = f3v_ui_read_buttons();
-    if (btn & F3V_BTN_CIRCLE)
+    /* Skip devices without a usable checkpoint */
+    while (g_resume_view < g_session_count && !g_resume_valid[g_resume_view])
     {
-        g_ctx.cancelled = 1;
-        g_state = STATE_RESULTS;
-        return;
+        g_resume_view++;
     }
 
-    /* Check if we have space */
-    if (!f3v_has_space(&g_ctx))
+    if (g_resume_view >= g_session_count)
     {
-        /* Disk full - transition to verify */
-        g_ctx.phase_start_time = f3v_get_time_usec();
-        g_ctx.current_file = 1;
-        g_ctx.current_block = 0;
-        g_ctx.bytes_verified = 0;
-        g_state = STATE_VERIFY;
+        launch_sessions();
         return;
     }
 
-    /* Calculate current file and block */
-    uint32_t file_idx = (uint32_t)(g_ctx.bytes_written / F3V_FILE_SIZE) + 1;
-    uint32_t block_idx = (uint32_t)((g_ctx.bytes_written % F3V_FILE_SIZE) / F3V_BLOCK_SIZE);
+    TestContext *ctx = &g_sessions[g_resume_view];
+    JournalRecord *rec = &g_resume_rec[g_resume_view];
 
-    /* Open new file if needed */
-    static int fd = -1;
-    static uint32_t current_file_idx = 0;
+    f3v_ui_header("f3vita - Resume Test");
+    f3v_ui_resume(ctx, rec);
+    f3v_ui_prompt("X: Resume | []: Start fresh | O: Back");
 
-    if (file_idx != current_file_idx)
-    {
-        /* Close previous file if open */
-        if (fd >= 0)
-        {
-            f3v_close(fd);
-        }
-
-        /* Open new file */
-        char filename[128];
-        f3v_get_test_filename(&g_ctx, file_idx, filename, sizeof(filename));
-        fd = f3v_open_write(filename);
-
-        if (fd < 0)
-        {
-            /* Write error - transition to verify */
-            g_ctx.phase_start_time = f3v_get_time_usec();
-            g_ctx.current_file = 1;
-            g_ctx.current_block = 0;
-            g_ctx.bytes_verified = 0;
-            g_state = STATE_VERIFY;
-            return;
-        }
+    uint32_t btn = f3v_ui_read_buttons();
 
-        current_file_idx = file_idx;
-        g_ctx.files_written = file_idx;
+    if (btn & F3V_BTN_CROSS)
+    {
+        f3v_journal_apply(ctx, rec);
+        g_resume_view++;
     }
-
-    /* Generate pattern for this block */
-    f3v_fill_pattern(g_buffer, file_idx, block_idx);
-
-    /* Write block */
-    int written = f3v_write_block(fd, g_buffer, F3V_BLOCK_SIZE);
-
-    if (written <= 0)
+    else if (btn & F3V_BTN_SQUARE)
     {
-        /* Write error or disk full */
-        f3v_close(fd);
-        fd = -1;
-        current_file_idx = 0;
-
-        g_ctx.phase_start_time = f3v_get_time_usec();
-        g_ctx.current_file = 1;
-        g_ctx.current_block = 0;
-        g_ctx.bytes_verified = 0;
-        g_state = STATE_VERIFY;
-        return;
+        f3v_journal_clear(ctx);
+        g_resume_view++;
+    }
+    else if (btn & F3V_BTN_CIRCLE)
+    {
+        discard_sessions();
+        g_state = STATE_MENU;
     }
-
-    g_ctx.bytes_written += written;
 }
 
 /**
- * Verify phase state - read back and verify test patterns
+ * Show the run header, with the pass number during burn-in
  */
-static void state_verify(void)
+static void run_header(const TestContext *ctx, const char *action)
 {
-    uint32_t elapsed = (uint32_t)((f3v_get_time_usec() - g_ctx.phase_start_time) / 1000000);
-
-    /* Draw progress */
-    f3v_ui_header("f3vita - Verifying");
-    f3v_ui_progress("VERIFY",
-                    g_ctx.bytes_verified / (1024 * 1024),
-                    g_ctx.bytes_written / (1024 * 1024),
-                    g_ctx.bytes_corrupted, elapsed);
-    f3v_ui_prompt("Press O to cancel");
+    char title[64];
 
-    /* Check for cancel */
-    uint32_t btn = f3v_ui_read_buttons();
-    if (btn & F3V_BTN_CIRCLE)
+    if (ctx->mode == MODE_BURNIN)
     {
-        g_ctx.cancelled = 1;
-        g_state = STATE_RESULTS;
-        return;
+        snprintf(title, sizeof(title), "f3vita - Burn-in Pass %u: %s", ctx->run.burn.pass + 1,
+                 action);
     }
-
-    /* Check if verification complete */
-    if (g_ctx.bytes_verified >= g_ctx.bytes_written)
+    else if (ctx->mode == MODE_WIPE)
     {
-        g_ctx.end_time = f3v_get_time_usec();
-        g_state = STATE_RESULTS;
-        return;
+        snprintf(title, sizeof(title), "f3vita - Wipe: %s", action);
     }
+    else
+    {
+        snprintf(title, sizeof(title), "f3vita - %s", action);
+    }
+    f3v_ui_header(title);
+}
 
-    /* Calculate current file and block */
-    uint32_t file_idx = (uint32_t)(g_ctx.bytes_verified / F3V_FILE_SIZE) + 1;
-    uint32_t block_idx = (uint32_t)((g_ctx.bytes_verified % F3V_FILE_SIZE) / F3V_BLOCK_SIZE);
-
-    /* Open file if needed */
-    static int fd = -1;
-    static uint32_t current_file_idx = 0;
-
-    if (file_idx != current_file_idx)
+/**
+ * Run state - show progress while the engine tests all sessions
+ */
+static void state_run(void)
+{
+    /* Track frame-to-frame time: long frames mean late input sampling */
+    uint64_t now = f3v_get_time_usec();
+    uint32_t frame = (uint32_t)(now - g_frame_last);
+    g_frame_last = now;
+    g_frame_total += frame;
+    g_frame_count++;
+    if (frame > g_frame_max)
     {
-        /* Close previous file if open */
-        if (fd >= 0)
-        {
-            f3v_close(fd);
-        }
+        g_frame_max = frame;
+    }
 
-        /* Open file for reading */
-        char filename[128];
-        f3v_get_test_filename(&g_ctx, file_idx, filename, sizeof(filename));
-        fd = f3v_open_read(filename);
+    if (g_session_count == 1)
+    {
+        /* Single device: full progress screen */
+        TestContext *ctx = &g_sessions[0];
+        uint32_t elapsed = (uint32_t)((f3v_get_time_usec() - ctx->phase_start_time) / 1000000);
 
-        if (fd < 0)
+        if (ctx->phase == PHASE_WRITE)
         {
-            /* Read error - count entire remaining file as corrupted */
-            uint64_t remaining = g_ctx.bytes_written - g_ctx.bytes_verified;
-            g_ctx.bytes_corrupted += remaining;
-            g_ctx.bytes_verified = g_ctx.bytes_written;
-
-            if (!g_ctx.has_first_error)
+            run_header(ctx, "Writing");
+            f3v_ui_progress("WRITE",
+                            ctx->bytes_written / (1024 * 1024),
+                            ctx->total_expected / (1024 * 1024),
+                            0, elapsed);
+
+            /* Second stream: blocks or files checked behind the writer */
+            if (ctx->readback != READBACK_OFF)
             {
-                g_ctx.has_first_error = 1;
-                g_ctx.first_error_file = file_idx;
-                g_ctx.first_error_block = block_idx;
-                g_ctx.first_error_offset = 0;
+                ReadbackTotals raw;
+                f3v_readback_totals(ctx, &raw);
+                f3v_ui_progress(ctx->readback == READBACK_FILE ? "VERIFY (per file)" : "READBACK",
+                                raw.verified / (1024 * 1024),
+                                ctx->bytes_written / (1024 * 1024),
+                                raw.corrupted, elapsed);
+            }
+            if (ctx->mode == MODE_CONFORM)
+            {
+                f3v_ui_conform(ctx);
+            }
+            if (ctx->mode == MODE_WIPE)
+            {
+                f3v_ui_wipe(ctx);
             }
-
-            g_ctx.end_time = f3v_get_time_usec();
-            g_state = STATE_RESULTS;
-            return;
         }
-
-        current_file_idx = file_idx;
+        else if (ctx->phase == PHASE_SAMPLE)
+        {
+            f3v_ui_header("f3vita - Sampling");
+            f3v_ui_progress("SAMPLE",
+                            ctx->bytes_verified / (1024 * 1024),
+                            ctx->total_expected / (1024 * 1024),
+                            ctx->bytes_corrupted, elapsed);
+        }
+        else if (ctx->phase == PHASE_STREAMS)
+        {
+            f3v_ui_header("f3vita - Parallel Streams");
+            f3v_ui_streams(ctx);
+        }
+        else if (ctx->phase == PHASE_ALIGN)
+        {
+            f3v_ui_header("f3vita - Alignment Grid");
+            f3v_ui_align(ctx);
+        }
+        else if (ctx->phase == PHASE_DISCOVER)
+        {
+            f3v_ui_header("f3vita - Discovery");
+            f3v_ui_discover(ctx);
+        }
+        else if (ctx->phase == PHASE_MIXED)
+        {
+            f3v_ui_header("f3vita - Mixed Workload");
+            f3v_ui_mixed(ctx);
+        }
+        else if (ctx->phase == PHASE_FSTREE)
+        {
+            f3v_ui_header("f3vita - Small Files");
+            f3v_ui_fstree(ctx);
+        }
+        else if (ctx->phase == PHASE_ROTSCAN)
+        {
+            f3v_ui_header(ctx->mode == MODE_SURFACE ? "f3vita - Surface Scan"
+                                                    : "f3vita - Bit-rot Scan");
+            f3v_ui_rotscan(ctx);
+        }
+        else if (ctx->phase == PHASE_BENCH)
+        {
+            f3v_ui_header("f3vita - Benchmark");
+            f3v_ui_bench(ctx);
+        }
+        else if (ctx->phase == PHASE_RETEST)
+        {
+            f3v_ui_header("f3vita - Re-testing Failed Regions");
+            f3v_ui_progress("RETEST",
+                            ctx->bytes_verified / (1024 * 1024),
+                            ctx->total_expected / (1024 * 1024),
+                            ctx->bytes_corrupted, elapsed);
+        }
+        else
+        {
+            run_header(ctx, "Verifying");
+            f3v_ui_progress("VERIFY",
+                            ctx->bytes_verified / (1024 * 1024),
+                            ctx->bytes_written / (1024 * 1024),
+                            ctx->bytes_corrupted, elapsed);
+        }
+    }
+    else
+    {
+        /* Several devices: one row each */
+        f3v_ui_header("f3vita - Testing");
+        f3v_ui_sessions(g_sessions, g_session_count);
     }
 
-    /* Read block */
-    int bytes_read = f3v_read_block(fd, g_buffer, F3V_BLOCK_SIZE);
+    char prompt[64];
+    snprintf(prompt, sizeof(prompt), "Profile: %s | Press O to cancel", f3v_profile_name((SchedProfile)g_option[OPT_PROFILE]));
+    f3v_ui_prompt(prompt);
 
-    if (bytes_read <= 0)
+    /* Check for cancel */
+    uint32_t btn = f3v_ui_read_buttons();
+    if (btn & F3V_BTN_CIRCLE)
     {
-        /* Read error - count as corrupted */
-        g_ctx.bytes_corrupted += F3V_BLOCK_SIZE;
-        g_ctx.bytes_verified += F3V_BLOCK_SIZE;
-
-        if (!g_ctx.has_first_error)
-        {
-            g_ctx.has_first_error = 1;
-            g_ctx.first_error_file = file_idx;
-            g_ctx.first_error_block = block_idx;
-            g_ctx.first_error_offset = 0;
-        }
-        return;
+        f3v_engine_cancel();
     }
 
-    /* Verify pattern */
-    uint32_t first_offset = 0;
-    uint32_t corrupted = f3v_verify_pattern(g_buffer, file_idx, block_idx, &first_offset);
-
-    if (corrupted > 0)
+    /* All sessions finished (or cancelled) */
+    if (!f3v_engine_busy())
     {
-        g_ctx.bytes_corrupted += corrupted;
+        f3v_engine_stop();
 
-        if (!g_ctx.has_first_error)
+        for (int i = 0; i < g_session_count; i++)
         {
-            g_ctx.has_first_error = 1;
-            g_ctx.first_error_file = file_idx;
-            g_ctx.first_error_block = block_idx;
-            g_ctx.first_error_offset = first_offset;
+            g_sessions[i].ui_frame_avg_us = (uint32_t)(g_frame_total / g_frame_count);
+            g_sessions[i].ui_frame_max_us = g_frame_max;
         }
+
+        g_result_view = 0;
+        g_state = STATE_RESULTS;
     }
+}
 
-    g_ctx.bytes_verified += bytes_read;
+/**
+ * Whether a session left test files for the cleanup to delete (scans, the
+ * file tree and stream rounds write none or remove their own, a wipe
+ * cleans up after itself)
+ */
+static int has_test_files(const TestContext *ctx)
+{
+    return ctx->files_written > 0 && ctx->mode != MODE_WIPE;
 }
 
 /**
@@ -374,35 +984,62 @@ static void state_verify(void)
  */
 static void state_results(void)
 {
-    TestResult result;
+    TestContext *ctx = &g_sessions[g_result_view];
+    TestResult result = f3v_session_result(ctx);
 
-    if (g_ctx.cancelled)
+    if (g_session_count > 1)
     {
-        result = RESULT_CANCELLED;
+        char title[64];
+        snprintf(title, sizeof(title), "f3vita - Results: %s (%d/%d)",
+                 ctx->target.path, g_result_view + 1, g_session_count);
+        f3v_ui_header(title);
     }
-    else if (g_ctx.bytes_corrupted > 0)
+    else
     {
-        result = RESULT_FAIL;
+        f3v_ui_header("f3vita - Results");
     }
-    else
+    f3v_ui_results(ctx, result);
+
+    int any_files = 0;
+    for (int i = 0; i < g_session_count; i++)
     {
-        result = RESULT_PASS;
+        any_files |= has_test_files(&g_sessions[i]);
     }
 
-    f3v_ui_header("f3vita - Results");
-    f3v_ui_results(&g_ctx, result);
-    f3v_ui_prompt("X: Clean up files | O: Keep files & exit");
+    if (g_session_count > 1)
+    {
+        f3v_ui_prompt(any_files ? "L/R: Device | X: Clean up files | O: Keep files & exit"
+                                : "L/R: Device | O: Exit");
+    }
+    else
+    {
+        f3v_ui_prompt(any_files ? "X: Clean up files | O: Keep files & exit" : "O: Exit");
+    }
 
     uint32_t btn = f3v_ui_read_buttons();
 
-    if (btn & F3V_BTN_CROSS)
+    if (btn & F3V_BTN_LEFT)
+    {
+        g_result_view = (g_result_view + g_session_count - 1) % g_session_count;
+    }
+    if (btn & F3V_BTN_RIGHT)
     {
-        g_ctx.cleanup_requested = 1;
+        g_result_view = (g_result_view + 1) % g_session_count;
+    }
+    if ((btn & F3V_BTN_CROSS) && any_files)
+    {
+        for (int i = 0; i < g_session_count; i++)
+        {
+            g_sessions[i].cleanup_requested = has_test_files(&g_sessions[i]);
+        }
         g_state = STATE_CLEANUP;
     }
     if (btn & F3V_BTN_CIRCLE)
     {
-        g_ctx.cleanup_requested = 0;
+        for (int i = 0; i < g_session_count; i++)
+        {
+            g_sessions[i].cleanup_requested = 0;
+        }
         g_state = STATE_EXIT;
     }
 }
@@ -416,7 +1053,17 @@ static void state_cleanup(void)
     f3v_ui_prompt("Deleting test files...");
     f3v_ui_swap(); /* Show message immediately */
 
-    int deleted = f3v_cleanup_files(&g_ctx);
+    int deleted = 0;
+    for (int i = 0; i < g_session_count; i++)
+    {
+        /* A kept run's files, log, fail list and journal stay */
+        if (!has_test_files(&g_sessions[i]))
+        {
+            continue;
+        }
+        f3v_journal_clear(&g_sessions[i]);
+        deleted += f3v_cleanup_files(&g_sessions[i]);
+    }
 
     f3v_ui_clear();
     f3v_ui_header("f3vita - Cleanup Complete");
@@ -434,4 +1081,4 @@ static void state_cleanup(void)
 
     f3v_ui_wait_button(F3V_BTN_ANY);
     g_state = STATE_EXIT;
-}
\ No newline at end of file
+}
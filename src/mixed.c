@@ -0,0 +1,495 @@
+/**
+ * @file mixed.c
+ * @brief Random reads under a concurrent sequential write stream
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mixed.h"
+#include "pattern.h"
+#include "pool.h"
+#include "profile.h"
+#include "stats.h"
+#include "storage.h"
+#include "thread.h"
+#include "ui.h"
+
+/* Test file written by the write stream */
+#define MIXED_WRITE_FILE 2
+
+/* One thread: the random reader or the sequential writer */
+typedef struct {
+    struct MixedState *state;
+    F3vThread thread;
+    int fd;
+    uint8_t *buf;
+    uint64_t rng;
+
+    /* Written by the thread, read by the other thread and the session step */
+    volatile uint32_t ops;
+
+    /* Owned by the thread until it is joined */
+    LatencyHist hist;
+    uint32_t bad;
+    uint64_t corrupted;     /* Bytes not matching, or lost to failed transfers */
+    uint64_t checked;       /* Bytes read and checked */
+} MixedWorker;
+
+struct MixedState {
+    TestContext *ctx;
+    MixedWorker reader;
+    MixedWorker writer;
+    int running;            /* Threads of the current stage are started */
+    uint64_t started;       /* Start of the current stage (usec) */
+    uint64_t written_before; /* Session byte counter when the write stream started */
+    volatile int stop;
+    volatile int writer_done;  /* The writer stopped, so the reader no longer waits for it */
+
+    /* Check stage */
+    int check_fd;
+    uint32_t check_block;
+    uint32_t check_blocks;
+};
+
+/**
+ * xorshift64* step
+ */
+static uint64_t next_random(MixedWorker *w)
+{
+    w->rng ^= w->rng >> 12;
+    w->rng ^= w->rng << 25;
+    w->rng ^= w->rng >> 27;
+    return w->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Whether the reader is more than one write block ahead of the ratio
+ */
+static int reader_ahead(const struct MixedState *s)
+{
+    uint32_t read_pct = s->ctx->run.mixed.read_pct;
+
+    return (uint64_t)s->reader.ops * F3V_MIXED_READ_SIZE * (100 - read_pct) >
+           ((uint64_t)s->writer.ops + 1) * F3V_BLOCK_SIZE * read_pct;
+}
+
+/**
+ * Whether the writer is ahead of the ratio
+ */
+static int writer_ahead(const struct MixedState *s)
+{
+    uint32_t read_pct = s->ctx->run.mixed.read_pct;
+
+    return (uint64_t)s->writer.ops * F3V_BLOCK_SIZE * read_pct >
+           (uint64_t)s->reader.ops * F3V_MIXED_READ_SIZE * (100 - read_pct);
+}
+
+/**
+ * Reader thread: random reads in the prefilled region until told to stop
+ */
+static int reader_thread(void *arg)
+{
+    MixedWorker *w = (MixedWorker *)arg;
+    struct MixedState *s = w->state;
+    TestContext *ctx = s->ctx;
+    uint64_t slots = ctx->run.mixed.region / F3V_MIXED_READ_SIZE;
+    int mixed = ctx->run.mixed.stage == MIXED_READ_WRITE;
+    int profile_applied = -1;
+
+    f3v_profile_refresh(ROLE_IO, &profile_applied);
+
+    while (!s->stop && !ctx->cancelled)
+    {
+        /* The writer waits on the opposite condition, so both never wait */
+        if (mixed && !s->writer_done && reader_ahead(s))
+        {
+            f3v_thread_sleep_usec(F3V_MIXED_WAIT_US);
+            continue;
+        }
+
+        uint64_t offset = next_random(w) % slots * F3V_MIXED_READ_SIZE;
+        uint32_t block_idx = (uint32_t)(offset / F3V_BLOCK_SIZE);
+        uint32_t in_block = (uint32_t)(offset % F3V_BLOCK_SIZE);
+
+        uint64_t t0 = f3v_get_time_usec();
+        int done = f3v_read_at(w->fd, w->buf, F3V_MIXED_READ_SIZE, offset);
+        f3v_hist_add(&w->hist, (uint32_t)(f3v_get_time_usec() - t0));
+
+        /* Check outside the timed window */
+        if (done == F3V_MIXED_READ_SIZE)
+        {
+            uint32_t corrupted = f3v_verify_pattern_range(w->buf, 1, block_idx, in_block,
+                                                          F3V_MIXED_READ_SIZE, NULL);
+            if (corrupted > 0)
+            {
+                w->bad++;
+                w->corrupted += corrupted;
+            }
+            w->checked += F3V_MIXED_READ_SIZE;
+        }
+        else
+        {
+            w->bad++;
+            w->corrupted += F3V_MIXED_READ_SIZE;
+        }
+        w->ops++;
+    }
+
+    return 0;
+}
+
+/**
+ * Writer thread: new pattern blocks in order through test file 2, wrapping
+ * at the end of the region
+ */
+static int writer_thread(void *arg)
+{
+    MixedWorker *w = (MixedWorker *)arg;
+    struct MixedState *s = w->state;
+    TestContext *ctx = s->ctx;
+    uint32_t blocks = (uint32_t)(ctx->run.mixed.region / F3V_BLOCK_SIZE);
+    int profile_applied = -1;
+
+    f3v_profile_refresh(ROLE_IO, &profile_applied);
+
+    while (!s->stop && !ctx->cancelled)
+    {
+        if (writer_ahead(s))
+        {
+            f3v_thread_sleep_usec(F3V_MIXED_WAIT_US);
+            continue;
+        }
+
+        uint32_t block_idx = w->ops % blocks;
+        f3v_fill_pattern(w->buf, MIXED_WRITE_FILE, block_idx);
+
+        uint64_t t0 = f3v_get_time_usec();
+        int done = f3v_write_at(w->fd, w->buf, F3V_BLOCK_SIZE,
+                                (uint64_t)block_idx * F3V_BLOCK_SIZE);
+        f3v_hist_add(&w->hist, (uint32_t)(f3v_get_time_usec() - t0));
+
+        if (done != F3V_BLOCK_SIZE)
+        {
+            /* A stream that cannot write leaves the reader alone */
+            w->bad++;
+            w->corrupted += F3V_BLOCK_SIZE;
+            break;
+        }
+        w->ops++;
+    }
+
+    f3v_sync(w->fd);
+    s->writer_done = 1;
+    return 0;
+}
+
+/**
+ * Reset a worker for a new stage
+ */
+static void reset_worker(struct MixedState *s, MixedWorker *w, uint32_t seed)
+{
+    w->state = s;
+    w->rng = ((uint64_t)s->ctx->session_nonce << 32 | seed) ^ 0x9E3779B97F4A7C15ULL;
+    w->ops = 0;
+    w->bad = 0;
+    w->corrupted = 0;
+    w->checked = 0;
+    memset(&w->hist, 0, sizeof(w->hist));
+}
+
+/**
+ * Stop the running stage's threads and release their handles
+ */
+static void stop_threads(struct MixedState *s)
+{
+    if (!s->running)
+    {
+        return;
+    }
+
+    s->stop = 1;
+    if (s->reader.fd >= 0)
+    {
+        f3v_thread_join(&s->reader.thread);
+        f3v_close(s->reader.fd);
+        s->reader.fd = -1;
+    }
+    if (s->writer.fd >= 0)
+    {
+        f3v_thread_join(&s->writer.thread);
+        f3v_close(s->writer.fd);
+        s->writer.fd = -1;
+    }
+    s->running = 0;
+}
+
+/**
+ * Open a worker's file and start its thread
+ * @return 0 on success, negative on error
+ */
+static int start_worker(MixedWorker *w, int fd, const char *name, F3vThreadFunc func)
+{
+    w->fd = fd;
+    if (w->fd >= 0 && f3v_thread_create(&w->thread, name, func, w) < 0)
+    {
+        f3v_close(w->fd);
+        w->fd = -1;
+    }
+    return w->fd >= 0 ? 0 : -1;
+}
+
+/**
+ * Start the threads for the current timed stage
+ * @return 0 on success, negative on error
+ */
+static int start_stage(struct MixedState *s)
+{
+    TestContext *ctx = s->ctx;
+    char filename[128];
+
+    s->stop = 0;
+    s->writer_done = 0;
+    s->running = 1;
+    reset_worker(s, &s->reader, ctx->run.mixed.stage);
+    reset_worker(s, &s->writer, 0);
+
+    f3v_get_test_filename(ctx, 1, filename, sizeof(filename));
+    if (start_worker(&s->reader, f3v_open_read(filename), "f3v_mixed_rd", reader_thread) < 0)
+    {
+        stop_threads(s);
+        return -1;
+    }
+
+    if (ctx->run.mixed.stage == MIXED_READ_WRITE)
+    {
+        s->written_before = ctx->bytes_written;
+        f3v_get_test_filename(ctx, MIXED_WRITE_FILE, filename, sizeof(filename));
+        if (start_worker(&s->writer, f3v_open_write(filename), "f3v_mixed_wr", writer_thread) <
+            0)
+        {
+            stop_threads(s);
+            return -1;
+        }
+    }
+
+    s->started = f3v_get_time_usec();
+    return 0;
+}
+
+/**
+ * Latency summary of one worker over a stage
+ */
+static void store_latency(MixedLatency *out, const MixedWorker *w, uint64_t elapsed)
+{
+    out->ops = w->ops;
+    out->iops = elapsed > 0 ? (uint32_t)((uint64_t)w->ops * 1000000 / elapsed) : 0;
+    out->lat_p50_us = f3v_hist_percentile(&w->hist, 0.50);
+    out->lat_p99_us = f3v_hist_percentile(&w->hist, 0.99);
+    out->lat_p999_us = f3v_hist_percentile(&w->hist, 0.999);
+    out->lat_max_us = w->hist.max_usec;
+}
+
+/**
+ * Account a worker's errors and checked bytes to the session
+ */
+static void account_worker(TestContext *ctx, const MixedWorker *w)
+{
+    ctx->run.mixed.result.bad += w->bad;
+    ctx->bytes_corrupted += w->corrupted;
+    ctx->bytes_verified += w->checked;
+}
+
+/**
+ * Stop the running stage and store its result
+ */
+static void end_stage(struct MixedState *s)
+{
+    TestContext *ctx = s->ctx;
+    MixedResult *result = &ctx->run.mixed.result;
+
+    stop_threads(s);
+    uint64_t elapsed = f3v_get_time_usec() - s->started;
+
+    account_worker(ctx, &s->reader);
+    if (ctx->run.mixed.stage == MIXED_READ_ALONE)
+    {
+        store_latency(&result->read_alone, &s->reader, elapsed);
+        ctx->run.mixed.stage = MIXED_READ_WRITE;
+        return;
+    }
+
+    store_latency(&result->read_mixed, &s->reader, elapsed);
+    store_latency(&result->write, &s->writer, elapsed);
+    account_worker(ctx, &s->writer);
+    result->write_bytes = (uint64_t)s->writer.ops * F3V_BLOCK_SIZE;
+    result->write_kbs = elapsed > 0 ? (uint32_t)(result->write_bytes / 1024 * 1000000 / elapsed)
+                                    : 0;
+    ctx->bytes_written = s->written_before + result->write_bytes;
+
+    /* Wrapped blocks were rewritten with the same data */
+    uint32_t blocks = (uint32_t)(ctx->run.mixed.region / F3V_BLOCK_SIZE);
+    s->check_blocks = s->writer.ops < blocks ? s->writer.ops : blocks;
+    s->check_block = 0;
+    ctx->run.mixed.stage = MIXED_CHECK;
+}
+
+/**
+ * Verify the next block the write stream stored
+ * @return 1 while blocks remain, 0 once the check is done
+ */
+static int check_step(struct MixedState *s)
+{
+    TestContext *ctx = s->ctx;
+    uint8_t *buf = s->writer.buf;
+    char filename[128];
+
+    f3v_get_test_filename(ctx, MIXED_WRITE_FILE, filename, sizeof(filename));
+
+    if (s->check_block < s->check_blocks)
+    {
+        if (s->check_fd < 0)
+        {
+            s->check_fd = f3v_open_read(filename);
+        }
+
+        uint32_t corrupted = F3V_BLOCK_SIZE;
+        if (s->check_fd >= 0 &&
+            f3v_read_at(s->check_fd, buf, F3V_BLOCK_SIZE,
+                        (uint64_t)s->check_block * F3V_BLOCK_SIZE) == F3V_BLOCK_SIZE)
+        {
+            corrupted = f3v_pool_verify(buf, MIXED_WRITE_FILE, s->check_block, NULL);
+        }
+        if (corrupted > 0)
+        {
+            ctx->run.mixed.result.bad++;
+            ctx->bytes_corrupted += corrupted;
+        }
+        ctx->bytes_verified += F3V_BLOCK_SIZE;
+        s->check_block++;
+        return 1;
+    }
+
+    if (s->check_fd >= 0)
+    {
+        f3v_close(s->check_fd);
+        s->check_fd = -1;
+    }
+    f3v_remove(filename);
+    ctx->run.mixed.stage = MIXED_DONE;
+    return 0;
+}
+
+int f3v_mixed_start(TestContext *ctx)
+{
+    struct MixedState *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+    {
+        return -1;
+    }
+    s->ctx = ctx;
+    s->reader.fd = -1;
+    s->writer.fd = -1;
+    s->check_fd = -1;
+
+    /* The writer's buffer is reused by the check stage */
+    s->reader.buf = malloc(F3V_MIXED_READ_SIZE);
+    s->writer.buf = malloc(F3V_BLOCK_SIZE);
+    if (s->reader.buf == NULL || s->writer.buf == NULL)
+    {
+        free(s->reader.buf);
+        free(s->writer.buf);
+        free(s);
+        return -1;
+    }
+
+    memset(&ctx->run.mixed.result, 0, sizeof(ctx->run.mixed.result));
+    ctx->run.mixed.stage = MIXED_READ_ALONE;
+    ctx->run.mixed.state = s;
+    return 0;
+}
+
+int f3v_mixed_step(TestContext *ctx)
+{
+    struct MixedState *s = ctx->run.mixed.state;
+
+    if (ctx->run.mixed.stage == MIXED_CHECK)
+    {
+        return check_step(s);
+    }
+    if (ctx->run.mixed.stage == MIXED_DONE)
+    {
+        return 0;
+    }
+
+    if (!s->running)
+    {
+        if (start_stage(s) < 0)
+        {
+            /* Without both threads the stage has nothing to compare */
+            ctx->run.mixed.result.bad++;
+            ctx->run.mixed.stage = MIXED_DONE;
+            return 0;
+        }
+        return 1;
+    }
+
+    /* Progress for the UI while the writer runs */
+    if (ctx->run.mixed.stage == MIXED_READ_WRITE)
+    {
+        ctx->bytes_written = s->written_before + (uint64_t)s->writer.ops * F3V_BLOCK_SIZE;
+    }
+
+    if (f3v_get_time_usec() - s->started < F3V_MIXED_SECONDS * 1000000ULL)
+    {
+        f3v_thread_sleep_usec(F3V_MIXED_POLL_US);
+        return 1;
+    }
+
+    end_stage(s);
+    return 1;
+}
+
+void f3v_mixed_stop(TestContext *ctx)
+{
+    struct MixedState *s = ctx->run.mixed.state;
+    char filename[128];
+
+    if (s == NULL)
+    {
+        return;
+    }
+
+    stop_threads(s);
+    if (s->check_fd >= 0)
+    {
+        f3v_close(s->check_fd);
+    }
+
+    /* The write stream's file is only needed until it is checked */
+    if (ctx->run.mixed.stage != MIXED_READ_ALONE)
+    {
+        f3v_get_test_filename(ctx, MIXED_WRITE_FILE, filename, sizeof(filename));
+        f3v_remove(filename);
+    }
+
+    free(s->reader.buf);
+    free(s->writer.buf);
+    free(s);
+    ctx->run.mixed.state = NULL;
+}
+
+const char *f3v_mixed_stage_name(MixedStage stage)
+{
+    switch (stage)
+    {
+    case MIXED_READ_ALONE:
+        return "read alone";
+    case MIXED_READ_WRITE:
+        return "read + write";
+    case MIXED_CHECK:
+        return "checking writes";
+    default:
+        return "done";
+    }
+}
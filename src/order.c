@@ -0,0 +1,93 @@
+/**
+ * @file order.c
+ * @brief Block orders for the verify pass
+ */
+
+#include "order.h"
+
+#define FEISTEL_ROUNDS 4
+
+static const char *g_order_names[ORDER_COUNT] = {"Sequential", "Reverse", "File shuffle",
+                                                 "Block shuffle"};
+
+/**
+ * Feistel round function
+ */
+static uint64_t round_key(uint64_t half, uint32_t seed, uint32_t round, uint64_t mask)
+{
+    uint64_t h = (half ^ ((uint64_t)seed << 32) ^ round) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h & mask;
+}
+
+uint64_t f3v_permute(uint64_t index, uint64_t count, uint32_t seed)
+{
+    /* Smallest even bit width covering count, so the halves are equal */
+    uint32_t bits = 2;
+    while (bits < 64 && (1ULL << bits) < count)
+    {
+        bits += 2;
+    }
+    uint32_t half_bits = bits / 2;
+    uint64_t mask = (1ULL << half_bits) - 1;
+
+    /* Cycle-walk: permute within 2^bits until the value lands in range
+       (2^bits < 4 * count, so this takes under four walks on average) */
+    uint64_t x = index;
+    do
+    {
+        uint64_t left = x >> half_bits;
+        uint64_t right = x & mask;
+
+        for (uint32_t r = 0; r < FEISTEL_ROUNDS; r++)
+        {
+            uint64_t next = left ^ round_key(right, seed, r, mask);
+            left = right;
+            right = next;
+        }
+        x = (left << half_bits) | right;
+    } while (x >= count);
+
+    return x;
+}
+
+uint64_t f3v_order_slots(VerifyOrder order, uint64_t blocks)
+{
+    if (order == ORDER_FILE_SHUFFLE)
+    {
+        return (blocks + F3V_BLOCKS_PER_FILE - 1) / F3V_BLOCKS_PER_FILE * F3V_BLOCKS_PER_FILE;
+    }
+    return blocks;
+}
+
+int f3v_order_block(VerifyOrder order, uint32_t seed, uint64_t index, uint64_t blocks,
+                    uint64_t *block)
+{
+    switch (order)
+    {
+    case ORDER_REVERSE:
+        *block = blocks - 1 - index;
+        return 1;
+    case ORDER_FILE_SHUFFLE:
+    {
+        uint64_t files = (blocks + F3V_BLOCKS_PER_FILE - 1) / F3V_BLOCKS_PER_FILE;
+        uint64_t file = f3v_permute(index / F3V_BLOCKS_PER_FILE, files, seed);
+
+        *block = file * F3V_BLOCKS_PER_FILE + index % F3V_BLOCKS_PER_FILE;
+        return *block < blocks;
+    }
+    case ORDER_BLOCK_SHUFFLE:
+        *block = f3v_permute(index, blocks, seed);
+        return 1;
+    default:
+        *block = index;
+        return 1;
+    }
+}
+
+const char *f3v_order_name(VerifyOrder order)
+{
+    return order < ORDER_COUNT ? g_order_names[order] : "Unknown";
+}
@@ -5,7 +5,35 @@
 
 #include "pattern.h"
 
+/**
+ * Seed XORed into the pattern base: changes every second variant
+ */
+static uint32_t variant_seed(uint32_t variant)
+{
+    return (variant >> 1) * 0x9E3779B1u;
+}
+
+/**
+ * Byte mask of a variant: odd variants are bit-inverted
+ */
+static uint8_t variant_invert(uint32_t variant)
+{
+    return (variant & 1) ? 0xFF : 0x00;
+}
+
 void f3v_fill_pattern(uint8_t *buf, uint32_t file_idx, uint32_t block_idx)
+{
+    f3v_fill_pattern_range(buf, file_idx, block_idx, 0, F3V_BLOCK_SIZE);
+}
+
+void f3v_fill_pattern_range(uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                            uint32_t offset, uint32_t len)
+{
+    f3v_fill_variant_range(buf, file_idx, block_idx, 0, offset, len);
+}
+
+void f3v_fill_variant_range(uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                            uint32_t variant, uint32_t offset, uint32_t len)
 {
     /*
      * Pattern formula: (file_index << 24) ^ (block_index << 16) ^ byte_offset
@@ -14,12 +42,18 @@ void f3v_fill_pattern(uint8_t *buf, uint32_t file_idx, uint32_t block_idx)
      * - file_idx occupies bits 31-24 (max 256 files = 256GB)
      * - block_idx occupies bits 23-16 (max 256 blocks per file = 256MB, but we use 1024)
      * - byte_offset occupies bits 15-0 (max 65536, we cycle within 1MB block)
+     *
+     * Variants XOR a seed into the base and/or invert every byte; the
+     * mapping stays one-to-one, so locations remain distinguishable.
      */
-    uint32_t base = (file_idx << 24) ^ (block_idx << 16);
+    uint32_t base = (file_idx << 24) ^ (block_idx << 16) ^ variant_seed(variant);
+    uint8_t invert = variant_invert(variant);
 
-    /* Fill buffer with deterministic pattern */
-    for (uint32_t i = 0; i < F3V_BLOCK_SIZE; i++)
+    /* Fill buffer with deterministic pattern (buf[0] is block byte 'offset') */
+    for (uint32_t j = 0; j < len; j++)
     {
+        uint32_t i = offset + j;
+
         /*
          * We take the XOR of base and offset, then extract a single byte.
          * Using different byte positions for different offsets ensures
@@ -28,23 +62,217 @@ void f3v_fill_pattern(uint8_t *buf, uint32_t file_idx, uint32_t block_idx)
         uint32_t val = base ^ i;
 
         /* Rotate through different byte positions for variety */
-        buf[i] = (uint8_t)(val >> ((i & 3) * 8));
+        buf[j] = (uint8_t)(val >> ((i & 3) * 8)) ^ invert;
     }
 }
 
 uint32_t f3v_verify_pattern(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
                             uint32_t *first_error_offset)
 {
-    uint32_t base = (file_idx << 24) ^ (block_idx << 16);
+    return f3v_verify_pattern_range(buf, file_idx, block_idx, 0, F3V_BLOCK_SIZE,
+                                    first_error_offset);
+}
+
+uint32_t f3v_verify_pattern_range(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                                  uint32_t offset, uint32_t len, uint32_t *first_error_offset)
+{
+    return f3v_verify_variant_range(buf, file_idx, block_idx, 0, offset, len, first_error_offset);
+}
+
+uint32_t f3v_verify_variant_range(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                                  uint32_t variant, uint32_t offset, uint32_t len,
+                                  uint32_t *first_error_offset)
+{
+    uint32_t base = (file_idx << 24) ^ (block_idx << 16) ^ variant_seed(variant);
+    uint8_t invert = variant_invert(variant);
     uint32_t corrupted = 0;
     int found_first = 0;
 
-    for (uint32_t i = 0; i < F3V_BLOCK_SIZE; i++)
+    /* buf[0] holds the byte at 'offset' within the block */
+    for (uint32_t j = 0; j < len; j++)
     {
+        uint32_t i = offset + j;
         uint32_t val = base ^ i;
+        uint8_t expected = (uint8_t)(val >> ((i & 3) * 8)) ^ invert;
+
+        if (buf[j] != expected)
+        {
+            corrupted++;
+
+            if (!found_first && first_error_offset != NULL)
+            {
+                *first_error_offset = i;
+                found_first = 1;
+            }
+        }
+    }
+
+    return corrupted;
+}
+
+void f3v_fill_file_range(uint8_t *buf, uint32_t file_idx, uint64_t offset, uint32_t len)
+{
+    for (uint32_t done = 0; done < len;)
+    {
+        uint64_t pos = offset + done;
+        uint32_t in_block = (uint32_t)(pos % F3V_BLOCK_SIZE);
+        uint32_t chunk = F3V_BLOCK_SIZE - in_block;
+
+        if (chunk > len - done)
+        {
+            chunk = len - done;
+        }
+        f3v_fill_pattern_range(buf + done, file_idx, (uint32_t)(pos / F3V_BLOCK_SIZE), in_block,
+                               chunk);
+        done += chunk;
+    }
+}
+
+uint32_t f3v_verify_file_range(const uint8_t *buf, uint32_t file_idx, uint64_t offset,
+                               uint32_t len)
+{
+    uint32_t corrupted = 0;
+
+    for (uint32_t done = 0; done < len;)
+    {
+        uint64_t pos = offset + done;
+        uint32_t in_block = (uint32_t)(pos % F3V_BLOCK_SIZE);
+        uint32_t chunk = F3V_BLOCK_SIZE - in_block;
+
+        if (chunk > len - done)
+        {
+            chunk = len - done;
+        }
+        corrupted += f3v_verify_pattern_range(buf + done, file_idx,
+                                              (uint32_t)(pos / F3V_BLOCK_SIZE), in_block, chunk,
+                                              NULL);
+        done += chunk;
+    }
+
+    return corrupted;
+}
+
+int f3v_identify_pattern(const uint8_t *buf, uint32_t max_files, uint32_t *file_idx,
+                         uint32_t *block_idx)
+{
+    return f3v_identify_variant(buf, 0, max_files, file_idx, block_idx);
+}
+
+int f3v_identify_variant(const uint8_t *buf, uint32_t variant, uint32_t max_files,
+                         uint32_t *file_idx, uint32_t *block_idx)
+{
+    /*
+     * Bytes 0-3 hold base bits 0-7, 8-15, 16-23 and 24-31 (after undoing the
+     * variant). The low 16 bits of every base are zero; bits 24-25 mix the
+     * file index with bits 8-9 of the block index.
+     */
+    uint8_t invert = variant_invert(variant);
+    uint32_t base = ((uint32_t)(buf[0] ^ invert) | ((uint32_t)(buf[1] ^ invert) << 8) |
+                     ((uint32_t)(buf[2] ^ invert) << 16) | ((uint32_t)(buf[3] ^ invert) << 24)) ^
+                    variant_seed(variant);
+
+    if ((base & 0xFFFF) != 0)
+    {
+        return 0;
+    }
+
+    for (uint32_t hi = 0; hi < (F3V_BLOCKS_PER_FILE + 255) / 256; hi++)
+    {
+        uint32_t file = (base >> 24) ^ hi;
+        uint32_t block = (hi << 8) | ((base >> 16) & 0xFF);
+
+        if (file < 1 || file > max_files || block >= F3V_BLOCKS_PER_FILE)
+        {
+            continue;
+        }
+
+        /* Every candidate produces the same bytes, so one check decides */
+        if (f3v_verify_variant_range(buf, file, block, variant, 0, F3V_BLOCK_SIZE, NULL) != 0)
+        {
+            return 0;
+        }
+
+        *file_idx = file;
+        *block_idx = block;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * 32-bit integer hash (lowbias32)
+ */
+static uint32_t hash32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352DU;
+    x ^= x >> 15;
+    x *= 0x846CA68BU;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * Noise word base of a block (word w of the block is hash32(base + w))
+ */
+static uint32_t noise_base(uint32_t seed, uint32_t file_idx, uint32_t block_idx)
+{
+    return hash32(seed ^ hash32((file_idx << 10) ^ block_idx));
+}
+
+void f3v_fill_noise_range(uint8_t *buf, uint32_t seed, uint32_t file_idx, uint32_t block_idx,
+                          uint32_t offset, uint32_t len)
+{
+    uint32_t base = noise_base(seed, file_idx, block_idx);
+    uint32_t j = 0;
+
+    /* Bytes before the first whole word */
+    for (; j < len && ((offset + j) & 3) != 0; j++)
+    {
+        uint32_t i = offset + j;
+        buf[j] = (uint8_t)(hash32(base + (i >> 2)) >> ((i & 3) * 8));
+    }
+
+    /* Whole words, one hash each */
+    for (; j + 4 <= len; j += 4)
+    {
+        uint32_t val = hash32(base + ((offset + j) >> 2));
+
+        buf[j] = (uint8_t)val;
+        buf[j + 1] = (uint8_t)(val >> 8);
+        buf[j + 2] = (uint8_t)(val >> 16);
+        buf[j + 3] = (uint8_t)(val >> 24);
+    }
+
+    for (; j < len; j++)
+    {
+        uint32_t i = offset + j;
+        buf[j] = (uint8_t)(hash32(base + (i >> 2)) >> ((i & 3) * 8));
+    }
+}
+
+uint32_t f3v_verify_noise_range(const uint8_t *buf, uint32_t seed, uint32_t file_idx,
+                                uint32_t block_idx, uint32_t offset, uint32_t len,
+                                uint32_t *first_error_offset)
+{
+    uint32_t base = noise_base(seed, file_idx, block_idx);
+    uint32_t corrupted = 0;
+    uint32_t val = 0;
+    int found_first = 0;
+
+    for (uint32_t j = 0; j < len; j++)
+    {
+        uint32_t i = offset + j;
+
+        /* One hash per word */
+        if (j == 0 || (i & 3) == 0)
+        {
+            val = hash32(base + (i >> 2));
+        }
         uint8_t expected = (uint8_t)(val >> ((i & 3) * 8));
 
-        if (buf[i] != expected)
+        if (buf[j] != expected)
         {
             corrupted++;
 
@@ -57,4 +285,26 @@ uint32_t f3v_verify_pattern(const uint8_t *buf, uint32_t file_idx, uint32_t bloc
     }
 
     return corrupted;
-}
\ No newline at end of file
+}
+
+uint32_t f3v_vote_bytes(uint8_t *out, const uint8_t *a, const uint8_t *b, const uint8_t *c,
+                        uint32_t len)
+{
+    uint32_t unstable = 0;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint8_t va = a[i], vb = b[i], vc = c[i];
+
+        if (va == vb && vb == vc)
+        {
+            out[i] = va;
+            continue;
+        }
+
+        unstable++;
+        out[i] = (vb == vc) ? vb : va;
+    }
+
+    return unstable;
+}
@@ -0,0 +1,446 @@
+/**
+ * @file pool.c
+ * @brief Persistent thread pool for stripe-parallel pattern fill/verify
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "digest.h"
+#include "engine.h"
+#include "pattern.h"
+#include "profile.h"
+#include "thread.h"
+
+/*
+ * Concurrent submitters: the engine workers (which also run the mixed
+ * workload's checks and the scans), one read-back thread per session and the
+ * UI thread (wipe kernel timing). With a slot each, nobody waits for a slot;
+ * the helpers are shared either way.
+ */
+#define POOL_MAX_JOBS (F3V_ENGINE_WORKERS + F3V_MAX_DEVICES + 1)
+
+/* A hash job gives each stripe one digest leaf */
+#if F3V_DIGEST_LEAF != F3V_STRIPE_SIZE
+#error "Digest leaves must be pool stripes"
+#endif
+
+typedef enum {
+    JOB_FILL,
+    JOB_VERIFY,
+    JOB_NOISE_FILL,         /* Noise jobs carry the seed in variant */
+    JOB_NOISE_VERIFY,
+    JOB_HASH                /* Stripes past len are skipped */
+} JobKind;
+
+/* One block being processed; stripes are claimed under g_lock */
+typedef struct {
+    int in_use;
+    JobKind kind;
+    uint8_t *buf;
+    uint32_t file_idx;
+    uint32_t block_idx;
+    uint32_t variant;
+    uint32_t len;           /* Hash jobs: bytes in the block */
+    uint64_t first_leaf;
+    uint64_t *digest;       /* Hash jobs: one leaf digest per stripe */
+    int next_stripe;
+    int done_stripes;
+    int owner_waiting;
+    F3vSema done;           /* Signalled when a helper finishes the last stripe */
+
+    /* Per-stripe verify results, merged in order by the owner */
+    uint32_t corrupted[F3V_POOL_STRIPES];
+    uint32_t first_error[F3V_POOL_STRIPES];
+} PoolJob;
+
+static PoolJob g_jobs[POOL_MAX_JOBS];
+static F3vMutex g_lock;
+static F3vSema g_work;      /* Wakes helpers when stripes are queued */
+static F3vSema g_slots;     /* Free entries in g_jobs */
+static F3vThread g_helpers[F3V_POOL_MAX_THREADS];
+static int g_helper_count = 0;
+static int g_initialized = 0;
+static volatile int g_shutdown = 0;
+
+/**
+ * Run one stripe of a job
+ */
+static void run_stripe(PoolJob *job, int stripe)
+{
+    uint32_t offset = (uint32_t)stripe * F3V_STRIPE_SIZE;
+
+    uint32_t first = 0;
+
+    switch (job->kind)
+    {
+    case JOB_FILL:
+        f3v_fill_variant_range(job->buf + offset, job->file_idx, job->block_idx, job->variant,
+                               offset, F3V_STRIPE_SIZE);
+        break;
+    case JOB_VERIFY:
+        job->corrupted[stripe] = f3v_verify_variant_range(job->buf + offset, job->file_idx,
+                                                          job->block_idx, job->variant, offset,
+                                                          F3V_STRIPE_SIZE, &first);
+        job->first_error[stripe] = first;
+        break;
+    case JOB_NOISE_FILL:
+        f3v_fill_noise_range(job->buf + offset, job->variant, job->file_idx, job->block_idx,
+                             offset, F3V_STRIPE_SIZE);
+        break;
+    case JOB_NOISE_VERIFY:
+        job->corrupted[stripe] = f3v_verify_noise_range(job->buf + offset, job->variant,
+                                                        job->file_idx, job->block_idx, offset,
+                                                        F3V_STRIPE_SIZE, &first);
+        job->first_error[stripe] = first;
+        break;
+    case JOB_HASH:
+        if (offset < job->len)
+        {
+            uint32_t len = job->len - offset < F3V_STRIPE_SIZE ? job->len - offset
+                                                               : F3V_STRIPE_SIZE;
+            job->digest[stripe] = f3v_hash64(job->buf + offset, len, job->first_leaf + stripe);
+        }
+        break;
+    }
+}
+
+/**
+ * Mark a stripe finished; wake the owner if it is waiting on the last one
+ */
+static void complete_stripe(PoolJob *job)
+{
+    f3v_mutex_lock(&g_lock);
+    int finished = (++job->done_stripes == F3V_POOL_STRIPES);
+    int wake = finished && job->owner_waiting;
+    f3v_mutex_unlock(&g_lock);
+
+    if (wake)
+    {
+        f3v_sema_signal(&job->done, 1);
+    }
+}
+
+/**
+ * Claim the next stripe of any job
+ * @return Stripe index, or -1 if nothing is queued
+ */
+static int claim_any(PoolJob **out)
+{
+    int stripe = -1;
+
+    f3v_mutex_lock(&g_lock);
+    for (int j = 0; j < POOL_MAX_JOBS && stripe < 0; j++)
+    {
+        if (g_jobs[j].in_use && g_jobs[j].next_stripe < F3V_POOL_STRIPES)
+        {
+            stripe = g_jobs[j].next_stripe++;
+            *out = &g_jobs[j];
+        }
+    }
+    f3v_mutex_unlock(&g_lock);
+
+    return stripe;
+}
+
+static int helper_main(void *arg)
+{
+    int profile_applied = -1;
+    (void)arg;
+
+    for (;;)
+    {
+        f3v_profile_refresh(ROLE_COMPUTE, &profile_applied);
+        f3v_sema_wait(&g_work);
+        if (g_shutdown)
+        {
+            break;
+        }
+
+        /* Drain whatever stripes are left, from any submitter */
+        PoolJob *job;
+        int stripe;
+        while ((stripe = claim_any(&job)) >= 0)
+        {
+            run_stripe(job, stripe);
+            complete_stripe(job);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Reserve a job slot; its stripes are held back until start_job()
+ */
+static PoolJob *claim_job(JobKind kind, uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                          uint32_t variant)
+{
+    PoolJob *job = NULL;
+
+    f3v_sema_wait(&g_slots);
+    f3v_mutex_lock(&g_lock);
+    for (int j = 0; j < POOL_MAX_JOBS; j++)
+    {
+        if (!g_jobs[j].in_use)
+        {
+            job = &g_jobs[j];
+            break;
+        }
+    }
+    job->kind = kind;
+    job->buf = buf;
+    job->file_idx = file_idx;
+    job->block_idx = block_idx;
+    job->variant = variant;
+    job->next_stripe = F3V_POOL_STRIPES;
+    job->done_stripes = 0;
+    job->owner_waiting = 0;
+    job->in_use = 1;
+    f3v_mutex_unlock(&g_lock);
+
+    return job;
+}
+
+/**
+ * Split a claimed job across the pool and wait until every stripe is done
+ */
+static PoolJob *start_job(PoolJob *job)
+{
+    f3v_mutex_lock(&g_lock);
+    job->next_stripe = 0;
+    f3v_mutex_unlock(&g_lock);
+
+    f3v_sema_signal(&g_work, g_helper_count);
+
+    /* Work on our own block alongside the helpers */
+    for (;;)
+    {
+        f3v_mutex_lock(&g_lock);
+        int stripe = job->next_stripe < F3V_POOL_STRIPES ? job->next_stripe++ : -1;
+        f3v_mutex_unlock(&g_lock);
+
+        if (stripe < 0)
+        {
+            break;
+        }
+
+        run_stripe(job, stripe);
+
+        f3v_mutex_lock(&g_lock);
+        job->done_stripes++;
+        f3v_mutex_unlock(&g_lock);
+    }
+
+    /* Wait for stripes still running on helpers */
+    f3v_mutex_lock(&g_lock);
+    int wait = job->done_stripes < F3V_POOL_STRIPES;
+    job->owner_waiting = wait;
+    f3v_mutex_unlock(&g_lock);
+
+    if (wait)
+    {
+        f3v_sema_wait(&job->done);
+    }
+
+    return job;
+}
+
+/**
+ * Split a block across the pool and wait until every stripe is done
+ */
+static PoolJob *run_job(JobKind kind, uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                        uint32_t variant)
+{
+    return start_job(claim_job(kind, buf, file_idx, block_idx, variant));
+}
+
+/**
+ * Return a job slot to the free list
+ */
+static void release_job(PoolJob *job)
+{
+    f3v_mutex_lock(&g_lock);
+    job->in_use = 0;
+    f3v_mutex_unlock(&g_lock);
+    f3v_sema_signal(&g_slots, 1);
+}
+
+/**
+ * Merge a finished verify job and return its slot
+ * @return Corrupted bytes in the block
+ */
+static uint32_t merge_verify(PoolJob *job, uint32_t *first_error_offset)
+{
+    /* Merge in stripe order: the first error is the lowest offset */
+    uint32_t corrupted = 0;
+    int found_first = 0;
+
+    for (int s = 0; s < F3V_POOL_STRIPES; s++)
+    {
+        corrupted += job->corrupted[s];
+
+        if (job->corrupted[s] > 0 && !found_first && first_error_offset != NULL)
+        {
+            *first_error_offset = job->first_error[s];
+            found_first = 1;
+        }
+    }
+
+    release_job(job);
+    return corrupted;
+}
+
+int f3v_pool_init(int threads)
+{
+    if (g_initialized)
+    {
+        return 0;
+    }
+
+    if (threads < 1)
+        threads = 1;
+    if (threads > F3V_POOL_MAX_THREADS)
+        threads = F3V_POOL_MAX_THREADS;
+
+    memset(g_jobs, 0, sizeof(g_jobs));
+    g_shutdown = 0;
+    g_helper_count = 0;
+
+    if (f3v_mutex_init(&g_lock, "f3v_pool") < 0 ||
+        f3v_sema_init(&g_work, "f3v_pool_work", 0) < 0 ||
+        f3v_sema_init(&g_slots, "f3v_pool_slots", POOL_MAX_JOBS) < 0)
+    {
+        return -1;
+    }
+
+    for (int j = 0; j < POOL_MAX_JOBS; j++)
+    {
+        if (f3v_sema_init(&g_jobs[j].done, "f3v_pool_done", 0) < 0)
+        {
+            return -1;
+        }
+    }
+
+    g_initialized = 1;
+
+    for (int i = 0; i < threads - 1; i++)
+    {
+        if (f3v_thread_create(&g_helpers[i], "f3v_pool", helper_main, NULL) < 0)
+        {
+            /* Fewer helpers just means less parallelism */
+            break;
+        }
+        g_helper_count++;
+    }
+
+    return 0;
+}
+
+void f3v_pool_shutdown(void)
+{
+    if (!g_initialized)
+    {
+        return;
+    }
+
+    g_shutdown = 1;
+    f3v_sema_signal(&g_work, g_helper_count);
+
+    for (int i = 0; i < g_helper_count; i++)
+    {
+        f3v_thread_join(&g_helpers[i]);
+    }
+
+    for (int j = 0; j < POOL_MAX_JOBS; j++)
+    {
+        f3v_sema_destroy(&g_jobs[j].done);
+    }
+    f3v_sema_destroy(&g_slots);
+    f3v_sema_destroy(&g_work);
+    f3v_mutex_destroy(&g_lock);
+
+    g_helper_count = 0;
+    g_initialized = 0;
+}
+
+int f3v_pool_threads(void)
+{
+    return g_helper_count + 1;
+}
+
+void f3v_pool_fill(uint8_t *buf, uint32_t file_idx, uint32_t block_idx)
+{
+    f3v_pool_fill_variant(buf, file_idx, block_idx, 0);
+}
+
+uint32_t f3v_pool_verify(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                         uint32_t *first_error_offset)
+{
+    return f3v_pool_verify_variant(buf, file_idx, block_idx, 0, first_error_offset);
+}
+
+void f3v_pool_fill_variant(uint8_t *buf, uint32_t file_idx, uint32_t block_idx, uint32_t variant)
+{
+    if (g_helper_count == 0)
+    {
+        f3v_fill_variant_range(buf, file_idx, block_idx, variant, 0, F3V_BLOCK_SIZE);
+        return;
+    }
+
+    release_job(run_job(JOB_FILL, buf, file_idx, block_idx, variant));
+}
+
+uint32_t f3v_pool_verify_variant(const uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                                 uint32_t variant, uint32_t *first_error_offset)
+{
+    if (g_helper_count == 0)
+    {
+        return f3v_verify_variant_range(buf, file_idx, block_idx, variant, 0, F3V_BLOCK_SIZE,
+                                        first_error_offset);
+    }
+
+    return merge_verify(run_job(JOB_VERIFY, (uint8_t *)buf, file_idx, block_idx, variant),
+                        first_error_offset);
+}
+
+void f3v_pool_fill_noise(uint8_t *buf, uint32_t seed, uint32_t file_idx, uint32_t block_idx)
+{
+    if (g_helper_count == 0)
+    {
+        f3v_fill_noise_range(buf, seed, file_idx, block_idx, 0, F3V_BLOCK_SIZE);
+        return;
+    }
+
+    release_job(run_job(JOB_NOISE_FILL, buf, file_idx, block_idx, seed));
+}
+
+uint32_t f3v_pool_verify_noise(const uint8_t *buf, uint32_t seed, uint32_t file_idx,
+                               uint32_t block_idx, uint32_t *first_error_offset)
+{
+    if (g_helper_count == 0)
+    {
+        return f3v_verify_noise_range(buf, seed, file_idx, block_idx, 0, F3V_BLOCK_SIZE,
+                                      first_error_offset);
+    }
+
+    return merge_verify(run_job(JOB_NOISE_VERIFY, (uint8_t *)buf, file_idx, block_idx, seed),
+                        first_error_offset);
+}
+
+uint32_t f3v_pool_hash(const uint8_t *buf, uint32_t len, uint64_t first_leaf, uint64_t *out)
+{
+    /* A single leaf has nothing to share */
+    if (g_helper_count == 0 || len <= F3V_STRIPE_SIZE)
+    {
+        return f3v_digest_leaves(buf, len, first_leaf, out);
+    }
+
+    PoolJob *job = claim_job(JOB_HASH, (uint8_t *)buf, 0, 0, 0);
+    job->len = len;
+    job->first_leaf = first_leaf;
+    job->digest = out;
+    release_job(start_job(job));
+
+    return (len + F3V_STRIPE_SIZE - 1) / F3V_STRIPE_SIZE;
+}
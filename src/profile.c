@@ -0,0 +1,102 @@
+/**
+ * @file profile.c
+ * @brief Thread scheduling profiles (priority and CPU affinity per role)
+ */
+
+#include "profile.h"
+
+#ifdef __vita__
+#include <psp2/kernel/threadmgr.h>
+#endif
+
+/* Core bits: bit N = user core N */
+#define CORE_0   0x1
+#define CORE_1   0x2
+#define CORE_2   0x4
+#define CORE_ALL (CORE_0 | CORE_1 | CORE_2)
+
+/* Scheduling for one role (priority: 64 = highest, 191 = lowest user) */
+typedef struct {
+    int priority;
+    int cores;
+} RoleSched;
+
+static const struct
+{
+    const char *name;
+    RoleSched roles[ROLE_COUNT]; /* UI, IO, COMPUTE */
+} g_profiles[PROFILE_COUNT] = {
+    /* Workers outrank the UI and float over every core */
+    {"Max throughput", {{160, CORE_0}, {96, CORE_ALL}, {128, CORE_ALL}}},
+    /* UI outranks workers on its own core so vblank and input stay smooth */
+    {"Balanced", {{96, CORE_0}, {128, CORE_1 | CORE_2}, {140, CORE_1 | CORE_2}}},
+    /* One core each, lowest priority: the UI never waits */
+    {"Low impact", {{64, CORE_0}, {160, CORE_1}, {191, CORE_2}}},
+};
+
+static volatile int g_active = F3V_PROFILE_DEFAULT;
+static volatile int g_generation = 0;
+
+/**
+ * Apply priority and affinity for a role to the calling thread
+ *
+ * Only on the Vita. The host build (tests, f3vcheck) leaves its threads to
+ * the OS scheduler: pinning them to three emulated cores would cap pool
+ * scaling at two helpers.
+ */
+static void apply(ThreadRole role)
+{
+    const RoleSched *rs = &g_profiles[g_active].roles[role];
+
+#ifdef __vita__
+    int mask = 0;
+    if (rs->cores & CORE_0)
+        mask |= SCE_KERNEL_CPU_MASK_USER_0;
+    if (rs->cores & CORE_1)
+        mask |= SCE_KERNEL_CPU_MASK_USER_1;
+    if (rs->cores & CORE_2)
+        mask |= SCE_KERNEL_CPU_MASK_USER_2;
+
+    sceKernelChangeThreadPriority(SCE_KERNEL_THREAD_ID_SELF, rs->priority);
+    sceKernelChangeThreadCpuAffinityMask(SCE_KERNEL_THREAD_ID_SELF, mask);
+#else
+    (void)rs;
+#endif
+}
+
+const char *f3v_profile_name(SchedProfile profile)
+{
+    if (profile < 0 || profile >= PROFILE_COUNT)
+    {
+        return "Unknown";
+    }
+    return g_profiles[profile].name;
+}
+
+void f3v_profile_set(SchedProfile profile)
+{
+    if (profile < 0 || profile >= PROFILE_COUNT)
+    {
+        return;
+    }
+
+    g_active = profile;
+    g_generation++;
+    apply(ROLE_UI);
+}
+
+SchedProfile f3v_profile_get(void)
+{
+    return (SchedProfile)g_active;
+}
+
+void f3v_profile_refresh(ThreadRole role, int *applied)
+{
+    int generation = g_generation;
+
+    if (*applied != generation)
+    {
+        apply(role);
+        *applied = generation;
+    }
+}
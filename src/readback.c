@@ -0,0 +1,253 @@
+/**
+ * @file readback.c
+ * @brief Pipelined read-after-write checking during the write phase
+ */
+
+#include <stdlib.h>
+
+#include "readback.h"
+#include "faillist.h"
+#include "storage.h"
+#include "pool.h"
+#include "profile.h"
+#include "thread.h"
+
+struct ReadbackPipe {
+    TestContext *ctx;
+    F3vThread thread;
+    F3vMutex lock;
+    F3vSema ready;          /* Signalled on every submit and on stop */
+
+    uint64_t submitted;     /* Synced bytes the reader may check (under lock) */
+    uint64_t checked;       /* Bytes checked so far (reader only) */
+    int stop;               /* Under lock */
+
+    int fd;                 /* Reader's own handle, or -1 */
+    uint32_t fd_file_idx;
+    uint8_t *buf;
+};
+
+/*
+ * Guards every session's ctx->raw: the reader publishes, the UI and the
+ * checkpoint read. Module-wide because the pipe is freed while the UI runs.
+ */
+static F3vMutex g_raw_lock;
+static int g_raw_lock_ready = 0;
+
+int f3v_readback_init(void)
+{
+    if (!g_raw_lock_ready && f3v_mutex_init(&g_raw_lock, "f3v_raw_totals") < 0)
+    {
+        return -1;
+    }
+    g_raw_lock_ready = 1;
+    return 0;
+}
+
+void f3v_readback_shutdown(void)
+{
+    if (g_raw_lock_ready)
+    {
+        f3v_mutex_destroy(&g_raw_lock);
+        g_raw_lock_ready = 0;
+    }
+}
+
+void f3v_readback_totals(const TestContext *ctx, ReadbackTotals *out)
+{
+    if (!g_raw_lock_ready)
+    {
+        *out = ctx->raw;
+        return;
+    }
+
+    f3v_mutex_lock(&g_raw_lock);
+    *out = ctx->raw;
+    f3v_mutex_unlock(&g_raw_lock);
+}
+
+/**
+ * Read back and verify one block
+ */
+static void check_block(struct ReadbackPipe *pipe, uint64_t written)
+{
+    TestContext *ctx = pipe->ctx;
+    uint32_t file_idx = (uint32_t)(pipe->checked / F3V_FILE_SIZE) + 1;
+    uint32_t block_idx = (uint32_t)((pipe->checked % F3V_FILE_SIZE) / F3V_BLOCK_SIZE);
+    uint32_t first_offset = 0;
+    uint32_t corrupted = F3V_BLOCK_SIZE;
+
+    if (file_idx != pipe->fd_file_idx)
+    {
+        char filename[128];
+
+        if (pipe->fd >= 0)
+        {
+            f3v_close(pipe->fd);
+        }
+        f3v_get_test_filename(ctx, file_idx, filename, sizeof(filename));
+        pipe->fd = f3v_open_read(filename);
+        pipe->fd_file_idx = pipe->fd >= 0 ? file_idx : 0;
+    }
+
+    if (pipe->fd >= 0 &&
+        f3v_read_at(pipe->fd, pipe->buf, F3V_BLOCK_SIZE, (uint64_t)block_idx * F3V_BLOCK_SIZE) ==
+            F3V_BLOCK_SIZE)
+    {
+        corrupted = f3v_pool_verify_variant(pipe->buf, file_idx, block_idx, ctx->pattern_variant,
+                                            &first_offset);
+    }
+
+    /* The writer does not touch the region list until read-back stops */
+    if (corrupted > 0 && ctx->readback == READBACK_FILE)
+    {
+        f3v_fail_note(ctx, file_idx, block_idx, first_offset);
+    }
+
+    pipe->checked += F3V_BLOCK_SIZE;
+
+    f3v_mutex_lock(&g_raw_lock);
+    ctx->raw.corrupted += corrupted;
+    if (corrupted > 0 && !ctx->raw.has_error)
+    {
+        ctx->raw.has_error = 1;
+        ctx->raw.error_file = file_idx;
+        ctx->raw.error_block = block_idx;
+        ctx->raw.error_offset = first_offset;
+        ctx->raw.error_written = written;
+    }
+    ctx->raw.verified = pipe->checked;
+    f3v_mutex_unlock(&g_raw_lock);
+}
+
+/**
+ * Reader thread: check each submitted group while the writer moves on
+ */
+static int readback_thread(void *arg)
+{
+    struct ReadbackPipe *pipe = (struct ReadbackPipe *)arg;
+    int profile_applied = -1;
+
+    for (;;)
+    {
+        f3v_profile_refresh(ROLE_IO, &profile_applied);
+        f3v_sema_wait(&pipe->ready);
+
+        f3v_mutex_lock(&pipe->lock);
+        uint64_t submitted = pipe->submitted;
+        int stop = pipe->stop;
+        f3v_mutex_unlock(&pipe->lock);
+
+        /* Whole blocks only: a short final write is left to the verify pass */
+        while (pipe->checked + F3V_BLOCK_SIZE <= submitted && !pipe->ctx->cancelled &&
+               !pipe->ctx->aborted)
+        {
+            check_block(pipe, submitted);
+        }
+
+        if (stop)
+        {
+            break;
+        }
+    }
+
+    if (pipe->fd >= 0)
+    {
+        f3v_close(pipe->fd);
+    }
+    return 0;
+}
+
+int f3v_readback_start(TestContext *ctx)
+{
+    struct ReadbackPipe *pipe;
+
+    /* Without the lock the totals could not be published safely */
+    if (!g_raw_lock_ready)
+    {
+        return -1;
+    }
+
+    pipe = calloc(1, sizeof(*pipe));
+    if (pipe == NULL)
+    {
+        return -1;
+    }
+
+    /* A resumed run first catches up on what was written before the
+       interruption but not yet read back */
+    pipe->ctx = ctx;
+    pipe->fd = -1;
+    pipe->checked = ctx->resumed ? ctx->raw.verified : ctx->bytes_written;
+    pipe->submitted = ctx->bytes_written;
+
+    f3v_mutex_lock(&g_raw_lock);
+    ctx->raw.verified = pipe->checked;
+    f3v_mutex_unlock(&g_raw_lock);
+
+    pipe->buf = malloc(F3V_BLOCK_SIZE);
+    if (pipe->buf == NULL)
+    {
+        free(pipe);
+        return -1;
+    }
+
+    if (f3v_mutex_init(&pipe->lock, "f3v_raw_lock") < 0)
+    {
+        free(pipe->buf);
+        free(pipe);
+        return -1;
+    }
+    if (f3v_sema_init(&pipe->ready, "f3v_raw_ready", 0) < 0)
+    {
+        f3v_mutex_destroy(&pipe->lock);
+        free(pipe->buf);
+        free(pipe);
+        return -1;
+    }
+    if (f3v_thread_create(&pipe->thread, "f3v_readback", readback_thread, pipe) < 0)
+    {
+        f3v_sema_destroy(&pipe->ready);
+        f3v_mutex_destroy(&pipe->lock);
+        free(pipe->buf);
+        free(pipe);
+        return -1;
+    }
+
+    ctx->raw_pipe = pipe;
+    return 0;
+}
+
+void f3v_readback_submit(TestContext *ctx)
+{
+    struct ReadbackPipe *pipe = ctx->raw_pipe;
+
+    f3v_mutex_lock(&pipe->lock);
+    pipe->submitted = ctx->bytes_written;
+    f3v_mutex_unlock(&pipe->lock);
+
+    f3v_sema_signal(&pipe->ready, 1);
+}
+
+void f3v_readback_stop(TestContext *ctx)
+{
+    struct ReadbackPipe *pipe = ctx->raw_pipe;
+
+    if (pipe == NULL)
+    {
+        return;
+    }
+
+    f3v_mutex_lock(&pipe->lock);
+    pipe->stop = 1;
+    f3v_mutex_unlock(&pipe->lock);
+
+    f3v_sema_signal(&pipe->ready, 1);
+    f3v_thread_join(&pipe->thread);
+
+    f3v_sema_destroy(&pipe->ready);
+    f3v_mutex_destroy(&pipe->lock);
+    free(pipe->buf);
+    free(pipe);
+    ctx->raw_pipe = NULL;
+}
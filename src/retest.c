@@ -0,0 +1,118 @@
+/**
+ * @file retest.c
+ * @brief Targeted re-test of the regions that failed an earlier verify
+ */
+
+#include "retest.h"
+#include "faillist.h"
+#include "pool.h"
+#include "session.h"
+#include "storage.h"
+
+int f3v_retest_step(TestContext *ctx, uint8_t *buf)
+{
+    RetestRun *run = &ctx->run.retest;
+
+    if (run->pass >= run->passes)
+    {
+        return 0;
+    }
+
+    FailRegion *region = &ctx->fail[run->region];
+    uint32_t start;
+    uint32_t count = f3v_fail_span(ctx, region, &start);
+    uint32_t block_idx = start + run->block;
+    int failed = 0;
+
+    ctx->current_file = region->file;
+    ctx->current_block = block_idx;
+
+    /* Open file if needed */
+    if (count > 0 && region->file != ctx->fd_file_idx)
+    {
+        f3v_session_close_file(ctx);
+
+        char filename[128];
+        f3v_get_test_filename(ctx, region->file, filename, sizeof(filename));
+        ctx->fd = f3v_open_rw(filename, 0);
+        ctx->fd_file_idx = ctx->fd >= 0 ? region->file : 0;
+    }
+
+    if (count == 0)
+    {
+        /* File shrank since the failing run: nothing left to test */
+    }
+    else if (ctx->fd < 0)
+    {
+        failed = 1;
+        if (run->reading)
+        {
+            ctx->bytes_corrupted += F3V_BLOCK_SIZE;
+            ctx->bytes_verified += F3V_BLOCK_SIZE;
+        }
+    }
+    else if (!run->reading)
+    {
+        f3v_pool_fill(buf, region->file, block_idx);
+        f3v_throttle_io(&ctx->throttle, F3V_BLOCK_SIZE);
+        if (f3v_write_at(ctx->fd, buf, F3V_BLOCK_SIZE, (uint64_t)block_idx * F3V_BLOCK_SIZE) !=
+            F3V_BLOCK_SIZE)
+        {
+            failed = 1;
+            ctx->bytes_corrupted += F3V_BLOCK_SIZE;
+        }
+    }
+    else
+    {
+        uint32_t first_offset = 0;
+        uint32_t corrupted = F3V_BLOCK_SIZE;
+
+        f3v_throttle_io(&ctx->throttle, F3V_BLOCK_SIZE);
+        if (f3v_read_at(ctx->fd, buf, F3V_BLOCK_SIZE, (uint64_t)block_idx * F3V_BLOCK_SIZE) ==
+            F3V_BLOCK_SIZE)
+        {
+            corrupted = f3v_pool_verify(buf, region->file, block_idx, &first_offset);
+        }
+
+        if (corrupted > 0)
+        {
+            failed = 1;
+            ctx->bytes_corrupted += corrupted;
+            f3v_session_note_first_error(ctx, region->file, block_idx, first_offset);
+        }
+        ctx->bytes_verified += F3V_BLOCK_SIZE;
+    }
+
+    /* Count each pass at most once per region */
+    if (failed && region->last_failed_pass != run->pass + 1)
+    {
+        region->last_failed_pass = run->pass + 1;
+        region->failed_passes++;
+    }
+
+    /* Advance: rewrite all blocks, sync, read them all back, next region */
+    if (++run->block < count)
+    {
+        return 1;
+    }
+    run->block = 0;
+
+    if (!run->reading && count > 0)
+    {
+        if (ctx->fd >= 0)
+        {
+            f3v_sync(ctx->fd);
+        }
+        run->reading = 1;
+        return 1;
+    }
+
+    run->reading = 0;
+    if (++run->region >= ctx->fail_count)
+    {
+        run->region = 0;
+        run->pass++;
+    }
+    return 1;
+}
+
@@ -0,0 +1,1010 @@
+/**
+ * @file rotscan.c
+ * @brief Scans of existing files: bit-rot check against a stored digest
+ *        manifest, or a read-only surface scan
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rotscan.h"
+#include "pool.h"
+#include "profile.h"
+#include "thread.h"
+
+/* Manifest header: magic ("F3VD"), version, entry count, path bytes */
+#define MANIFEST_MAGIC   0x44563346U
+#define MANIFEST_VERSION 1
+#define MANIFEST_HEADER  16
+
+/* Trailing hash of everything before it */
+#define MANIFEST_TRAILER 8
+
+/* Largest manifest accepted when loading */
+#define MANIFEST_MAX (64U * 1024 * 1024)
+
+/* Longest full path (root plus the path below it) */
+#define FULL_PATH (128 + F3V_ROTSCAN_PATH)
+
+/* One read by the reader thread */
+typedef struct {
+    uint8_t *buf;
+    uint32_t file;
+    uint64_t offset;
+    uint64_t span;          /* Bytes tried */
+    int len;                /* Bytes read (all of span), negative on error */
+    uint32_t usec;          /* Time of the read call */
+    int last;               /* Last read of the file */
+} RotSlot;
+
+struct RotPipe {
+    struct RotScanState *state;
+    const RotScanDevice *dev;
+    F3vThread thread;
+    F3vSema filled;         /* Slots read and waiting to be hashed */
+    F3vSema empty;          /* Slots the reader may fill */
+    volatile int stop;
+
+    RotSlot slot[F3V_ROTSCAN_DEPTH];
+    uint32_t taken;         /* Slots hashed so far (stepping thread only) */
+    uint8_t *mem;
+};
+
+/**
+ * Full path of a path below the root
+ */
+static char *full_path(const struct RotScanState *state, const char *path, char *buf,
+                       size_t buf_size)
+{
+    size_t len = strlen(state->root);
+    int bare = path[0] == '\0' ||
+               (len > 0 && (state->root[len - 1] == ':' || state->root[len - 1] == '/'));
+
+    snprintf(buf, buf_size, "%s%s%s", state->root, bare ? "" : "/", path);
+    return buf;
+}
+
+static void put_varint(uint8_t *buf, uint32_t *pos, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        buf[(*pos)++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    buf[(*pos)++] = (uint8_t)v;
+}
+
+/**
+ * @return 0 on success, negative past end or on an overlong value
+ */
+static int get_varint(const uint8_t *buf, uint32_t end, uint32_t *pos, uint64_t *v)
+{
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (*pos >= end)
+        {
+            return -1;
+        }
+
+        uint8_t b = buf[(*pos)++];
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void put_le(uint8_t *buf, uint32_t *pos, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        buf[(*pos)++] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t *buf, uint32_t pos, int bytes)
+{
+    uint64_t v = 0;
+
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+        v = (v << 8) | buf[pos + i];
+    }
+    return v;
+}
+
+/**
+ * Release the previous scan's manifest
+ */
+static void drop_manifest(struct RotScanState *state)
+{
+    free(state->old);
+    free(state->old_arena);
+    state->old = NULL;
+    state->old_arena = NULL;
+    state->old_count = 0;
+}
+
+/**
+ * Decode a manifest into state->old
+ * @return 0 on success, negative if it is damaged or memory runs out
+ */
+static int decode_manifest(struct RotScanState *state, const uint8_t *buf, uint32_t len)
+{
+    if (len < MANIFEST_HEADER + MANIFEST_TRAILER ||
+        get_le(buf, len - MANIFEST_TRAILER, 8) != f3v_hash64(buf, len - MANIFEST_TRAILER, 0) ||
+        get_le(buf, 0, 4) != MANIFEST_MAGIC || get_le(buf, 4, 4) != MANIFEST_VERSION)
+    {
+        return -1;
+    }
+
+    uint32_t count = (uint32_t)get_le(buf, 8, 4);
+    uint32_t path_bytes = (uint32_t)get_le(buf, 12, 4);
+    if (count > F3V_ROTSCAN_MAX_FILES || path_bytes > count * F3V_ROTSCAN_PATH)
+    {
+        return -1;
+    }
+
+    state->old = calloc(count > 0 ? count : 1, sizeof(RotFile));
+    state->old_arena = malloc(path_bytes > 0 ? path_bytes : 1);
+    if (state->old == NULL || state->old_arena == NULL)
+    {
+        drop_manifest(state);
+        return -1;
+    }
+
+    uint32_t end = len - MANIFEST_TRAILER;
+    uint32_t pos = MANIFEST_HEADER;
+    uint32_t used = 0;
+    uint32_t prev_len = 0;
+    const char *prev = "";
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        RotFile *file = &state->old[i];
+        uint64_t shared, rest;
+
+        if (get_varint(buf, end, &pos, &shared) < 0 || get_varint(buf, end, &pos, &rest) < 0 ||
+            shared > prev_len || shared + rest >= F3V_ROTSCAN_PATH ||
+            used + shared + rest + 1 > path_bytes || rest > end - pos)
+        {
+            drop_manifest(state);
+            return -1;
+        }
+
+        /* Shared start from the previous path, then the rest */
+        char *path = state->old_arena + used;
+        memcpy(path, prev, (size_t)shared);
+        memcpy(path + shared, buf + pos, (size_t)rest);
+        path[shared + rest] = '\0';
+        pos += (uint32_t)rest;
+
+        if (get_varint(buf, end, &pos, &file->size) < 0 ||
+            get_varint(buf, end, &pos, &file->mtime) < 0 || end - pos < 8)
+        {
+            drop_manifest(state);
+            return -1;
+        }
+        file->digest = get_le(buf, pos, 8);
+        pos += 8;
+
+        file->path_off = used;
+        file->path = path;
+        prev = path;
+        prev_len = (uint32_t)(shared + rest);
+        used += prev_len + 1;
+    }
+
+    if (pos != end || used != path_bytes)
+    {
+        drop_manifest(state);
+        return -1;
+    }
+    state->old_count = count;
+    return 0;
+}
+
+/**
+ * Load the previous scan's manifest, if any
+ */
+static void load_manifest(struct RotScanState *state, const RotScanDevice *dev)
+{
+    int fd = dev->open_read(dev->handle, state->manifest);
+    if (fd < 0)
+    {
+        state->result.manifest = 0;
+        return;
+    }
+
+    uint8_t *buf = NULL;
+    uint32_t len = 0;
+    int got = F3V_BLOCK_SIZE;
+
+    /* Read until a short read; the size is not stored anywhere else */
+    while (got == F3V_BLOCK_SIZE && len < MANIFEST_MAX)
+    {
+        uint8_t *grown = realloc(buf, len + F3V_BLOCK_SIZE);
+        if (grown == NULL)
+        {
+            got = -1;
+            break;
+        }
+        buf = grown;
+
+        got = dev->read_at(dev->handle, fd, buf + len, F3V_BLOCK_SIZE, len);
+        if (got > 0)
+        {
+            len += (uint32_t)got;
+        }
+    }
+    dev->close(dev->handle, fd);
+
+    state->result.manifest = got >= 0 && len < MANIFEST_MAX && decode_manifest(state, buf, len) == 0
+                                 ? 1
+                                 : -1;
+    free(buf);
+}
+
+/**
+ * Encode the files with a known digest as a manifest
+ * @return Manifest (free() it), or NULL if memory runs out
+ */
+static uint8_t *encode_manifest(const struct RotScanState *state, uint32_t *out_len)
+{
+    /* Per file at most two 2-byte path lengths, two 10-byte integers and the digest */
+    uint8_t *buf = malloc(MANIFEST_HEADER + (size_t)state->count * 32 + state->arena_len +
+                          MANIFEST_TRAILER);
+    if (buf == NULL)
+    {
+        return NULL;
+    }
+
+    uint32_t pos = MANIFEST_HEADER;
+    uint32_t count = 0;
+    uint32_t path_bytes = 0;
+    const char *prev = "";
+
+    for (uint32_t i = 0; i < state->count; i++)
+    {
+        const RotFile *file = &state->files[i];
+        uint64_t digest = file->digest;
+
+        /* A corrupted or unreadable unchanged file keeps being checked against its old digest */
+        if (file->status == ROT_FILE_MISMATCHED ||
+            (file->status == ROT_FILE_UNREADABLE && file->expect != 0))
+        {
+            digest = file->expect;
+        }
+        else if (file->status == ROT_FILE_UNREADABLE)
+        {
+            continue;
+        }
+
+        uint32_t shared = 0;
+        uint32_t len = (uint32_t)strlen(file->path);
+        while (prev[shared] != '\0' && prev[shared] == file->path[shared])
+        {
+            shared++;
+        }
+
+        put_varint(buf, &pos, shared);
+        put_varint(buf, &pos, len - shared);
+        memcpy(buf + pos, file->path + shared, len - shared);
+        pos += len - shared;
+        put_varint(buf, &pos, file->size);
+        put_varint(buf, &pos, file->mtime);
+        put_le(buf, &pos, digest, 8);
+
+        prev = file->path;
+        path_bytes += len + 1;
+        count++;
+    }
+
+    uint32_t header = 0;
+    put_le(buf, &header, MANIFEST_MAGIC, 4);
+    put_le(buf, &header, MANIFEST_VERSION, 4);
+    put_le(buf, &header, count, 4);
+    put_le(buf, &header, path_bytes, 4);
+    put_le(buf, &pos, f3v_hash64(buf, pos, 0), 8);
+
+    *out_len = pos;
+    return buf;
+}
+
+/**
+ * Replace the manifest: write a new file, then swap it in
+ */
+static void save_manifest(struct RotScanState *state, const RotScanDevice *dev)
+{
+    char temp[sizeof(state->manifest) + 8];
+    uint32_t len = 0;
+
+    uint8_t *buf = encode_manifest(state, &len);
+    if (buf == NULL)
+    {
+        return;
+    }
+
+    snprintf(temp, sizeof(temp), "%s.new", state->manifest);
+    if (dev->write_file(dev->handle, temp, buf, len) == (int)len)
+    {
+        dev->remove(dev->handle, state->manifest);
+        state->result.saved = dev->rename(dev->handle, temp, state->manifest) >= 0;
+    }
+    free(buf);
+}
+
+/**
+ * Add a file found by the walk
+ * @return 0 on success (or skipped), negative if memory runs out
+ */
+static int add_file(struct RotScanState *state, const char *path, const RotDirEntry *entry)
+{
+    uint32_t len = (uint32_t)strlen(path) + 1;
+
+    if (state->count == F3V_ROTSCAN_MAX_FILES)
+    {
+        state->result.skipped++;
+        return 0;
+    }
+
+    if (state->count == state->capacity)
+    {
+        uint32_t capacity = state->capacity > 0 ? state->capacity * 2 : 1024;
+        RotFile *files = realloc(state->files, (size_t)capacity * sizeof(RotFile));
+        if (files == NULL)
+        {
+            return -1;
+        }
+        state->files = files;
+        state->capacity = capacity;
+    }
+    if (state->arena_len + len > state->arena_capacity)
+    {
+        uint32_t capacity = state->arena_capacity > 0 ? state->arena_capacity * 2 : 65536;
+        char *arena = realloc(state->arena, capacity);
+        if (arena == NULL)
+        {
+            return -1;
+        }
+        state->arena = arena;
+        state->arena_capacity = capacity;
+    }
+
+    RotFile *file = &state->files[state->count++];
+    memset(file, 0, sizeof(*file));
+    file->path_off = state->arena_len;
+    file->size = entry->size;
+    file->mtime = entry->mtime;
+    memcpy(state->arena + state->arena_len, path, len);
+    state->arena_len += len;
+
+    state->result.files++;
+    state->result.bytes += entry->size;
+    return 0;
+}
+
+static int compare_path(const void *a, const void *b)
+{
+    return strcmp(((const RotFile *)a)->path, ((const RotFile *)b)->path);
+}
+
+/**
+ * Sort the files and mark each against the manifest (both in path order)
+ */
+static void match_manifest(struct RotScanState *state)
+{
+    uint32_t j = 0;
+    uint32_t found = 0;
+
+    for (uint32_t i = 0; i < state->count; i++)
+    {
+        state->files[i].path = state->arena + state->files[i].path_off;
+    }
+    if (state->count > 1)
+    {
+        qsort(state->files, state->count, sizeof(RotFile), compare_path);
+    }
+
+    for (uint32_t i = 0; i < state->count; i++)
+    {
+        RotFile *file = &state->files[i];
+
+        while (j < state->old_count && strcmp(state->old[j].path, file->path) < 0)
+        {
+            j++;
+        }
+        if (j == state->old_count || strcmp(state->old[j].path, file->path) != 0)
+        {
+            file->status = ROT_FILE_NEW;
+            continue;
+        }
+
+        const RotFile *old = &state->old[j++];
+        found++;
+        if (old->size == file->size && old->mtime == file->mtime)
+        {
+            file->status = ROT_FILE_CHECK;
+            file->expect = old->digest;
+        }
+        else
+        {
+            file->status = ROT_FILE_CHANGED;
+        }
+    }
+
+    state->result.missing = state->old_count - found;
+    drop_manifest(state);
+}
+
+/**
+ * Read and time one span of a file
+ * @return len, or negative on error or a short read
+ */
+static int timed_read(const RotScanDevice *dev, int fd, uint8_t *buf, uint32_t len,
+                      uint64_t offset, uint32_t *usec)
+{
+    uint64_t t0 = dev->now_usec(dev->handle);
+    int got = dev->read_at(dev->handle, fd, buf, len, offset);
+
+    *usec = (uint32_t)(dev->now_usec(dev->handle) - t0);
+    return got == (int)len ? got : -1;
+}
+
+/**
+ * Reader thread: read every file in order into the ring
+ */
+static int reader_thread(void *arg)
+{
+    struct RotPipe *pipe = (struct RotPipe *)arg;
+    const struct RotScanState *state = pipe->state;
+    const RotScanDevice *dev = pipe->dev;
+    int profile_applied = -1;
+    uint32_t filled = 0;
+    char path[FULL_PATH];
+
+    for (uint32_t f = 0; f < state->count && !pipe->stop; f++)
+    {
+        const RotFile *file = &state->files[f];
+        int fd = dev->open_read(dev->handle, full_path(state, file->path, path, sizeof(path)));
+        uint64_t offset = 0;
+        uint64_t retry_end = 0;     /* Read block by block up to here after an error */
+        int last = 0;
+
+        while (!last)
+        {
+            f3v_profile_refresh(ROLE_IO, &profile_applied);
+            f3v_sema_wait(&pipe->empty);
+            if (pipe->stop)
+            {
+                break;
+            }
+
+            RotSlot *slot = &pipe->slot[filled++ % F3V_ROTSCAN_DEPTH];
+            uint64_t left = file->size - offset;
+            uint32_t size = offset < retry_end ? F3V_BLOCK_SIZE : state->read_size;
+            uint32_t want = left < size ? (uint32_t)left : size;
+
+            slot->file = f;
+            slot->offset = offset;
+            slot->span = fd < 0 ? left : want;
+            slot->len = fd < 0 ? -1 : 0;
+            slot->usec = 0;
+            if (fd >= 0 && want > 0)
+            {
+                slot->len = timed_read(dev, fd, slot->buf, want, offset, &slot->usec);
+
+                /* Narrow a failed large read down to the blocks that fail */
+                if (slot->len < 0 && want > F3V_BLOCK_SIZE)
+                {
+                    retry_end = offset + want;
+                    slot->span = F3V_BLOCK_SIZE;
+                    slot->len = timed_read(dev, fd, slot->buf, F3V_BLOCK_SIZE, offset, &slot->usec);
+                }
+            }
+
+            /* The bit-rot scan gives a file up at its first error; the surface scan reads on */
+            offset += slot->span;
+            last = offset >= file->size || (slot->len < 0 && !state->surface);
+            slot->last = last;
+            f3v_sema_signal(&pipe->filled, 1);
+        }
+
+        if (fd >= 0)
+        {
+            dev->close(dev->handle, fd);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Start the reader thread and its ring
+ * @return 0 on success, negative on error
+ */
+static int start_pipe(struct RotScanState *state, const RotScanDevice *dev)
+{
+    struct RotPipe *pipe = calloc(1, sizeof(*pipe));
+    if (pipe == NULL)
+    {
+        return -1;
+    }
+
+    pipe->state = state;
+    pipe->dev = dev;
+    pipe->mem = malloc((size_t)F3V_ROTSCAN_DEPTH * state->read_size + 64);
+    if (pipe->mem == NULL)
+    {
+        free(pipe);
+        return -1;
+    }
+
+    uint8_t *base = (uint8_t *)(((uintptr_t)pipe->mem + 63) & ~(uintptr_t)63);
+    for (uint32_t i = 0; i < F3V_ROTSCAN_DEPTH; i++)
+    {
+        pipe->slot[i].buf = base + (size_t)i * state->read_size;
+    }
+
+    if (f3v_sema_init(&pipe->filled, "f3v_rot_filled", 0) < 0)
+    {
+        free(pipe->mem);
+        free(pipe);
+        return -1;
+    }
+    if (f3v_sema_init(&pipe->empty, "f3v_rot_empty", F3V_ROTSCAN_DEPTH) < 0)
+    {
+        f3v_sema_destroy(&pipe->filled);
+        free(pipe->mem);
+        free(pipe);
+        return -1;
+    }
+    if (f3v_thread_create(&pipe->thread, "f3v_rotscan", reader_thread, pipe) < 0)
+    {
+        f3v_sema_destroy(&pipe->empty);
+        f3v_sema_destroy(&pipe->filled);
+        free(pipe->mem);
+        free(pipe);
+        return -1;
+    }
+
+    state->pipe = pipe;
+    return 0;
+}
+
+/**
+ * Stop the reader thread (if running) and release the ring
+ */
+static void stop_pipe(struct RotScanState *state)
+{
+    struct RotPipe *pipe = state->pipe;
+
+    if (pipe == NULL)
+    {
+        return;
+    }
+
+    /* The reader only waits for an empty slot */
+    pipe->stop = 1;
+    f3v_sema_signal(&pipe->empty, 1);
+    f3v_thread_join(&pipe->thread);
+
+    f3v_sema_destroy(&pipe->empty);
+    f3v_sema_destroy(&pipe->filled);
+    free(pipe->mem);
+    free(pipe);
+    state->pipe = NULL;
+}
+
+/**
+ * Open the root and start the walk
+ * @return 1 on success, negative if the root cannot be read
+ */
+static int begin_walk(struct RotScanState *state, const RotScanDevice *dev)
+{
+    int dir = dev->dir_open(dev->handle, state->root);
+    if (dir < 0)
+    {
+        return -1;
+    }
+
+    state->dir[0] = dir;
+    state->dir_path_len[0] = 0;
+    state->depth = 1;
+    state->path[0] = '\0';
+    state->stage = ROTSCAN_WALK;
+    return 1;
+}
+
+/**
+ * Match the files found with the manifest and start hashing them
+ * @return 1 on success, negative on error
+ */
+static int end_walk(struct RotScanState *state, const RotScanDevice *dev)
+{
+    match_manifest(state);
+
+    if (state->count == 0)
+    {
+        state->stage = ROTSCAN_SAVE;
+        return 1;
+    }
+    /* The clock is the reader's from here on */
+    state->hash_start = dev->now_usec(dev->handle);
+    if (start_pipe(state, dev) < 0)
+    {
+        return -1;
+    }
+    state->stage = ROTSCAN_HASH;
+    return 1;
+}
+
+/**
+ * Read the next batch of directory entries
+ */
+static int walk_step(struct RotScanState *state, const RotScanDevice *dev)
+{
+    char path[F3V_ROTSCAN_PATH];
+    char full[FULL_PATH];
+    RotDirEntry entry;
+
+    for (uint32_t n = 0; n < F3V_ROTSCAN_WALK_BATCH && state->depth > 0; n++)
+    {
+        uint32_t top = state->depth - 1;
+        int ret = dev->dir_read(dev->handle, state->dir[top], &entry);
+
+        /* End of the directory (or an error, which ends it early) */
+        if (ret <= 0)
+        {
+            if (ret < 0)
+            {
+                state->result.skipped++;
+            }
+            dev->dir_close(dev->handle, state->dir[top]);
+            state->depth--;
+            if (state->depth > 0)
+            {
+                state->path[state->dir_path_len[state->depth - 1]] = '\0';
+            }
+            continue;
+        }
+
+        if (strcmp(entry.name, ".") == 0 || strcmp(entry.name, "..") == 0)
+        {
+            continue;
+        }
+
+        int len = snprintf(path, sizeof(path), "%s%s%s", state->path,
+                           state->path[0] != '\0' ? "/" : "", entry.name);
+        if (len < 0 || (size_t)len >= sizeof(path))
+        {
+            state->result.skipped++;
+            continue;
+        }
+
+        if (!entry.is_dir)
+        {
+            if (add_file(state, path, &entry) < 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        if (strcmp(full_path(state, path, full, sizeof(full)), state->exclude) == 0)
+        {
+            continue;
+        }
+
+        int dir = state->depth <= F3V_ROTSCAN_MAX_DEPTH ? dev->dir_open(dev->handle, full) : -1;
+        if (dir < 0)
+        {
+            state->result.skipped++;
+            continue;
+        }
+        state->dir[state->depth] = dir;
+        state->dir_path_len[state->depth] = (uint32_t)len;
+        state->depth++;
+        memcpy(state->path, path, (size_t)len + 1);
+    }
+
+    return state->depth > 0 ? 1 : end_walk(state, dev);
+}
+
+/**
+ * Count a bad region and list it, or extend the last one if this follows on
+ */
+static void note_region(struct RotScanState *state, RotBadKind kind, uint64_t offset,
+                        uint64_t length, uint32_t kbs)
+{
+    RotScanResult *result = &state->result;
+    const RotFile *file = &state->files[state->file];
+
+    if (kind == ROT_BAD_SLOW)
+    {
+        result->slow_bytes += length;
+    }
+    else
+    {
+        result->bad_bytes += length;
+        if (kind == ROT_BAD_UNREADABLE)
+        {
+            result->error_bytes += length;
+        }
+    }
+
+    if (state->region_file == state->file && state->region_kind == kind &&
+        state->region_end == offset)
+    {
+        state->region_end += length;
+        if (state->region_listed >= 0)
+        {
+            RotBadRegion *bad = &result->bad[state->region_listed];
+
+            bad->length += length;
+            bad->min_kbs = kbs < bad->min_kbs ? kbs : bad->min_kbs;
+        }
+        return;
+    }
+
+    state->region_file = state->file;
+    state->region_kind = kind;
+    state->region_end = offset + length;
+    state->region_listed = -1;
+    if (kind == ROT_BAD_SLOW)
+    {
+        result->slow_regions++;
+    }
+    else if (kind == ROT_BAD_UNREADABLE)
+    {
+        result->error_regions++;
+    }
+
+    if (result->bad_count == F3V_ROTSCAN_BAD)
+    {
+        result->bad_lost++;
+        return;
+    }
+
+    /* The end of a long path says more than its start */
+    RotBadRegion *bad = &result->bad[result->bad_count];
+    size_t len = strlen(file->path);
+    size_t skip = len >= sizeof(bad->path) ? len - (sizeof(bad->path) - 1) : 0;
+
+    memcpy(bad->path, file->path + skip, len - skip + 1);
+    bad->kind = kind;
+    bad->offset = offset;
+    bad->length = length;
+    bad->min_kbs = kbs;
+    state->region_listed = (int)result->bad_count++;
+}
+
+/**
+ * Judge a file once its last block is hashed
+ */
+static void finish_file(struct RotScanState *state, RotFile *file)
+{
+    RotScanResult *result = &state->result;
+
+    if (state->file_failed)
+    {
+        file->status = ROT_FILE_UNREADABLE;
+        result->unreadable++;
+        if (!state->surface)
+        {
+            note_region(state, ROT_BAD_UNREADABLE, 0, file->size, 0);
+        }
+        return;
+    }
+    if (state->surface)
+    {
+        return;
+    }
+
+    file->digest = f3v_hash64_final(&state->hash);
+    switch (file->status)
+    {
+    case ROT_FILE_NEW:
+        result->added++;
+        break;
+    case ROT_FILE_CHANGED:
+        result->changed++;
+        break;
+    default:
+        if (file->digest == file->expect)
+        {
+            file->status = ROT_FILE_MATCHED;
+            result->matched++;
+        }
+        else
+        {
+            file->status = ROT_FILE_MISMATCHED;
+            result->mismatched++;
+            note_region(state, ROT_BAD_MISMATCH, 0, file->size, 0);
+        }
+        break;
+    }
+}
+
+/**
+ * Time of the reads so far
+ */
+static void read_stats(struct RotScanState *state, uint64_t usec)
+{
+    RotScanResult *result = &state->result;
+
+    result->hash_usec = usec;
+    result->read_kbs = usec > 0 ? (uint32_t)(state->hashed / 1024 * 1000000 / usec) : 0;
+    result->lat_p50_us = f3v_hist_percentile(&state->lat, 0.50);
+    result->lat_p99_us = f3v_hist_percentile(&state->lat, 0.99);
+    result->lat_max_us = state->lat.max_usec;
+}
+
+/**
+ * Hash (or for a surface scan, just account for) the next read the reader has ready
+ */
+static void hash_step(struct RotScanState *state, const RotScanDevice *dev)
+{
+    struct RotPipe *pipe = state->pipe;
+    RotSlot *slot = &pipe->slot[pipe->taken % F3V_ROTSCAN_DEPTH];
+    uint64_t leaves[F3V_DIGEST_LEAVES];
+
+    f3v_sema_wait(&pipe->filled);
+
+    RotFile *file = &state->files[slot->file];
+    if (slot->offset == 0)
+    {
+        f3v_digest_begin(&state->hash, file->size);
+        state->file_failed = 0;
+    }
+
+    if (slot->len < 0)
+    {
+        state->file_failed = 1;
+        if (state->surface)
+        {
+            note_region(state, ROT_BAD_UNREADABLE, slot->offset, slot->span, 0);
+        }
+    }
+    else if (slot->len > 0)
+    {
+        uint32_t usec = slot->usec > 0 ? slot->usec : 1;
+        uint32_t kbs = (uint32_t)((uint64_t)slot->len / 1024 * 1000000 / usec);
+
+        /* Small files and tails are mostly latency; only whole blocks can be slow */
+        f3v_hist_add(&state->lat, slot->usec);
+        if (state->surface && slot->len >= F3V_BLOCK_SIZE && kbs < F3V_SURFACE_SLOW_KBS)
+        {
+            note_region(state, ROT_BAD_SLOW, slot->offset, (uint64_t)slot->len, kbs);
+        }
+        if (!state->surface)
+        {
+            uint32_t count = f3v_pool_hash(slot->buf, (uint32_t)slot->len,
+                                           slot->offset / F3V_DIGEST_LEAF, leaves);
+            f3v_digest_add(&state->hash, leaves, count);
+        }
+        state->hashed += (uint64_t)slot->len;
+    }
+
+    /* Hand the buffer back before judging the file */
+    int last = slot->last;
+    pipe->taken++;
+    f3v_sema_signal(&pipe->empty, 1);
+
+    if (!last)
+    {
+        return;
+    }
+
+    finish_file(state, file);
+    state->file++;
+    if (state->file == state->count)
+    {
+        stop_pipe(state);
+        read_stats(state, dev->now_usec(dev->handle) - state->hash_start);
+        state->stage = ROTSCAN_SAVE;
+    }
+}
+
+int f3v_rotscan_init(struct RotScanState *state, const char *root, const char *exclude,
+                     const char *manifest)
+{
+    memset(state, 0, sizeof(*state));
+
+    if (strlen(root) >= sizeof(state->root) || strlen(exclude) >= sizeof(state->exclude) ||
+        strlen(manifest) >= sizeof(state->manifest))
+    {
+        return -1;
+    }
+
+    strcpy(state->root, root);
+    strcpy(state->exclude, exclude);
+    strcpy(state->manifest, manifest);
+    snprintf(state->result.root, sizeof(state->result.root), "%s", root);
+    state->read_size = F3V_BLOCK_SIZE;
+    state->region_file = UINT32_MAX;
+    state->region_listed = -1;
+    state->stage = ROTSCAN_LOAD;
+    return 0;
+}
+
+int f3v_rotscan_init_surface(struct RotScanState *state, const char *root, const char *exclude)
+{
+    if (f3v_rotscan_init(state, root, exclude, "") < 0)
+    {
+        return -1;
+    }
+
+    state->surface = 1;
+    state->read_size = F3V_SURFACE_READ;
+    return 0;
+}
+
+int f3v_rotscan_step(struct RotScanState *state, const RotScanDevice *dev)
+{
+    switch (state->stage)
+    {
+    case ROTSCAN_LOAD:
+        if (!state->surface)
+        {
+            load_manifest(state, dev);
+        }
+        return begin_walk(state, dev);
+
+    case ROTSCAN_WALK:
+        return walk_step(state, dev);
+
+    case ROTSCAN_HASH:
+        hash_step(state, dev);
+        return 1;
+
+    case ROTSCAN_SAVE:
+        if (!state->surface)
+        {
+            save_manifest(state, dev);
+        }
+        state->stage = ROTSCAN_DONE;
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+void f3v_rotscan_free(struct RotScanState *state, const RotScanDevice *dev)
+{
+    stop_pipe(state);
+
+    while (state->depth > 0)
+    {
+        dev->dir_close(dev->handle, state->dir[--state->depth]);
+    }
+
+    drop_manifest(state);
+    free(state->files);
+    free(state->arena);
+    state->files = NULL;
+    state->arena = NULL;
+    state->count = 0;
+    state->capacity = 0;
+    state->arena_len = 0;
+    state->arena_capacity = 0;
+}
+
+const char *f3v_rotscan_stage_name(RotScanStage stage)
+{
+    static const char *names[] = {"load", "walk", "hash", "save", "done"};
+
+    return stage <= ROTSCAN_DONE ? names[stage] : "?";
+}
+
+const char *f3v_rotscan_bad_name(RotBadKind kind)
+{
+    static const char *names[] = {"mismatch", "unreadable", "slow"};
+
+    return kind <= ROT_BAD_SLOW ? names[kind] : "?";
+}
@@ -0,0 +1,484 @@
+/**
+ * @file sample.c
+ * @brief Stratified random block selection for sampling mode
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "sample.h"
+#include "pool.h"
+#include "session.h"
+#include "stats.h"
+#include "storage.h"
+#include "ui.h"
+
+typedef struct {
+    uint64_t first;         /* First block of the zone */
+    uint64_t count;
+    uint64_t remaining;     /* Blocks not sampled yet */
+    uint32_t samples;
+    uint32_t bad;
+    uint64_t write_usec;
+    uint32_t writes;
+    int32_t credit;         /* Weighted round-robin balance */
+} SampleZone;
+
+struct SampleState {
+    uint64_t rng;
+    uint8_t *taken;         /* One bit per block */
+
+    SampleZone zone[F3V_SAMPLE_ZONES];
+    uint32_t zone_count;
+    uint64_t write_usec;    /* All writes, for spotting slow zones */
+    uint64_t writes;
+
+    /* Current batch, sorted by position */
+    uint64_t batch[F3V_SAMPLE_BATCH];
+    uint8_t batch_zone[F3V_SAMPLE_BATCH];
+    uint8_t batch_failed[F3V_SAMPLE_BATCH];
+    uint32_t batch_len;
+    uint32_t batch_pos;
+    int reading;
+
+    uint64_t fd_end;        /* Size of the open file; a write past it allocates the gap */
+};
+
+/**
+ * xorshift64* step
+ */
+static uint64_t next_random(struct SampleState *s)
+{
+    s->rng ^= s->rng >> 12;
+    s->rng ^= s->rng << 25;
+    s->rng ^= s->rng >> 27;
+    return s->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Zone weight: errors and slow writes draw extra samples (0 = exhausted)
+ */
+static int32_t zone_weight(const struct SampleState *s, const SampleZone *zone)
+{
+    int32_t weight = 1;
+
+    if (zone->remaining == 0)
+    {
+        return 0;
+    }
+    if (zone->bad > 0)
+    {
+        weight += 3;
+    }
+
+    /* Slow: average write over 1.5x the average across all zones */
+    if (zone->writes >= 2 && s->writes > 0 &&
+        zone->write_usec * s->writes * 2 > s->write_usec * zone->writes * 3)
+    {
+        weight += 1;
+    }
+
+    return weight;
+}
+
+/**
+ * Pick the next zone by smooth weighted round-robin
+ * @return Zone index, or -1 once every block has been sampled
+ */
+static int pick_zone(struct SampleState *s)
+{
+    int32_t total = 0;
+    int best = -1;
+
+    for (uint32_t i = 0; i < s->zone_count; i++)
+    {
+        int32_t weight = zone_weight(s, &s->zone[i]);
+        if (weight == 0)
+        {
+            continue;
+        }
+
+        s->zone[i].credit += weight;
+        total += weight;
+        if (best < 0 || s->zone[i].credit > s->zone[best].credit)
+        {
+            best = (int)i;
+        }
+    }
+
+    if (best >= 0)
+    {
+        s->zone[best].credit -= total;
+    }
+    return best;
+}
+
+/**
+ * Draw an unsampled block from a zone (the zone must have one left)
+ */
+static uint64_t draw_block(struct SampleState *s, SampleZone *zone)
+{
+    uint64_t start = next_random(s) % zone->count;
+
+    for (uint64_t k = 0;; k++)
+    {
+        uint64_t block = zone->first + (start + k) % zone->count;
+        if (!(s->taken[block / 8] & (1 << (block % 8))))
+        {
+            s->taken[block / 8] |= (uint8_t)(1 << (block % 8));
+            zone->remaining--;
+            return block;
+        }
+    }
+}
+
+/**
+ * Fill the next batch
+ * @return Number of blocks in the batch
+ */
+static uint32_t new_batch(TestContext *ctx)
+{
+    struct SampleState *s = ctx->run.sample.state;
+
+    s->batch_len = 0;
+    s->batch_pos = 0;
+    s->reading = 0;
+
+    while (s->batch_len < F3V_SAMPLE_BATCH)
+    {
+        int z = pick_zone(s);
+        if (z < 0)
+        {
+            break;
+        }
+
+        if (zone_weight(s, &s->zone[z]) > 1)
+        {
+            ctx->run.sample.extra++;
+        }
+
+        /* Insert in position order so writes move forward through each file */
+        uint64_t block = draw_block(s, &s->zone[z]);
+        uint32_t i = s->batch_len++;
+        while (i > 0 && s->batch[i - 1] > block)
+        {
+            s->batch[i] = s->batch[i - 1];
+            s->batch_zone[i] = s->batch_zone[i - 1];
+            i--;
+        }
+        s->batch[i] = block;
+        s->batch_zone[i] = (uint8_t)z;
+    }
+
+    for (uint32_t i = 0; i < s->batch_len; i++)
+    {
+        s->batch_failed[i] = 0;
+    }
+    return s->batch_len;
+}
+
+/**
+ * Refresh the estimate of the blocks the run will sample (progress total)
+ */
+static void update_estimate(TestContext *ctx)
+{
+    uint64_t estimate = ctx->run.sample.total_blocks;
+
+    if (ctx->run.sample.budget_sec > 0)
+    {
+        uint64_t elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+        if (elapsed > 0)
+        {
+            uint64_t projected =
+                ctx->run.sample.count * ctx->run.sample.budget_sec * 1000000ULL / elapsed;
+            if (projected < estimate)
+            {
+                estimate = projected;
+            }
+        }
+    }
+
+    if (ctx->run.sample.target_ppm > 0)
+    {
+        uint64_t needed = ctx->run.sample.count;
+        if (ctx->run.sample.upper_ppm > ctx->run.sample.target_ppm)
+        {
+            /* Assume no further failures, but at least one more batch */
+            needed = f3v_wilson_samples_needed(ctx->run.sample.target_ppm / 1e6, F3V_Z_95);
+            if (needed < ctx->run.sample.count + F3V_SAMPLE_BATCH)
+            {
+                needed = ctx->run.sample.count + F3V_SAMPLE_BATCH;
+            }
+        }
+        if (needed < estimate)
+        {
+            estimate = needed;
+        }
+    }
+
+    if (estimate < ctx->run.sample.count)
+    {
+        estimate = ctx->run.sample.count;
+    }
+    ctx->total_expected = estimate * F3V_BLOCK_SIZE;
+}
+
+/**
+ * Count a finished sample
+ */
+static void record(TestContext *ctx, SampleZone *zone, int bad)
+{
+    zone->samples++;
+    ctx->run.sample.count++;
+    if (bad)
+    {
+        zone->bad++;
+        ctx->run.sample.bad++;
+    }
+
+    double upper = f3v_wilson_upper(ctx->run.sample.bad, ctx->run.sample.count, F3V_Z_95);
+    ctx->run.sample.upper_ppm = (uint32_t)ceil(upper * 1e6);
+
+    update_estimate(ctx);
+}
+
+/**
+ * Check whether another batch should be started
+ */
+static int keep_going(const TestContext *ctx)
+{
+    if (ctx->run.sample.budget_sec > 0 &&
+        f3v_get_time_usec() - ctx->phase_start_time >= ctx->run.sample.budget_sec * 1000000ULL)
+    {
+        return 0;
+    }
+    if (ctx->run.sample.target_ppm > 0 && ctx->run.sample.count > 0 &&
+        ctx->run.sample.upper_ppm <= ctx->run.sample.target_ppm)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+int f3v_sample_start(TestContext *ctx)
+{
+    uint64_t total = ctx->run.sample.total_blocks;
+
+    if (total == 0)
+    {
+        return -1;
+    }
+
+    struct SampleState *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+    {
+        return -1;
+    }
+    s->taken = calloc((size_t)((total + 7) / 8), 1);
+    if (s->taken == NULL)
+    {
+        free(s);
+        return -1;
+    }
+
+    s->rng = ((uint64_t)ctx->session_nonce << 32) | 0x9E3779B9u;
+
+    s->zone_count = total < F3V_SAMPLE_ZONES ? (uint32_t)total : F3V_SAMPLE_ZONES;
+    for (uint32_t i = 0; i < s->zone_count; i++)
+    {
+        SampleZone *zone = &s->zone[i];
+        zone->first = total * i / s->zone_count;
+        zone->count = total * (i + 1) / s->zone_count - zone->first;
+        zone->remaining = zone->count;
+    }
+
+    ctx->run.sample.state = s;
+    update_estimate(ctx);
+    return 0;
+}
+
+int f3v_sample_next(TestContext *ctx, uint32_t *file_idx, uint32_t *block_idx, int *reading)
+{
+    struct SampleState *s = ctx->run.sample.state;
+
+    for (;;)
+    {
+        if (s->batch_pos < s->batch_len)
+        {
+            /* Failed writes were already counted */
+            if (s->reading && s->batch_failed[s->batch_pos])
+            {
+                s->batch_pos++;
+                continue;
+            }
+
+            uint64_t block = s->batch[s->batch_pos];
+            *file_idx = (uint32_t)(block / F3V_BLOCKS_PER_FILE) + 1;
+            *block_idx = (uint32_t)(block % F3V_BLOCKS_PER_FILE);
+            *reading = s->reading;
+            return 1;
+        }
+
+        /* Batch written: read it all back */
+        if (!s->reading && s->batch_len > 0)
+        {
+            s->reading = 1;
+            s->batch_pos = 0;
+            continue;
+        }
+
+        if (!keep_going(ctx) || new_batch(ctx) == 0)
+        {
+            return 0;
+        }
+    }
+}
+
+void f3v_sample_wrote(TestContext *ctx, uint32_t usec, int failed, int extended)
+{
+    struct SampleState *s = ctx->run.sample.state;
+    SampleZone *zone = &s->zone[s->batch_zone[s->batch_pos]];
+
+    if (!extended)
+    {
+        zone->write_usec += usec;
+        zone->writes++;
+        s->write_usec += usec;
+        s->writes++;
+    }
+
+    if (failed)
+    {
+        s->batch_failed[s->batch_pos] = 1;
+        record(ctx, zone, 1);
+    }
+    s->batch_pos++;
+}
+
+void f3v_sample_checked(TestContext *ctx, int bad)
+{
+    struct SampleState *s = ctx->run.sample.state;
+
+    record(ctx, &s->zone[s->batch_zone[s->batch_pos]], bad);
+    s->batch_pos++;
+}
+
+int f3v_sample_step(TestContext *ctx, uint8_t *buf)
+{
+    struct SampleState *s = ctx->run.sample.state;
+    uint32_t file_idx, block_idx;
+    int reading;
+
+    if (!f3v_sample_next(ctx, &file_idx, &block_idx, &reading))
+    {
+        return 0;
+    }
+
+    ctx->current_file = file_idx;
+    ctx->current_block = block_idx;
+
+    /* The whole batch is on the card before any of it is read back */
+    if (reading != ctx->run.sample.reading)
+    {
+        if (ctx->fd >= 0)
+        {
+            f3v_sync(ctx->fd);
+        }
+        f3v_session_close_file(ctx);
+        ctx->run.sample.reading = reading;
+    }
+
+    /* Open file if needed */
+    if (file_idx != ctx->fd_file_idx)
+    {
+        if (ctx->fd >= 0 && !reading)
+        {
+            f3v_sync(ctx->fd);
+        }
+        f3v_session_close_file(ctx);
+
+        char filename[128];
+        f3v_get_test_filename(ctx, file_idx, filename, sizeof(filename));
+        int64_t size = f3v_get_file_size(filename);
+        s->fd_end = size > 0 ? (uint64_t)size : 0;
+        ctx->fd = f3v_open_rw(filename, 1);
+        ctx->fd_file_idx = ctx->fd >= 0 ? file_idx : 0;
+
+        if (file_idx > ctx->files_written)
+        {
+            ctx->files_written = file_idx;
+        }
+    }
+
+    uint64_t offset = (uint64_t)block_idx * F3V_BLOCK_SIZE;
+
+    if (!reading)
+    {
+        f3v_pool_fill(buf, file_idx, block_idx);
+        f3v_throttle_io(&ctx->throttle, F3V_BLOCK_SIZE);
+
+        /* The file system fills the gap before a write past the end of the
+           file, which says nothing about the zone's speed */
+        int extended = offset > s->fd_end;
+        uint64_t write_start = f3v_get_time_usec();
+        int failed = ctx->fd < 0 ||
+                     f3v_write_at(ctx->fd, buf, F3V_BLOCK_SIZE, offset) != F3V_BLOCK_SIZE;
+        f3v_sample_wrote(ctx, (uint32_t)(f3v_get_time_usec() - write_start), failed, extended);
+        if (!failed && offset + F3V_BLOCK_SIZE > s->fd_end)
+        {
+            s->fd_end = offset + F3V_BLOCK_SIZE;
+        }
+
+        if (failed)
+        {
+            ctx->bytes_corrupted += F3V_BLOCK_SIZE;
+            f3v_session_note_error(ctx, file_idx, block_idx, 0);
+        }
+        else
+        {
+            ctx->bytes_written += F3V_BLOCK_SIZE;
+        }
+        return 1;
+    }
+
+    /* Read back and verify */
+    uint32_t first_offset = 0;
+    uint32_t corrupted = F3V_BLOCK_SIZE;
+    int aliased = 0;
+
+    f3v_throttle_io(&ctx->throttle, F3V_BLOCK_SIZE);
+    if (ctx->fd >= 0 && f3v_read_at(ctx->fd, buf, F3V_BLOCK_SIZE, offset) == F3V_BLOCK_SIZE)
+    {
+        corrupted = f3v_pool_verify(buf, file_idx, block_idx, &first_offset);
+    }
+
+    if (corrupted > 0)
+    {
+        ctx->bytes_corrupted += corrupted;
+        f3v_session_note_error(ctx, file_idx, block_idx, first_offset);
+        aliased = f3v_session_note_alias(ctx, buf, file_idx, block_idx);
+    }
+    ctx->bytes_verified += F3V_BLOCK_SIZE;
+    f3v_sample_checked(ctx, corrupted > 0);
+
+    if (f3v_session_check_abort(ctx, corrupted, aliased))
+    {
+        ctx->aborted = 1;
+        return 0;
+    }
+    return 1;
+}
+
+void f3v_sample_stop(TestContext *ctx)
+{
+    struct SampleState *s = ctx->run.sample.state;
+
+    if (s == NULL)
+    {
+        return;
+    }
+
+    free(s->taken);
+    free(s);
+    ctx->run.sample.state = NULL;
+}
@@ -0,0 +1,2103 @@
+/**
+ * @file session.c
+ * @brief Per-device test session (write and verify phases)
+ *
+ * Each session owns its open file and progress counters so several devices
+ * can be tested at once. The engine decides which thread steps which session.
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "session.h"
+#include "storage.h"
+#include "pool.h"
+#include "pattern.h"
+#include "journal.h"
+#include "faillist.h"
+#include "readback.h"
+#include "retest.h"
+#include "sample.h"
+#include "bench.h"
+#include "stream.h"
+#include "mixed.h"
+#include "discover.h"
+#include "align.h"
+#include "conform.h"
+#include "fstree.h"
+#include "rotscan.h"
+#include "wipe.h"
+#include "order.h"
+#include "ui.h"
+
+static void finish(TestContext *ctx);
+
+void f3v_session_close_file(TestContext *ctx)
+{
+    if (ctx->fd >= 0)
+    {
+        f3v_close(ctx->fd);
+    }
+    ctx->fd = -1;
+    ctx->fd_file_idx = 0;
+}
+
+void f3v_session_note_first_error(TestContext *ctx, uint32_t file_idx, uint32_t block_idx,
+                                  uint32_t offset)
+{
+    if (!ctx->has_first_error)
+    {
+        ctx->has_first_error = 1;
+        ctx->first_error_file = file_idx;
+        ctx->first_error_block = block_idx;
+        ctx->first_error_offset = offset;
+    }
+}
+
+void f3v_session_note_error(TestContext *ctx, uint32_t file_idx, uint32_t block_idx,
+                            uint32_t offset)
+{
+    f3v_fail_note(ctx, file_idx, block_idx, offset);
+    f3v_session_note_first_error(ctx, file_idx, block_idx, offset);
+}
+
+int f3v_session_note_alias(TestContext *ctx, const uint8_t *buf, uint32_t file_idx,
+                           uint32_t block_idx)
+{
+    uint32_t src_file, src_block;
+
+    /* Zeros and noise carry no location */
+    if (ctx->mode == MODE_WIPE && ctx->run.wipe.fill != WIPE_PATTERN)
+    {
+        return 0;
+    }
+
+    if (!f3v_identify_variant(buf, ctx->pattern_variant, ctx->files_written, &src_file,
+                              &src_block))
+    {
+        return 0;
+    }
+
+    if (!ctx->has_alias)
+    {
+        ctx->has_alias = 1;
+        ctx->alias_file = file_idx;
+        ctx->alias_block = block_idx;
+        ctx->alias_src_file = src_file;
+        ctx->alias_src_block = src_block;
+    }
+    return 1;
+}
+
+int f3v_session_check_abort(TestContext *ctx, uint32_t corrupted, int aliased)
+{
+    ctx->window_bytes += F3V_BLOCK_SIZE;
+    ctx->window_bad += corrupted;
+
+    switch (ctx->abort_policy)
+    {
+    case ABORT_FIRST_BAD:
+        return corrupted > 0;
+    case ABORT_BAD_MB:
+        return ctx->bytes_corrupted + ctx->raw_fed_bad >= (uint64_t)ctx->abort_param * 1024 * 1024;
+    case ABORT_BAD_RATIO:
+    {
+        if (ctx->window_bytes < F3V_ABORT_WINDOW)
+        {
+            return 0;
+        }
+        int over = ctx->window_bad * 100 > ctx->window_bytes * ctx->abort_param;
+        ctx->window_bytes = 0;
+        ctx->window_bad = 0;
+        return over;
+    }
+    case ABORT_ALIASING:
+        return aliased;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Classify a transfer made with the retry policy
+ */
+static void note_transfer(TestContext *ctx, uint32_t retries_before, int complete)
+{
+    if (!complete)
+    {
+        ctx->io_failed++;
+    }
+    else if (ctx->io_retries != retries_before)
+    {
+        ctx->io_recovered++;
+    }
+}
+
+/**
+ * Check data read back against what the write phase stored
+ * @return Corrupted bytes in the first length bytes of the block
+ */
+static uint32_t verify_data(const TestContext *ctx, const uint8_t *buf, uint32_t file_idx,
+                            uint32_t block_idx, uint32_t length, uint32_t *first_offset)
+{
+    if (ctx->mode == MODE_WIPE)
+    {
+        return f3v_wipe_verify(buf, ctx->run.wipe.fill, ctx->run.wipe.kernel, ctx->session_nonce,
+                               file_idx, block_idx, length, first_offset);
+    }
+
+    /* A short last block only up to what was written */
+    return length == F3V_BLOCK_SIZE
+               ? f3v_pool_verify_variant(buf, file_idx, block_idx, ctx->pattern_variant,
+                                         first_offset)
+               : f3v_verify_variant_range(buf, file_idx, block_idx, ctx->pattern_variant, 0,
+                                          length, first_offset);
+}
+
+/**
+ * Re-read a block that failed verification and vote per byte
+ *
+ * Only blocks that mismatched pay for the extra reads. On success buf holds
+ * the voted data.
+ *
+ * @return Corrupted bytes in the voted data, or -1 if the re-reads failed
+ */
+static int64_t vote_block(TestContext *ctx, uint8_t *buf, uint32_t file_idx, uint32_t block_idx,
+                          uint32_t length, uint32_t *first_offset)
+{
+    uint8_t *reads = malloc(3 * F3V_VOTE_SLICE);
+    uint64_t block_start = (uint64_t)block_idx * F3V_BLOCK_SIZE;
+    uint32_t unstable = 0;
+
+    if (reads == NULL)
+    {
+        return -1;
+    }
+
+    for (uint32_t pos = 0; pos < length; pos += F3V_VOTE_SLICE)
+    {
+        uint32_t len = length - pos < F3V_VOTE_SLICE ? length - pos : F3V_VOTE_SLICE;
+
+        for (int r = 0; r < 3; r++)
+        {
+            if (f3v_read_retry(ctx->fd, reads + r * F3V_VOTE_SLICE, len, block_start + pos,
+                               &ctx->io_retries) != (int)len)
+            {
+                free(reads);
+                return -1;
+            }
+        }
+        unstable += f3v_vote_bytes(buf + pos, reads, reads + F3V_VOTE_SLICE,
+                                   reads + 2 * F3V_VOTE_SLICE, len);
+    }
+    free(reads);
+
+    ctx->vote_unstable += unstable;
+    return verify_data(ctx, buf, file_idx, block_idx, length, first_offset);
+}
+
+/**
+ * Flush written data and checkpoint progress
+ */
+static void checkpoint(TestContext *ctx)
+{
+    /* Only full runs resume. Re-tests, samples and the benchmark rewrite
+       the same patterns, so an earlier run's journal stays valid; burn-in
+       passes are not resumable. A verify-only run is short and must not
+       replace the journal of an interrupted full run on the same files */
+    if (ctx->mode != MODE_FULL)
+    {
+        return;
+    }
+
+    if (ctx->phase == PHASE_WRITE && ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+
+    /* A failed checkpoint only costs resumability, not the test */
+    f3v_journal_save(ctx);
+    ctx->last_checkpoint = ctx->phase == PHASE_WRITE ? ctx->bytes_written : ctx->bytes_verified;
+}
+
+/**
+ * Switch from the write phase to the verify phase
+ */
+static void begin_verify(TestContext *ctx)
+{
+    if (ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+    f3v_session_close_file(ctx);
+
+    /* Let read-back finish the tail before the full pass starts */
+    if (ctx->raw_pipe != NULL)
+    {
+        f3v_readback_submit(ctx);
+        f3v_readback_stop(ctx);
+    }
+
+    /* Per-file schedule: what the stream found is part of the result (the
+       reader has been joined, so ctx->raw is final) */
+    ctx->raw_fed_bad = 0;
+    if (ctx->readback == READBACK_FILE && ctx->raw.corrupted > 0)
+    {
+        ctx->bytes_corrupted += ctx->raw.corrupted;
+        f3v_session_note_first_error(ctx, ctx->raw.error_file, ctx->raw.error_block,
+                                     ctx->raw.error_offset);
+    }
+
+    ctx->phase_start_time = f3v_get_time_usec();
+    ctx->current_file = 1;
+    ctx->current_block = 0;
+    ctx->bytes_verified = 0;
+    ctx->verify_index = 0;
+    ctx->phase = PHASE_VERIFY;
+
+    checkpoint(ctx);
+}
+
+/**
+ * Switch from prefilling the benchmark region to the benchmark itself
+ */
+static void begin_bench(TestContext *ctx)
+{
+    if (ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+    f3v_session_close_file(ctx);
+
+    /* Whole blocks only; a card that ran out of space tests what it got */
+    ctx->run.bench.region = ctx->bytes_written / F3V_BLOCK_SIZE * F3V_BLOCK_SIZE;
+    ctx->phase_start_time = f3v_get_time_usec();
+    ctx->phase = PHASE_BENCH;
+}
+
+/**
+ * Switch from prefilling the read region to the mixed workload
+ */
+static void begin_mixed(TestContext *ctx)
+{
+    if (ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+    f3v_session_close_file(ctx);
+
+    /* Whole blocks only; a card that ran out of space tests what it got */
+    ctx->run.mixed.region = ctx->bytes_written / F3V_BLOCK_SIZE * F3V_BLOCK_SIZE;
+    ctx->phase_start_time = f3v_get_time_usec();
+    ctx->phase = PHASE_MIXED;
+}
+
+/**
+ * Switch from prefilling the discovery region to the probe writes
+ */
+static void begin_discover(TestContext *ctx)
+{
+    char filename[128];
+
+    if (ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+    f3v_session_close_file(ctx);
+
+    /* Probes overwrite the prefilled blocks in place */
+    f3v_get_test_filename(ctx, 1, filename, sizeof(filename));
+    ctx->fd = f3v_open_rw(filename, 0);
+    if (ctx->fd >= 0)
+    {
+        ctx->fd_file_idx = 1;
+    }
+
+    /* Whole blocks only; step_discover() fails the run without a state */
+    DiscoverRun *run = &ctx->run.discover;
+    run->state = malloc(sizeof(*run->state));
+    if (run->state != NULL &&
+        f3v_discover_init(run->state, ctx->bytes_written / F3V_BLOCK_SIZE * F3V_BLOCK_SIZE) < 0)
+    {
+        free(run->state);
+        run->state = NULL;
+    }
+
+    ctx->phase_start_time = f3v_get_time_usec();
+    ctx->phase = PHASE_DISCOVER;
+}
+
+/**
+ * Wipe: fill the free space left below one block
+ *
+ * The write phase stops with less than a block free. One more file takes
+ * what is left in halving chunk sizes down to F3V_WIPE_TAIL_MIN; the tail
+ * is not verified.
+ */
+static void wipe_tail(TestContext *ctx)
+{
+    uint64_t limit = ctx->target.free_bytes + F3V_BLOCK_SIZE;
+    uint32_t chunk = F3V_BLOCK_SIZE / 2;
+    char filename[128];
+
+    if (ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+    f3v_session_close_file(ctx);
+
+    f3v_get_test_filename(ctx, ctx->files_written + 1, filename, sizeof(filename));
+    int fd = f3v_open_write(filename);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    /* The buffer still holds the last transfer's data */
+    while (chunk >= F3V_WIPE_TAIL_MIN && ctx->run.wipe.tail < limit)
+    {
+        int written = f3v_write_block(fd, ctx->run.wipe.buf, chunk);
+        if (written > 0)
+        {
+            ctx->run.wipe.tail += (uint32_t)written;
+        }
+        if (written != (int)chunk)
+        {
+            chunk /= 2;
+        }
+    }
+    f3v_sync(fd);
+    f3v_close(fd);
+}
+
+/**
+ * Wipe: size the next transfer and fill it
+ * @param size Output: bytes to write
+ * @return Buffer holding them
+ */
+static uint8_t *wipe_prepare(TestContext *ctx, uint32_t file_idx, uint32_t block_idx,
+                             uint32_t *size)
+{
+    uint32_t blocks = f3v_wipe_tune_blocks(&ctx->run.wipe.tune);
+
+    /* Aligned to the transfer size (so never across files) and within the free space */
+    while (blocks > 1 && (block_idx % blocks != 0 ||
+                          ctx->target.free_bytes < (uint64_t)blocks * F3V_BLOCK_SIZE))
+    {
+        blocks /= 2;
+    }
+
+    /* Zeros were written into the whole buffer once */
+    for (uint32_t i = 0; i < blocks && ctx->run.wipe.kernel != WIPE_KERNEL_ONCE; i++)
+    {
+        f3v_wipe_fill(ctx->run.wipe.buf + (size_t)i * F3V_BLOCK_SIZE, ctx->run.wipe.fill,
+                      ctx->run.wipe.kernel, ctx->session_nonce, file_idx, block_idx + i);
+    }
+
+    *size = blocks * F3V_BLOCK_SIZE;
+    return ctx->run.wipe.buf;
+}
+
+/**
+ * Switch from prefilling the grid region to the grid cases
+ */
+static void begin_align(TestContext *ctx)
+{
+    if (ctx->fd >= 0)
+    {
+        f3v_sync(ctx->fd);
+    }
+    f3v_session_close_file(ctx);
+
+    ctx->phase_start_time = f3v_get_time_usec();
+    ctx->phase = PHASE_ALIGN;
+}
+
+/**
+ * The write phase ended (space used up, region filled or a write failed)
+ */
+static void end_write(TestContext *ctx)
+{
+    if (ctx->mode == MODE_BENCH)
+    {
+        begin_bench(ctx);
+    }
+    else if (ctx->mode == MODE_MIXED)
+    {
+        begin_mixed(ctx);
+    }
+    else if (ctx->mode == MODE_DISCOVER)
+    {
+        begin_discover(ctx);
+    }
+    else if (ctx->mode == MODE_ALIGN)
+    {
+        begin_align(ctx);
+    }
+    else if (ctx->mode == MODE_WIPE)
+    {
+        wipe_tail(ctx);
+        if (ctx->run.wipe.verify)
+        {
+            begin_verify(ctx);
+        }
+        else
+        {
+            finish(ctx);
+        }
+    }
+    else
+    {
+        if (ctx->mode == MODE_CONFORM)
+        {
+            f3v_conform_finish(&ctx->run.conform.result);
+        }
+        begin_verify(ctx);
+    }
+}
+
+/**
+ * Format one line into the test directory log
+ * A line longer than the buffer is cut short rather than written past it.
+ */
+static void log_line(int fd, const char *fmt, ...)
+{
+    char line[192];
+    va_list args;
+
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (len >= (int)sizeof(line))
+    {
+        len = (int)sizeof(line) - 1;
+    }
+    if (len > 0)
+    {
+        f3v_write_block(fd, line, (size_t)len);
+    }
+}
+
+/**
+ * Append timestamped lines for a run other than a full test to the test
+ * directory log
+ */
+static void record_recheck(TestContext *ctx)
+{
+    static const char *result_names[] = {"UNKNOWN", "PASS", "FAIL", "CANCELLED"};
+    char path[128], stamp[32];
+
+    snprintf(path, sizeof(path), "%s/%s", ctx->test_dir, F3V_LOG_NAME);
+    int fd = f3v_open_append(path);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    f3v_format_timestamp(stamp, sizeof(stamp));
+    if (ctx->mode == MODE_RETEST)
+    {
+        uint32_t persistent = 0, intermittent = 0;
+        for (uint32_t i = 0; i < ctx->fail_count; i++)
+        {
+            if (ctx->fail[i].failed_passes >= ctx->run.retest.passes)
+            {
+                persistent++;
+            }
+            else if (ctx->fail[i].failed_passes > 0)
+            {
+                intermittent++;
+            }
+        }
+
+        log_line(fd,
+                 "%s re-test %s: %u regions x %u passes, %u persistent, %u intermittent\n",
+                 stamp, result_names[f3v_session_result(ctx)], ctx->fail_count,
+                 ctx->run.retest.passes, persistent, intermittent);
+    }
+    else if (ctx->mode == MODE_BURNIN)
+    {
+        const BurnRun *burn = &ctx->run.burn;
+        log_line(fd, "%s burn-in %s%s: %u passes, %llu bytes corrupted\n",
+                 stamp, result_names[f3v_session_result(ctx)],
+                 ctx->aborted ? " (partial)" : "",
+                 burn->count > 0 ? burn->history[burn->count - 1].pass : 0,
+                 ctx->bytes_corrupted);
+    }
+    else if (ctx->mode == MODE_BENCH)
+    {
+        char name[32];
+
+        /* One line per setting, then the summary */
+        for (uint32_t i = 0; i < ctx->run.bench.count; i++)
+        {
+            const BenchResult *result = &ctx->run.bench.result[i];
+
+            log_line(fd,
+                     "%s bench %s: %u IOPS, latency p50 %u us, p99 %u us, p99.9 %u us, "
+                     "max %u us, %u bad\n",
+                     stamp, f3v_bench_name(result, name, sizeof(name)), result->iops,
+                     result->lat_p50_us, result->lat_p99_us, result->lat_p999_us,
+                     result->lat_max_us, result->bad);
+        }
+        log_line(fd, "%s benchmark %s: %u of %u settings on %llu MB\n",
+                 stamp, result_names[f3v_session_result(ctx)], ctx->run.bench.count,
+                 ctx->run.bench.total, ctx->run.bench.region / (1024 * 1024));
+    }
+    else if (ctx->mode == MODE_MIXED)
+    {
+        const MixedResult *mixed = &ctx->run.mixed.result;
+        const MixedLatency *lat[] = {&mixed->read_alone, &mixed->read_mixed, &mixed->write};
+        static const char *lat_names[] = {"read alone", "read under writes", "write 1 MB"};
+
+        /* One line per transfer kind, then the summary */
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            log_line(fd,
+                     "%s mixed %s: %u IOPS, latency p50 %u us, p99 %u us, p99.9 %u us, "
+                     "max %u us\n",
+                     stamp, lat_names[i], lat[i]->iops, lat[i]->lat_p50_us,
+                     lat[i]->lat_p99_us, lat[i]->lat_p999_us, lat[i]->lat_max_us);
+        }
+        log_line(fd,
+                 "%s mixed workload %s: %u%% read on %llu MB, %llu MB written at %u KB/s, "
+                 "%u bad\n",
+                 stamp, result_names[f3v_session_result(ctx)], ctx->run.mixed.read_pct,
+                 ctx->run.mixed.region / (1024 * 1024), mixed->write_bytes / (1024 * 1024),
+                 mixed->write_kbs, mixed->bad);
+    }
+    else if (ctx->mode == MODE_FSTREE)
+    {
+        const FsTreeResult *tree = &ctx->run.fstree.result;
+
+        /* One line per operation type, then the summary */
+        for (uint32_t i = 0; i < FS_OP_COUNT; i++)
+        {
+            const FsOpStats *op = &tree->op[i];
+
+            log_line(fd,
+                     "%s files %s: %u done, %u failed, %u/s, latency p50 %u us, "
+                     "p99 %u us, max %u us\n",
+                     stamp, f3v_fstree_op_name((FsOp)i), op->count, op->failed,
+                     f3v_fstree_ops_per_sec(op), op->lat_p50_us, op->lat_p99_us,
+                     op->lat_max_us);
+        }
+        log_line(fd,
+                 "%s small files %s: %u dirs, %u files, %llu MB, %u bad files\n",
+                 stamp, result_names[f3v_session_result(ctx)], tree->dirs, tree->files,
+                 tree->bytes / (1024 * 1024), tree->bad_files);
+    }
+    else if (ctx->mode == MODE_ROTSCAN)
+    {
+        const RotScanResult *scan = &ctx->run.scan.result;
+
+        /* One line per corrupted or unreadable file, then the summary */
+        for (uint32_t i = 0; i < scan->bad_count; i++)
+        {
+            log_line(fd, "%s bit-rot %s: %s\n", stamp,
+                     f3v_rotscan_bad_name(scan->bad[i].kind), scan->bad[i].path);
+        }
+        log_line(fd,
+                 "%s bit-rot scan %s%s: %u files, %u matched, %u mismatched, "
+                 "%u unreadable, %u new, %u changed, %u missing\n",
+                 stamp, result_names[f3v_session_result(ctx)],
+                 ctx->aborted ? " (partial)" : "", scan->files, scan->matched,
+                 scan->mismatched, scan->unreadable, scan->added, scan->changed,
+                 scan->missing);
+    }
+    else if (ctx->mode == MODE_SURFACE)
+    {
+        const RotScanResult *scan = &ctx->run.scan.result;
+
+        /* One line per unreadable or slow region, then the summary */
+        for (uint32_t i = 0; i < scan->bad_count; i++)
+        {
+            const RotBadRegion *bad = &scan->bad[i];
+
+            log_line(fd, "%s surface %s: %s at %llu KB, %llu KB, %u KB/s\n",
+                     stamp, f3v_rotscan_bad_name(bad->kind), bad->path, bad->offset / 1024,
+                     (bad->length + 1023) / 1024, bad->min_kbs);
+        }
+        log_line(fd,
+                 "%s surface scan %s%s: %u files, %llu MB at %u KB/s, p99 %u us, "
+                 "%u unreadable (%llu KB), %u slow\n",
+                 stamp, result_names[f3v_session_result(ctx)],
+                 ctx->aborted ? " (partial)" : "", scan->files,
+                 ctx->bytes_verified / (1024 * 1024), scan->read_kbs, scan->lat_p99_us,
+                 scan->error_regions, (scan->error_bytes + 1023) / 1024,
+                 scan->slow_regions);
+    }
+    else if (ctx->mode == MODE_STREAMS)
+    {
+        /* One line per round, then the summary */
+        for (uint32_t i = 0; i < ctx->run.stream.count; i++)
+        {
+            const StreamResult *result = &ctx->run.stream.result[i];
+
+            log_line(fd,
+                     "%s streams x%u: write %u KB/s (%u-%u per stream), "
+                     "read %u KB/s (%u-%u per stream), %llu bytes corrupted\n",
+                     stamp, i + 1, result->write_kbs, result->write_min_kbs,
+                     result->write_max_kbs, result->read_kbs, result->read_min_kbs,
+                     result->read_max_kbs, result->corrupted);
+        }
+        log_line(fd, "%s stream sweep %s: %u of %u rounds\n", stamp,
+                 result_names[f3v_session_result(ctx)], ctx->run.stream.count,
+                 ctx->run.stream.max);
+    }
+    else if (ctx->mode == MODE_CONFORM)
+    {
+        const ConformResult *conform = &ctx->run.conform.result;
+
+        /* Runs of slow windows, then the verdict */
+        for (uint32_t i = 0; i < conform->drop_count; i++)
+        {
+            const ConformDrop *drop = &conform->drop[i];
+
+            log_line(fd,
+                     "%s conformance drop at %llu MB: %llu MB below %u MB/s, "
+                     "slowest %u KB/s\n",
+                     stamp, drop->offset / (1024 * 1024), drop->length / (1024 * 1024),
+                     conform->class_mbps, drop->min_kbs);
+        }
+        log_line(fd,
+                 "%s conformance %u MB/s %s, data %s: %u of %u windows below, "
+                 "min %u, 1%% %u, 5%% %u, avg %u KB/s\n",
+                 stamp, conform->class_mbps,
+                 f3v_conform_verdict_name(f3v_conform_verdict(conform)),
+                 result_names[f3v_session_result(ctx)], conform->below, conform->windows,
+                 conform->min_kbs, conform->p1_kbs, conform->p5_kbs, conform->avg_kbs);
+    }
+    else if (ctx->mode == MODE_ALIGN)
+    {
+        const AlignResult *base = &ctx->run.align.result[0];
+        char size_str[16];
+
+        /* One line per case, then the summary */
+        for (uint32_t i = 0; i < ctx->run.align.count; i++)
+        {
+            const AlignResult *result = &ctx->run.align.result[i];
+
+            log_line(fd,
+                     "%s align %s, buffer +%u, offset +%u: write %u KB/s (%+d%%), "
+                     "read %u KB/s (%+d%%), %u bad\n",
+                     stamp, f3v_align_size_name(result->size, size_str, sizeof(size_str)),
+                     result->buf_offset, result->file_offset, result->write_kbs,
+                     f3v_align_change(result->write_kbs, base->write_kbs),
+                     result->read_kbs, f3v_align_change(result->read_kbs, base->read_kbs),
+                     result->bad);
+        }
+        log_line(fd, "%s alignment grid %s: %u of %u cases\n", stamp,
+                 result_names[f3v_session_result(ctx)], ctx->run.align.count,
+                 ctx->run.align.total);
+    }
+    else if (ctx->mode == MODE_DISCOVER)
+    {
+        const DiscoverResult *result = &ctx->run.discover.result;
+
+        log_line(fd,
+                 "%s discovery %s%s: erase block %u KB at +%u KB (score %u%%), "
+                 "%s%u open segments\n",
+                 stamp, result_names[f3v_session_result(ctx)],
+                 ctx->aborted ? " (partial)" : "", result->erase_size / 1024,
+                 result->erase_phase / 1024, result->erase_score,
+                 result->open_limited ? "" : ">= ", result->open_max);
+        log_line(fd,
+                 "%s discovery recommends: %u KB transfers aligned to +%u KB, "
+                 "%u streams\n",
+                 stamp, result->transfer / 1024, result->alignment / 1024,
+                 result->streams);
+    }
+    else if (ctx->mode == MODE_SAMPLE)
+    {
+        log_line(fd,
+                 "%s sample %s: %llu of %llu blocks, %llu bad, <= %u ppm bad at 95%%\n",
+                 stamp, result_names[f3v_session_result(ctx)], ctx->run.sample.count,
+                 ctx->run.sample.total_blocks, ctx->run.sample.bad, ctx->run.sample.upper_ppm);
+    }
+    else
+    {
+        uint32_t secs = (uint32_t)((f3v_get_time_usec() - ctx->phase_start_time) / 1000000);
+
+        log_line(fd,
+                 "%s re-check %s%s: %llu of %llu MB verified, %llu bytes corrupted, "
+                 "%s order %llu MB/s\n",
+                 stamp, result_names[f3v_session_result(ctx)],
+                 ctx->aborted ? " (partial)" : "",
+                 ctx->bytes_verified / (1024 * 1024), ctx->bytes_written / (1024 * 1024),
+                 ctx->bytes_corrupted, f3v_order_name(ctx->verify_order),
+                 secs > 0 ? ctx->bytes_verified / (1024 * 1024) / secs : 0);
+    }
+    f3v_close(fd);
+}
+
+/*
+ * Small-file workload callbacks on the card
+ */
+static int tree_mkdir(void *handle, const char *path)
+{
+    (void)handle;
+    return f3v_mkdir(path);
+}
+
+static int tree_rmdir(void *handle, const char *path)
+{
+    (void)handle;
+    return f3v_rmdir(path);
+}
+
+static int tree_write_file(void *handle, const char *path, const uint8_t *buf, uint32_t len)
+{
+    (void)handle;
+    int fd = f3v_open_write(path);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    int written = f3v_write_block(fd, buf, len);
+    if (f3v_close(fd) < 0 && written >= 0)
+    {
+        return -1;
+    }
+    return written;
+}
+
+static int tree_read_file(void *handle, const char *path, uint8_t *buf, uint32_t len)
+{
+    (void)handle;
+    int fd = f3v_open_read(path);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    int got = f3v_read_block(fd, buf, len);
+    f3v_close(fd);
+    return got;
+}
+
+static int64_t tree_stat(void *handle, const char *path)
+{
+    (void)handle;
+    return f3v_get_file_size(path);
+}
+
+static int tree_remove(void *handle, const char *path)
+{
+    (void)handle;
+    return f3v_remove(path);
+}
+
+static uint64_t tree_now(void *handle)
+{
+    (void)handle;
+    return f3v_get_time_usec();
+}
+
+static const FsTreeDevice g_tree_device = {
+    tree_mkdir, tree_rmdir, tree_write_file, tree_read_file, tree_stat, tree_remove, tree_now, NULL,
+};
+
+/*
+ * Bit-rot scan callbacks on the card
+ */
+static int rot_dir_open(void *handle, const char *path)
+{
+    (void)handle;
+    return f3v_dir_open(path);
+}
+
+static int rot_dir_read(void *handle, int dir, RotDirEntry *entry)
+{
+    (void)handle;
+    return f3v_dir_read(dir, entry->name, sizeof(entry->name), &entry->is_dir, &entry->size,
+                        &entry->mtime);
+}
+
+static void rot_dir_close(void *handle, int dir)
+{
+    (void)handle;
+    f3v_dir_close(dir);
+}
+
+static int rot_open_read(void *handle, const char *path)
+{
+    (void)handle;
+    return f3v_open_read(path);
+}
+
+static int rot_read_at(void *handle, int fd, uint8_t *buf, uint32_t len, uint64_t offset)
+{
+    (void)handle;
+    return f3v_read_at(fd, buf, len, offset);
+}
+
+static void rot_close(void *handle, int fd)
+{
+    (void)handle;
+    f3v_close(fd);
+}
+
+static int rot_rename(void *handle, const char *from, const char *to)
+{
+    (void)handle;
+    return f3v_rename(from, to);
+}
+
+static const RotScanDevice g_rot_device = {
+    rot_dir_open, rot_dir_read, rot_dir_close, rot_open_read, rot_read_at, rot_close,
+    tree_write_file, rot_rename, tree_remove, tree_now, NULL,
+};
+
+/**
+ * Stop the mode's threads and release its state; results stay in ctx->run
+ */
+static void stop_mode(TestContext *ctx)
+{
+    switch (ctx->mode)
+    {
+    case MODE_SAMPLE:
+        f3v_sample_stop(ctx);
+        break;
+    case MODE_BENCH:
+        f3v_bench_stop(ctx);
+        break;
+    case MODE_STREAMS:
+        f3v_stream_stop(ctx);
+        break;
+    case MODE_MIXED:
+        f3v_mixed_stop(ctx);
+        break;
+    case MODE_DISCOVER:
+        free(ctx->run.discover.state);
+        ctx->run.discover.state = NULL;
+        break;
+    case MODE_ALIGN:
+        f3v_align_stop(ctx);
+        break;
+    case MODE_FSTREE:
+    {
+        FsTreeRun *run = &ctx->run.fstree;
+
+        /* A cancelled tree is removed; the result keeps what was timed */
+        if (run->state != NULL)
+        {
+            f3v_fstree_cleanup(run->state, &g_tree_device);
+            run->result = run->state->result;
+            free(run->state);
+            run->state = NULL;
+        }
+        break;
+    }
+    case MODE_ROTSCAN:
+    case MODE_SURFACE:
+    {
+        ScanRun *run = &ctx->run.scan;
+
+        /* A scan stopped early leaves the manifest as it was */
+        if (run->state != NULL)
+        {
+            run->result = run->state->result;
+            f3v_rotscan_free(run->state, &g_rot_device);
+            free(run->state);
+            run->state = NULL;
+        }
+        break;
+    }
+    case MODE_CONFORM:
+        /* Judge what a cancelled conformance run wrote */
+        if (ctx->phase == PHASE_WRITE)
+        {
+            f3v_conform_finish(&ctx->run.conform.result);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Finish the session (done, cancelled or failed)
+ *
+ * A cancelled session keeps its journal (with a final checkpoint) so it can
+ * be resumed; any other outcome discards it.
+ */
+static void finish(TestContext *ctx)
+{
+    f3v_readback_stop(ctx);
+    stop_mode(ctx);
+
+    if (ctx->cancelled && ctx->phase != PHASE_DONE)
+    {
+        checkpoint(ctx);
+    }
+    else if (ctx->mode == MODE_FULL)
+    {
+        f3v_journal_clear(ctx);
+    }
+    f3v_session_close_file(ctx);
+
+    /* Keep the failed regions for a later re-test (a clean pass drops them) */
+    if ((ctx->phase == PHASE_VERIFY || ctx->phase == PHASE_SAMPLE ||
+         (ctx->phase == PHASE_WRITE && ctx->aborted)) &&
+        (ctx->fail_count > 0 || !ctx->cancelled))
+    {
+        f3v_fail_save(ctx);
+    }
+
+    /* A wipe leaves nothing of its own behind, finished or not; the test
+       directory goes too unless an earlier run's files are kept in it */
+    if (ctx->mode == MODE_WIPE)
+    {
+        char parent[sizeof(ctx->test_dir)];
+        ctx->run.wipe.deleted = f3v_cleanup_files(ctx);
+        snprintf(parent, sizeof(parent), "%s", ctx->test_dir);
+        *strrchr(parent, '/') = '\0';
+        f3v_rmdir(parent);
+        free(ctx->run.wipe.mem);
+        ctx->run.wipe.mem = NULL;
+        ctx->run.wipe.buf = NULL;
+    }
+
+    ctx->end_time = f3v_get_time_usec();
+    ctx->phase = PHASE_DONE;
+
+    /* The wipe's log would be the one thing left on the card */
+    if (ctx->mode != MODE_FULL && ctx->mode != MODE_WIPE)
+    {
+        record_recheck(ctx);
+    }
+}
+
+/**
+ * Record a finished burn-in pass and log it to the test directory
+ */
+static void record_pass(TestContext *ctx)
+{
+    uint64_t now = f3v_get_time_usec();
+    BurnPass pass;
+
+    pass.pass = ctx->run.burn.pass + 1;
+    pass.variant = ctx->pattern_variant;
+    pass.bytes_written = ctx->bytes_written;
+    pass.write_ms = (uint32_t)((ctx->phase_start_time - ctx->run.burn.pass_start) / 1000);
+    pass.verify_ms = (uint32_t)((now - ctx->phase_start_time) / 1000);
+    pass.bytes_corrupted = ctx->bytes_corrupted - ctx->run.burn.corrupted_start;
+
+    /* Keep the fresh-card pass and the most recent ones */
+    if (ctx->run.burn.count == F3V_BURN_HISTORY)
+    {
+        memmove(&ctx->run.burn.history[1], &ctx->run.burn.history[2],
+                (F3V_BURN_HISTORY - 2) * sizeof(BurnPass));
+        ctx->run.burn.count--;
+    }
+    ctx->run.burn.history[ctx->run.burn.count++] = pass;
+
+    char path[128], stamp[32], variant[32];
+    snprintf(path, sizeof(path), "%s/%s", ctx->test_dir, F3V_LOG_NAME);
+    int fd = f3v_open_append(path);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    f3v_format_timestamp(stamp, sizeof(stamp));
+    f3v_format_variant(pass.variant, variant, sizeof(variant));
+    log_line(fd,
+             "%s burn-in pass %u (%s): %llu MB, write %llu MB/s, verify %llu MB/s, "
+             "%llu new bad bytes\n",
+             stamp, pass.pass, variant, pass.bytes_written / (1024 * 1024),
+             pass.write_ms > 0 ? pass.bytes_written / 1024 * 1000 / 1024 / pass.write_ms
+                               : 0,
+             pass.verify_ms > 0 ? pass.bytes_written / 1024 * 1000 / 1024 / pass.verify_ms
+                                : 0,
+             pass.bytes_corrupted);
+    f3v_close(fd);
+}
+
+/**
+ * Start the next burn-in pass with the next pattern variant
+ *
+ * The previous pass's files are deleted first so the pass writes the whole
+ * free space again.
+ */
+static void begin_pass(TestContext *ctx)
+{
+    char filename[128];
+
+    f3v_session_close_file(ctx);
+    for (uint32_t i = 1; i <= ctx->files_written; i++)
+    {
+        f3v_get_test_filename(ctx, i, filename, sizeof(filename));
+        f3v_remove(filename);
+    }
+
+    ctx->run.burn.pass++;
+    ctx->pattern_variant = ctx->run.burn.pass;
+    ctx->verify_seed++;
+
+    /* Progress expects about as much as the last pass wrote */
+    ctx->total_expected = ctx->bytes_written;
+    ctx->files_written = 0;
+    ctx->bytes_written = 0;
+    ctx->bytes_verified = 0;
+    ctx->verify_index = 0;
+    ctx->window_bytes = 0;
+    ctx->window_bad = 0;
+    memset(&ctx->raw, 0, sizeof(ctx->raw));
+    ctx->run.burn.corrupted_start = ctx->bytes_corrupted;
+
+    ctx->run.burn.pass_start = f3v_get_time_usec();
+    ctx->phase_start_time = ctx->run.burn.pass_start;
+    ctx->phase = PHASE_WRITE;
+}
+
+/**
+ * The verify pass completed: finish, or start the next burn-in pass
+ */
+static void end_verify(TestContext *ctx)
+{
+    if (ctx->mode == MODE_BURNIN)
+    {
+        record_pass(ctx);
+
+        int more_passes = ctx->run.burn.passes == 0 ||
+                          ctx->run.burn.pass + 1 < ctx->run.burn.passes;
+        int time_left = ctx->run.burn.duration_sec == 0 ||
+                        f3v_get_time_usec() - ctx->start_time <
+                            (uint64_t)ctx->run.burn.duration_sec * 1000000;
+        if (more_passes && time_left)
+        {
+            begin_pass(ctx);
+            return;
+        }
+    }
+
+    finish(ctx);
+}
+
+/**
+ * A conformance window is complete: sync it and record its speed
+ */
+static void end_window(TestContext *ctx)
+{
+    uint64_t sync_start = f3v_get_time_usec();
+
+    f3v_sync(ctx->fd);
+    ctx->run.conform.usec += f3v_get_time_usec() - sync_start;
+    f3v_conform_add(&ctx->run.conform.result, ctx->bytes_written - F3V_CONFORM_WINDOW,
+                    ctx->run.conform.usec);
+    ctx->run.conform.usec = 0;
+}
+
+/**
+ * Whether a mode that only prefills a region has written all of it
+ */
+static int region_filled(const TestContext *ctx)
+{
+    switch (ctx->mode)
+    {
+    case MODE_BENCH:
+        return ctx->bytes_written >= ctx->run.bench.region;
+    case MODE_MIXED:
+        return ctx->bytes_written >= ctx->run.mixed.region;
+    case MODE_DISCOVER:
+    case MODE_ALIGN:
+    case MODE_CONFORM:
+        return ctx->bytes_written >= ctx->total_expected;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Apply the abort policy to the blocks the read-back stream checked since
+ * the last call (the stream sees corruption, not aliasing)
+ * @return 1 if the run should stop
+ */
+static int readback_abort(TestContext *ctx)
+{
+    ReadbackTotals raw;
+    int stop = 0;
+
+    f3v_readback_totals(ctx, &raw);
+    while (ctx->raw_fed + F3V_BLOCK_SIZE <= raw.verified)
+    {
+        uint64_t left = raw.corrupted - ctx->raw_fed_bad;
+        uint32_t bad = left > F3V_BLOCK_SIZE ? F3V_BLOCK_SIZE : (uint32_t)left;
+
+        ctx->raw_fed += F3V_BLOCK_SIZE;
+        ctx->raw_fed_bad += bad;
+        stop |= f3v_session_check_abort(ctx, bad, 0);
+    }
+    return stop;
+}
+
+/**
+ * Stop a run during the write phase on what the read-back stream found
+ *
+ * No verify pass follows, so the stream's findings become the result
+ * whatever the read-back schedule.
+ */
+static void abort_write(TestContext *ctx)
+{
+    ctx->aborted = 1;
+    f3v_readback_stop(ctx);
+
+    ctx->bytes_corrupted += ctx->raw.corrupted;
+    ctx->raw_fed_bad = 0;
+    if (ctx->raw.has_error)
+    {
+        f3v_session_note_first_error(ctx, ctx->raw.error_file, ctx->raw.error_block,
+                                     ctx->raw.error_offset);
+        /* The per-file stream already noted its regions */
+        if (ctx->readback != READBACK_FILE)
+        {
+            f3v_fail_note(ctx, ctx->raw.error_file, ctx->raw.error_block,
+                          ctx->raw.error_offset);
+        }
+    }
+    finish(ctx);
+}
+
+/**
+ * Write phase - write the next pattern block
+ */
+static void step_write(TestContext *ctx, uint8_t *buf)
+{
+    /* Check if we have space (prefilling modes stop at their region) */
+    if (!f3v_has_space(ctx) || region_filled(ctx))
+    {
+        /* Disk full - transition to verify */
+        end_write(ctx);
+        return;
+    }
+
+    /* Calculate current file and block */
+    uint32_t file_idx = (uint32_t)(ctx->bytes_written / F3V_FILE_SIZE) + 1;
+    uint32_t block_idx = (uint32_t)((ctx->bytes_written % F3V_FILE_SIZE) / F3V_BLOCK_SIZE);
+
+    /* Open new file if needed */
+    if (file_idx != ctx->fd_file_idx)
+    {
+        f3v_session_close_file(ctx);
+
+        char filename[128];
+        f3v_get_test_filename(ctx, file_idx, filename, sizeof(filename));
+        if (block_idx == 0)
+        {
+            ctx->fd = f3v_open_write(filename);
+        }
+        else
+        {
+            /* Resumed mid-file: keep the blocks already checkpointed */
+            ctx->fd = f3v_open_resume(filename, (uint64_t)block_idx * F3V_BLOCK_SIZE);
+        }
+
+        if (ctx->fd < 0)
+        {
+            /* Write error - transition to verify */
+            end_write(ctx);
+            return;
+        }
+
+        ctx->fd_file_idx = file_idx;
+        ctx->files_written = file_idx;
+    }
+
+    /* Read-back starts with the first block this session writes; the abort
+       policy has already seen what it checked before an interruption */
+    if (ctx->readback != READBACK_OFF && ctx->raw_pipe == NULL)
+    {
+        ctx->raw_fed = ctx->raw.verified;
+        ctx->raw_fed_bad = ctx->raw.corrupted;
+        if (f3v_readback_start(ctx) < 0)
+        {
+            ctx->readback = READBACK_OFF;
+        }
+    }
+
+    /* Generate pattern for this block (stripes spread over the pool); a
+       wipe writes its own data, possibly several blocks at once */
+    uint8_t *out = buf;
+    uint32_t size = F3V_BLOCK_SIZE;
+    if (ctx->mode == MODE_WIPE)
+    {
+        out = wipe_prepare(ctx, file_idx, block_idx, &size);
+    }
+    else
+    {
+        f3v_pool_fill_variant(buf, file_idx, block_idx, ctx->pattern_variant);
+    }
+
+    /* Write block (retrying errors and short writes) */
+    uint32_t retries_before = ctx->io_retries;
+    f3v_throttle_io(&ctx->throttle, size);
+    uint64_t write_start = f3v_get_time_usec();
+    int written = f3v_write_retry(ctx->fd, out, size, (uint64_t)block_idx * F3V_BLOCK_SIZE,
+                                  &ctx->io_retries);
+    uint64_t write_usec = f3v_get_time_usec() - write_start;
+    if (ctx->mode == MODE_CONFORM)
+    {
+        ctx->run.conform.usec += write_usec;
+    }
+    else if (ctx->mode == MODE_WIPE && written > 0)
+    {
+        f3v_wipe_tune_add(&ctx->run.wipe.tune, (uint32_t)written, write_usec);
+    }
+
+    /* Running out of space is the expected end of the phase, not an error */
+    if (written == (int)size || f3v_has_space(ctx))
+    {
+        note_transfer(ctx, retries_before, written == (int)size);
+    }
+
+    if (written <= 0)
+    {
+        /* Write error or disk full */
+        end_write(ctx);
+        return;
+    }
+
+    ctx->bytes_written += written;
+
+    if (ctx->mode == MODE_CONFORM && ctx->bytes_written % F3V_CONFORM_WINDOW == 0)
+    {
+        end_window(ctx);
+    }
+
+    /* Hand each synced group (or file) to read-back; it overlaps the next writes */
+    uint32_t group = ctx->readback == READBACK_FILE ? F3V_BLOCKS_PER_FILE : F3V_READBACK_GROUP;
+    if (ctx->raw_pipe != NULL && (ctx->bytes_written / F3V_BLOCK_SIZE) % group == 0)
+    {
+        f3v_sync(ctx->fd);
+        f3v_readback_submit(ctx);
+    }
+
+    /* The stream may check the late files on its own, so it feeds the
+       abort policy too */
+    if (ctx->raw_pipe != NULL && readback_abort(ctx))
+    {
+        abort_write(ctx);
+        return;
+    }
+
+    if (ctx->bytes_written - ctx->last_checkpoint >= F3V_JOURNAL_INTERVAL)
+    {
+        checkpoint(ctx);
+    }
+}
+
+/**
+ * Verify phase - read back and verify the next block in the verify order
+ */
+static void step_verify(TestContext *ctx, uint8_t *buf)
+{
+    uint64_t blocks = (ctx->bytes_written + F3V_BLOCK_SIZE - 1) / F3V_BLOCK_SIZE;
+    uint64_t block;
+
+    /* Check if verification complete */
+    if (ctx->verify_index >= f3v_order_slots(ctx->verify_order, blocks))
+    {
+        end_verify(ctx);
+        return;
+    }
+
+    /* Positions past a short last file (file-shuffled order) are empty */
+    if (!f3v_order_block(ctx->verify_order, ctx->verify_seed, ctx->verify_index++, blocks,
+                         &block))
+    {
+        return;
+    }
+
+    /* Calculate current file and block */
+    uint32_t file_idx = (uint32_t)(block / F3V_BLOCKS_PER_FILE) + 1;
+    uint32_t block_idx = (uint32_t)(block % F3V_BLOCKS_PER_FILE);
+    uint64_t length = ctx->bytes_written - block * F3V_BLOCK_SIZE;
+    if (length > F3V_BLOCK_SIZE)
+    {
+        length = F3V_BLOCK_SIZE;
+    }
+
+    ctx->current_file = file_idx;
+    ctx->current_block = block_idx;
+
+    /* Per-file closing pass: later files were verified while writing,
+       except a short last block (the stream only checks whole blocks) */
+    if (ctx->readback == READBACK_FILE && file_idx > F3V_CLOSING_FILES && block_idx > 0 &&
+        length == F3V_BLOCK_SIZE)
+    {
+        ctx->verify_skipped += length;
+        ctx->bytes_verified += length;
+        return;
+    }
+
+    /* Open file if needed */
+    if (file_idx != ctx->fd_file_idx)
+    {
+        f3v_session_close_file(ctx);
+
+        char filename[128];
+        f3v_get_test_filename(ctx, file_idx, filename, sizeof(filename));
+        ctx->fd = f3v_open_read(filename);
+
+        if (ctx->fd < 0)
+        {
+            /* Read error - count entire remaining data as corrupted */
+            ctx->bytes_corrupted += ctx->bytes_written - ctx->bytes_verified;
+            ctx->bytes_verified = ctx->bytes_written;
+            f3v_session_note_error(ctx, file_idx, block_idx, 0);
+
+            finish(ctx);
+            return;
+        }
+
+        ctx->fd_file_idx = file_idx;
+    }
+
+    /* Read block (positional, so any order works without seeking) */
+    uint32_t retries_before = ctx->io_retries;
+    f3v_throttle_io(&ctx->throttle, F3V_BLOCK_SIZE);
+    int bytes_read = f3v_read_retry(ctx->fd, buf, (size_t)length,
+                                    (uint64_t)block_idx * F3V_BLOCK_SIZE, &ctx->io_retries);
+    note_transfer(ctx, retries_before, bytes_read == (int)length);
+
+    if (bytes_read <= 0)
+    {
+        /* Read error - count as corrupted (a short last block only as far
+           as it was written) */
+        ctx->bytes_corrupted += length;
+        ctx->bytes_verified += length;
+        f3v_session_note_error(ctx, file_idx, block_idx, 0);
+
+        if (f3v_session_check_abort(ctx, (uint32_t)length, 0))
+        {
+            ctx->aborted = 1;
+            finish(ctx);
+        }
+        return;
+    }
+
+    /* Verify what was read; the buffer beyond it holds stale data */
+    uint32_t got = (uint32_t)bytes_read;
+    uint32_t first_offset = 0;
+    uint32_t corrupted = verify_data(ctx, buf, file_idx, block_idx, got, &first_offset);
+    int aliased = 0;
+
+    /* Re-read and vote: a mismatch that does not reproduce is transient */
+    if (corrupted > 0)
+    {
+        int64_t voted = vote_block(ctx, buf, file_idx, block_idx, got, &first_offset);
+        if (voted == 0)
+        {
+            ctx->vote_transient++;
+            corrupted = 0;
+        }
+        else
+        {
+            ctx->vote_persistent++;
+            if (voted > 0)
+            {
+                corrupted = (uint32_t)voted;
+            }
+        }
+    }
+
+    /* A short read is an error for the tail it did not return */
+    if (got < length)
+    {
+        if (corrupted == 0)
+        {
+            first_offset = got;
+        }
+        corrupted += (uint32_t)length - got;
+    }
+
+    if (corrupted > 0)
+    {
+        ctx->bytes_corrupted += corrupted;
+        f3v_session_note_error(ctx, file_idx, block_idx, first_offset);
+        aliased = f3v_session_note_alias(ctx, buf, file_idx, block_idx);
+    }
+
+    ctx->bytes_verified += length;
+
+    if (f3v_session_check_abort(ctx, corrupted, aliased))
+    {
+        ctx->aborted = 1;
+        finish(ctx);
+        return;
+    }
+
+    if (ctx->bytes_verified - ctx->last_checkpoint >= F3V_JOURNAL_INTERVAL)
+    {
+        checkpoint(ctx);
+    }
+}
+
+/* Discovery probes go to the prefilled test file 1 */
+typedef struct {
+    TestContext *ctx;
+    uint8_t *buf;
+} ProbeTarget;
+
+/**
+ * Discovery write callback: rewrite the pattern bytes at offset and sync
+ */
+static int64_t probe_write(void *handle, uint64_t offset, uint32_t len)
+{
+    ProbeTarget *target = (ProbeTarget *)handle;
+
+    /* Probes may straddle a pattern block boundary */
+    f3v_fill_file_range(target->buf, 1, offset, len);
+
+    uint64_t t0 = f3v_get_time_usec();
+    if (f3v_write_at(target->ctx->fd, target->buf, len, offset) != (int)len ||
+        f3v_sync(target->ctx->fd) < 0)
+    {
+        return -1;
+    }
+    return (int64_t)(f3v_get_time_usec() - t0);
+}
+
+/**
+ * Discovery phase - next timed probe write
+ */
+static void step_discover(TestContext *ctx, uint8_t *buf)
+{
+    ProbeTarget target = {ctx, buf};
+    DiscoverDevice dev = {probe_write, &target};
+
+    struct DiscoverState *state = ctx->run.discover.state;
+    int ret = ctx->fd >= 0 && state != NULL ? f3v_discover_step(state, &dev) : -1;
+    if (ret < 0)
+    {
+        ctx->aborted = 1;
+        finish(ctx);
+    }
+    else if (ret == 0)
+    {
+        ctx->run.discover.result = ctx->run.discover.state->result;
+        finish(ctx);
+    }
+}
+
+/**
+ * Small-file phase - next file system operation
+ */
+static void step_fstree(TestContext *ctx, uint8_t *buf)
+{
+    struct FsTreeState *tree = ctx->run.fstree.state;
+
+    int ret = f3v_fstree_step(tree, &g_tree_device, buf);
+    ctx->bytes_written = tree->written;
+    ctx->bytes_verified = tree->verified;
+    ctx->bytes_corrupted = tree->result.corrupted;
+
+    if (ret < 0)
+    {
+        ctx->aborted = 1;
+        finish(ctx);
+    }
+    else if (ret == 0)
+    {
+        finish(ctx);
+    }
+}
+
+/**
+ * Bit-rot or surface scan phase - next directory batch or read
+ */
+static void step_rotscan(TestContext *ctx)
+{
+    struct RotScanState *scan = ctx->run.scan.state;
+    uint64_t hashed = scan->hashed;
+
+    int ret = f3v_rotscan_step(scan, &g_rot_device);
+    ctx->bytes_verified = scan->hashed;
+    ctx->total_expected = scan->result.bytes;
+    ctx->bytes_corrupted = scan->result.bad_bytes;
+    f3v_throttle_io(&ctx->throttle, (size_t)(scan->hashed - hashed));
+
+    if (ret < 0)
+    {
+        ctx->aborted = 1;
+        finish(ctx);
+    }
+    else if (ret == 0)
+    {
+        finish(ctx);
+    }
+}
+
+int f3v_session_start(TestContext *ctx, const StorageDevice *device)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->target = *device;
+    ctx->fd = -1;
+
+    /* Create test directory */
+    int ret = f3v_create_test_dir(ctx);
+    if (ret < 0)
+    {
+        ctx->phase = PHASE_DONE;
+        return ret;
+    }
+
+    /* Initialize test */
+    ctx->total_expected = ctx->target.free_bytes;
+    ctx->start_time = f3v_get_time_usec();
+    ctx->phase_start_time = ctx->start_time;
+    ctx->phase = PHASE_WRITE;
+    ctx->session_nonce = (uint32_t)(ctx->start_time ^ (ctx->start_time >> 32));
+
+    return 0;
+}
+
+int f3v_session_start_verify(TestContext *ctx, const StorageDevice *device)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->target = *device;
+    ctx->fd = -1;
+    ctx->mode = MODE_VERIFY_ONLY;
+    ctx->phase = PHASE_DONE;
+
+    /* Rebuild what the earlier run wrote from the files on the card */
+    int ret = f3v_create_test_dir(ctx);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = f3v_scan_test_files(ctx);
+    if (ret <= 0 || ctx->bytes_written == 0)
+    {
+        return -1;
+    }
+
+    ctx->total_expected = ctx->bytes_written;
+    ctx->start_time = f3v_get_time_usec();
+    ctx->session_nonce = (uint32_t)(ctx->start_time ^ (ctx->start_time >> 32));
+    begin_verify(ctx);
+
+    return 0;
+}
+
+int f3v_session_start_retest(TestContext *ctx, const StorageDevice *device, uint32_t passes,
+                             uint32_t margin)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->target = *device;
+    ctx->fd = -1;
+    ctx->mode = MODE_RETEST;
+    ctx->phase = PHASE_DONE;
+
+    /* Regions come from the last verify; file sizes bound the margin */
+    int ret = f3v_create_test_dir(ctx);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (f3v_scan_test_files(ctx) <= 0 || f3v_fail_load(ctx) <= 0)
+    {
+        return -1;
+    }
+
+    ctx->run.retest.passes = passes > 0 ? passes : 1;
+    ctx->run.retest.margin = margin;
+
+    /* Progress counts read-back bytes */
+    uint64_t blocks = 0;
+    for (uint32_t i = 0; i < ctx->fail_count; i++)
+    {
+        uint32_t start;
+        blocks += f3v_fail_span(ctx, &ctx->fail[i], &start);
+    }
+    ctx->total_expected = blocks * ctx->run.retest.passes * F3V_BLOCK_SIZE;
+
+    ctx->start_time = f3v_get_time_usec();
+    ctx->phase_start_time = ctx->start_time;
+    ctx->phase = PHASE_RETEST;
+
+    return 0;
+}
+
+int f3v_session_start_burnin(TestContext *ctx, const StorageDevice *device, uint32_t passes,
+                             uint32_t duration_sec)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* Later passes rewrite the files with other variants: no checkpoint of an
+       earlier run survives */
+    f3v_journal_clear(ctx);
+
+    ctx->mode = MODE_BURNIN;
+    ctx->run.burn.passes = passes;
+    ctx->run.burn.duration_sec = duration_sec;
+    ctx->run.burn.pass_start = ctx->start_time;
+
+    return 0;
+}
+
+int f3v_session_start_bench(TestContext *ctx, const StorageDevice *device, uint32_t max_depth)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_BENCH;
+    ctx->run.bench.depth = max_depth;
+    ctx->run.bench.region = F3V_BENCH_REGION;
+    if (ctx->run.bench.region > ctx->target.free_bytes)
+    {
+        ctx->run.bench.region = ctx->target.free_bytes;
+    }
+    if (ctx->run.bench.region < F3V_BENCH_MIN_REGION)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->total_expected = ctx->run.bench.region;
+
+    /* The write phase prefills the region; f3v_bench_step() takes over */
+    if (f3v_bench_start(ctx) < 0)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    return 0;
+}
+
+int f3v_session_start_mixed(TestContext *ctx, const StorageDevice *device, uint32_t read_pct)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_MIXED;
+    ctx->run.mixed.read_pct = read_pct;
+
+    /* The write stream needs a region of the same size next to the one read */
+    ctx->run.mixed.region = F3V_MIXED_REGION;
+    if (ctx->run.mixed.region > ctx->target.free_bytes / 2)
+    {
+        ctx->run.mixed.region = ctx->target.free_bytes / 2 / F3V_BLOCK_SIZE * F3V_BLOCK_SIZE;
+    }
+    if (ctx->run.mixed.region < F3V_MIXED_MIN_REGION)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->total_expected = ctx->run.mixed.region;
+
+    /* The write phase prefills the region; f3v_mixed_step() takes over */
+    if (f3v_mixed_start(ctx) < 0)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    return 0;
+}
+
+int f3v_session_start_fstree(TestContext *ctx, const StorageDevice *device,
+                             const FsTreeShape *shape)
+{
+    char root[128];
+
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_FSTREE;
+    ctx->run.fstree.state = malloc(sizeof(*ctx->run.fstree.state));
+    if (ctx->run.fstree.state == NULL)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    snprintf(root, sizeof(root), "%s/%s", ctx->test_dir, F3V_FSTREE_ROOT);
+    /* Every file takes at least a cluster; allow one per file and directory */
+    struct FsTreeState *tree = ctx->run.fstree.state;
+    if (f3v_fstree_init(tree, shape, root, ctx->session_nonce) < 0 ||
+        tree->result.bytes + (uint64_t)(tree->result.files + tree->result.dirs) * 32768 >
+            ctx->target.free_bytes)
+    {
+        free(ctx->run.fstree.state);
+        ctx->run.fstree.state = NULL;
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->total_expected = ctx->run.fstree.state->result.bytes;
+    ctx->phase = PHASE_FSTREE;
+
+    return 0;
+}
+
+int f3v_session_start_rotscan(TestContext *ctx, const StorageDevice *device, const char *subdir)
+{
+    char root[128], manifest[128];
+
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_ROTSCAN;
+    ctx->total_expected = 0;
+    ctx->run.scan.state = malloc(sizeof(*ctx->run.scan.state));
+    if (ctx->run.scan.state == NULL)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    /* Each scanned directory keeps its own manifest */
+    snprintf(root, sizeof(root), "%s%s", ctx->target.path, subdir);
+    snprintf(manifest, sizeof(manifest), "%s/%s%s%s", ctx->test_dir, F3V_DIGEST_PREFIX,
+             subdir[0] != '\0' ? subdir : "all", F3V_DIGEST_EXT);
+    if (f3v_rotscan_init(ctx->run.scan.state, root, ctx->test_dir, manifest) < 0)
+    {
+        free(ctx->run.scan.state);
+        ctx->run.scan.state = NULL;
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->phase = PHASE_ROTSCAN;
+
+    return 0;
+}
+
+int f3v_session_start_surface(TestContext *ctx, const StorageDevice *device, const char *subdir)
+{
+    char root[128];
+
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_SURFACE;
+    ctx->total_expected = 0;
+    ctx->run.scan.state = malloc(sizeof(*ctx->run.scan.state));
+    if (ctx->run.scan.state == NULL)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    snprintf(root, sizeof(root), "%s%s", ctx->target.path, subdir);
+    if (f3v_rotscan_init_surface(ctx->run.scan.state, root, ctx->test_dir) < 0)
+    {
+        free(ctx->run.scan.state);
+        ctx->run.scan.state = NULL;
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->phase = PHASE_ROTSCAN;
+
+    return 0;
+}
+
+int f3v_session_start_wipe(TestContext *ctx, const StorageDevice *device, WipeFill fill,
+                           int verify)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_WIPE;
+    ctx->run.wipe.fill = fill;
+    ctx->run.wipe.verify = verify;
+
+    /* Its own directory, so the cleanup cannot reach a kept run's test
+       files, log, fail list or journal */
+    size_t len = strlen(ctx->test_dir);
+    snprintf(ctx->test_dir + len, sizeof(ctx->test_dir) - len, "/%s", F3V_WIPE_DIR);
+    if (f3v_mkdir(ctx->test_dir) < 0)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    ctx->run.wipe.mem = malloc((size_t)F3V_WIPE_MAX_BLOCKS * F3V_BLOCK_SIZE + 64);
+    if (ctx->run.wipe.mem == NULL)
+    {
+        f3v_rmdir(ctx->test_dir);
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->run.wipe.buf = (uint8_t *)(((uintptr_t)ctx->run.wipe.mem + 63) & ~(uintptr_t)63);
+
+    /* Time is what a wipe is for: measure the generators before starting */
+    ctx->run.wipe.kernel = f3v_wipe_pick_kernel(fill, ctx->run.wipe.buf, ctx->session_nonce,
+                                            f3v_get_time_usec, ctx->run.wipe.kernel_kbs);
+    f3v_wipe_tune_init(&ctx->run.wipe.tune);
+
+    return 0;
+}
+
+int f3v_session_start_streams(TestContext *ctx, const StorageDevice *device,
+                              uint32_t max_streams)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_STREAMS;
+    ctx->run.stream.max = max_streams < F3V_STREAM_MAX ? max_streams : F3V_STREAM_MAX;
+
+    /* The last round needs room for all its files at once */
+    if (ctx->target.free_bytes < ctx->run.stream.max * F3V_STREAM_BYTES)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->total_expected = (uint64_t)ctx->run.stream.max * (ctx->run.stream.max + 1) / 2 *
+                          F3V_STREAM_BYTES;
+
+    if (f3v_stream_start(ctx) < 0)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+    ctx->phase = PHASE_STREAMS;
+
+    return 0;
+}
+
+int f3v_session_start_discover(TestContext *ctx, const StorageDevice *device)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_DISCOVER;
+
+    /* The open-segment test needs erase blocks past the scanned window */
+    ctx->total_expected = F3V_DISCOVER_REGION;
+    if (ctx->total_expected > ctx->target.free_bytes)
+    {
+        ctx->total_expected = ctx->target.free_bytes / F3V_BLOCK_SIZE * F3V_BLOCK_SIZE;
+    }
+    if (ctx->total_expected < 2 * F3V_DISCOVER_SCAN)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    /* The write phase prefills the region; the probes follow in step_discover() */
+    return 0;
+}
+
+int f3v_session_start_conform(TestContext *ctx, const StorageDevice *device,
+                              uint32_t class_mbps)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_CONFORM;
+    f3v_conform_init(&ctx->run.conform.result, class_mbps);
+
+    /* Whole windows only */
+    ctx->total_expected = F3V_CONFORM_REGION;
+    if (ctx->total_expected > ctx->target.free_bytes)
+    {
+        ctx->total_expected = ctx->target.free_bytes / F3V_CONFORM_WINDOW * F3V_CONFORM_WINDOW;
+    }
+    if (ctx->total_expected < F3V_CONFORM_MIN_REGION)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    return 0;
+}
+
+int f3v_session_start_align(TestContext *ctx, const StorageDevice *device)
+{
+    int ret = f3v_session_start(ctx, device);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ctx->mode = MODE_ALIGN;
+    ctx->total_expected = F3V_ALIGN_REGION;
+    if (ctx->target.free_bytes < ctx->total_expected)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    /* The write phase prefills the region; f3v_align_step() takes over */
+    if (f3v_align_start(ctx) < 0)
+    {
+        ctx->phase = PHASE_DONE;
+        return -1;
+    }
+
+    return 0;
+}
+
+int f3v_session_start_sample(TestContext *ctx, const StorageDevice *device, uint32_t budget_sec,
+                             uint32_t target_ppm)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->target = *device;
+    ctx->fd = -1;
+    ctx->mode = MODE_SAMPLE;
+    ctx->phase = PHASE_DONE;
+
+    int ret = f3v_create_test_dir(ctx);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* Sample the space a full run would fill, within the pattern's file limit */
+    uint64_t space = ctx->target.free_bytes > F3V_SAMPLE_RESERVE
+                         ? ctx->target.free_bytes - F3V_SAMPLE_RESERVE
+                         : 0;
+    ctx->run.sample.total_blocks = space / F3V_BLOCK_SIZE;
+    if (ctx->run.sample.total_blocks > 255ULL * F3V_BLOCKS_PER_FILE)
+    {
+        ctx->run.sample.total_blocks = 255ULL * F3V_BLOCKS_PER_FILE;
+    }
+    ctx->run.sample.budget_sec = budget_sec;
+    ctx->run.sample.target_ppm = target_ppm;
+
+    ctx->start_time = f3v_get_time_usec();
+    ctx->phase_start_time = ctx->start_time;
+    ctx->session_nonce = (uint32_t)(ctx->start_time ^ (ctx->start_time >> 32));
+
+    if (f3v_sample_start(ctx) < 0)
+    {
+        return -1;
+    }
+    ctx->phase = PHASE_SAMPLE;
+
+    return 0;
+}
+
+void f3v_session_discard(TestContext *ctx)
+{
+    f3v_readback_stop(ctx);
+    stop_mode(ctx);
+    f3v_session_close_file(ctx);
+
+    if (ctx->mode == MODE_WIPE && ctx->run.wipe.mem != NULL)
+    {
+        free(ctx->run.wipe.mem);
+        ctx->run.wipe.mem = NULL;
+        ctx->run.wipe.buf = NULL;
+        f3v_rmdir(ctx->test_dir);
+    }
+    ctx->phase = PHASE_DONE;
+}
+
+int f3v_session_step(TestContext *ctx, uint8_t *buf)
+{
+    if (ctx->cancelled && ctx->phase != PHASE_DONE)
+    {
+        finish(ctx);
+    }
+
+    switch (ctx->phase)
+    {
+    case PHASE_WRITE:
+        step_write(ctx, buf);
+        break;
+    case PHASE_VERIFY:
+        step_verify(ctx, buf);
+        break;
+    case PHASE_RETEST:
+        if (!f3v_retest_step(ctx, buf))
+        {
+            finish(ctx);
+        }
+        break;
+    case PHASE_SAMPLE:
+        if (!f3v_sample_step(ctx, buf))
+        {
+            finish(ctx);
+        }
+        break;
+    case PHASE_BENCH:
+        if (!f3v_bench_step(ctx))
+        {
+            finish(ctx);
+        }
+        break;
+    case PHASE_STREAMS:
+        if (!f3v_stream_step(ctx))
+        {
+            finish(ctx);
+        }
+        break;
+    case PHASE_MIXED:
+        if (!f3v_mixed_step(ctx))
+        {
+            finish(ctx);
+        }
+        break;
+    case PHASE_DISCOVER:
+        step_discover(ctx, buf);
+        break;
+    case PHASE_FSTREE:
+        step_fstree(ctx, buf);
+        break;
+    case PHASE_ROTSCAN:
+        step_rotscan(ctx);
+        break;
+    case PHASE_ALIGN:
+        if (!f3v_align_step(ctx))
+        {
+            finish(ctx);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return ctx->phase != PHASE_DONE;
+}
+
+TestResult f3v_session_result(const TestContext *ctx)
+{
+    if (ctx->cancelled)
+    {
+        return RESULT_CANCELLED;
+    }
+    if (ctx->bytes_corrupted > 0)
+    {
+        return RESULT_FAIL;
+    }
+    return RESULT_PASS;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file stats.c
+ * @brief Statistics helpers: confidence bounds and latency percentiles
+ */
+
+#include <math.h>
+
+#include "stats.h"
+
+double f3v_wilson_upper(uint64_t bad, uint64_t n, double z)
+{
+    if (n == 0)
+    {
+        return 1.0;
+    }
+
+    double nn = (double)n;
+    double p = (double)bad / nn;
+    double z2 = z * z;
+
+    double center = p + z2 / (2.0 * nn);
+    double margin = z * sqrt(p * (1.0 - p) / nn + z2 / (4.0 * nn * nn));
+    double upper = (center + margin) / (1.0 + z2 / nn);
+
+    return upper > 1.0 ? 1.0 : upper;
+}
+
+uint64_t f3v_wilson_samples_needed(double target, double z)
+{
+    /* With no failures the bound reduces to z^2 / (n + z^2) */
+    double z2 = z * z;
+    uint64_t n = (uint64_t)ceil(z2 * (1.0 - target) / target);
+
+    /* Guard against rounding at the boundary */
+    while (n > 0 && f3v_wilson_upper(0, n - 1, z) <= target)
+    {
+        n--;
+    }
+    while (f3v_wilson_upper(0, n, z) > target)
+    {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Bucket holding a latency
+ */
+static uint32_t hist_bucket(uint32_t usec)
+{
+    if (usec < F3V_HIST_SUB)
+    {
+        return usec;
+    }
+
+    uint32_t msb = 31;
+    while (!(usec & (1u << msb)))
+    {
+        msb--;
+    }
+    uint32_t shift = msb - F3V_HIST_SUB_BITS;
+    return (shift + 1) * F3V_HIST_SUB + ((usec >> shift) - F3V_HIST_SUB);
+}
+
+/**
+ * Largest latency that falls into a bucket
+ */
+static uint32_t hist_upper(uint32_t bucket)
+{
+    if (bucket < F3V_HIST_SUB)
+    {
+        return bucket;
+    }
+
+    uint32_t shift = bucket / F3V_HIST_SUB - 1;
+    uint64_t low = (uint64_t)(F3V_HIST_SUB + bucket % F3V_HIST_SUB) << shift;
+    uint64_t high = low + (1ULL << shift) - 1;
+    return high > UINT32_MAX ? UINT32_MAX : (uint32_t)high;
+}
+
+void f3v_hist_add(LatencyHist *hist, uint32_t usec)
+{
+    hist->count[hist_bucket(usec)]++;
+    hist->total++;
+    hist->sum_usec += usec;
+    if (usec > hist->max_usec)
+    {
+        hist->max_usec = usec;
+    }
+}
+
+void f3v_hist_merge(LatencyHist *dst, const LatencyHist *src)
+{
+    for (uint32_t i = 0; i < F3V_HIST_BUCKETS; i++)
+    {
+        dst->count[i] += src->count[i];
+    }
+    dst->total += src->total;
+    dst->sum_usec += src->sum_usec;
+    if (src->max_usec > dst->max_usec)
+    {
+        dst->max_usec = src->max_usec;
+    }
+}
+
+uint32_t f3v_hist_percentile(const LatencyHist *hist, double q)
+{
+    if (hist->total == 0)
+    {
+        return 0;
+    }
+
+    /* Rank of the quantile, 1-based */
+    uint64_t rank = (uint64_t)ceil(q * (double)hist->total);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < F3V_HIST_BUCKETS; i++)
+    {
+        seen += hist->count[i];
+        if (seen >= rank)
+        {
+            uint32_t upper = hist_upper(i);
+            return upper < hist->max_usec ? upper : hist->max_usec;
+        }
+    }
+    return hist->max_usec;
+}
@@ -11,6 +11,9 @@
 #include <stdio.h>
 
 #include "storage.h"
+#include "thread.h"
+#include "throttle.h"
+#include "ui.h"
 
 /* Known storage paths on PS Vita */
 static const struct
@@ -102,6 +105,33 @@ int f3v_open_write(const char *path)
     return sceIoOpen(path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0666);
 }
 
+int f3v_open_resume(const char *path, uint64_t offset)
+{
+    int fd = sceIoOpen(path, SCE_O_WRONLY | SCE_O_CREAT, 0666);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    if (f3v_seek(fd, offset) < 0)
+    {
+        sceIoClose(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int f3v_open_rw(const char *path, int create)
+{
+    return sceIoOpen(path, create ? SCE_O_RDWR | SCE_O_CREAT : SCE_O_RDWR, 0666);
+}
+
+int f3v_open_append(const char *path)
+{
+    return sceIoOpen(path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_APPEND, 0666);
+}
+
 int f3v_open_read(const char *path)
 {
     return sceIoOpen(path, SCE_O_RDONLY, 0);
@@ -117,6 +147,162 @@ int f3v_read_block(int fd, void *buf, size_t size)
     return sceIoRead(fd, buf, size);
 }
 
+int f3v_write_at(int fd, const void *buf, size_t size, uint64_t offset)
+{
+    return sceIoPwrite(fd, buf, size, (SceOff)offset);
+}
+
+int f3v_read_at(int fd, void *buf, size_t size, uint64_t offset)
+{
+    return sceIoPread(fd, buf, size, (SceOff)offset);
+}
+
+/**
+ * Positional transfer with the bounded retry policy
+ */
+static int transfer_retry(int fd, uint8_t *buf, size_t size, uint64_t offset, uint32_t *retries,
+                          int write)
+{
+    size_t done = 0;
+    uint32_t backoff = F3V_IO_BACKOFF_US;
+    int ret = 0;
+
+    for (uint32_t attempt = 0;; attempt++)
+    {
+        ret = write ? sceIoPwrite(fd, buf + done, size - done, (SceOff)(offset + done))
+                    : sceIoPread(fd, buf + done, size - done, (SceOff)(offset + done));
+        if (ret > 0)
+        {
+            done += (size_t)ret;
+            if (done >= size)
+            {
+                break;
+            }
+        }
+
+        if (attempt == F3V_IO_RETRIES)
+        {
+            break;
+        }
+        (*retries)++;
+
+        /* Errors get time to clear; a short transfer just continues */
+        if (ret <= 0)
+        {
+            f3v_thread_sleep_usec(backoff);
+            backoff *= 4;
+        }
+    }
+
+    return done > 0 ? (int)done : ret;
+}
+
+int f3v_write_retry(int fd, const void *buf, size_t size, uint64_t offset, uint32_t *retries)
+{
+    return transfer_retry(fd, (uint8_t *)buf, size, offset, retries, 1);
+}
+
+int f3v_read_retry(int fd, void *buf, size_t size, uint64_t offset, uint32_t *retries)
+{
+    return transfer_retry(fd, (uint8_t *)buf, size, offset, retries, 0);
+}
+
+int f3v_seek(int fd, uint64_t offset)
+{
+    SceOff pos = sceIoLseek(fd, (SceOff)offset, SCE_SEEK_SET);
+    return pos < 0 ? (int)pos : 0;
+}
+
+int f3v_sync(int fd)
+{
+    return sceIoSyncByFd(fd, 0);
+}
+
+int64_t f3v_get_file_size(const char *path)
+{
+    SceIoStat stat;
+
+    int ret = sceIoGetstat(path, &stat);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    return stat.st_size;
+}
+
+int f3v_remove(const char *path)
+{
+    return sceIoRemove(path);
+}
+
+int f3v_mkdir(const char *path)
+{
+    int ret = sceIoMkdir(path, 0777);
+    if (ret < 0 && ret != (int)0x80010011)
+    { /* Ignore "already exists" error */
+        return ret;
+    }
+
+    return 0;
+}
+
+int f3v_rmdir(const char *path)
+{
+    return sceIoRmdir(path);
+}
+
+int f3v_rename(const char *from, const char *to)
+{
+    return sceIoRename(from, to);
+}
+
+int f3v_dir_open(const char *path)
+{
+    return sceIoDopen(path);
+}
+
+int f3v_dir_read(int dir, char *name, size_t name_size, int *is_dir, uint64_t *size,
+                 uint64_t *mtime)
+{
+    SceIoDirent entry;
+
+    memset(&entry, 0, sizeof(entry));
+    int ret = sceIoDread(dir, &entry);
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    const SceDateTime *t = &entry.d_stat.sce_st_mtime;
+    snprintf(name, name_size, "%s", entry.d_name);
+    *is_dir = SCE_S_ISDIR(entry.d_stat.st_mode);
+    *size = (uint64_t)entry.d_stat.st_size;
+    *mtime = (uint64_t)t->year << 48 | (uint64_t)t->month << 40 | (uint64_t)t->day << 32 |
+             (uint64_t)t->hour << 24 | (uint64_t)t->minute << 16 | (uint64_t)t->second << 8 |
+             t->microsecond / 10000;
+    return 1;
+}
+
+void f3v_dir_close(int dir)
+{
+    sceIoDclose(dir);
+}
+
+void f3v_throttle_init(IoThrottle *throttle, uint32_t rate_mbps, uint32_t burst_mb)
+{
+    f3v_throttle_setup(throttle, rate_mbps, burst_mb, f3v_get_time_usec());
+}
+
+void f3v_throttle_wait(IoThrottle *throttle, size_t bytes)
+{
+    uint64_t wait = f3v_throttle_take(throttle, bytes, f3v_get_time_usec());
+    if (wait > 0)
+    {
+        f3v_thread_sleep_usec((uint32_t)wait);
+    }
+}
+
 int f3v_close(int fd)
 {
     return sceIoClose(fd);
@@ -138,12 +324,68 @@ int f3v_cleanup_files(TestContext *ctx)
         }
     }
 
+    /* Re-check history and failed regions go with the files they describe */
+    snprintf(filename, sizeof(filename), "%s/%s", ctx->test_dir, F3V_LOG_NAME);
+    sceIoRemove(filename);
+    snprintf(filename, sizeof(filename), "%s/%s", ctx->test_dir, F3V_FAIL_NAME);
+    sceIoRemove(filename);
+
     /* Try to remove the test directory (will fail if not empty) */
     sceIoRmdir(ctx->test_dir);
 
     return deleted;
 }
 
+int f3v_scan_test_files(TestContext *ctx)
+{
+    /* Index 0 is unused; the pattern supports up to 255 files */
+    int64_t sizes[256];
+    memset(sizes, 0xFF, sizeof(sizes));
+
+    SceUID dir = sceIoDopen(ctx->test_dir);
+    if (dir < 0)
+    {
+        return dir;
+    }
+
+    SceIoDirent entry;
+    size_t prefix_len = strlen(F3V_FILE_PREFIX);
+
+    memset(&entry, 0, sizeof(entry));
+    while (sceIoDread(dir, &entry) > 0)
+    {
+        unsigned int index;
+        char ext[8];
+
+        if (strncmp(entry.d_name, F3V_FILE_PREFIX, prefix_len) == 0 &&
+            sscanf(entry.d_name + prefix_len, "%3u%7s", &index, ext) == 2 &&
+            strcmp(ext, F3V_FILE_EXT) == 0 && index > 0 && index < 256)
+        {
+            sizes[index] = entry.d_stat.st_size;
+        }
+        memset(&entry, 0, sizeof(entry));
+    }
+    sceIoDclose(dir);
+
+    ctx->files_written = 0;
+    ctx->bytes_written = 0;
+
+    for (uint32_t i = 1; i < 256 && sizes[i] >= 0; i++)
+    {
+        ctx->files_written = i;
+        ctx->bytes_written += (uint64_t)sizes[i];
+
+        if (sizes[i] < F3V_FILE_SIZE)
+        {
+            break;
+        }
+    }
+
+    ctx->bytes_written -= ctx->bytes_written % F3V_BLOCK_SIZE;
+
+    return (int)ctx->files_written;
+}
+
 int f3v_has_space(TestContext *ctx)
 {
     /* Refresh storage info */
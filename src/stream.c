@@ -0,0 +1,326 @@
+/**
+ * @file stream.c
+ * @brief Parallel sequential streams to measure controller concurrency
+ */
+
+#include <stdlib.h>
+
+#include "stream.h"
+#include "pattern.h"
+#include "profile.h"
+#include "storage.h"
+#include "thread.h"
+#include "ui.h"
+
+#define STREAM_BLOCKS (uint32_t)(F3V_STREAM_BYTES / F3V_BLOCK_SIZE)
+
+/* One stream: a thread working through its own test file */
+typedef struct {
+    struct StreamState *state;
+    F3vThread thread;
+    uint32_t file;          /* Test file index, also its pattern file index */
+    int fd;
+    uint8_t *buf;
+
+    /* Written by the thread, read by the session step */
+    volatile uint32_t blocks_done;
+    volatile int finished;
+
+    /* Owned by the thread until it is joined */
+    uint64_t start;
+    uint64_t end;
+    uint64_t corrupted;
+} StreamWorker;
+
+struct StreamState {
+    TestContext *ctx;
+    StreamWorker worker[F3V_STREAM_MAX];
+    uint32_t running;       /* Streams of the current round (0 = idle) */
+    uint64_t started;
+    uint64_t bytes_before;  /* Session byte counter when the round started */
+    volatile int stop;
+};
+
+/**
+ * Stream thread: write or read and verify the stream's file in order
+ */
+static int stream_thread(void *arg)
+{
+    StreamWorker *w = (StreamWorker *)arg;
+    struct StreamState *s = w->state;
+    TestContext *ctx = s->ctx;
+    int profile_applied = -1;
+
+    f3v_profile_refresh(ROLE_IO, &profile_applied);
+    w->start = f3v_get_time_usec();
+
+    for (uint32_t b = 0; b < STREAM_BLOCKS && !s->stop && !ctx->cancelled; b++)
+    {
+        uint64_t offset = (uint64_t)b * F3V_BLOCK_SIZE;
+
+        /* Patterns are made on the stream's own thread: the shared pool has
+           fewer job slots than streams and would serialise them */
+        if (!ctx->run.stream.reading)
+        {
+            f3v_fill_pattern(w->buf, w->file, b);
+            if (f3v_write_at(w->fd, w->buf, F3V_BLOCK_SIZE, offset) != F3V_BLOCK_SIZE)
+            {
+                /* The rest of the stream is lost */
+                w->corrupted += (uint64_t)(STREAM_BLOCKS - b) * F3V_BLOCK_SIZE;
+                break;
+            }
+        }
+        else if (f3v_read_at(w->fd, w->buf, F3V_BLOCK_SIZE, offset) == F3V_BLOCK_SIZE)
+        {
+            w->corrupted += f3v_verify_pattern(w->buf, w->file, b, NULL);
+        }
+        else
+        {
+            w->corrupted += F3V_BLOCK_SIZE;
+        }
+        w->blocks_done = b + 1;
+    }
+
+    if (!ctx->run.stream.reading)
+    {
+        f3v_sync(w->fd);
+    }
+    w->end = f3v_get_time_usec();
+    w->finished = 1;
+    return 0;
+}
+
+/**
+ * Join the round's threads and close their files
+ */
+static void join_streams(struct StreamState *s)
+{
+    for (uint32_t i = 0; i < s->running; i++)
+    {
+        StreamWorker *w = &s->worker[i];
+
+        f3v_thread_join(&w->thread);
+        f3v_close(w->fd);
+        w->fd = -1;
+    }
+}
+
+/**
+ * Delete the round's test files
+ */
+static void remove_files(TestContext *ctx, uint32_t count)
+{
+    char filename[128];
+
+    for (uint32_t i = 1; i <= count; i++)
+    {
+        f3v_get_test_filename(ctx, i, filename, sizeof(filename));
+        f3v_remove(filename);
+    }
+}
+
+/**
+ * Start the write or read threads for the current round
+ * @return 0 on success, negative on error
+ */
+static int start_round(struct StreamState *s, uint32_t streams)
+{
+    TestContext *ctx = s->ctx;
+    char filename[128];
+
+    s->running = 0;
+    s->stop = 0;
+    s->started = f3v_get_time_usec();
+    s->bytes_before = ctx->run.stream.reading ? ctx->bytes_verified : ctx->bytes_written;
+
+    for (uint32_t i = 0; i < streams; i++)
+    {
+        StreamWorker *w = &s->worker[i];
+
+        w->state = s;
+        w->file = i + 1;
+        w->blocks_done = 0;
+        w->finished = 0;
+        w->corrupted = 0;
+
+        f3v_get_test_filename(ctx, w->file, filename, sizeof(filename));
+        w->fd = ctx->run.stream.reading ? f3v_open_read(filename) : f3v_open_write(filename);
+        if (w->fd >= 0 && f3v_thread_create(&w->thread, "f3v_stream", stream_thread, w) < 0)
+        {
+            f3v_close(w->fd);
+            w->fd = -1;
+        }
+        if (w->fd < 0)
+        {
+            s->stop = 1;
+            join_streams(s);
+            s->running = 0;
+            return -1;
+        }
+        s->running++;
+    }
+
+    return 0;
+}
+
+/**
+ * Per-stream throughput in KB/s
+ */
+static uint32_t stream_kbs(const StreamWorker *w)
+{
+    uint64_t usec = w->end - w->start;
+    return usec > 0 ? (uint32_t)((uint64_t)w->blocks_done * 1024 * 1000000 / usec) : 0;
+}
+
+/**
+ * All streams of the round finished: join them and record the round
+ */
+static void end_round(struct StreamState *s)
+{
+    TestContext *ctx = s->ctx;
+    StreamResult *result = &ctx->run.stream.result[ctx->run.stream.count];
+    uint64_t last_end = s->started;
+    uint64_t blocks = 0;
+    uint32_t min_kbs = UINT32_MAX, max_kbs = 0;
+
+    join_streams(s);
+
+    for (uint32_t i = 0; i < s->running; i++)
+    {
+        const StreamWorker *w = &s->worker[i];
+        uint32_t kbs = stream_kbs(w);
+
+        blocks += w->blocks_done;
+        min_kbs = kbs < min_kbs ? kbs : min_kbs;
+        max_kbs = kbs > max_kbs ? kbs : max_kbs;
+        last_end = w->end > last_end ? w->end : last_end;
+        result->corrupted += w->corrupted;
+        ctx->bytes_corrupted += w->corrupted;
+    }
+
+    /* Aggregate over the wall time until the slowest stream finished */
+    uint64_t usec = last_end - s->started;
+    uint32_t total_kbs = usec > 0 ? (uint32_t)(blocks * 1024 * 1000000 / usec) : 0;
+
+    if (!ctx->run.stream.reading)
+    {
+        result->write_kbs = total_kbs;
+        result->write_min_kbs = min_kbs;
+        result->write_max_kbs = max_kbs;
+        ctx->bytes_written = s->bytes_before + blocks * F3V_BLOCK_SIZE;
+        ctx->run.stream.reading = 1;
+    }
+    else
+    {
+        result->read_kbs = total_kbs;
+        result->read_min_kbs = min_kbs;
+        result->read_max_kbs = max_kbs;
+        ctx->bytes_verified = s->bytes_before + blocks * F3V_BLOCK_SIZE;
+        remove_files(ctx, s->running);
+        ctx->run.stream.reading = 0;
+        ctx->run.stream.count++;
+    }
+    s->running = 0;
+}
+
+int f3v_stream_start(TestContext *ctx)
+{
+    struct StreamState *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+    {
+        return -1;
+    }
+    s->ctx = ctx;
+
+    for (uint32_t i = 0; i < F3V_STREAM_MAX; i++)
+    {
+        s->worker[i].fd = -1;
+        s->worker[i].buf = malloc(F3V_BLOCK_SIZE);
+        if (s->worker[i].buf == NULL)
+        {
+            for (uint32_t j = 0; j < i; j++)
+            {
+                free(s->worker[j].buf);
+            }
+            free(s);
+            return -1;
+        }
+    }
+
+    ctx->run.stream.state = s;
+    return 0;
+}
+
+int f3v_stream_step(TestContext *ctx)
+{
+    struct StreamState *s = ctx->run.stream.state;
+    uint32_t streams = ctx->run.stream.count + 1;
+
+    if (s->running == 0)
+    {
+        if (ctx->run.stream.count >= ctx->run.stream.max)
+        {
+            return 0;
+        }
+        if (start_round(s, streams) < 0)
+        {
+            /* A stream that cannot open its file fails the round */
+            ctx->run.stream.result[ctx->run.stream.count].corrupted += F3V_STREAM_BYTES;
+            ctx->bytes_corrupted += F3V_STREAM_BYTES;
+            remove_files(ctx, streams);
+            ctx->run.stream.reading = 0;
+            ctx->run.stream.count++;
+        }
+        return 1;
+    }
+
+    /* Progress for the UI while the streams run */
+    uint64_t blocks = 0;
+    int finished = 1;
+    for (uint32_t i = 0; i < s->running; i++)
+    {
+        blocks += s->worker[i].blocks_done;
+        finished = finished && s->worker[i].finished;
+    }
+    if (ctx->run.stream.reading)
+    {
+        ctx->bytes_verified = s->bytes_before + blocks * F3V_BLOCK_SIZE;
+    }
+    else
+    {
+        ctx->bytes_written = s->bytes_before + blocks * F3V_BLOCK_SIZE;
+    }
+
+    if (!finished)
+    {
+        f3v_thread_sleep_usec(F3V_STREAM_POLL_US);
+        return 1;
+    }
+
+    end_round(s);
+    return ctx->run.stream.count < ctx->run.stream.max;
+}
+
+void f3v_stream_stop(TestContext *ctx)
+{
+    struct StreamState *s = ctx->run.stream.state;
+
+    if (s == NULL)
+    {
+        return;
+    }
+
+    /* Cancelled mid-round */
+    if (s->running > 0)
+    {
+        s->stop = 1;
+        join_streams(s);
+        remove_files(ctx, s->running);
+    }
+    for (uint32_t i = 0; i < F3V_STREAM_MAX; i++)
+    {
+        free(s->worker[i].buf);
+    }
+    free(s);
+    ctx->run.stream.state = NULL;
+}
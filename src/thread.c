@@ -0,0 +1,219 @@
+/**
+ * @file thread.c
+ * @brief Minimal threading primitives (Vita kernel objects or pthreads)
+ */
+
+#ifndef __vita__
+#define _POSIX_C_SOURCE 200809L /* nanosleep */
+#endif
+
+#include "thread.h"
+
+#ifdef __vita__
+
+/* Default stack for worker threads */
+#define F3V_THREAD_STACK (64 * 1024)
+
+/* Copied onto the new thread's stack by sceKernelStartThread */
+typedef struct {
+    F3vThreadFunc func;
+    void *arg;
+} ThreadStart;
+
+static int thread_entry(SceSize args, void *argp)
+{
+    ThreadStart *start = (ThreadStart *)argp;
+    (void)args;
+    return start->func(start->arg);
+}
+
+int f3v_thread_create(F3vThread *thread, const char *name, F3vThreadFunc func, void *arg)
+{
+    ThreadStart start = {func, arg};
+
+    SceUID thid = sceKernelCreateThread(name, thread_entry, SCE_KERNEL_DEFAULT_PRIORITY_USER,
+                                        F3V_THREAD_STACK, 0, SCE_KERNEL_CPU_MASK_USER_ALL, NULL);
+    if (thid < 0)
+    {
+        return thid;
+    }
+
+    int ret = sceKernelStartThread(thid, sizeof(start), &start);
+    if (ret < 0)
+    {
+        sceKernelDeleteThread(thid);
+        return ret;
+    }
+
+    *thread = thid;
+    return 0;
+}
+
+int f3v_thread_join(F3vThread *thread)
+{
+    int ret = sceKernelWaitThreadEnd(*thread, NULL, NULL);
+    sceKernelDeleteThread(*thread);
+    return ret < 0 ? ret : 0;
+}
+
+void f3v_thread_sleep_usec(uint32_t usec)
+{
+    sceKernelDelayThread(usec);
+}
+
+int f3v_mutex_init(F3vMutex *mutex, const char *name)
+{
+    *mutex = sceKernelCreateMutex(name, 0, 0, NULL);
+    return *mutex < 0 ? *mutex : 0;
+}
+
+void f3v_mutex_lock(F3vMutex *mutex)
+{
+    sceKernelLockMutex(*mutex, 1, NULL);
+}
+
+void f3v_mutex_unlock(F3vMutex *mutex)
+{
+    sceKernelUnlockMutex(*mutex, 1);
+}
+
+void f3v_mutex_destroy(F3vMutex *mutex)
+{
+    sceKernelDeleteMutex(*mutex);
+}
+
+int f3v_sema_init(F3vSema *sema, const char *name, int initial)
+{
+    *sema = sceKernelCreateSema(name, 0, initial, 0x7FFFFFFF, NULL);
+    return *sema < 0 ? *sema : 0;
+}
+
+void f3v_sema_wait(F3vSema *sema)
+{
+    sceKernelWaitSema(*sema, 1, NULL);
+}
+
+void f3v_sema_signal(F3vSema *sema, int count)
+{
+    sceKernelSignalSema(*sema, count);
+}
+
+void f3v_sema_destroy(F3vSema *sema)
+{
+    sceKernelDeleteSema(*sema);
+}
+
+#else /* Host: pthreads */
+
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    F3vThreadFunc func;
+    void *arg;
+} ThreadStart;
+
+static void *thread_entry(void *argp)
+{
+    ThreadStart start = *(ThreadStart *)argp;
+    free(argp);
+    start.func(start.arg);
+    return NULL;
+}
+
+int f3v_thread_create(F3vThread *thread, const char *name, F3vThreadFunc func, void *arg)
+{
+    ThreadStart *start = malloc(sizeof(*start));
+    (void)name;
+
+    if (start == NULL)
+    {
+        return -1;
+    }
+    start->func = func;
+    start->arg = arg;
+
+    if (pthread_create(thread, NULL, thread_entry, start) != 0)
+    {
+        free(start);
+        return -1;
+    }
+    return 0;
+}
+
+int f3v_thread_join(F3vThread *thread)
+{
+    return pthread_join(*thread, NULL) == 0 ? 0 : -1;
+}
+
+void f3v_thread_sleep_usec(uint32_t usec)
+{
+    struct timespec ts;
+    ts.tv_sec = usec / 1000000;
+    ts.tv_nsec = (long)(usec % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+}
+
+int f3v_mutex_init(F3vMutex *mutex, const char *name)
+{
+    (void)name;
+    return pthread_mutex_init(mutex, NULL) == 0 ? 0 : -1;
+}
+
+void f3v_mutex_lock(F3vMutex *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+void f3v_mutex_unlock(F3vMutex *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+void f3v_mutex_destroy(F3vMutex *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+int f3v_sema_init(F3vSema *sema, const char *name, int initial)
+{
+    (void)name;
+    sema->count = initial;
+    if (pthread_mutex_init(&sema->lock, NULL) != 0)
+    {
+        return -1;
+    }
+    if (pthread_cond_init(&sema->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&sema->lock);
+        return -1;
+    }
+    return 0;
+}
+
+void f3v_sema_wait(F3vSema *sema)
+{
+    pthread_mutex_lock(&sema->lock);
+    while (sema->count == 0)
+    {
+        pthread_cond_wait(&sema->cond, &sema->lock);
+    }
+    sema->count--;
+    pthread_mutex_unlock(&sema->lock);
+}
+
+void f3v_sema_signal(F3vSema *sema, int count)
+{
+    pthread_mutex_lock(&sema->lock);
+    sema->count += count;
+    pthread_cond_broadcast(&sema->cond);
+    pthread_mutex_unlock(&sema->lock);
+}
+
+void f3v_sema_destroy(F3vSema *sema)
+{
+    pthread_cond_destroy(&sema->cond);
+    pthread_mutex_destroy(&sema->lock);
+}
+
+#endif /* __vita__ */
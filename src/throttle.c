@@ -0,0 +1,66 @@
+/**
+ * @file throttle.c
+ * @brief Token-bucket rate limiter and its rate-compliance windows
+ */
+
+#include <string.h>
+
+#include "throttle.h"
+
+void f3v_throttle_setup(IoThrottle *throttle, uint32_t rate_mbps, uint32_t burst_mb,
+                        uint64_t now)
+{
+    memset(throttle, 0, sizeof(*throttle));
+
+    if (rate_mbps == 0)
+    {
+        return;
+    }
+
+    throttle->rate_bps = (uint64_t)rate_mbps * 1024 * 1024;
+    throttle->burst_bytes = (uint64_t)(burst_mb > 0 ? burst_mb : 1) * 1024 * 1024;
+    throttle->tokens = (int64_t)throttle->burst_bytes;
+    throttle->last_refill = now;
+    throttle->window_start = now;
+}
+
+uint64_t f3v_throttle_take(IoThrottle *throttle, size_t bytes, uint64_t now)
+{
+    /* Judge a finished window over its own length, then move on to the
+       window holding now, skipping whole windows without any transfer */
+    uint64_t elapsed = now - throttle->window_start;
+    if (elapsed >= F3V_THROTTLE_WINDOW_USEC)
+    {
+        uint64_t target = throttle->rate_bps * F3V_THROTTLE_WINDOW_USEC / 1000000;
+        if (!throttle->window_partial)
+        {
+            throttle->windows++;
+            if (throttle->window_bytes * 100 < target * F3V_THROTTLE_TARGET_PCT)
+            {
+                throttle->windows_missed++;
+            }
+        }
+        throttle->window_start += elapsed / F3V_THROTTLE_WINDOW_USEC * F3V_THROTTLE_WINDOW_USEC;
+        throttle->window_bytes = 0;
+
+        /* After a whole window with no transfer the new window began idle */
+        throttle->window_partial = now - throttle->last_refill >= F3V_THROTTLE_WINDOW_USEC;
+    }
+    throttle->window_bytes += bytes;
+
+    /* Refill, capped at the burst size */
+    throttle->tokens += (int64_t)(throttle->rate_bps * (now - throttle->last_refill) / 1000000);
+    if (throttle->tokens > (int64_t)throttle->burst_bytes)
+    {
+        throttle->tokens = (int64_t)throttle->burst_bytes;
+    }
+    throttle->last_refill = now;
+
+    /* Spend; if in debt, wait until the debt is paid off */
+    throttle->tokens -= (int64_t)bytes;
+    if (throttle->tokens >= 0)
+    {
+        return 0;
+    }
+    return (uint64_t)(-throttle->tokens) * 1000000 / throttle->rate_bps;
+}
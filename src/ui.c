@@ -11,6 +11,20 @@
 #include <string.h>
 
 #include "ui.h"
+#include "profile.h"
+#include "faillist.h"
+#include "readback.h"
+#include "session.h"
+#include "order.h"
+#include "bench.h"
+#include "stream.h"
+#include "discover.h"
+#include "align.h"
+#include "conform.h"
+#include "mixed.h"
+#include "fstree.h"
+#include "wipe.h"
+#include "rotscan.h"
 
 /* Debug screen from VitaSDK samples */
 #include <debugScreen.h>
@@ -19,6 +33,21 @@
 #define SCREEN_WIDTH 60
 #define SCREEN_HEIGHT 34
 
+/* Grid cases this much slower than the baseline are highlighted (percent) */
+#define ALIGN_PENALTY 20
+
+/* Read p99 under writes this many times the read-alone p99 is highlighted */
+#define MIXED_SPIKE 4
+
+/* Runs of slow conformance windows listed */
+#define CONFORM_ROWS 4
+
+/* Burn-in passes listed on the results screen */
+#define BURN_ROWS 6
+
+/* Write slowdown from the first to the last burn-in pass shown as a warning (%) */
+#define BURN_SLOWDOWN 20
+
 /* Last button state for edge detection */
 static uint32_t g_last_buttons = 0;
 
@@ -47,7 +76,8 @@ void f3v_ui_header(const char *title)
     psvDebugScreenSetFgColor(0xFFFFFFFF); /* White */
 }
 
-void f3v_ui_menu(const StorageDevice *devices, int count, int selected)
+void f3v_ui_menu(const StorageDevice *devices, int count, int selected, const int *marked,
+                 const MenuOption *options, int option_count)
 {
     psvDebugScreenPrintf("  Select storage device:\n\n");
 
@@ -68,8 +98,32 @@ void f3v_ui_menu(const StorageDevice *devices, int count, int selected)
             psvDebugScreenPrintf("    ");
         }
 
-        psvDebugScreenPrintf("%s (%s)\n", devices[i].path, devices[i].name);
-        psvDebugScreenPrintf("      Free: %s / %s\n\n", free_str, total_str);
+        psvDebugScreenPrintf("[%c] %s (%s)\n", marked[i] ? 'x' : ' ',
+                             devices[i].path, devices[i].name);
+        psvDebugScreenPrintf("          Free: %s / %s\n\n", free_str, total_str);
+    }
+
+    for (int i = 0; i < option_count; i++)
+    {
+        if (options[i].hidden)
+        {
+            continue;
+        }
+        if (options[i].fixed)
+        {
+            psvDebugScreenSetFgColor(0xFF888888); /* Gray: set by the mode */
+            psvDebugScreenPrintf("    %-10s   %s\n", options[i].label, options[i].value);
+        }
+        else if (count + i == selected)
+        {
+            psvDebugScreenSetFgColor(0xFF00FF00); /* Green for selected */
+            psvDebugScreenPrintf("  > %-10s < %s >\n", options[i].label, options[i].value);
+        }
+        else
+        {
+            psvDebugScreenSetFgColor(0xFFFFFFFF); /* White */
+            psvDebugScreenPrintf("    %-10s   %s\n", options[i].label, options[i].value);
+        }
     }
 
     psvDebugScreenSetFgColor(0xFFFFFFFF);
@@ -114,28 +168,790 @@ void f3v_ui_progress(const char *phase, uint64_t current_mb, uint64_t total_mb,
     psvDebugScreenPrintf("  Processed: %llu MB / %llu MB\n", current_mb, total_mb);
     psvDebugScreenPrintf("  Elapsed:   %s\n", time_str);
 
-    if (strcmp(phase, "VERIFY") == 0)
+    if (strcmp(phase, "WRITE") != 0)
+    {
+        if (errors > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        else
+        {
+            psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
+        }
+        psvDebugScreenPrintf("  Errors:    %llu bytes\n", errors);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+
+    /* Speed calculation */
+    if (elapsed_secs > 0)
+    {
+        uint64_t speed_mbps = current_mb / elapsed_secs;
+        psvDebugScreenPrintf("  Speed:     %llu MB/s\n", speed_mbps);
+    }
+
+    psvDebugScreenPrintf("\n");
+}
+
+void f3v_ui_sessions(const TestContext *sessions, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const TestContext *ctx = &sessions[i];
+        const char *phase;
+        uint64_t current, total;
+        uint64_t elapsed;
+
+        switch (ctx->phase)
+        {
+        case PHASE_WRITE:
+            phase = "WRITE ";
+            current = ctx->bytes_written;
+            total = ctx->total_expected;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_VERIFY:
+            phase = "VERIFY";
+            current = ctx->bytes_verified;
+            total = ctx->bytes_written;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_SAMPLE:
+            phase = "SAMPLE";
+            current = ctx->bytes_verified;
+            total = ctx->total_expected;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_BENCH:
+            phase = "BENCH ";
+            current = ctx->run.bench.count;
+            total = ctx->run.bench.total;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_STREAMS:
+            phase = "STREAM";
+            current = ctx->bytes_written + ctx->bytes_verified;
+            total = ctx->total_expected * 2;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_MIXED:
+            phase = "MIXED ";
+            current = ctx->run.mixed.stage;
+            total = MIXED_DONE;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_FSTREE:
+            phase = "FILES ";
+            current = ctx->run.fstree.state != NULL ? ctx->run.fstree.state->ops : 0;
+            total = ctx->run.fstree.state != NULL ? ctx->run.fstree.state->total_ops : 0;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_ROTSCAN:
+            phase = "SCAN  ";
+            current = ctx->bytes_verified;
+            total = ctx->total_expected;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_ALIGN:
+            phase = "ALIGN ";
+            current = ctx->run.align.count;
+            total = ctx->run.align.total;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_DISCOVER:
+            phase = "PROBE ";
+            current = ctx->run.discover.state != NULL ? ctx->run.discover.state->writes : 0;
+            total = ctx->run.discover.state != NULL ? ctx->run.discover.state->total_writes : 0;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        case PHASE_RETEST:
+            phase = "RETEST";
+            current = ctx->bytes_verified;
+            total = ctx->total_expected;
+            elapsed = f3v_get_time_usec() - ctx->phase_start_time;
+            break;
+        default:
+            phase = "DONE  ";
+            current = ctx->bytes_verified;
+            total = ctx->mode == MODE_RETEST || ctx->mode == MODE_SAMPLE ? ctx->total_expected
+                                                                         : ctx->bytes_written;
+            elapsed = ctx->end_time - ctx->phase_start_time;
+            break;
+        }
+
+        uint32_t percent = 0;
+        if (total > 0)
+        {
+            percent = (uint32_t)((current * 100) / total);
+            if (percent > 100)
+                percent = 100;
+        }
+
+        /* Row 1: device, phase and a short bar */
+        psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+        psvDebugScreenPrintf("  %-6s %s ", ctx->target.path, phase);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+        int bar_width = 24;
+        int filled = (bar_width * percent) / 100;
+
+        psvDebugScreenPrintf("[");
+        psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
+        for (int b = 0; b < filled; b++)
+            psvDebugScreenPrintf("=");
+        psvDebugScreenSetFgColor(0xFF888888); /* Gray */
+        for (int b = filled; b < bar_width; b++)
+            psvDebugScreenPrintf("-");
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+        psvDebugScreenPrintf("] %3u%%\n", percent);
+
+        /* Row 2: amount, speed and errors */
+        uint32_t secs = (uint32_t)(elapsed / 1000000);
+        uint64_t speed_mbps = secs > 0 ? (current / (1024 * 1024)) / secs : 0;
+
+        /* While writing, read-back finds errors before the verify pass */
+        ReadbackTotals raw;
+        f3v_readback_totals(ctx, &raw);
+        uint64_t errors = ctx->phase == PHASE_WRITE ? raw.corrupted : ctx->bytes_corrupted;
+
+        if (ctx->phase == PHASE_BENCH || ctx->phase == PHASE_ALIGN)
+        {
+            psvDebugScreenPrintf("         Setting %llu / %llu  ", current, total);
+        }
+        else if (ctx->phase == PHASE_DISCOVER)
+        {
+            psvDebugScreenPrintf("         Probe %llu / %llu  ", current, total);
+        }
+        else if (ctx->phase == PHASE_MIXED)
+        {
+            psvDebugScreenPrintf("         Stage %llu / %llu  ", current + 1, total);
+        }
+        else if (ctx->phase == PHASE_FSTREE)
+        {
+            psvDebugScreenPrintf("         Op %llu / %llu  ", current, total);
+        }
+        else
+        {
+            psvDebugScreenPrintf("         %llu / %llu MB  %llu MB/s  ",
+                                 current / (1024 * 1024), total / (1024 * 1024), speed_mbps);
+        }
+        if (errors > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        else
+        {
+            psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
+        }
+        psvDebugScreenPrintf("Errors: %llu\n", errors);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+        /* Row 3: the read-back stream running alongside the writer */
+        if (ctx->phase == PHASE_WRITE && ctx->readback != READBACK_OFF)
+        {
+            psvDebugScreenPrintf("         %s %llu / %llu MB\n",
+                                 ctx->readback == READBACK_FILE ? "Verified:" : "Read back:",
+                                 raw.verified / (1024 * 1024),
+                                 ctx->bytes_written / (1024 * 1024));
+        }
+        psvDebugScreenPrintf("\n");
+    }
+}
+
+/**
+ * Benchmark table: one row per transfer size and queue depth
+ */
+static void bench_table(const TestContext *ctx)
+{
+    psvDebugScreenPrintf("  Size  QD  Read IOPS   p50    p99  Write IOPS   p50    p99\n");
+    psvDebugScreenPrintf("                        (latency in us)\n");
+
+    /* Settings come in read/write pairs */
+    for (uint32_t i = 0; i + 1 < ctx->run.bench.total; i += 2)
+    {
+        const BenchResult *rd = &ctx->run.bench.result[i];
+        const BenchResult *wr = &ctx->run.bench.result[i + 1];
+        char size_str[8];
+
+        snprintf(size_str, sizeof(size_str), "%uK", rd->size / 1024);
+        if (i >= ctx->run.bench.count)
+        {
+            psvDebugScreenSetFgColor(0xFF888888); /* Gray: not run yet */
+            psvDebugScreenPrintf("  %-4s  %2u  %9s %5s %6s  %10s %5s %6s\n", size_str, rd->depth,
+                                 "-", "-", "-", "-", "-", "-");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            continue;
+        }
+
+        if (rd->bad > 0 || (i + 1 < ctx->run.bench.count && wr->bad > 0))
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        psvDebugScreenPrintf("  %-4s  %2u  %9u %5u %6u", size_str, rd->depth, rd->iops,
+                             rd->lat_p50_us, rd->lat_p99_us);
+        if (i + 1 < ctx->run.bench.count)
+        {
+            psvDebugScreenPrintf("  %10u %5u %6u\n", wr->iops, wr->lat_p50_us, wr->lat_p99_us);
+        }
+        else
+        {
+            psvDebugScreenPrintf("  %10s %5s %6s\n", "-", "-", "-");
+        }
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+}
+
+/**
+ * Format a rate in KB/s as MB/s with one decimal
+ */
+static char *format_kbs(uint32_t kbs, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "%u.%u", kbs / 1024, (kbs % 1024) * 10 / 1024);
+    return buf;
+}
+
+/**
+ * Stream sweep table: aggregate and per-stream range for each round
+ */
+static void stream_table(const TestContext *ctx)
+{
+    char total[16], low[16], high[16], range[32];
+
+    psvDebugScreenPrintf("  Streams  Write MB/s   per stream  Read MB/s   per stream\n");
+    for (uint32_t i = 0; i < ctx->run.stream.max; i++)
+    {
+        const StreamResult *result = &ctx->run.stream.result[i];
+
+        if (i >= ctx->run.stream.count)
+        {
+            psvDebugScreenSetFgColor(0xFF888888); /* Gray: not run yet */
+            psvDebugScreenPrintf("  %7u  %10s  %11s  %9s  %11s\n", i + 1, "-", "-", "-", "-");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            continue;
+        }
+
+        if (result->corrupted > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        snprintf(range, sizeof(range), "%s-%s",
+                 format_kbs(result->write_min_kbs, low, sizeof(low)),
+                 format_kbs(result->write_max_kbs, high, sizeof(high)));
+        psvDebugScreenPrintf("  %7u  %10s  %11s", i + 1,
+                             format_kbs(result->write_kbs, total, sizeof(total)), range);
+        snprintf(range, sizeof(range), "%s-%s",
+                 format_kbs(result->read_min_kbs, low, sizeof(low)),
+                 format_kbs(result->read_max_kbs, high, sizeof(high)));
+        psvDebugScreenPrintf("  %9s  %11s\n", format_kbs(result->read_kbs, total, sizeof(total)),
+                             range);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+}
+
+void f3v_ui_streams(const TestContext *ctx)
+{
+    uint64_t done = ctx->bytes_written + ctx->bytes_verified;
+    uint32_t percent = ctx->total_expected > 0 ? (uint32_t)(done * 50 / ctx->total_expected) : 0;
+
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    if (ctx->run.stream.count < ctx->run.stream.max)
+    {
+        psvDebugScreenPrintf("  Phase: STREAMS x%u (%s)\n\n", ctx->run.stream.count + 1,
+                             ctx->run.stream.reading ? "verifying" : "writing");
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Phase: STREAMS\n\n");
+    }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+    psvDebugScreenPrintf("  Progress: %3u%%  Written: %llu MB  Errors: %llu\n\n", percent,
+                         ctx->bytes_written / (1024 * 1024), ctx->bytes_corrupted);
+    stream_table(ctx);
+}
+
+void f3v_ui_bench(const TestContext *ctx)
+{
+    char name[32];
+    const BenchRun *run = &ctx->run.bench;
+    uint32_t percent = run->total > 0 ? run->count * 100 / run->total : 0;
+
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    if (run->count < run->total)
+    {
+        psvDebugScreenPrintf("  Phase: BENCH %s (%u of %u)\n\n",
+                             f3v_bench_name(&run->result[run->count], name, sizeof(name)),
+                             run->count + 1, run->total);
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Phase: BENCH\n\n");
+    }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+    psvDebugScreenPrintf("  Progress: %3u%%  Region: %llu MB  Errors: %llu\n\n", percent,
+                         run->region / (1024 * 1024), ctx->bytes_corrupted);
+    bench_table(ctx);
+}
+
+/**
+ * Mixed workload table: reads alone, reads under the write stream, and the
+ * stream's writes
+ */
+static void mixed_table(const TestContext *ctx)
+{
+    const MixedResult *mixed = &ctx->run.mixed.result;
+    const MixedLatency *lat[] = {&mixed->read_alone, &mixed->read_mixed, &mixed->write};
+    static const char *names[] = {"Read alone", "Read + write", "Write 1 MB"};
+
+    psvDebugScreenPrintf("                  IOPS    p50     p99   p99.9      max\n");
+    psvDebugScreenPrintf("                        (latency in us)\n");
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        /* The first row is done after the first stage, the others after the second */
+        if (ctx->run.mixed.stage <= (i == 0 ? MIXED_READ_ALONE : MIXED_READ_WRITE))
+        {
+            psvDebugScreenSetFgColor(0xFF888888); /* Gray: not run yet */
+            psvDebugScreenPrintf("  %-12s  %6s %6s  %6s  %6s  %7s\n", names[i], "-", "-", "-",
+                                 "-", "-");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            continue;
+        }
+        psvDebugScreenPrintf("  %-12s  %6u %6u  %6u  %6u  %7u\n", names[i], lat[i]->iops,
+                             lat[i]->lat_p50_us, lat[i]->lat_p99_us, lat[i]->lat_p999_us,
+                             lat[i]->lat_max_us);
+    }
+}
+
+void f3v_ui_mixed(const TestContext *ctx)
+{
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    if (ctx->run.mixed.stage < MIXED_DONE)
+    {
+        psvDebugScreenPrintf("  Phase: MIXED %s (%u of %u)\n\n",
+                             f3v_mixed_stage_name(ctx->run.mixed.stage), ctx->run.mixed.stage + 1,
+                             MIXED_DONE);
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Phase: MIXED\n\n");
+    }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+    psvDebugScreenPrintf("  Mix: %u%% read  Region: %llu MB  Errors: %llu\n\n",
+                         ctx->run.mixed.read_pct, ctx->run.mixed.region / (1024 * 1024),
+                         ctx->bytes_corrupted);
+    mixed_table(ctx);
+}
+
+/**
+ * Small-file table: count, rate and latency of each operation type
+ * (percentiles fill in as each stage ends)
+ */
+static void fstree_table(const FsTreeResult *tree)
+{
+    psvDebugScreenPrintf("  Op         Count  Failed   Ops/s    p50     p99      max\n");
+    psvDebugScreenPrintf("                                     (latency in us)\n");
+    for (uint32_t i = 0; i < FS_OP_COUNT; i++)
+    {
+        const FsOpStats *op = &tree->op[i];
+
+        if (op->count == 0)
+        {
+            psvDebugScreenSetFgColor(0xFF888888); /* Gray: not run yet */
+            psvDebugScreenPrintf("  %-8s  %6s  %6s  %6s  %5s  %6s  %7s\n",
+                                 f3v_fstree_op_name((FsOp)i), "-", "-", "-", "-", "-", "-");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            continue;
+        }
+
+        psvDebugScreenPrintf("  %-8s  %6u  ", f3v_fstree_op_name((FsOp)i), op->count);
+        if (op->failed > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        psvDebugScreenPrintf("%6u", op->failed);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+        psvDebugScreenPrintf("  %6u", f3v_fstree_ops_per_sec(op));
+        if (op->lat_max_us == 0)
+        {
+            psvDebugScreenPrintf("  %5s  %6s  %7s\n", "-", "-", "-");
+            continue;
+        }
+        psvDebugScreenPrintf("  %5u  %6u  %7u\n", op->lat_p50_us, op->lat_p99_us,
+                             op->lat_max_us);
+    }
+}
+
+void f3v_ui_fstree(const TestContext *ctx)
+{
+    const struct FsTreeState *tree = ctx->run.fstree.state;
+
+    if (tree == NULL)
+    {
+        return;
+    }
+
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    if (tree->stage < FSTREE_DONE)
+    {
+        psvDebugScreenPrintf("  Phase: FILES %s (%u of %u)\n\n",
+                             f3v_fstree_stage_name(tree->stage), tree->stage + 1, FSTREE_DONE);
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Phase: FILES\n\n");
+    }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+    psvDebugScreenPrintf("  Tree: %u dirs, %u files, %llu MB  Errors: %llu\n\n",
+                         tree->result.dirs, tree->result.files,
+                         tree->result.bytes / (1024 * 1024), ctx->bytes_corrupted);
+    fstree_table(&tree->result);
+}
+
+/**
+ * Alignment grid table: throughput of each layout and its change from the
+ * baseline in the first row
+ */
+static void align_table(const TestContext *ctx)
+{
+    const AlignResult *base = &ctx->run.align.result[0];
+    char size_str[16], write_str[16], read_str[16];
+
+    psvDebugScreenPrintf("  Size     Buffer Offset  Write MB/s        Read MB/s\n");
+    for (uint32_t i = 0; i < ctx->run.align.total; i++)
+    {
+        const AlignResult *result = &ctx->run.align.result[i];
+
+        f3v_align_size_name(result->size, size_str, sizeof(size_str));
+        if (i >= ctx->run.align.count)
+        {
+            psvDebugScreenSetFgColor(0xFF888888); /* Gray: not run yet */
+            psvDebugScreenPrintf("  %-8s %6u %6u  %10s        %9s\n", size_str,
+                                 result->buf_offset, result->file_offset, "-", "-");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            continue;
+        }
+
+        if (result->bad > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        else if (f3v_align_change(result->write_kbs, base->write_kbs) <= -ALIGN_PENALTY ||
+                 f3v_align_change(result->read_kbs, base->read_kbs) <= -ALIGN_PENALTY)
+        {
+            psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+        }
+        psvDebugScreenPrintf("  %-8s %6u %6u  %10s", size_str, result->buf_offset,
+                             result->file_offset,
+                             format_kbs(result->write_kbs, write_str, sizeof(write_str)));
+        if (i == 0)
+        {
+            psvDebugScreenPrintf(" %6s  %9s %6s\n", "base",
+                                 format_kbs(result->read_kbs, read_str, sizeof(read_str)),
+                                 "base");
+        }
+        else
+        {
+            psvDebugScreenPrintf(" %+5d%%  %9s %+5d%%\n",
+                                 f3v_align_change(result->write_kbs, base->write_kbs),
+                                 format_kbs(result->read_kbs, read_str, sizeof(read_str)),
+                                 f3v_align_change(result->read_kbs, base->read_kbs));
+        }
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+}
+
+void f3v_ui_align(const TestContext *ctx)
+{
+    char size_str[16];
+    const AlignRun *run = &ctx->run.align;
+    uint32_t percent = run->total > 0 ? run->count * 100 / run->total : 0;
+
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    if (run->count < run->total)
+    {
+        const AlignResult *result = &run->result[run->count];
+
+        psvDebugScreenPrintf("  Phase: ALIGN %s, buffer +%u, offset +%u (%u of %u)\n\n",
+                             f3v_align_size_name(result->size, size_str, sizeof(size_str)),
+                             result->buf_offset, result->file_offset, run->count + 1, run->total);
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Phase: ALIGN\n\n");
+    }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+    psvDebugScreenPrintf("  Progress: %3u%%  Errors: %llu\n\n", percent, ctx->bytes_corrupted);
+    align_table(ctx);
+}
+
+/**
+ * Runs of conformance windows below the class speed
+ */
+static void conform_drops(const ConformResult *conform)
+{
+    char kbs_str[16];
+
+    for (uint32_t i = 0; i < conform->drop_count && i < CONFORM_ROWS; i++)
+    {
+        const ConformDrop *drop = &conform->drop[i];
+
+        psvDebugScreenPrintf("  %s %llu MB (%llu MB long, down to %s MB/s)\n",
+                             i == 0 ? "Slow At:      " : "              ",
+                             drop->offset / (1024 * 1024), drop->length / (1024 * 1024),
+                             format_kbs(drop->min_kbs, kbs_str, sizeof(kbs_str)));
+    }
+    if (conform->drop_count + conform->drops_lost > CONFORM_ROWS)
+    {
+        psvDebugScreenPrintf("                 ... %u more\n",
+                             conform->drop_count + conform->drops_lost - CONFORM_ROWS);
+    }
+}
+
+void f3v_ui_conform(const TestContext *ctx)
+{
+    const ConformResult *conform = &ctx->run.conform.result;
+    uint32_t slowest = UINT32_MAX;
+    char kbs_str[16];
+
+    /* Not sorted until the write phase ends */
+    for (uint32_t i = 0; i < conform->windows; i++)
+    {
+        slowest = conform->window_kbs[i] < slowest ? conform->window_kbs[i] : slowest;
+    }
+
+    psvDebugScreenPrintf("  Class:         %u MB/s, %u of %u windows below", conform->class_mbps,
+                         conform->below, conform->windows);
+    if (conform->windows > 0)
+    {
+        psvDebugScreenPrintf(", slowest %s MB/s", format_kbs(slowest, kbs_str, sizeof(kbs_str)));
+    }
+    psvDebugScreenPrintf("\n\n");
+    conform_drops(conform);
+}
+
+/**
+ * Wipe kernel and transfer size, with what they were picked from
+ */
+static void wipe_summary(const TestContext *ctx)
+{
+    const WipeTuner *tune = &ctx->run.wipe.tune;
+    char kbs_str[16];
+
+    psvDebugScreenPrintf("  Fill:          %s, %s kernel", f3v_wipe_fill_name(ctx->run.wipe.fill),
+                         f3v_wipe_kernel_name(ctx->run.wipe.kernel));
+    if (ctx->run.wipe.kernel != WIPE_KERNEL_ONCE)
+    {
+        psvDebugScreenPrintf(" (inline %s", format_kbs(ctx->run.wipe.kernel_kbs[WIPE_KERNEL_INLINE],
+                                                       kbs_str, sizeof(kbs_str)));
+        psvDebugScreenPrintf(", pool %s MB/s)",
+                             format_kbs(ctx->run.wipe.kernel_kbs[WIPE_KERNEL_POOL], kbs_str,
+                                        sizeof(kbs_str)));
+    }
+    psvDebugScreenPrintf("\n");
+
+    if (tune->size < F3V_WIPE_SIZES)
+    {
+        psvDebugScreenPrintf("  Transfer:      tuning, trying %u MB per write\n",
+                             f3v_wipe_tune_blocks(tune) * (F3V_BLOCK_SIZE / (1024 * 1024)));
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Transfer:      %u MB per write\n",
+                             f3v_wipe_tune_blocks(tune) * (F3V_BLOCK_SIZE / (1024 * 1024)));
+    }
+
+    /* Speeds of the sizes tried so far */
+    psvDebugScreenPrintf("  Tuning MB/s:  ");
+    for (uint32_t i = 0; i < F3V_WIPE_SIZES; i++)
+    {
+        uint32_t kbs = f3v_wipe_tune_kbs(tune, i);
+
+        if (tune->size >= F3V_WIPE_SIZES && i == tune->best)
+        {
+            psvDebugScreenSetFgColor(0xFF00FF00); /* Green: chosen */
+        }
+        psvDebugScreenPrintf(" %u MB %s", 1U << i,
+                             kbs > 0 ? format_kbs(kbs, kbs_str, sizeof(kbs_str)) : "-");
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+    psvDebugScreenPrintf("\n");
+}
+
+void f3v_ui_wipe(const TestContext *ctx)
+{
+    wipe_summary(ctx);
+    psvDebugScreenPrintf("\n");
+}
+
+/**
+ * Files or regions a scan found bad
+ */
+static void scan_bad_list(const RotScanResult *scan, int surface)
+{
+    if (scan->bad_count == 0)
+    {
+        return;
+    }
+
+    psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+    for (uint32_t i = 0; i < scan->bad_count; i++)
+    {
+        const RotBadRegion *bad = &scan->bad[i];
+
+        psvDebugScreenPrintf("    %-10s %s", f3v_rotscan_bad_name(bad->kind), bad->path);
+        if (surface)
+        {
+            psvDebugScreenPrintf(" @ %llu KB +%llu KB", bad->offset / 1024,
+                                 (bad->length + 1023) / 1024);
+        }
+        if (bad->kind == ROT_BAD_SLOW)
+        {
+            psvDebugScreenPrintf(", %u KB/s", bad->min_kbs);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    if (scan->bad_lost > 0)
+    {
+        psvDebugScreenPrintf("    ... %u more (see %s)\n", scan->bad_lost, F3V_LOG_NAME);
+    }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+}
+
+/**
+ * Files found by a scan
+ */
+static void scan_files(const RotScanResult *scan)
+{
+    psvDebugScreenPrintf("  Files:         %u, %llu MB", scan->files, scan->bytes / (1024 * 1024));
+    if (scan->skipped > 0)
+    {
+        psvDebugScreenPrintf(" (%u skipped)", scan->skipped);
+    }
+    psvDebugScreenPrintf("\n");
+}
+
+/**
+ * Bit-rot scan counts and the corrupted or unreadable files
+ */
+static void rotscan_summary(const RotScanResult *scan)
+{
+    static const char *manifest_names[] = {"damaged, ignored", "none", "loaded"};
+
+    scan_files(scan);
+    psvDebugScreenPrintf("  Last Scan:     %s\n", manifest_names[scan->manifest + 1]);
+    psvDebugScreenPrintf("  Unchanged:     %u matched, %u mismatched, %u unreadable\n",
+                         scan->matched, scan->mismatched, scan->unreadable);
+    psvDebugScreenPrintf("  Since Then:    %u new, %u changed, %u missing\n", scan->added,
+                         scan->changed, scan->missing);
+    scan_bad_list(scan, 0);
+}
+
+/**
+ * Surface scan reads, latency and the unreadable or slow regions
+ */
+static void surface_summary(const RotScanResult *scan)
+{
+    char kbs_str[16];
+
+    scan_files(scan);
+    psvDebugScreenPrintf("  Read:          %s MB/s, latency p50 %u us, p99 %u us, max %u us\n",
+                         format_kbs(scan->read_kbs, kbs_str, sizeof(kbs_str)), scan->lat_p50_us,
+                         scan->lat_p99_us, scan->lat_max_us);
+    psvDebugScreenPrintf("  Unreadable:    %u regions, %llu KB in %u files\n", scan->error_regions,
+                         (scan->error_bytes + 1023) / 1024, scan->unreadable);
+    psvDebugScreenPrintf("  Slow:          %u regions, %llu MB below %u MB/s\n",
+                         scan->slow_regions, scan->slow_bytes / (1024 * 1024),
+                         F3V_SURFACE_SLOW_KBS / 1024);
+    scan_bad_list(scan, 1);
+}
+
+void f3v_ui_rotscan(const TestContext *ctx)
+{
+    const struct RotScanState *scan = ctx->run.scan.state;
+
+    if (scan == NULL)
+    {
+        return;
+    }
+
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    psvDebugScreenPrintf("  Phase: SCAN %s (%u of %u)  %s\n\n",
+                         scan->surface && scan->stage == ROTSCAN_HASH
+                             ? "read"
+                             : f3v_rotscan_stage_name(scan->stage),
+                         scan->stage + 1, ROTSCAN_DONE, scan->root);
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+    if (scan->stage == ROTSCAN_HASH)
+    {
+        psvDebugScreenPrintf("  File %u / %u  %llu / %llu MB\n\n", scan->file + 1, scan->count,
+                             scan->hashed / (1024 * 1024), scan->result.bytes / (1024 * 1024));
+    }
+    if (scan->surface)
+    {
+        surface_summary(&scan->result);
+    }
+    else
+    {
+        rotscan_summary(&scan->result);
+    }
+}
+
+/**
+ * Discovery findings and what they suggest for the other modes
+ */
+static void discover_summary(const DiscoverResult *result)
+{
+    if (result->erase_size == 0)
     {
-        if (errors > 0)
-        {
-            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
-        }
-        else
-        {
-            psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
-        }
-        psvDebugScreenPrintf("  Errors:    %llu bytes\n", errors);
-        psvDebugScreenSetFgColor(0xFFFFFFFF);
+        psvDebugScreenPrintf("  Erase Block:   not detected\n");
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Erase Block:   %u KB at +%u KB (boundary writes %u%%)\n",
+                             result->erase_size / 1024, result->erase_phase / 1024,
+                             result->erase_score);
+    }
+    if (result->open_max > 0)
+    {
+        psvDebugScreenPrintf("  Open Segments: %s%u\n", result->open_limited ? "" : ">= ",
+                             result->open_max);
+    }
+    if (result->transfer > 0)
+    {
+        psvDebugScreenPrintf("  Suggested:     %u KB transfers at +%u KB, %u streams\n",
+                             result->transfer / 1024, result->alignment / 1024,
+                             result->streams);
     }
+}
 
-    /* Speed calculation */
-    if (elapsed_secs > 0)
+void f3v_ui_discover(const TestContext *ctx)
+{
+    const struct DiscoverState *state = ctx->run.discover.state;
+    uint32_t percent = state != NULL && state->total_writes > 0
+                           ? state->writes * 100 / state->total_writes
+                           : 0;
+
+    psvDebugScreenSetFgColor(0xFF00FFFF); /* Cyan */
+    if (state != NULL && state->stage == DISCOVER_OPEN)
     {
-        uint64_t speed_mbps = current_mb / elapsed_secs;
-        psvDebugScreenPrintf("  Speed:     %llu MB/s\n", speed_mbps);
+        psvDebugScreenPrintf("  Phase: DISCOVER open segments x%u\n\n", state->open_n);
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Phase: DISCOVER boundary scan\n\n");
     }
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
 
-    psvDebugScreenPrintf("\n");
+    psvDebugScreenPrintf("  Progress: %3u%%  Probes: %u\n\n", percent,
+                         state != NULL ? state->writes : 0);
+    if (state != NULL && state->stage != DISCOVER_SCAN)
+    {
+        discover_summary(&state->result);
+    }
 }
 
 void f3v_ui_results(const TestContext *ctx, TestResult result)
@@ -156,7 +972,7 @@ void f3v_ui_results(const TestContext *ctx, TestResult result)
         break;
     case RESULT_FAIL:
         psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
-        psvDebugScreenPrintf("  Status: FAIL\n\n");
+        psvDebugScreenPrintf("  Status: FAIL%s\n\n", ctx->aborted ? " (partial result)" : "");
         break;
     case RESULT_CANCELLED:
         psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
@@ -169,9 +985,445 @@ void f3v_ui_results(const TestContext *ctx, TestResult result)
     psvDebugScreenSetFgColor(0xFFFFFFFF);
 
     /* Statistics */
-    psvDebugScreenPrintf("  Data Written:  %s (%u files)\n", bytes_str, ctx->files_written);
+    if (ctx->mode == MODE_RETEST)
+    {
+        psvDebugScreenPrintf("  Mode:          Re-test (%u passes, margin %u blocks)\n",
+                             ctx->run.retest.passes, ctx->run.retest.margin);
+    }
+    else if (ctx->mode == MODE_BURNIN)
+    {
+        char variant_str[32];
+        uint32_t shown = 0;
+
+        if (ctx->run.burn.passes > 0)
+        {
+            psvDebugScreenPrintf("  Mode:          Burn-in (%u of %u passes)\n",
+                                 ctx->run.burn.count, ctx->run.burn.passes);
+        }
+        else
+        {
+            psvDebugScreenPrintf("  Mode:          Burn-in (%u passes in %u h)\n",
+                                 ctx->run.burn.count, ctx->run.burn.duration_sec / 3600);
+        }
+        psvDebugScreenPrintf("  Data Written:  %s in the last pass (%u files)\n", bytes_str,
+                             ctx->files_written);
+
+        /* Per-pass table: the first pass, then the most recent ones */
+        psvDebugScreenPrintf("\n  Pass  Pattern           Write MB/s  Read MB/s  Bad bytes\n");
+        for (uint32_t i = 0; i < ctx->run.burn.count; i++)
+        {
+            const BurnPass *pass = &ctx->run.burn.history[i];
+
+            if (i > 0 && ctx->run.burn.count - i > BURN_ROWS - 1)
+            {
+                continue;
+            }
+            if (i > 0 && pass->pass > ctx->run.burn.history[i - 1].pass + 1 && shown == 1)
+            {
+                psvDebugScreenPrintf("  ...\n");
+            }
+
+            f3v_format_variant(pass->variant, variant_str, sizeof(variant_str));
+            if (pass->bytes_corrupted > 0)
+            {
+                psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            }
+            psvDebugScreenPrintf("  %4u  %-16s  %10llu  %9llu  %llu\n", pass->pass, variant_str,
+                                 pass->write_ms > 0 ? pass->bytes_written / 1024 * 1000 / 1024 /
+                                                          pass->write_ms
+                                                    : 0,
+                                 pass->verify_ms > 0 ? pass->bytes_written / 1024 * 1000 / 1024 /
+                                                           pass->verify_ms
+                                                     : 0,
+                                 pass->bytes_corrupted);
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            shown++;
+        }
+
+        /* A card that slows down pass after pass is wearing out */
+        if (ctx->run.burn.count >= 2)
+        {
+            const BurnPass *first = &ctx->run.burn.history[0];
+            const BurnPass *last = &ctx->run.burn.history[ctx->run.burn.count - 1];
+            uint64_t first_kbs = first->write_ms > 0 ? first->bytes_written / first->write_ms : 0;
+            uint64_t last_kbs = last->write_ms > 0 ? last->bytes_written / last->write_ms : 0;
+
+            if (first_kbs > 0)
+            {
+                int64_t change =
+                    ((int64_t)last_kbs - (int64_t)first_kbs) * 100 / (int64_t)first_kbs;
+                if (change <= -BURN_SLOWDOWN)
+                {
+                    psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+                }
+                psvDebugScreenPrintf("  Write Speed:   %+lld%% from pass 1 to pass %u\n",
+                                     (long long)change, last->pass);
+                psvDebugScreenSetFgColor(0xFFFFFFFF);
+            }
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_STREAMS)
+    {
+        psvDebugScreenPrintf("  Mode:          Streams (1 to %u files at once, %llu MB each)\n\n",
+                             ctx->run.stream.max, F3V_STREAM_BYTES / (1024 * 1024));
+        stream_table(ctx);
+
+        /* How much of the single-stream rate survives the most streams */
+        if (ctx->run.stream.count >= 2 && ctx->run.stream.result[0].write_kbs > 0)
+        {
+            const StreamResult *last = &ctx->run.stream.result[ctx->run.stream.count - 1];
+            uint32_t scaled = (uint32_t)((uint64_t)last->write_kbs * 100 /
+                                         ctx->run.stream.result[0].write_kbs);
+
+            psvDebugScreenPrintf("\n  Concurrency:   %u streams write at %u%% of one stream\n",
+                                 ctx->run.stream.count, scaled);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_ALIGN)
+    {
+        uint32_t bad = 0;
+
+        psvDebugScreenPrintf("  Mode:          Alignment (%llu MB per case, offsets in bytes)\n\n",
+                             F3V_ALIGN_BYTES / (1024 * 1024));
+        align_table(ctx);
+
+        for (uint32_t i = 0; i < ctx->run.align.count; i++)
+        {
+            bad += ctx->run.align.result[i].bad;
+        }
+        if (bad > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("\n  Bad Transfers: %u failed or mismatched\n", bad);
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_DISCOVER)
+    {
+        psvDebugScreenPrintf("  Mode:          Discover (%llu MB region)\n\n",
+                             ctx->bytes_written / (1024 * 1024));
+        if (ctx->aborted)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Probe writes failed; no result\n");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        else if (!ctx->cancelled)
+        {
+            discover_summary(&ctx->run.discover.result);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_MIXED)
+    {
+        const MixedResult *mixed = &ctx->run.mixed.result;
+        char write_str[16];
+
+        psvDebugScreenPrintf("  Mode:          Mixed (%u%% read, %u KB reads, %u s per stage)\n\n",
+                             ctx->run.mixed.read_pct, F3V_MIXED_READ_SIZE / 1024,
+                             F3V_MIXED_SECONDS);
+        mixed_table(ctx);
+        psvDebugScreenPrintf("\n");
+
+        /* Reads that stall behind writes show in the tail first */
+        if (ctx->run.mixed.stage > MIXED_READ_WRITE && mixed->read_alone.lat_p99_us > 0)
+        {
+            uint32_t ratio = (uint32_t)((uint64_t)mixed->read_mixed.lat_p99_us * 10 /
+                                        mixed->read_alone.lat_p99_us);
+
+            if (ratio >= MIXED_SPIKE * 10)
+            {
+                psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+            }
+            psvDebugScreenPrintf("  Interference:  read p99 %u.%ux under writes\n", ratio / 10,
+                                 ratio % 10);
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+            psvDebugScreenPrintf("  Write Stream:  %s MB/s, %llu MB\n",
+                                 format_kbs(mixed->write_kbs, write_str, sizeof(write_str)),
+                                 mixed->write_bytes / (1024 * 1024));
+        }
+        if (mixed->bad > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Bad Transfers: %u failed or mismatched\n", mixed->bad);
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_FSTREE)
+    {
+        const FsTreeResult *tree = &ctx->run.fstree.result;
+        const FsOpStats *op = tree->op;
+        uint64_t dir_usec = op[FS_OP_MKDIR].usec + op[FS_OP_RMDIR].usec;
+        uint64_t dir_ops = op[FS_OP_MKDIR].count + op[FS_OP_RMDIR].count;
+
+        psvDebugScreenPrintf("  Mode:          Small files (%u dirs, %u files, %llu MB)\n\n",
+                             tree->dirs, tree->files, tree->bytes / (1024 * 1024));
+        if (ctx->aborted)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Could not create the tree; no result\n");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        else
+        {
+            fstree_table(tree);
+            psvDebugScreenPrintf("\n");
+
+            psvDebugScreenPrintf("  Files:         %u/s created, %u/s read back\n",
+                                 f3v_fstree_ops_per_sec(&op[FS_OP_CREATE]),
+                                 f3v_fstree_ops_per_sec(&op[FS_OP_READ]));
+            psvDebugScreenPrintf("  Directory Ops: %llu/s (mkdir + rmdir)\n",
+                                 dir_usec > 0 ? dir_ops * 1000000 / dir_usec : 0);
+        }
+        if (tree->bad_files > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Bad Files:     %u short or mismatched\n", tree->bad_files);
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_BENCH)
+    {
+        const BenchResult *worst = NULL;
+        uint32_t bad = 0;
+        char name[32];
+
+        psvDebugScreenPrintf("  Mode:          Benchmark (%llu MB region, %u s per setting)\n\n",
+                             ctx->run.bench.region / (1024 * 1024), F3V_BENCH_SECONDS);
+        bench_table(ctx);
+
+        for (uint32_t i = 0; i < ctx->run.bench.count; i++)
+        {
+            bad += ctx->run.bench.result[i].bad;
+            if (worst == NULL || ctx->run.bench.result[i].lat_p999_us > worst->lat_p999_us)
+            {
+                worst = &ctx->run.bench.result[i];
+            }
+        }
+
+        /* Stalls show in the tail long before they move the median */
+        if (worst != NULL)
+        {
+            psvDebugScreenPrintf("\n  Worst Tail:    p99.9 %u us, max %u us (%s)\n",
+                                 worst->lat_p999_us, worst->lat_max_us,
+                                 f3v_bench_name(worst, name, sizeof(name)));
+        }
+        if (bad > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Bad Transfers: %u failed or mismatched\n", bad);
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        psvDebugScreenPrintf("\n");
+    }
+    else if (ctx->mode == MODE_SAMPLE)
+    {
+        uint64_t coverage = ctx->run.sample.total_blocks > 0
+                                ? ctx->run.sample.count * 10000 / ctx->run.sample.total_blocks
+                                : 0;
+
+        if (ctx->run.sample.budget_sec > 0)
+        {
+            psvDebugScreenPrintf("  Mode:          Sample (%u min budget)\n",
+                                 ctx->run.sample.budget_sec / 60);
+        }
+        else
+        {
+            psvDebugScreenPrintf("  Mode:          Sample (until <%u.%02u%% bad at 95%%)\n",
+                                 ctx->run.sample.target_ppm / 10000,
+                                 (ctx->run.sample.target_ppm / 100) % 100);
+        }
+        psvDebugScreenPrintf("  Coverage:      %llu of %llu blocks (%llu.%02llu%%)\n",
+                             ctx->run.sample.count, ctx->run.sample.total_blocks, coverage / 100,
+                             coverage % 100);
+        psvDebugScreenPrintf("  Bad Samples:   %llu (%llu extra in flagged zones)\n",
+                             ctx->run.sample.bad, ctx->run.sample.extra);
+        psvDebugScreenPrintf("  Bad Fraction:  <= %u.%04u%% at 95%% confidence\n",
+                             ctx->run.sample.upper_ppm / 10000, ctx->run.sample.upper_ppm % 10000);
+    }
+    else if (ctx->mode == MODE_CONFORM)
+    {
+        const ConformResult *conform = &ctx->run.conform.result;
+        ConformVerdict verdict = f3v_conform_verdict(conform);
+        char min_str[16], p1_str[16], p5_str[16], avg_str[16];
+
+        psvDebugScreenPrintf("  Mode:          Conformance (%u MB/s class, %u MB windows)\n",
+                             conform->class_mbps, F3V_CONFORM_WINDOW / (1024 * 1024));
+        if (verdict == CONFORM_PASS)
+        {
+            psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
+        }
+        else if (verdict == CONFORM_MARGINAL)
+        {
+            psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+        }
+        else
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        psvDebugScreenPrintf("  Speed Class:   %s (%u of %u windows below)\n",
+                             f3v_conform_verdict_name(verdict), conform->below, conform->windows);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+        psvDebugScreenPrintf("  Window MB/s:   min %s, 1%% %s, 5%% %s, avg %s\n",
+                             format_kbs(conform->min_kbs, min_str, sizeof(min_str)),
+                             format_kbs(conform->p1_kbs, p1_str, sizeof(p1_str)),
+                             format_kbs(conform->p5_kbs, p5_str, sizeof(p5_str)),
+                             format_kbs(conform->avg_kbs, avg_str, sizeof(avg_str)));
+        conform_drops(conform);
+        psvDebugScreenPrintf("  Data Written:  %s (%u files)\n", bytes_str, ctx->files_written);
+    }
+    else if (ctx->mode == MODE_WIPE)
+    {
+        psvDebugScreenPrintf("  Mode:          Wipe (%s)\n",
+                             ctx->run.wipe.verify ? "verified" : "not verified");
+        wipe_summary(ctx);
+        psvDebugScreenPrintf("  Data Wiped:    %s + %llu KB tail (%u files)\n", bytes_str,
+                             ctx->run.wipe.tail / 1024,
+                             ctx->files_written + (ctx->run.wipe.tail > 0));
+        psvDebugScreenPrintf("  Files Deleted: %d\n", ctx->run.wipe.deleted);
+    }
+    else if (ctx->mode == MODE_ROTSCAN)
+    {
+        const RotScanResult *scan = &ctx->run.scan.result;
+        char kbs_str[16];
+
+        psvDebugScreenPrintf("  Mode:          Bit-rot scan of %s\n", scan->root);
+        if (ctx->aborted)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Scan stopped: directory unreadable or out of memory\n");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        rotscan_summary(scan);
+        psvDebugScreenPrintf("  Hashing:       %s MB/s\n",
+                             format_kbs(scan->read_kbs, kbs_str, sizeof(kbs_str)));
+        psvDebugScreenPrintf("  Digests:       %s\n",
+                             scan->saved ? "saved for the next scan" : "not saved");
+    }
+    else if (ctx->mode == MODE_SURFACE)
+    {
+        psvDebugScreenPrintf("  Mode:          Surface scan of %s (read only)\n",
+                             ctx->run.scan.result.root);
+        if (ctx->aborted)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            psvDebugScreenPrintf("  Scan stopped: directory unreadable or out of memory\n");
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        surface_summary(&ctx->run.scan.result);
+    }
+    else if (ctx->mode == MODE_VERIFY_ONLY)
+    {
+        psvDebugScreenPrintf("  Mode:          Verify only (logged to %s)\n", F3V_LOG_NAME);
+        psvDebugScreenPrintf("  Data Found:    %s (%u files)\n", bytes_str, ctx->files_written);
+    }
+    else
+    {
+        psvDebugScreenPrintf("  Data Written:  %s (%u files)\n", bytes_str, ctx->files_written);
+    }
     psvDebugScreenPrintf("  Data Verified: %llu MB\n", ctx->bytes_verified / (1024 * 1024));
-    psvDebugScreenPrintf("  Total Time:    %s\n\n", time_str);
+    if (ctx->mode == MODE_FULL || ctx->mode == MODE_VERIFY_ONLY)
+    {
+        /* Verify speed by order shows how much caching and readahead helped */
+        uint32_t verify_secs = (uint32_t)((ctx->end_time - ctx->phase_start_time) / 1000000);
+
+        psvDebugScreenPrintf("  Verify Order:  %s", f3v_order_name(ctx->verify_order));
+        if (ctx->verify_order == ORDER_FILE_SHUFFLE || ctx->verify_order == ORDER_BLOCK_SHUFFLE)
+        {
+            psvDebugScreenPrintf(" (seed %08X)", ctx->verify_seed);
+        }
+        psvDebugScreenPrintf(", %llu MB/s\n",
+                             verify_secs > 0 ? ctx->bytes_verified / (1024 * 1024) / verify_secs
+                                             : 0);
+    }
+    psvDebugScreenPrintf("  Total Time:    %s%s\n", time_str,
+                         ctx->resumed ? " (resumed from checkpoint)" : "");
+    psvDebugScreenPrintf("  Profile:       %s (UI frame avg %u.%u ms, max %u.%u ms)\n",
+                         f3v_profile_name((SchedProfile)ctx->profile),
+                         ctx->ui_frame_avg_us / 1000, (ctx->ui_frame_avg_us / 100) % 10,
+                         ctx->ui_frame_max_us / 1000, (ctx->ui_frame_max_us / 100) % 10);
+
+    if (ctx->readback == READBACK_FILE)
+    {
+        psvDebugScreenPrintf("  Schedule:      Per file, %llu MB verified while writing\n",
+                             ctx->raw.verified / (1024 * 1024));
+        psvDebugScreenPrintf("  Closing Pass:  %llu MB re-read (first %d files in full)\n",
+                             (ctx->bytes_verified - ctx->verify_skipped) / (1024 * 1024),
+                             F3V_CLOSING_FILES);
+    }
+    else if (ctx->readback == READBACK_BLOCK)
+    {
+        psvDebugScreenPrintf("  Readback:      %llu MB checked after write, %llu bytes bad\n",
+                             ctx->raw.verified / (1024 * 1024), ctx->raw.corrupted);
+    }
+    if (ctx->readback != READBACK_OFF && ctx->raw.has_error)
+    {
+        psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        psvDebugScreenPrintf("  Caught At:     %llu MB written (File %03u, Block %u)\n",
+                             ctx->raw.error_written / (1024 * 1024), ctx->raw.error_file,
+                             ctx->raw.error_block);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+
+    if (ctx->abort_policy != ABORT_NEVER)
+    {
+        char policy_str[32];
+        f3v_format_abort(ctx->abort_policy, ctx->abort_param, policy_str, sizeof(policy_str));
+
+        if (ctx->aborted)
+        {
+            psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+            psvDebugScreenPrintf("  Abort Policy:  %s - stopped after %llu of %llu MB\n",
+                                 policy_str, ctx->bytes_verified / (1024 * 1024),
+                                 ctx->bytes_written / (1024 * 1024));
+            psvDebugScreenSetFgColor(0xFFFFFFFF);
+        }
+        else
+        {
+            psvDebugScreenPrintf("  Abort Policy:  %s (not triggered)\n", policy_str);
+        }
+    }
+
+    /* Transient errors point at the adapter or contacts, persistent ones at the media */
+    if (ctx->io_retries > 0)
+    {
+        if (ctx->io_failed > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        }
+        else
+        {
+            psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+        }
+        psvDebugScreenPrintf("  I/O Retries:   %u (%u transient, %u persistent)\n",
+                             ctx->io_retries, ctx->io_recovered, ctx->io_failed);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+    if (ctx->vote_transient > 0 || ctx->vote_persistent > 0)
+    {
+        psvDebugScreenPrintf("  Re-read Vote:  %u transient, %u persistent, %llu unstable bytes\n",
+                             ctx->vote_transient, ctx->vote_persistent, ctx->vote_unstable);
+    }
+
+    if (ctx->throttle.rate_bps != 0)
+    {
+        psvDebugScreenPrintf("  Rate Limit:    %llu MB/s, burst %llu MB\n",
+                             ctx->throttle.rate_bps / (1024 * 1024),
+                             ctx->throttle.burst_bytes / (1024 * 1024));
+        if (ctx->throttle.windows_missed > 0)
+        {
+            psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+        }
+        psvDebugScreenPrintf("  Under Target:  %u of %u s\n", ctx->throttle.windows_missed,
+                             ctx->throttle.windows);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+    psvDebugScreenPrintf("\n");
 
     if (ctx->bytes_corrupted > 0)
     {
@@ -185,6 +1437,12 @@ void f3v_ui_results(const TestContext *ctx, TestResult result)
                                  ctx->first_error_file, ctx->first_error_block,
                                  ctx->first_error_offset);
         }
+        if (ctx->has_alias)
+        {
+            psvDebugScreenPrintf("  Aliasing:      File %03u Block %u holds File %03u Block %u\n",
+                                 ctx->alias_file, ctx->alias_block, ctx->alias_src_file,
+                                 ctx->alias_src_block);
+        }
     }
     else if (result == RESULT_PASS)
     {
@@ -193,9 +1451,92 @@ void f3v_ui_results(const TestContext *ctx, TestResult result)
         psvDebugScreenSetFgColor(0xFFFFFFFF);
     }
 
+    if (ctx->mode == MODE_RETEST)
+    {
+        uint32_t shown = ctx->fail_count < 8 ? ctx->fail_count : 8;
+
+        psvDebugScreenPrintf("\n  Re-tested regions:\n");
+        for (uint32_t i = 0; i < shown; i++)
+        {
+            const FailRegion *region = &ctx->fail[i];
+
+            if (region->failed_passes >= ctx->run.retest.passes)
+            {
+                psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+            }
+            else if (region->failed_passes > 0)
+            {
+                psvDebugScreenSetFgColor(0xFF00FFFF); /* Yellow */
+            }
+            else
+            {
+                psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
+            }
+            psvDebugScreenPrintf("    File %03u, Blocks %u-%u: %s (%u/%u)\n", region->file,
+                                 region->block, region->block + region->block_count - 1,
+                                 f3v_fail_class(region, ctx->run.retest.passes),
+                                 region->failed_passes, ctx->run.retest.passes);
+        }
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+
+        if (ctx->fail_count > shown)
+        {
+            psvDebugScreenPrintf("    ... and %u more\n", ctx->fail_count - shown);
+        }
+        if (ctx->fail_truncated)
+        {
+            psvDebugScreenPrintf("    (list was capped at %d regions)\n", F3V_MAX_FAIL_REGIONS);
+        }
+    }
+
     psvDebugScreenPrintf("\n");
 }
 
+void f3v_ui_resume(const TestContext *ctx, const JournalRecord *rec)
+{
+    char written_str[32], verified_str[32];
+
+    f3v_format_bytes(rec->bytes_written, written_str, sizeof(written_str));
+    f3v_format_bytes(rec->bytes_verified, verified_str, sizeof(verified_str));
+
+    psvDebugScreenPrintf("  An interrupted test was found on %s (%s).\n\n",
+                         ctx->target.path, ctx->target.name);
+
+    psvDebugScreenPrintf("  Phase:         %s\n", rec->phase == PHASE_VERIFY ? "Verify" : "Write");
+    psvDebugScreenPrintf("  Data Written:  %s (%u files)\n", written_str, rec->files_written);
+    if (rec->phase == PHASE_VERIFY)
+    {
+        psvDebugScreenPrintf("  Data Verified: %s (%s order)\n", verified_str,
+                             f3v_order_name((VerifyOrder)rec->verify_order));
+    }
+
+    /* A resumed run keeps these, whatever the menu says */
+    static const char *readback_names[READBACK_COUNT] = {"Off", "After each write", "Per file"};
+    char abort_str[32];
+    f3v_format_abort((AbortPolicy)rec->abort_policy, rec->abort_param, abort_str,
+                     sizeof(abort_str));
+    psvDebugScreenPrintf("  Readback:      %s (kept)\n", readback_names[rec->readback]);
+    psvDebugScreenPrintf("  Abort:         %s (kept)\n", abort_str);
+
+    /* While writing, the per-file stream's finds are not yet in the total */
+    uint64_t corrupted = rec->bytes_corrupted;
+    if (rec->phase != PHASE_VERIFY && rec->readback == READBACK_FILE)
+    {
+        corrupted += rec->raw_corrupted;
+    }
+
+    if (corrupted > 0)
+    {
+        psvDebugScreenSetFgColor(0xFF0000FF); /* Red */
+        psvDebugScreenPrintf("  Corrupted:     %llu bytes so far\n", corrupted);
+        psvDebugScreenSetFgColor(0xFFFFFFFF);
+    }
+
+    psvDebugScreenSetFgColor(0xFF00FF00); /* Green */
+    psvDebugScreenPrintf("\n  Test files match the last checkpoint.\n\n");
+    psvDebugScreenSetFgColor(0xFFFFFFFF);
+}
+
 void f3v_ui_prompt(const char *message)
 {
     psvDebugScreenSetFgColor(0xFF888888); /* Gray */
@@ -232,6 +1573,8 @@ uint32_t f3v_ui_read_buttons(void)
         current |= F3V_BTN_RIGHT;
     if (pad.buttons & SCE_CTRL_START)
         current |= F3V_BTN_START;
+    if (pad.buttons & SCE_CTRL_SQUARE)
+        current |= F3V_BTN_SQUARE;
 
     /* Return newly pressed buttons (edge detection) */
     uint32_t pressed = current & ~g_last_buttons;
@@ -310,4 +1653,52 @@ char *f3v_format_duration(uint32_t seconds, char *buf, size_t buf_size)
         snprintf(buf, buf_size, "%u:%02u", mins, secs);
     }
     return buf;
-}
\ No newline at end of file
+}
+
+char *f3v_format_timestamp(char *buf, size_t buf_size)
+{
+    SceDateTime now;
+    sceRtcGetCurrentClockLocalTime(&now);
+
+    snprintf(buf, buf_size, "%04u-%02u-%02u %02u:%02u:%02u",
+             now.year, now.month, now.day, now.hour, now.minute, now.second);
+    return buf;
+}
+
+char *f3v_format_variant(uint32_t variant, char *buf, size_t buf_size)
+{
+    const char *inverted = (variant & 1) ? " inverted" : "";
+
+    if (variant < 2)
+    {
+        snprintf(buf, buf_size, "%s", (variant & 1) ? "inverted" : "normal");
+    }
+    else
+    {
+        snprintf(buf, buf_size, "seed %u%s", variant >> 1, inverted);
+    }
+    return buf;
+}
+
+char *f3v_format_abort(AbortPolicy policy, uint32_t param, char *buf, size_t buf_size)
+{
+    switch (policy)
+    {
+    case ABORT_FIRST_BAD:
+        snprintf(buf, buf_size, "First bad block");
+        break;
+    case ABORT_BAD_MB:
+        snprintf(buf, buf_size, "%u MB bad", param);
+        break;
+    case ABORT_BAD_RATIO:
+        snprintf(buf, buf_size, "%u%% bad in %llu MB", param, F3V_ABORT_WINDOW / (1024 * 1024));
+        break;
+    case ABORT_ALIASING:
+        snprintf(buf, buf_size, "Aliasing seen");
+        break;
+    default:
+        snprintf(buf, buf_size, "Never");
+        break;
+    }
+    return buf;
+}
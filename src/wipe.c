@@ -0,0 +1,162 @@
+/**
+ * @file wipe.c
+ * @brief Free-space wipe: fill kernels and transfer size tuning
+ */
+
+#include <string.h>
+
+#include "wipe.h"
+#include "pattern.h"
+#include "pool.h"
+
+void f3v_wipe_tune_init(WipeTuner *tuner)
+{
+    memset(tuner, 0, sizeof(*tuner));
+}
+
+uint32_t f3v_wipe_tune_blocks(const WipeTuner *tuner)
+{
+    return 1U << (tuner->size < F3V_WIPE_SIZES ? tuner->size : tuner->best);
+}
+
+void f3v_wipe_tune_add(WipeTuner *tuner, uint32_t bytes, uint64_t usec)
+{
+    if (tuner->size >= F3V_WIPE_SIZES)
+    {
+        return;
+    }
+
+    tuner->bytes[tuner->size] += bytes;
+    tuner->usec[tuner->size] += usec;
+    if (tuner->bytes[tuner->size] < F3V_WIPE_TUNE_BYTES || ++tuner->size < F3V_WIPE_SIZES)
+    {
+        return;
+    }
+
+    /* bytes[i] / usec[i] > bytes[best] / usec[best] by the gain, without dividing */
+    tuner->best = 0;
+    for (uint32_t i = 1; i < F3V_WIPE_SIZES; i++)
+    {
+        uint32_t b = tuner->best;
+
+        if (tuner->usec[i] > 0 &&
+            tuner->bytes[i] * tuner->usec[b] * 100 >
+                tuner->bytes[b] * tuner->usec[i] * (100 + F3V_WIPE_TUNE_GAIN_PCT))
+        {
+            tuner->best = i;
+        }
+    }
+}
+
+uint32_t f3v_wipe_tune_kbs(const WipeTuner *tuner, uint32_t size)
+{
+    if (size >= F3V_WIPE_SIZES || tuner->usec[size] == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)(tuner->bytes[size] / 1024 * 1000000 / tuner->usec[size]);
+}
+
+void f3v_wipe_fill(uint8_t *buf, WipeFill fill, WipeKernel kernel, uint32_t seed,
+                   uint32_t file_idx, uint32_t block_idx)
+{
+    switch (fill)
+    {
+    case WIPE_RANDOM:
+        if (kernel == WIPE_KERNEL_POOL)
+        {
+            f3v_pool_fill_noise(buf, seed, file_idx, block_idx);
+        }
+        else
+        {
+            f3v_fill_noise_range(buf, seed, file_idx, block_idx, 0, F3V_BLOCK_SIZE);
+        }
+        break;
+    case WIPE_PATTERN:
+        if (kernel == WIPE_KERNEL_POOL)
+        {
+            f3v_pool_fill(buf, file_idx, block_idx);
+        }
+        else
+        {
+            f3v_fill_pattern_range(buf, file_idx, block_idx, 0, F3V_BLOCK_SIZE);
+        }
+        break;
+    default:
+        memset(buf, 0, F3V_BLOCK_SIZE);
+        break;
+    }
+}
+
+uint32_t f3v_wipe_verify(const uint8_t *buf, WipeFill fill, WipeKernel kernel, uint32_t seed,
+                         uint32_t file_idx, uint32_t block_idx, uint32_t len,
+                         uint32_t *first_error_offset)
+{
+    int pool = kernel == WIPE_KERNEL_POOL && len == F3V_BLOCK_SIZE;
+    uint32_t corrupted = 0;
+
+    switch (fill)
+    {
+    case WIPE_RANDOM:
+        return pool ? f3v_pool_verify_noise(buf, seed, file_idx, block_idx, first_error_offset)
+                    : f3v_verify_noise_range(buf, seed, file_idx, block_idx, 0, len,
+                                             first_error_offset);
+    case WIPE_PATTERN:
+        return pool ? f3v_pool_verify(buf, file_idx, block_idx, first_error_offset)
+                    : f3v_verify_pattern_range(buf, file_idx, block_idx, 0, len,
+                                               first_error_offset);
+    default:
+        for (uint32_t i = 0; i < len; i++)
+        {
+            if (buf[i] != 0 && corrupted++ == 0 && first_error_offset != NULL)
+            {
+                *first_error_offset = i;
+            }
+        }
+        return corrupted;
+    }
+}
+
+WipeKernel f3v_wipe_pick_kernel(WipeFill fill, uint8_t *buf, uint32_t seed,
+                                uint64_t (*now_usec)(void), uint32_t *kbs)
+{
+    WipeKernel best = WIPE_KERNEL_INLINE;
+
+    if (fill == WIPE_ZEROS)
+    {
+        memset(buf, 0, (size_t)F3V_WIPE_MAX_BLOCKS * F3V_BLOCK_SIZE);
+        return WIPE_KERNEL_ONCE;
+    }
+
+    for (WipeKernel k = WIPE_KERNEL_INLINE; k <= WIPE_KERNEL_POOL; k++)
+    {
+        uint64_t t0 = now_usec();
+        for (uint32_t i = 0; i < F3V_WIPE_CALIBRATE_BLOCKS; i++)
+        {
+            f3v_wipe_fill(buf + (size_t)i * F3V_BLOCK_SIZE, fill, k, seed, 1, i);
+        }
+        uint64_t usec = now_usec() - t0;
+
+        kbs[k] = (uint32_t)((uint64_t)F3V_WIPE_CALIBRATE_BLOCKS * (F3V_BLOCK_SIZE / 1024) *
+                            1000000 / (usec > 0 ? usec : 1));
+        if (kbs[k] > kbs[best])
+        {
+            best = k;
+        }
+    }
+    return best;
+}
+
+const char *f3v_wipe_fill_name(WipeFill fill)
+{
+    static const char *names[WIPE_FILL_COUNT] = {"Zeros", "Random", "Test pattern"};
+
+    return fill < WIPE_FILL_COUNT ? names[fill] : "?";
+}
+
+const char *f3v_wipe_kernel_name(WipeKernel kernel)
+{
+    static const char *names[WIPE_KERNEL_COUNT] = {"fill once", "inline", "pool"};
+
+    return kernel < WIPE_KERNEL_COUNT ? names[kernel] : "?";
+}
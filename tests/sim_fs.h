@@ -0,0 +1,95 @@
+/**
+ * @file sim_fs.h
+ * @brief In-memory file system shared by the f3vita workload tests
+ *
+ * A flat list of full paths. Files hold their data in memory; the test
+ * that includes this header supplies the device callbacks on top of it.
+ * Define SIM_MAX_ENTRIES before including to size the list, and
+ * SIM_FS_EXTRA to add test-specific fields to SimFs.
+ */
+
+#ifndef F3V_TESTS_SIM_FS_H
+#define F3V_TESTS_SIM_FS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Most entries the simulated file system holds */
+#ifndef SIM_MAX_ENTRIES
+#define SIM_MAX_ENTRIES 64
+#endif
+
+/* Test-specific SimFs fields (none by default) */
+#ifndef SIM_FS_EXTRA
+#define SIM_FS_EXTRA
+#endif
+
+typedef struct {
+    char path[192];
+    int is_dir;
+    uint8_t *data;
+    uint32_t size;
+    uint64_t mtime;
+    int unreadable;         /* Opens, but every read fails */
+    uint64_t bad_offset;    /* Reads touching [bad_offset, +bad_len) fail */
+    uint64_t bad_len;
+    uint64_t slow_offset;   /* Reads touching [slow_offset, +slow_len) take 5 s */
+    uint64_t slow_len;
+} SimEntry;
+
+typedef struct {
+    SimEntry entry[SIM_MAX_ENTRIES];
+    uint32_t count;
+    uint64_t clock;
+    SIM_FS_EXTRA
+} SimFs;
+
+static SimFs g_fs;
+
+static int sim_find(const char *path)
+{
+    for (uint32_t i = 0; i < g_fs.count; i++)
+    {
+        if (strcmp(g_fs.entry[i].path, path) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void sim_drop(int i)
+{
+    free(g_fs.entry[i].data);
+    g_fs.entry[i] = g_fs.entry[--g_fs.count];
+}
+
+/**
+ * Remove a file (directories are left alone)
+ */
+static int sim_remove(void *handle, const char *path)
+{
+    (void)handle;
+    int i = sim_find(path);
+    if (i < 0 || g_fs.entry[i].is_dir)
+    {
+        return -1;
+    }
+    sim_drop(i);
+    return 0;
+}
+
+/**
+ * Free every entry and zero the file system
+ */
+static void sim_reset(void)
+{
+    while (g_fs.count > 0)
+    {
+        sim_drop(0);
+    }
+    memset(&g_fs, 0, sizeof(g_fs));
+}
+
+#endif /* F3V_TESTS_SIM_FS_H */
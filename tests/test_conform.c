@@ -0,0 +1,230 @@
+/**
+ * @file test_conform.c
+ * @brief Unit tests for f3vita speed-class conformance
+ *
+ * Desktop-runnable tests for the window statistics and verdicts.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_conform test_conform.c ../src/conform.c
+ * Run: ./test_conform
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "conform.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                      \
+    do                                                             \
+    {                                                              \
+        if ((actual) != (expected))                                \
+        {                                                          \
+            printf("  FAIL: %s (expected %llu, got %llu)\n", msg,  \
+                   (unsigned long long)(expected),                 \
+                   (unsigned long long)(actual));                  \
+            g_tests_failed++;                                      \
+            return 0;                                              \
+        }                                                          \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/* Window time for a speed in KB/s */
+#define WINDOW_USEC(kbs) ((uint64_t)(F3V_CONFORM_WINDOW / 1024) * 1000000 / (kbs))
+
+static ConformResult g_result;
+
+/**
+ * Helper: record windows at one speed, continuing at window index first
+ */
+static void add_windows(uint32_t first, uint32_t count, uint32_t kbs)
+{
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        f3v_conform_add(&g_result, (uint64_t)i * F3V_CONFORM_WINDOW, WINDOW_USEC(kbs));
+    }
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * CF001: Every Window Fast Enough
+ * Class speed uses 1 MB = 1,000,000 bytes; window statistics and a pass
+ */
+static int test_conform_pass(void)
+{
+    f3v_conform_init(&g_result, 10);
+    TEST_ASSERT_EQ(g_result.class_kbs, 9765, "10 MB/s in KB/s");
+
+    add_windows(0, 50, 20000);
+    add_windows(50, 50, 12000);
+    f3v_conform_finish(&g_result);
+
+    TEST_ASSERT_EQ(g_result.windows, 100, "Windows counted");
+    TEST_ASSERT_EQ(g_result.below, 0, "No slow window");
+    TEST_ASSERT_EQ(g_result.drop_count, 0, "No slow run");
+    TEST_ASSERT(g_result.min_kbs >= 11990 && g_result.min_kbs <= 12000, "Slowest window");
+    TEST_ASSERT(g_result.avg_kbs > 14900 && g_result.avg_kbs < 15100,
+                "Average is total bytes over total time");
+    TEST_ASSERT_EQ(f3v_conform_verdict(&g_result), CONFORM_PASS, "Verdict");
+
+    return 1;
+}
+
+/**
+ * CF002: One Slow Window
+ * A single window below the class is marginal and listed with its offset
+ */
+static int test_conform_marginal(void)
+{
+    f3v_conform_init(&g_result, 10);
+    add_windows(0, 200, 15000);
+    f3v_conform_add(&g_result, 200ULL * F3V_CONFORM_WINDOW, WINDOW_USEC(5000));
+    add_windows(201, 99, 15000);
+    f3v_conform_finish(&g_result);
+
+    TEST_ASSERT_EQ(g_result.below, 1, "One slow window");
+    TEST_ASSERT_EQ(g_result.drop_count, 1, "One slow run");
+    TEST_ASSERT_EQ(g_result.drop[0].offset, 200ULL * F3V_CONFORM_WINDOW, "Run offset");
+    TEST_ASSERT_EQ(g_result.drop[0].length, F3V_CONFORM_WINDOW, "Run length");
+    TEST_ASSERT(g_result.min_kbs < 5100, "Slowest window");
+    TEST_ASSERT(g_result.p1_kbs >= g_result.class_kbs, "1% window above class");
+    TEST_ASSERT_EQ(f3v_conform_verdict(&g_result), CONFORM_MARGINAL, "Verdict");
+
+    return 1;
+}
+
+/**
+ * CF003: Slow Windows Merge Into Runs
+ * Consecutive slow windows form one run with its slowest speed
+ */
+static int test_conform_runs(void)
+{
+    f3v_conform_init(&g_result, 30);
+    add_windows(0, 10, 40000);
+    add_windows(10, 3, 20000);
+    f3v_conform_add(&g_result, 13ULL * F3V_CONFORM_WINDOW, WINDOW_USEC(8000));
+    add_windows(14, 10, 40000);
+    add_windows(24, 2, 25000);
+    f3v_conform_finish(&g_result);
+
+    TEST_ASSERT_EQ(g_result.below, 6, "Slow windows");
+    TEST_ASSERT_EQ(g_result.drop_count, 2, "Two runs");
+    TEST_ASSERT_EQ(g_result.drop[0].offset, 10ULL * F3V_CONFORM_WINDOW, "First run offset");
+    TEST_ASSERT_EQ(g_result.drop[0].length, 4ULL * F3V_CONFORM_WINDOW, "First run length");
+    TEST_ASSERT(g_result.drop[0].min_kbs < 8100, "First run slowest window");
+    TEST_ASSERT_EQ(g_result.drop[1].offset, 24ULL * F3V_CONFORM_WINDOW, "Second run offset");
+    TEST_ASSERT_EQ(f3v_conform_verdict(&g_result), CONFORM_FAIL, "Verdict");
+
+    return 1;
+}
+
+/**
+ * CF004: Many Slow Runs
+ * Runs past F3V_CONFORM_DROPS are counted but not listed; low percentiles
+ * come from the sorted windows
+ */
+static int test_conform_many_runs(void)
+{
+    f3v_conform_init(&g_result, 10);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        add_windows(i, 1, i % 10 == 0 ? 5000 : 20000);
+    }
+    f3v_conform_finish(&g_result);
+
+    TEST_ASSERT_EQ(g_result.below, 10, "Slow windows");
+    TEST_ASSERT_EQ(g_result.drop_count, F3V_CONFORM_DROPS, "Runs listed");
+    TEST_ASSERT_EQ(g_result.drops_lost, 10 - F3V_CONFORM_DROPS, "Runs not listed");
+    TEST_ASSERT(g_result.p5_kbs < g_result.class_kbs, "5% window below class");
+    TEST_ASSERT(g_result.window_kbs[0] <= g_result.window_kbs[99], "Windows sorted");
+    TEST_ASSERT_EQ(f3v_conform_verdict(&g_result), CONFORM_FAIL, "Verdict");
+
+    return 1;
+}
+
+/**
+ * CF005: Limits
+ * No windows fails; windows past the array are ignored
+ */
+static int test_conform_limits(void)
+{
+    f3v_conform_init(&g_result, 10);
+    f3v_conform_finish(&g_result);
+    TEST_ASSERT_EQ(f3v_conform_verdict(&g_result), CONFORM_FAIL, "No windows");
+
+    add_windows(0, F3V_CONFORM_WINDOWS + 5, 20000);
+    TEST_ASSERT_EQ(g_result.windows, F3V_CONFORM_WINDOWS, "Windows capped");
+    f3v_conform_finish(&g_result);
+    TEST_ASSERT_EQ(f3v_conform_verdict(&g_result), CONFORM_PASS, "Full run passes");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Conformance Module Tests ===\n\n");
+
+    printf("--- f3v_conform_add() / f3v_conform_verdict() Tests ---\n");
+    RUN_TEST(test_conform_pass);
+    RUN_TEST(test_conform_marginal);
+    RUN_TEST(test_conform_runs);
+    RUN_TEST(test_conform_many_runs);
+    RUN_TEST(test_conform_limits);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,355 @@
+/**
+ * @file test_discover.c
+ * @brief Unit tests for f3vita erase-block discovery
+ *
+ * Desktop-runnable tests that run discovery against a simulated card with
+ * a known erase-block size, phase and open-segment limit.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_discover test_discover.c ../src/discover.c
+ * Run: ./test_discover
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "discover.h"
+
+/* Region every simulated run may write */
+#define SIM_REGION (256ULL * 1024 * 1024)
+
+/* Most erase blocks the simulated card tracks */
+#define SIM_MAX_OPEN 32
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                      \
+    do                                                             \
+    {                                                              \
+        if ((actual) != (expected))                                \
+        {                                                          \
+            printf("  FAIL: %s (expected %llu, got %llu)\n", msg,  \
+                   (unsigned long long)(expected),                 \
+                   (unsigned long long)(actual));                  \
+            g_tests_failed++;                                      \
+            return 0;                                              \
+        }                                                          \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * Simulated card
+ *
+ * A write costs a fixed overhead, its transfer time, a program cost per
+ * erase block it touches and, when the block is not among the open_limit
+ * most recently written ones, the cost of closing one and opening another.
+ */
+typedef struct {
+    uint32_t erase_size;
+    uint32_t phase;             /* Offset of the first erase-block boundary */
+    uint32_t open_limit;        /* 0 = unlimited */
+    uint32_t base_us;
+    uint32_t per_block_us;
+    uint32_t open_us;
+    uint32_t jitter_us;         /* Up to this much added at random */
+    uint32_t stall_every;       /* Every n-th write stalls (0 = never) */
+    uint32_t stall_us;
+
+    uint64_t open[SIM_MAX_OPEN]; /* Most recently written first */
+    uint32_t open_count;
+    uint32_t writes;
+    uint64_t rng;
+    int fail_after;             /* Fail writes after this many (0 = never) */
+} SimCard;
+
+static struct DiscoverState g_state;
+
+/**
+ * Move block to the front of the open list
+ * @return 1 if another block had to be closed for it
+ */
+static int sim_touch(SimCard *card, uint64_t block)
+{
+    uint32_t limit = card->open_limit > 0 ? card->open_limit : SIM_MAX_OPEN;
+    uint32_t i = 0;
+
+    while (i < card->open_count && card->open[i] != block)
+    {
+        i++;
+    }
+    int evicted = i == limit;
+    if (i == card->open_count && card->open_count < limit)
+    {
+        card->open_count++;
+    }
+    if (i >= card->open_count)
+    {
+        i = card->open_count - 1;
+    }
+    memmove(&card->open[1], &card->open[0], i * sizeof(card->open[0]));
+    card->open[0] = block;
+
+    return evicted && card->open_limit > 0;
+}
+
+static int64_t sim_write(void *handle, uint64_t offset, uint32_t len)
+{
+    SimCard *card = (SimCard *)handle;
+
+    if (card->fail_after > 0 && card->writes >= (uint32_t)card->fail_after)
+    {
+        return -1;
+    }
+    card->writes++;
+
+    /* Block numbers shifted by one so offsets before the phase work */
+    uint64_t first = (offset + card->erase_size - card->phase) / card->erase_size;
+    uint64_t last = (offset + len - 1 + card->erase_size - card->phase) / card->erase_size;
+    int64_t usec = card->base_us + len / 64;
+
+    for (uint64_t block = first; block <= last; block++)
+    {
+        usec += card->per_block_us;
+        if (sim_touch(card, block))
+        {
+            usec += card->open_us;
+        }
+    }
+
+    if (card->jitter_us > 0)
+    {
+        card->rng = card->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        usec += (int64_t)((card->rng >> 33) % card->jitter_us);
+    }
+    if (card->stall_every > 0 && card->writes % card->stall_every == 0)
+    {
+        usec += card->stall_us;
+    }
+
+    return usec;
+}
+
+/**
+ * Helper: a typical card with the given geometry
+ */
+static void sim_init(SimCard *card, uint32_t erase_size, uint32_t phase, uint32_t open_limit)
+{
+    memset(card, 0, sizeof(*card));
+    card->erase_size = erase_size;
+    card->phase = phase;
+    card->open_limit = open_limit;
+    card->base_us = 500;
+    card->per_block_us = 300;
+    card->open_us = 3000;
+    card->rng = 12345;
+}
+
+/**
+ * Helper: run discovery to the end
+ * @return 0 when done, negative on error or if it does not finish
+ */
+static int run_discovery(SimCard *card, uint64_t region)
+{
+    DiscoverDevice dev = {sim_write, card};
+
+    if (f3v_discover_init(&g_state, region) < 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 1000000; i++)
+    {
+        int ret = f3v_discover_step(&g_state, &dev);
+        if (ret <= 0)
+        {
+            return ret;
+        }
+    }
+    return -1;
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * DS001: Erase Block and Open Segments
+ * 4 MB blocks at offset 0 with six open segments
+ */
+static int test_discover_basic(void)
+{
+    SimCard card;
+
+    sim_init(&card, 4 * 1024 * 1024, 0, 6);
+    TEST_ASSERT_EQ(run_discovery(&card, SIM_REGION), 0, "Discovery finishes");
+
+    const DiscoverResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->erase_size, 4 * 1024 * 1024, "Erase block size");
+    TEST_ASSERT_EQ(result->erase_phase, 0, "Erase block phase");
+    TEST_ASSERT(result->erase_score >= F3V_DISCOVER_MIN_SCORE, "Score above threshold");
+    TEST_ASSERT_EQ(result->open_max, 6, "Open segments");
+    TEST_ASSERT(result->open_limited, "Limit detected");
+    TEST_ASSERT_EQ(g_state.writes, g_state.total_writes, "Progress ends at 100%");
+    TEST_ASSERT_EQ(card.writes, g_state.writes, "Every write counted");
+
+    return 1;
+}
+
+/**
+ * DS002: Phase
+ * 1 MB blocks starting 192 KB into the file
+ */
+static int test_discover_phase(void)
+{
+    SimCard card;
+
+    sim_init(&card, 1024 * 1024, 192 * 1024, 4);
+    TEST_ASSERT_EQ(run_discovery(&card, SIM_REGION), 0, "Discovery finishes");
+
+    const DiscoverResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->erase_size, 1024 * 1024, "Erase block size");
+    TEST_ASSERT_EQ(result->erase_phase, 192 * 1024, "Erase block phase");
+    TEST_ASSERT_EQ(result->open_max, 4, "Open segments");
+
+    return 1;
+}
+
+/**
+ * DS003: Jitter and Stalls
+ * Random jitter and periodic long stalls do not move the result
+ */
+static int test_discover_noise(void)
+{
+    SimCard card;
+
+    sim_init(&card, 8 * 1024 * 1024, 2 * 1024 * 1024, 3);
+    card.jitter_us = 150;
+    card.stall_every = 37;
+    card.stall_us = 20000;
+    TEST_ASSERT_EQ(run_discovery(&card, SIM_REGION), 0, "Discovery finishes");
+
+    const DiscoverResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->erase_size, 8 * 1024 * 1024, "Erase block size");
+    TEST_ASSERT_EQ(result->erase_phase, 2 * 1024 * 1024, "Erase block phase");
+    TEST_ASSERT_EQ(result->open_max, 3, "Open segments");
+
+    return 1;
+}
+
+/**
+ * DS004: No Open Limit
+ * A card that keeps every segment open reports the most tried, not limited
+ */
+static int test_discover_unlimited(void)
+{
+    SimCard card;
+
+    sim_init(&card, 2 * 1024 * 1024, 0, 0);
+    TEST_ASSERT_EQ(run_discovery(&card, SIM_REGION), 0, "Discovery finishes");
+
+    const DiscoverResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->erase_size, 2 * 1024 * 1024, "Erase block size");
+    TEST_ASSERT_EQ(result->open_max, F3V_DISCOVER_MAX_OPEN, "Most segments tried");
+    TEST_ASSERT(!result->open_limited, "No limit");
+
+    return 1;
+}
+
+/**
+ * DS005: Recommendations
+ * Transfer size, alignment and streams follow the result; no boundaries
+ * means no erase block, a small region or a failing write an error
+ */
+static int test_discover_recommend(void)
+{
+    SimCard card;
+
+    sim_init(&card, 16 * 1024 * 1024, 4 * 1024 * 1024, 5);
+    TEST_ASSERT_EQ(run_discovery(&card, SIM_REGION), 0, "Discovery finishes");
+    TEST_ASSERT_EQ(g_state.result.erase_size, 16 * 1024 * 1024, "Largest erase block");
+    TEST_ASSERT_EQ(g_state.result.transfer, F3V_DISCOVER_MAX_TRANSFER, "Transfer capped");
+    TEST_ASSERT_EQ(g_state.result.alignment, 4 * 1024 * 1024, "Aligned to the phase");
+    TEST_ASSERT_EQ(g_state.result.streams, 4, "One segment left for the file system");
+
+    /* Flat timing: nothing found, defaults recommended */
+    sim_init(&card, 4 * 1024 * 1024, 0, 0);
+    card.per_block_us = 0;
+    TEST_ASSERT_EQ(run_discovery(&card, SIM_REGION), 0, "Discovery finishes");
+    TEST_ASSERT_EQ(g_state.result.erase_size, 0, "No erase block");
+    TEST_ASSERT_EQ(g_state.result.open_max, 0, "Open segments not tested");
+    TEST_ASSERT_EQ(g_state.result.transfer, F3V_BLOCK_SIZE, "Default transfer");
+    TEST_ASSERT_EQ(g_state.result.streams, 1, "Single stream");
+
+    sim_init(&card, 4 * 1024 * 1024, 0, 6);
+    TEST_ASSERT(run_discovery(&card, F3V_DISCOVER_SCAN) < 0, "Region too small");
+
+    sim_init(&card, 4 * 1024 * 1024, 0, 6);
+    card.fail_after = 100;
+    TEST_ASSERT(run_discovery(&card, SIM_REGION) < 0, "Write error reported");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Discovery Module Tests ===\n\n");
+
+    printf("--- f3v_discover_step() Tests ---\n");
+    RUN_TEST(test_discover_basic);
+    RUN_TEST(test_discover_phase);
+    RUN_TEST(test_discover_noise);
+    RUN_TEST(test_discover_unlimited);
+    RUN_TEST(test_discover_recommend);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
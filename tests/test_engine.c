@@ -0,0 +1,268 @@
+/**
+ * @file test_engine.c
+ * @brief Unit tests for the f3vita multi-device worker pool
+ *
+ * Desktop-runnable tests; the workers run on pthreads on the host and step
+ * simulated sessions instead of real ones.
+ * Compile: gcc -Wall -Wextra -std=c99 -pthread -I../include -o test_engine test_engine.c ../src/engine.c ../src/thread.c ../src/profile.c
+ * Run: ./test_engine
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "engine.h"
+#include "session.h"
+#include "thread.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                 \
+    do                                                        \
+    {                                                         \
+        if ((actual) != (expected))                           \
+        {                                                     \
+            printf("  FAIL: %s (expected %u, got %u)\n", msg, \
+                   (unsigned)(expected), (unsigned)(actual)); \
+            g_tests_failed++;                                 \
+            return 0;                                         \
+        }                                                     \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * =============================================================================
+ * Simulated Sessions
+ * =============================================================================
+ */
+
+/* Every session needs this many steps before it is done */
+#define SIM_STEPS 400
+
+static TestContext g_sessions[F3V_MAX_DEVICES];
+static F3vMutex g_sim_lock;
+static uint32_t g_steps[F3V_MAX_DEVICES];
+static uint32_t g_at_first_done[F3V_MAX_DEVICES];  /* Steps when the first session finished */
+static int g_done_count;
+static int g_overlap;           /* A session was stepped by two threads at once */
+static int g_in_step[F3V_MAX_DEVICES];
+
+/**
+ * Stand-in for the real session step: a short "transfer" per step
+ */
+int f3v_session_step(TestContext *ctx, uint8_t *buf)
+{
+    int idx = (int)(ctx - g_sessions);
+    int more;
+
+    (void)buf;
+
+    f3v_mutex_lock(&g_sim_lock);
+    g_overlap |= g_in_step[idx];
+    g_in_step[idx] = 1;
+    f3v_mutex_unlock(&g_sim_lock);
+
+    f3v_thread_sleep_usec(50);
+
+    f3v_mutex_lock(&g_sim_lock);
+    g_in_step[idx] = 0;
+    g_steps[idx]++;
+    more = g_steps[idx] < SIM_STEPS && !ctx->cancelled;
+    if (!more)
+    {
+        ctx->phase = PHASE_DONE;
+        if (g_done_count++ == 0)
+        {
+            memcpy(g_at_first_done, g_steps, sizeof(g_steps));
+        }
+    }
+    f3v_mutex_unlock(&g_sim_lock);
+
+    return more;
+}
+
+/**
+ * Prepare count sessions; those in done[] start finished
+ */
+static void sim_init(int count, const int *done)
+{
+    memset(g_sessions, 0, sizeof(g_sessions));
+    memset(g_steps, 0, sizeof(g_steps));
+    memset(g_at_first_done, 0, sizeof(g_at_first_done));
+    memset(g_in_step, 0, sizeof(g_in_step));
+    g_done_count = 0;
+    g_overlap = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        g_sessions[i].phase = done != NULL && done[i] ? PHASE_DONE : PHASE_WRITE;
+    }
+}
+
+/**
+ * Run the engine until every session is done
+ * @return 0 on success, negative if it did not start
+ */
+static int sim_run(int count)
+{
+    if (f3v_engine_start(g_sessions, count) < 0)
+    {
+        return -1;
+    }
+    while (f3v_engine_busy())
+    {
+        f3v_thread_sleep_usec(1000);
+    }
+    f3v_engine_stop();
+    return 0;
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * EN001: Every Session Advances
+ * More sessions than workers: each gets quanta while all are still busy
+ */
+static int test_engine_fair(void)
+{
+    sim_init(4, NULL);
+
+    TEST_ASSERT_EQ(sim_run(4), 0, "Engine starts");
+    TEST_ASSERT_EQ(g_done_count, 4, "Every session finished");
+    TEST_ASSERT(!g_overlap, "No session stepped by two threads at once");
+
+    /* A worker holding two sessions must alternate between them */
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_ASSERT(g_at_first_done[i] >= SIM_STEPS / 4,
+                    "Session advanced before the first one finished");
+    }
+
+    return 1;
+}
+
+/**
+ * EN002: Finished Sessions Are Skipped
+ * Sessions already done are never stepped; the rest all complete
+ */
+static int test_engine_skip_done(void)
+{
+    static const int done[] = {1, 0, 1, 0, 0};
+
+    sim_init(5, done);
+
+    TEST_ASSERT_EQ(sim_run(5), 0, "Engine starts");
+    TEST_ASSERT_EQ(g_steps[0] + g_steps[2], 0, "Finished sessions not stepped");
+    TEST_ASSERT_EQ(g_steps[1], SIM_STEPS, "Session 1 completed");
+    TEST_ASSERT_EQ(g_steps[3], SIM_STEPS, "Session 3 completed");
+    TEST_ASSERT_EQ(g_steps[4], SIM_STEPS, "Session 4 completed");
+
+    /* Nothing to run at all: the workers exit straight away */
+    sim_init(2, (const int[]){1, 1});
+    TEST_ASSERT_EQ(sim_run(2), 0, "Engine starts with nothing to do");
+    TEST_ASSERT_EQ(g_steps[0] + g_steps[1], 0, "Nothing stepped");
+
+    return 1;
+}
+
+/**
+ * EN003: Cancel
+ * Every session stops at its next step
+ */
+static int test_engine_cancel(void)
+{
+    sim_init(3, NULL);
+
+    TEST_ASSERT_EQ(f3v_engine_start(g_sessions, 3), 0, "Engine starts");
+    f3v_thread_sleep_usec(5000);
+    f3v_engine_cancel();
+    while (f3v_engine_busy())
+    {
+        f3v_thread_sleep_usec(1000);
+    }
+    f3v_engine_stop();
+
+    TEST_ASSERT_EQ(g_done_count, 3, "Every session stopped");
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_ASSERT(g_steps[i] < SIM_STEPS, "Stopped early");
+    }
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Engine Module Tests ===\n");
+    printf("Workers: %d, quantum: %d steps\n\n", F3V_ENGINE_WORKERS, F3V_ENGINE_QUANTUM);
+
+    if (f3v_mutex_init(&g_sim_lock, "sim_lock") < 0)
+    {
+        printf("FAILED: mutex init\n");
+        return 1;
+    }
+
+    printf("--- f3v_engine_start() Tests ---\n");
+    RUN_TEST(test_engine_fair);
+    RUN_TEST(test_engine_skip_done);
+    RUN_TEST(test_engine_cancel);
+
+    f3v_mutex_destroy(&g_sim_lock);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,469 @@
+/**
+ * @file test_fstree.c
+ * @brief Unit tests for f3vita small-file workload
+ *
+ * Desktop-runnable tests that run the workload against a simulated file
+ * system with fixed operation costs.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_fstree test_fstree.c ../src/fstree.c ../src/stats.c ../src/pattern.c -lm
+ * Run: ./test_fstree
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fstree.h"
+
+/* Most entries the simulated file system holds */
+#define SIM_MAX_ENTRIES 1024
+
+/* Operation costs and injected faults */
+#define SIM_FS_EXTRA                                                           \
+    uint32_t cost[FS_OP_COUNT];                                                \
+    uint32_t creates;                                                          \
+    int flip_file;          /* Create that gets a byte flipped (-1 = none) */  \
+    int short_file;         /* Create that stores one byte less (-1 = none) */ \
+    int fail_file;          /* Create that fails (-1 = none) */
+
+#include "sim_fs.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                      \
+    do                                                             \
+    {                                                              \
+        if ((actual) != (expected))                                \
+        {                                                          \
+            printf("  FAIL: %s (expected %llu, got %llu)\n", msg,  \
+                   (unsigned long long)(expected),                 \
+                   (unsigned long long)(actual));                  \
+            g_tests_failed++;                                      \
+            return 0;                                              \
+        }                                                          \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * Simulated file system
+ *
+ * Directories must exist before anything is created in them and be empty
+ * to be removed. Every operation advances the clock by a fixed cost.
+ */
+static struct FsTreeState g_state;
+static uint8_t g_buf[F3V_FSTREE_MAX_FILE];
+
+/**
+ * Whether the directory holding path exists (the root's parent always does)
+ */
+static int sim_parent_exists(const char *path)
+{
+    char parent[192];
+    char *slash;
+
+    snprintf(parent, sizeof(parent), "%s", path);
+    slash = strrchr(parent, '/');
+    if (slash == NULL)
+    {
+        return 0;
+    }
+    *slash = '\0';
+    if (strchr(parent, '/') == NULL)
+    {
+        return 1;
+    }
+    int i = sim_find(parent);
+    return i >= 0 && g_fs.entry[i].is_dir;
+}
+
+static int sim_add(const char *path, int is_dir)
+{
+    if (g_fs.count == SIM_MAX_ENTRIES || sim_find(path) >= 0 || !sim_parent_exists(path))
+    {
+        return -1;
+    }
+    SimEntry *e = &g_fs.entry[g_fs.count++];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->is_dir = is_dir;
+    return (int)(g_fs.count - 1);
+}
+
+static int sim_mkdir(void *handle, const char *path)
+{
+    (void)handle;
+    g_fs.clock += g_fs.cost[FS_OP_MKDIR];
+    return sim_add(path, 1) >= 0 ? 0 : -1;
+}
+
+static int sim_rmdir(void *handle, const char *path)
+{
+    size_t len = strlen(path);
+
+    (void)handle;
+    g_fs.clock += g_fs.cost[FS_OP_RMDIR];
+    int i = sim_find(path);
+    if (i < 0 || !g_fs.entry[i].is_dir)
+    {
+        return -1;
+    }
+    for (uint32_t j = 0; j < g_fs.count; j++)
+    {
+        if (strncmp(g_fs.entry[j].path, path, len) == 0 && g_fs.entry[j].path[len] == '/')
+        {
+            return -1;
+        }
+    }
+    sim_drop(i);
+    return 0;
+}
+
+static int sim_write_file(void *handle, const char *path, const uint8_t *buf, uint32_t len)
+{
+    int create = (int)g_fs.creates++;
+
+    (void)handle;
+    g_fs.clock += g_fs.cost[FS_OP_CREATE];
+    if (create == g_fs.fail_file)
+    {
+        return -1;
+    }
+    int i = sim_add(path, 0);
+    if (i < 0)
+    {
+        return -1;
+    }
+
+    SimEntry *e = &g_fs.entry[i];
+    e->size = create == g_fs.short_file && len > 0 ? len - 1 : len;
+    e->data = malloc(len > 0 ? len : 1);
+    memcpy(e->data, buf, len);
+    if (create == g_fs.flip_file && len > 0)
+    {
+        e->data[len / 2] ^= 0x10;
+    }
+    return (int)len;
+}
+
+static int sim_read_file(void *handle, const char *path, uint8_t *buf, uint32_t len)
+{
+    (void)handle;
+    g_fs.clock += g_fs.cost[FS_OP_READ];
+    int i = sim_find(path);
+    if (i < 0 || g_fs.entry[i].is_dir)
+    {
+        return -1;
+    }
+    uint32_t n = g_fs.entry[i].size < len ? g_fs.entry[i].size : len;
+    memcpy(buf, g_fs.entry[i].data, n);
+    return (int)n;
+}
+
+static int64_t sim_stat(void *handle, const char *path)
+{
+    (void)handle;
+    g_fs.clock += g_fs.cost[FS_OP_STAT];
+    int i = sim_find(path);
+    return i >= 0 ? (int64_t)g_fs.entry[i].size : -1;
+}
+
+static int sim_delete(void *handle, const char *path)
+{
+    g_fs.clock += g_fs.cost[FS_OP_DELETE];
+    return sim_remove(handle, path);
+}
+
+static uint64_t sim_now(void *handle)
+{
+    (void)handle;
+    return g_fs.clock;
+}
+
+static const FsTreeDevice g_dev = {sim_mkdir,  sim_rmdir,  sim_write_file, sim_read_file,
+                                   sim_stat,   sim_delete, sim_now,        NULL};
+
+/**
+ * Helper: empty file system with distinct operation costs
+ */
+static void sim_init(void)
+{
+    sim_reset();
+    for (uint32_t i = 0; i < FS_OP_COUNT; i++)
+    {
+        g_fs.cost[i] = 1000 * (i + 1);
+    }
+    g_fs.flip_file = -1;
+    g_fs.short_file = -1;
+    g_fs.fail_file = -1;
+}
+
+/**
+ * Helper: a shape with one size range
+ */
+static FsTreeShape make_shape(uint32_t fanout, uint32_t depth, uint32_t files,
+                              uint32_t min_size, uint32_t max_size)
+{
+    FsTreeShape shape;
+
+    memset(&shape, 0, sizeof(shape));
+    shape.fanout = fanout;
+    shape.depth = depth;
+    shape.files_per_dir = files;
+    shape.bucket[0].weight = 1;
+    shape.bucket[0].min_size = min_size;
+    shape.bucket[0].max_size = max_size;
+    shape.bucket_count = 1;
+    return shape;
+}
+
+/**
+ * Helper: run the workload to the end
+ * @return 0 when done, negative on error or if it does not finish
+ */
+static int run_tree(const FsTreeShape *shape)
+{
+    if (f3v_fstree_init(&g_state, shape, "ux0:data/tree", 42) < 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 1000000; i++)
+    {
+        int ret = f3v_fstree_step(&g_state, &g_dev, g_buf);
+        if (ret <= 0)
+        {
+            return ret;
+        }
+    }
+    return -1;
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * FT001: Tree Lifecycle
+ * Every directory and file is created, checked and removed again
+ */
+static int test_fstree_lifecycle(void)
+{
+    FsTreeShape shape = make_shape(3, 2, 5, 1, 8192);
+
+    sim_init();
+    TEST_ASSERT_EQ(f3v_fstree_dirs(&shape), 13, "1 + 3 + 9 directories");
+    TEST_ASSERT_EQ(run_tree(&shape), 0, "Workload finishes");
+
+    const FsTreeResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->files, 65, "Files");
+    TEST_ASSERT_EQ(result->op[FS_OP_MKDIR].count, 13, "Directories created");
+    TEST_ASSERT_EQ(result->op[FS_OP_RMDIR].count, 13, "Directories removed");
+    for (uint32_t i = FS_OP_CREATE; i <= FS_OP_DELETE; i++)
+    {
+        TEST_ASSERT_EQ(result->op[i].count, 65, "Every file handled by each file op");
+    }
+    for (uint32_t i = 0; i < FS_OP_COUNT; i++)
+    {
+        TEST_ASSERT_EQ(result->op[i].failed, 0, "No failures");
+    }
+    TEST_ASSERT_EQ(result->bad_files, 0, "No bad files");
+    TEST_ASSERT_EQ(g_fs.count, 0, "Tree removed");
+    TEST_ASSERT_EQ(g_state.ops, g_state.total_ops, "Progress ends at 100%");
+    TEST_ASSERT_EQ(g_state.written, result->bytes, "All bytes written");
+    TEST_ASSERT_EQ(g_state.verified, result->bytes, "All bytes read back");
+
+    return 1;
+}
+
+/**
+ * FT002: File Sizes
+ * Sizes repeat for a seed, stay in their ranges and follow the weights
+ */
+static int test_fstree_sizes(void)
+{
+    FsTreeShape shape = make_shape(0, 0, 1, 0, 0);
+    uint32_t small = 0;
+
+    shape.bucket[0] = (FsSizeBucket){3, 100, 199};
+    shape.bucket[1] = (FsSizeBucket){1, 5000, 5000};
+    shape.bucket_count = 2;
+
+    for (uint32_t n = 0; n < 4000; n++)
+    {
+        uint32_t size = f3v_fstree_file_size(&shape, 7, n);
+
+        TEST_ASSERT_EQ(size, f3v_fstree_file_size(&shape, 7, n), "Same size for the seed");
+        TEST_ASSERT((size >= 100 && size <= 199) || size == 5000, "Size within a range");
+        small += size < 5000;
+    }
+    TEST_ASSERT(small > 2800 && small < 3200, "Three quarters in the first range");
+
+    uint32_t differ = 0;
+    for (uint32_t n = 0; n < 100; n++)
+    {
+        differ += f3v_fstree_file_size(&shape, 7, n) != f3v_fstree_file_size(&shape, 8, n);
+    }
+    TEST_ASSERT(differ > 10, "Another seed gives other sizes");
+
+    return 1;
+}
+
+/**
+ * FT003: Corruption
+ * A flipped byte and a truncated file are found; a failed create is
+ * counted and the rest of the tree still goes away
+ */
+static int test_fstree_corruption(void)
+{
+    FsTreeShape shape = make_shape(2, 1, 4, 1000, 2000);
+
+    sim_init();
+    g_fs.flip_file = 1;
+    g_fs.short_file = 5;
+    g_fs.fail_file = 9;
+    TEST_ASSERT_EQ(run_tree(&shape), 0, "Workload finishes");
+
+    const FsTreeResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->op[FS_OP_CREATE].failed, 1, "Failed create");
+    TEST_ASSERT_EQ(result->op[FS_OP_STAT].failed, 2, "Short and missing file");
+    TEST_ASSERT_EQ(result->op[FS_OP_READ].failed, 1, "Missing file");
+    TEST_ASSERT_EQ(result->op[FS_OP_DELETE].failed, 1, "Missing file");
+    TEST_ASSERT_EQ(result->bad_files, 3, "Flipped, short and missing files");
+    TEST_ASSERT_EQ(result->corrupted, 1 + 1 + f3v_fstree_file_size(&shape, 42, 9),
+                   "One flipped byte, one missing byte and the missing file");
+    TEST_ASSERT_EQ(g_fs.count, 0, "Tree removed");
+
+    return 1;
+}
+
+/**
+ * FT004: Latency and Rates
+ * Percentiles and operations per second follow the operation costs
+ */
+static int test_fstree_latency(void)
+{
+    FsTreeShape shape = make_shape(4, 1, 10, 1, 100);
+
+    sim_init();
+    TEST_ASSERT_EQ(run_tree(&shape), 0, "Workload finishes");
+
+    for (uint32_t i = 0; i < FS_OP_COUNT; i++)
+    {
+        const FsOpStats *stats = &g_state.result.op[i];
+        uint32_t cost = g_fs.cost[i];
+
+        TEST_ASSERT(stats->lat_p50_us >= cost && stats->lat_p50_us <= cost + cost / 16,
+                    "Median within a histogram bucket of the cost");
+        TEST_ASSERT_EQ(stats->lat_max_us, cost, "Max is the cost");
+        TEST_ASSERT_EQ(stats->usec, (uint64_t)cost * stats->count, "Time adds up");
+        TEST_ASSERT_EQ(f3v_fstree_ops_per_sec(stats), 1000000 / cost, "Operations per second");
+    }
+    TEST_ASSERT_EQ(strcmp(f3v_fstree_op_name(FS_OP_RMDIR), "rmdir"), 0, "Operation name");
+
+    return 1;
+}
+
+/**
+ * FT005: Limits and Cancel
+ * Bad shapes are refused, a root that cannot be created ends the run and
+ * cleanup after a cancel removes a half-built tree
+ */
+static int test_fstree_limits(void)
+{
+    FsTreeShape shape = make_shape(2, 2, 3, 10, 20);
+    FsTreeShape bad;
+
+    bad = make_shape(0, 2, 3, 10, 20);
+    TEST_ASSERT(f3v_fstree_init(&g_state, &bad, "ux0:data/tree", 1) < 0, "Depth without fanout");
+    bad = make_shape(2, 2, 3, 20, 10);
+    TEST_ASSERT(f3v_fstree_init(&g_state, &bad, "ux0:data/tree", 1) < 0, "Empty size range");
+    bad = make_shape(2, 2, 3, 10, F3V_FSTREE_MAX_FILE + 1);
+    TEST_ASSERT(f3v_fstree_init(&g_state, &bad, "ux0:data/tree", 1) < 0, "File too big");
+    bad = make_shape(16, 3, 8, 10, 20);
+    TEST_ASSERT(f3v_fstree_init(&g_state, &bad, "ux0:data/tree", 1) < 0, "Too many files");
+
+    /* Flat tree: only the root */
+    bad = make_shape(0, 0, 3, 10, 20);
+    TEST_ASSERT_EQ(f3v_fstree_dirs(&bad), 1, "Root only");
+
+    sim_init();
+    sim_mkdir(NULL, "ux0:data/tree");
+    TEST_ASSERT(run_tree(&shape) < 0, "Root already taken");
+
+    sim_init();
+    TEST_ASSERT_EQ(f3v_fstree_init(&g_state, &shape, "ux0:data/tree", 3), 0, "Init");
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        f3v_fstree_step(&g_state, &g_dev, g_buf);
+    }
+    TEST_ASSERT(g_fs.count > 0, "Half-built tree");
+    f3v_fstree_cleanup(&g_state, &g_dev);
+    TEST_ASSERT_EQ(g_fs.count, 0, "Cleanup removes it");
+    TEST_ASSERT_EQ(f3v_fstree_step(&g_state, &g_dev, g_buf), 0, "Nothing left to do");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Small-File Workload Tests ===\n\n");
+
+    printf("--- f3v_fstree_step() Tests ---\n");
+    RUN_TEST(test_fstree_lifecycle);
+    RUN_TEST(test_fstree_sizes);
+    RUN_TEST(test_fstree_corruption);
+    RUN_TEST(test_fstree_latency);
+    RUN_TEST(test_fstree_limits);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,400 @@
+/**
+ * @file test_journal.c
+ * @brief Unit tests for the f3vita checkpoint journal
+ *
+ * Desktop-runnable tests; the journal writes to a simulated file system.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_journal test_journal.c ../src/journal.c ../src/pattern.c
+ * Run: ./test_journal
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "journal.h"
+#include "readback.h"
+#include "storage.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                 \
+    do                                                        \
+    {                                                         \
+        if ((actual) != (expected))                           \
+        {                                                     \
+            printf("  FAIL: %s (expected %u, got %u)\n", msg, \
+                   (unsigned)(expected), (unsigned)(actual)); \
+            g_tests_failed++;                                 \
+            return 0;                                         \
+        }                                                     \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * =============================================================================
+ * Simulated File System
+ * =============================================================================
+ */
+
+#define SIM_FILES 8
+#define SIM_FILE_MAX 4096
+
+typedef struct {
+    char path[128];
+    uint8_t data[SIM_FILE_MAX];
+    uint32_t size;
+    int used;
+} SimFile;
+
+static SimFile g_files[SIM_FILES];
+static uint32_t g_pos[SIM_FILES];
+
+static void sim_init(void)
+{
+    memset(g_files, 0, sizeof(g_files));
+}
+
+static int sim_find(const char *path)
+{
+    for (int i = 0; i < SIM_FILES; i++)
+    {
+        if (g_files[i].used && strcmp(g_files[i].path, path) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+char *f3v_get_test_filename(TestContext *ctx, uint32_t index, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "%s/%s%03u%s", ctx->test_dir, F3V_FILE_PREFIX, index, F3V_FILE_EXT);
+    return buf;
+}
+
+int f3v_open_write(const char *path)
+{
+    int i = sim_find(path);
+
+    for (int j = 0; i < 0 && j < SIM_FILES; j++)
+    {
+        if (!g_files[j].used)
+        {
+            i = j;
+        }
+    }
+    if (i < 0)
+    {
+        return -1;
+    }
+
+    g_files[i].used = 1;
+    g_files[i].size = 0;
+    snprintf(g_files[i].path, sizeof(g_files[i].path), "%s", path);
+    g_pos[i] = 0;
+    return i;
+}
+
+int f3v_open_read(const char *path)
+{
+    int i = sim_find(path);
+
+    if (i >= 0)
+    {
+        g_pos[i] = 0;
+    }
+    return i;
+}
+
+int f3v_write_block(int fd, const void *buf, size_t size)
+{
+    if (g_pos[fd] + size > SIM_FILE_MAX)
+    {
+        return -1;
+    }
+    memcpy(g_files[fd].data + g_pos[fd], buf, size);
+    g_pos[fd] += (uint32_t)size;
+    if (g_pos[fd] > g_files[fd].size)
+    {
+        g_files[fd].size = g_pos[fd];
+    }
+    return (int)size;
+}
+
+int f3v_read_block(int fd, void *buf, size_t size)
+{
+    uint32_t left = g_files[fd].size - g_pos[fd];
+    uint32_t len = size < left ? (uint32_t)size : left;
+
+    memcpy(buf, g_files[fd].data + g_pos[fd], len);
+    g_pos[fd] += len;
+    return (int)len;
+}
+
+int f3v_seek(int fd, uint64_t offset)
+{
+    g_pos[fd] = (uint32_t)offset;
+    return 0;
+}
+
+int f3v_sync(int fd)
+{
+    (void)fd;
+    return 0;
+}
+
+int f3v_close(int fd)
+{
+    (void)fd;
+    return 0;
+}
+
+int64_t f3v_get_file_size(const char *path)
+{
+    int i = sim_find(path);
+    return i >= 0 ? (int64_t)g_files[i].size : -1;
+}
+
+int f3v_remove(const char *path)
+{
+    int i = sim_find(path);
+
+    if (i < 0)
+    {
+        return -1;
+    }
+    g_files[i].used = 0;
+    return 0;
+}
+
+/**
+ * Stand-in for the read-back module: no reader thread runs here
+ */
+void f3v_readback_totals(const TestContext *ctx, ReadbackTotals *out)
+{
+    *out = ctx->raw;
+}
+
+/**
+ * A session part way through a per-file run that aborts after 16 MB bad
+ */
+static void sim_session(TestContext *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    snprintf(ctx->test_dir, sizeof(ctx->test_dir), "ux0:data/f3vita");
+    ctx->target.free_bytes = 8ULL * F3V_FILE_SIZE;
+    ctx->mode = MODE_FULL;
+    ctx->phase = PHASE_WRITE;
+    ctx->session_nonce = 0x1234;
+    ctx->files_written = 3;
+    ctx->bytes_written = 2ULL * F3V_FILE_SIZE + 256ULL * 1024 * 1024;
+    ctx->verify_order = ORDER_BLOCK_SHUFFLE;
+    ctx->verify_seed = 77;
+    ctx->readback = READBACK_FILE;
+    ctx->abort_policy = ABORT_BAD_MB;
+    ctx->abort_param = 16;
+}
+
+/**
+ * A session as the menu sets it up before the resume prompt
+ */
+static void sim_fresh(TestContext *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    snprintf(ctx->test_dir, sizeof(ctx->test_dir), "ux0:data/f3vita");
+    ctx->target.free_bytes = 5ULL * F3V_FILE_SIZE;
+    ctx->mode = MODE_FULL;
+    ctx->phase = PHASE_WRITE;
+    ctx->session_nonce = 0x9999;
+    ctx->readback = READBACK_OFF;
+    ctx->abort_policy = ABORT_NEVER;
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * JR001: Checkpoint Round Trip
+ * The newest of the two slots is loaded and restores the progress
+ */
+static int test_journal_round_trip(void)
+{
+    TestContext ctx, resumed;
+    JournalRecord rec;
+
+    sim_init();
+    sim_session(&ctx);
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "First checkpoint");
+    ctx.bytes_written += F3V_JOURNAL_INTERVAL;
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "Second checkpoint");
+    TEST_ASSERT_EQ(ctx.journal_seq, 2, "Sequence counted");
+
+    sim_fresh(&resumed);
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Checkpoint found");
+    TEST_ASSERT_EQ(rec.seq, 2, "Newest slot wins");
+    f3v_journal_apply(&resumed, &rec);
+    TEST_ASSERT(resumed.resumed, "Marked resumed");
+    TEST_ASSERT_EQ(resumed.session_nonce, 0x1234, "Nonce of the run");
+    TEST_ASSERT(resumed.bytes_written == ctx.bytes_written, "Bytes written");
+    TEST_ASSERT(resumed.last_checkpoint == ctx.bytes_written, "Checkpoint position");
+    TEST_ASSERT(resumed.total_expected == resumed.target.free_bytes + ctx.bytes_written,
+                "Expected size grows by what was written");
+
+    /* A damaged newest slot falls back to the other */
+    g_files[sim_find("ux0:data/f3vita/f3vita.journal.0")].data[40] ^= 1;
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Older checkpoint found");
+    TEST_ASSERT_EQ(rec.seq, 1, "Torn slot skipped");
+
+    f3v_journal_clear(&ctx);
+    TEST_ASSERT(f3v_journal_load(&resumed, &rec) < 0, "Cleared");
+
+    return 1;
+}
+
+/**
+ * JR002: Settings Kept on Resume
+ * The run's read-back schedule and abort policy replace the menu's
+ */
+static int test_journal_settings(void)
+{
+    TestContext ctx, resumed;
+    JournalRecord rec;
+
+    sim_init();
+    sim_session(&ctx);
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "Checkpoint");
+
+    sim_fresh(&resumed);
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Checkpoint found");
+    f3v_journal_apply(&resumed, &rec);
+    TEST_ASSERT_EQ(resumed.readback, READBACK_FILE, "Read-back schedule kept");
+    TEST_ASSERT_EQ(resumed.abort_policy, ABORT_BAD_MB, "Abort policy kept");
+    TEST_ASSERT_EQ(resumed.abort_param, 16, "Abort threshold kept");
+    TEST_ASSERT_EQ(resumed.pattern_variant, 0, "Pattern variant kept");
+
+    /* The verify order only carries over once verifying has started */
+    TEST_ASSERT_EQ(resumed.verify_order, ORDER_SEQUENTIAL, "Menu order for a writing run");
+    ctx.phase = PHASE_VERIFY;
+    ctx.bytes_verified = 3 * F3V_JOURNAL_INTERVAL;
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "Verify checkpoint");
+    sim_fresh(&resumed);
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Checkpoint found");
+    f3v_journal_apply(&resumed, &rec);
+    TEST_ASSERT_EQ(resumed.verify_order, ORDER_BLOCK_SHUFFLE, "Order kept while verifying");
+    TEST_ASSERT_EQ(resumed.verify_seed, 77, "Seed kept");
+
+    /* A record with an unknown schedule is not trusted */
+    ctx.readback = READBACK_COUNT;
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "Checkpoint");
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Earlier checkpoint found");
+    TEST_ASSERT_EQ(rec.readback, READBACK_FILE, "Invalid record skipped");
+
+    return 1;
+}
+
+/**
+ * JR003: Read-Back Findings Survive a Resume
+ * Corruption the per-file stream caught before the interruption is restored
+ */
+static int test_journal_readback(void)
+{
+    TestContext ctx, resumed;
+    JournalRecord rec;
+
+    sim_init();
+    sim_session(&ctx);
+    ctx.raw.verified = F3V_FILE_SIZE + 64ULL * 1024 * 1024;
+    ctx.raw.corrupted = 8192;
+    ctx.raw.has_error = 1;
+    ctx.raw.error_file = 2;
+    ctx.raw.error_block = 17;
+    ctx.raw.error_offset = 512;
+    ctx.raw.error_written = F3V_FILE_SIZE + 40ULL * 1024 * 1024;
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "Checkpoint");
+
+    sim_fresh(&resumed);
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Checkpoint found");
+    f3v_journal_apply(&resumed, &rec);
+    TEST_ASSERT(resumed.raw.verified == ctx.raw.verified, "Stream position restored");
+    TEST_ASSERT(resumed.raw.verified < resumed.bytes_written, "Gap left to read back");
+    TEST_ASSERT_EQ(resumed.raw.corrupted, 8192, "Stream corruption restored");
+    TEST_ASSERT(resumed.raw.has_error, "Stream error restored");
+    TEST_ASSERT_EQ(resumed.raw.error_file, 2, "Error file");
+    TEST_ASSERT_EQ(resumed.raw.error_block, 17, "Error block");
+    TEST_ASSERT_EQ(resumed.raw.error_offset, 512, "Error offset");
+    TEST_ASSERT(resumed.raw.error_written == ctx.raw.error_written, "Caught at");
+
+    /* A stream ahead of the writer cannot be right */
+    ctx.raw.verified = ctx.bytes_written + F3V_BLOCK_SIZE;
+    TEST_ASSERT_EQ(f3v_journal_save(&ctx), 0, "Checkpoint");
+    TEST_ASSERT_EQ(f3v_journal_load(&resumed, &rec), 0, "Earlier checkpoint found");
+    TEST_ASSERT_EQ(rec.seq, 1, "Invalid record skipped");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Journal Module Tests ===\n");
+    printf("Record size: %u bytes\n\n", (unsigned)sizeof(JournalRecord));
+
+    printf("--- f3v_journal_save() / f3v_journal_apply() Tests ---\n");
+    RUN_TEST(test_journal_round_trip);
+    RUN_TEST(test_journal_settings);
+    RUN_TEST(test_journal_readback);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file test_order.c
+ * @brief Unit tests for f3vita verify orders
+ *
+ * Desktop-runnable tests for the seeded permutation and block orders.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_order test_order.c ../src/order.c
+ * Run: ./test_order
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "order.h"
+
+/* Largest block count exercised (a bit over four files) */
+#define MAX_BLOCKS (4 * F3V_BLOCKS_PER_FILE + 300)
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/* Visit counts per block */
+static uint8_t g_seen[MAX_BLOCKS];
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                      \
+    do                                                             \
+    {                                                              \
+        if ((actual) != (expected))                                \
+        {                                                          \
+            printf("  FAIL: %s (expected %llu, got %llu)\n", msg,  \
+                   (unsigned long long)(expected),                 \
+                   (unsigned long long)(actual));                  \
+            g_tests_failed++;                                      \
+            return 0;                                              \
+        }                                                          \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * Helper: walk an order and check every block is visited exactly once
+ * @return Number of blocks visited, or 0 on a repeat or out-of-range block
+ */
+static uint64_t walk_order(VerifyOrder order, uint32_t seed, uint64_t blocks)
+{
+    uint64_t slots = f3v_order_slots(order, blocks);
+    uint64_t visited = 0;
+
+    memset(g_seen, 0, sizeof(g_seen));
+    for (uint64_t i = 0; i < slots; i++)
+    {
+        uint64_t block;
+        if (!f3v_order_block(order, seed, i, blocks, &block))
+        {
+            continue;
+        }
+        if (block >= blocks || g_seen[block])
+        {
+            return 0;
+        }
+        g_seen[block] = 1;
+        visited++;
+    }
+    return visited;
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * OR001: Permutation Is a Bijection
+ * Every value in range appears exactly once, for awkward sizes too
+ */
+static int test_permute_bijection(void)
+{
+    static const uint64_t counts[] = {1, 2, 3, 5, 1000, 4096, 4097, MAX_BLOCKS};
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        memset(g_seen, 0, sizeof(g_seen));
+        for (uint64_t i = 0; i < counts[c]; i++)
+        {
+            uint64_t v = f3v_permute(i, counts[c], 0x1234);
+            TEST_ASSERT(v < counts[c], "Value out of range");
+            TEST_ASSERT(!g_seen[v], "Value repeated");
+            g_seen[v] = 1;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * OR002: Seeded
+ * The same seed repeats the order; another seed gives a different one
+ */
+static int test_permute_seeded(void)
+{
+    int same = 1, differs = 0;
+
+    for (uint64_t i = 0; i < 1000; i++)
+    {
+        same &= f3v_permute(i, 1000, 7) == f3v_permute(i, 1000, 7);
+        differs |= f3v_permute(i, 1000, 7) != f3v_permute(i, 1000, 8);
+    }
+    TEST_ASSERT(same, "Same seed should give the same order");
+    TEST_ASSERT(differs, "Different seeds should give different orders");
+
+    return 1;
+}
+
+/**
+ * OR003: Shuffled
+ * Few consecutive positions land on consecutive blocks
+ */
+static int test_permute_scatters(void)
+{
+    uint32_t adjacent = 0;
+
+    for (uint64_t i = 0; i + 1 < 10000; i++)
+    {
+        if (f3v_permute(i + 1, 10000, 42) == f3v_permute(i, 10000, 42) + 1)
+        {
+            adjacent++;
+        }
+    }
+    TEST_ASSERT(adjacent < 50, "Permutation should scatter neighbouring positions");
+
+    return 1;
+}
+
+/**
+ * OR004: Sequential and Reverse
+ */
+static int test_order_sequential_reverse(void)
+{
+    uint64_t block;
+
+    TEST_ASSERT(f3v_order_block(ORDER_SEQUENTIAL, 0, 5, 100, &block), "Slot should hold a block");
+    TEST_ASSERT_EQ(block, 5, "Sequential maps position to block");
+    TEST_ASSERT(f3v_order_block(ORDER_REVERSE, 0, 0, 100, &block), "Slot should hold a block");
+    TEST_ASSERT_EQ(block, 99, "Reverse starts at the last block");
+    TEST_ASSERT_EQ(walk_order(ORDER_REVERSE, 0, 100), 100, "Reverse visits every block once");
+
+    return 1;
+}
+
+/**
+ * OR005: File Shuffle
+ * Files in random order, blocks of each file in order, short last file
+ */
+static int test_order_file_shuffle(void)
+{
+    uint64_t blocks = MAX_BLOCKS;
+    uint64_t first;
+
+    TEST_ASSERT_EQ(f3v_order_slots(ORDER_FILE_SHUFFLE, blocks), 5ULL * F3V_BLOCKS_PER_FILE,
+                   "Every file gets a full set of positions");
+    TEST_ASSERT_EQ(walk_order(ORDER_FILE_SHUFFLE, 99, blocks), blocks,
+                   "File shuffle visits every block once");
+
+    for (uint64_t f = 0; f < 5; f++)
+    {
+        uint64_t base = f * F3V_BLOCKS_PER_FILE, block;
+        int present = f3v_order_block(ORDER_FILE_SHUFFLE, 99, base, blocks, &first);
+        TEST_ASSERT(present && first % F3V_BLOCKS_PER_FILE == 0, "Each file starts at block 0");
+
+        f3v_order_block(ORDER_FILE_SHUFFLE, 99, base + 1, blocks, &block);
+        TEST_ASSERT_EQ(block, first + 1, "Blocks within a file stay in order");
+    }
+
+    return 1;
+}
+
+/**
+ * OR006: Block Shuffle Across Files
+ */
+static int test_order_block_shuffle(void)
+{
+    TEST_ASSERT_EQ(f3v_order_slots(ORDER_BLOCK_SHUFFLE, MAX_BLOCKS), MAX_BLOCKS,
+                   "One position per block");
+    TEST_ASSERT_EQ(walk_order(ORDER_BLOCK_SHUFFLE, 3, MAX_BLOCKS), MAX_BLOCKS,
+                   "Block shuffle visits every block once");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Order Module Tests ===\n\n");
+
+    printf("--- f3v_permute() Tests ---\n");
+    RUN_TEST(test_permute_bijection);
+    RUN_TEST(test_permute_seeded);
+    RUN_TEST(test_permute_scatters);
+
+    printf("\n--- f3v_order_block() Tests ---\n");
+    RUN_TEST(test_order_sequential_reverse);
+    RUN_TEST(test_order_file_shuffle);
+    RUN_TEST(test_order_block_shuffle);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
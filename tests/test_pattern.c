@@ -452,6 +452,380 @@ static int test_verify_wrong_block_index(void)
     return 1;
 }
 
+/*
+ * =============================================================================
+ * Test Cases for f3v_verify_pattern_range()
+ * =============================================================================
+ */
+
+/**
+ * VR001: Range Matches Full Block
+ * Verifying a block in slices finds the same errors as a full verify
+ */
+static int test_range_matches_full(void)
+{
+    uint32_t total = 0;
+
+    f3v_fill_pattern(g_buf1, 4, 9);
+    g_buf1[12345] = ~g_buf1[12345];
+    g_buf1[700000] = ~g_buf1[700000];
+
+    /* Odd-sized slices so boundaries do not fall on 4-byte lanes */
+    for (uint32_t off = 0; off < F3V_BLOCK_SIZE; off += 65537)
+    {
+        uint32_t len = F3V_BLOCK_SIZE - off;
+        if (len > 65537)
+            len = 65537;
+        total += f3v_verify_pattern_range(g_buf1 + off, 4, 9, off, len, NULL);
+    }
+
+    TEST_ASSERT_EQ(total, 2, "Sliced verify should find both corrupted bytes");
+
+    return 1;
+}
+
+/**
+ * VR002: Range First Error Offset
+ * first_error_offset is reported relative to the block, not the slice
+ */
+static int test_range_first_error_offset(void)
+{
+    uint32_t first_offset = 0;
+
+    f3v_fill_pattern(g_buf1, 2, 3);
+    g_buf1[5003] = ~g_buf1[5003];
+
+    uint32_t corrupted = f3v_verify_pattern_range(g_buf1 + 4096, 2, 3, 4096, 4096,
+                                                  &first_offset);
+
+    TEST_ASSERT_EQ(corrupted, 1, "Slice should contain one corrupted byte");
+    TEST_ASSERT_EQ(first_offset, 5003, "First error offset should be block-relative");
+
+    return 1;
+}
+
+/**
+ * VR003: Short Tail
+ * A partial tail slice verifies clean and ignores bytes past its length
+ */
+static int test_range_short_tail(void)
+{
+    f3v_fill_pattern(g_buf1, 1, 0);
+    g_buf1[1000] = ~g_buf1[1000]; /* Outside the verified range */
+
+    uint32_t corrupted = f3v_verify_pattern_range(g_buf1, 1, 0, 0, 1000, NULL);
+
+    TEST_ASSERT_EQ(corrupted, 0, "Bytes past len should not be checked");
+
+    return 1;
+}
+
+/**
+ * VR004: File Range Across Blocks
+ * An unaligned range spanning a block boundary matches both blocks
+ */
+static int test_range_file_across_blocks(void)
+{
+    uint64_t offset = 3ULL * F3V_BLOCK_SIZE - 4095;
+    uint32_t len = 10001;
+
+    f3v_fill_file_range(g_buf1, 5, offset, len);
+    f3v_fill_pattern(g_buf2, 5, 2);
+    TEST_ASSERT(memcmp(g_buf1, g_buf2 + F3V_BLOCK_SIZE - 4095, 4095) == 0,
+                "Head should match the end of block 2");
+    f3v_fill_pattern(g_buf2, 5, 3);
+    TEST_ASSERT(memcmp(g_buf1 + 4095, g_buf2, len - 4095) == 0,
+                "Tail should match the start of block 3");
+
+    TEST_ASSERT_EQ(f3v_verify_file_range(g_buf1, 5, offset, len), 0, "Range should verify");
+    g_buf1[4094] = ~g_buf1[4094];
+    g_buf1[4095] = ~g_buf1[4095];
+    TEST_ASSERT_EQ(f3v_verify_file_range(g_buf1, 5, offset, len), 2,
+                   "Errors on both sides of the boundary should count");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Test Cases for f3v_identify_pattern()
+ * =============================================================================
+ */
+
+/**
+ * ID001: Identify Own Block
+ * An intact block identifies as a location with the same pattern
+ */
+static int test_identify_intact(void)
+{
+    uint32_t file = 0, block = 0;
+
+    f3v_fill_pattern(g_buf1, 7, 42);
+
+    TEST_ASSERT_EQ(f3v_identify_pattern(g_buf1, 255, &file, &block), 1,
+                   "Intact block should be identified");
+    TEST_ASSERT_EQ(file, 7, "File index should be recovered");
+    TEST_ASSERT_EQ(block, 42, "Block index should be recovered");
+
+    return 1;
+}
+
+/**
+ * ID002: Identify High Block Index
+ * Block index bits 8-9 are recovered alongside the file index
+ */
+static int test_identify_high_block(void)
+{
+    uint32_t file = 0, block = 0;
+
+    f3v_fill_pattern(g_buf1, 3, 1000);
+
+    /* (3, 1000) shares its base with (0, 1000 - 768): file 0 is out of range */
+    TEST_ASSERT_EQ(f3v_identify_pattern(g_buf1, 255, &file, &block), 1,
+                   "High block index should be identified");
+    f3v_fill_pattern(g_buf2, file, block);
+    TEST_ASSERT(buffers_equal(g_buf1, g_buf2, F3V_BLOCK_SIZE),
+                "Identified location should produce identical data");
+    TEST_ASSERT(file >= 1, "Identified file index should be in range");
+
+    return 1;
+}
+
+/**
+ * ID003: Reject Corrupted Block
+ * A block with a flipped byte is not an intact pattern
+ */
+static int test_identify_corrupted(void)
+{
+    uint32_t file = 0, block = 0;
+
+    f3v_fill_pattern(g_buf1, 2, 5);
+    g_buf1[300000] ^= 0x10;
+
+    TEST_ASSERT_EQ(f3v_identify_pattern(g_buf1, 255, &file, &block), 0,
+                   "Corrupted block should not be identified");
+
+    memset(g_buf1, 0xFF, F3V_BLOCK_SIZE);
+    TEST_ASSERT_EQ(f3v_identify_pattern(g_buf1, 255, &file, &block), 0,
+                   "Erased block should not be identified");
+
+    return 1;
+}
+
+/**
+ * ID004: Aliased Block
+ * Data written for one location and read back at another is identified
+ * as the original location
+ */
+static int test_identify_aliased(void)
+{
+    uint32_t file = 0, block = 0;
+
+    /* Block 10 of file 4 landed where block 10 of file 1 should be */
+    f3v_fill_pattern(g_buf1, 4, 10);
+
+    TEST_ASSERT(f3v_verify_pattern(g_buf1, 1, 10, NULL) > 0,
+                "Aliased block should fail verification");
+    TEST_ASSERT_EQ(f3v_identify_pattern(g_buf1, 8, &file, &block), 1,
+                   "Aliased block should be identified");
+    TEST_ASSERT_EQ(file, 4, "Source file should be recovered");
+    TEST_ASSERT_EQ(block, 10, "Source block should be recovered");
+
+    return 1;
+}
+
+/**
+ * PV001: Variant 0 Is the Normal Pattern
+ */
+static int test_variant_zero(void)
+{
+    f3v_fill_pattern(g_buf1, 6, 123);
+    f3v_fill_variant_range(g_buf2, 6, 123, 0, 0, F3V_BLOCK_SIZE);
+
+    TEST_ASSERT(buffers_equal(g_buf1, g_buf2, F3V_BLOCK_SIZE),
+                "Variant 0 should match f3v_fill_pattern");
+
+    return 1;
+}
+
+/**
+ * PV002: Alternating Variants Flip Every Bit
+ * Each odd variant is the bitwise inverse of the one before it
+ */
+static int test_variant_inverted(void)
+{
+    for (uint32_t v = 0; v < 6; v += 2)
+    {
+        f3v_fill_variant_range(g_buf1, 2, 9, v, 0, F3V_BLOCK_SIZE);
+        f3v_fill_variant_range(g_buf2, 2, 9, v + 1, 0, F3V_BLOCK_SIZE);
+
+        for (uint32_t i = 0; i < F3V_BLOCK_SIZE; i++)
+        {
+            TEST_ASSERT((uint8_t)(g_buf1[i] ^ g_buf2[i]) == 0xFF, "Odd variant should invert every bit");
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * PV003: Variants Verify Only Against Themselves
+ */
+static int test_variant_verify(void)
+{
+    uint32_t first_offset = 0;
+
+    f3v_fill_variant_range(g_buf1, 3, 400, 2, 0, F3V_BLOCK_SIZE);
+
+    TEST_ASSERT_EQ(f3v_verify_variant_range(g_buf1, 3, 400, 2, 0, F3V_BLOCK_SIZE, NULL), 0,
+                   "Block should verify against its own variant");
+    TEST_ASSERT(f3v_verify_pattern(g_buf1, 3, 400, NULL) > F3V_BLOCK_SIZE / 2,
+                "Shifted-seed variant should not pass as the normal pattern");
+    TEST_ASSERT(f3v_verify_variant_range(g_buf1, 3, 400, 4, 0, F3V_BLOCK_SIZE, NULL) >
+                    F3V_BLOCK_SIZE / 2,
+                "Different seeds should not match each other");
+
+    g_buf1[777] ^= 0x01;
+    TEST_ASSERT_EQ(f3v_verify_variant_range(g_buf1, 3, 400, 2, 0, F3V_BLOCK_SIZE,
+                                            &first_offset), 1,
+                   "Flipped byte should be detected");
+    TEST_ASSERT_EQ(first_offset, 777, "First error offset");
+
+    return 1;
+}
+
+/**
+ * PV004: Identify Variant Block
+ * Aliasing detection works for every variant
+ */
+static int test_variant_identify(void)
+{
+    uint32_t file = 0, block = 0;
+
+    for (uint32_t v = 1; v < 6; v++)
+    {
+        f3v_fill_variant_range(g_buf1, 5, 17, v, 0, F3V_BLOCK_SIZE);
+
+        TEST_ASSERT_EQ(f3v_identify_variant(g_buf1, v, 8, &file, &block), 1,
+                       "Variant block should be identified");
+        TEST_ASSERT_EQ(file, 5, "File index should be recovered");
+        TEST_ASSERT_EQ(block, 17, "Block index should be recovered");
+    }
+
+    return 1;
+}
+
+/**
+ * NZ001: Noise Slices Match the Whole Block
+ * Ranges at any offset produce the bytes of a whole-block fill
+ */
+static int test_noise_ranges(void)
+{
+    static const uint32_t cuts[] = {0, 1, 3, 4, 7, 4096, 65537, F3V_BLOCK_SIZE - 5, F3V_BLOCK_SIZE};
+
+    f3v_fill_noise_range(g_buf1, 1234, 3, 9, 0, F3V_BLOCK_SIZE);
+    memset(g_buf2, 0, F3V_BLOCK_SIZE);
+    for (uint32_t i = 0; i + 1 < sizeof(cuts) / sizeof(cuts[0]); i++)
+    {
+        f3v_fill_noise_range(g_buf2 + cuts[i], 1234, 3, 9, cuts[i], cuts[i + 1] - cuts[i]);
+    }
+
+    TEST_ASSERT(buffers_equal(g_buf1, g_buf2, F3V_BLOCK_SIZE), "Slices should match the block");
+    TEST_ASSERT_EQ(f3v_verify_noise_range(g_buf1 + 5, 1234, 3, 9, 5, 1000, NULL), 0,
+                   "Unaligned range should verify");
+
+    return 1;
+}
+
+/**
+ * NZ002: Noise Differs by Seed and Location
+ * Every seed and block gets its own data, and it does not repeat the
+ * test pattern
+ */
+static int test_noise_distinct(void)
+{
+    uint32_t first = 0;
+
+    f3v_fill_noise_range(g_buf1, 1234, 3, 9, 0, F3V_BLOCK_SIZE);
+
+    TEST_ASSERT(f3v_verify_noise_range(g_buf1, 1235, 3, 9, 0, F3V_BLOCK_SIZE, NULL) >
+                    F3V_BLOCK_SIZE / 2,
+                "Another seed should not verify");
+    TEST_ASSERT(f3v_verify_noise_range(g_buf1, 1234, 4, 9, 0, F3V_BLOCK_SIZE, NULL) >
+                    F3V_BLOCK_SIZE / 2,
+                "Another file should not verify");
+    TEST_ASSERT(f3v_verify_noise_range(g_buf1, 1234, 3, 10, 0, F3V_BLOCK_SIZE, NULL) >
+                    F3V_BLOCK_SIZE / 2,
+                "Another block should not verify");
+    TEST_ASSERT(f3v_verify_pattern(g_buf1, 3, 9, NULL) > F3V_BLOCK_SIZE / 2,
+                "Noise should not look like the pattern");
+
+    g_buf1[777] ^= 0x20;
+    TEST_ASSERT_EQ(f3v_verify_noise_range(g_buf1, 1234, 3, 9, 0, F3V_BLOCK_SIZE, &first), 1,
+                   "Flipped byte should be counted");
+    TEST_ASSERT_EQ(first, 777, "First error offset");
+
+    return 1;
+}
+
+/**
+ * VT001: Vote Agreement
+ * Three identical reads pass through with no unstable bytes
+ */
+static int test_vote_agreement(void)
+{
+    f3v_fill_pattern(g_buf1, 1, 3);
+    memcpy(g_buf2, g_buf1, F3V_BLOCK_SIZE);
+
+    TEST_ASSERT_EQ(f3v_vote_bytes(g_buf2, g_buf1, g_buf1, g_buf1, F3V_BLOCK_SIZE), 0,
+                   "Identical reads should have no unstable bytes");
+    TEST_ASSERT(buffers_equal(g_buf1, g_buf2, F3V_BLOCK_SIZE), "Output should match the reads");
+
+    return 1;
+}
+
+/**
+ * VT002: Vote Majority
+ * A byte wrong in any single read is outvoted by the other two
+ */
+static int test_vote_majority(void)
+{
+    uint8_t a[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t b[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t c[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t out[8];
+
+    a[1] = 0xAA;
+    b[4] = 0xBB;
+    c[6] = 0xCC;
+
+    TEST_ASSERT_EQ(f3v_vote_bytes(out, a, b, c, 8), 3, "Three bytes should be unstable");
+    for (int i = 0; i < 8; i++)
+    {
+        TEST_ASSERT_EQ(out[i], i + 1, "Majority value should win");
+    }
+
+    return 1;
+}
+
+/**
+ * VT003: Vote Without Majority, In Place
+ * All three reads differ: the first read's value is kept; out may alias a
+ */
+static int test_vote_no_majority(void)
+{
+    uint8_t a[4] = {10, 20, 30, 40};
+    uint8_t b[4] = {10, 21, 30, 40};
+    uint8_t c[4] = {10, 22, 31, 41};
+
+    TEST_ASSERT_EQ(f3v_vote_bytes(a, a, b, c, 4), 3, "Three bytes should be unstable");
+    TEST_ASSERT_EQ(a[1], 20, "No majority keeps the first read");
+    TEST_ASSERT_EQ(a[2], 30, "Two of three agreeing wins");
+    TEST_ASSERT_EQ(a[3], 40, "Two of three agreeing wins");
+
+    return 1;
+}
+
 /*
  * =============================================================================
  * Main Test Runner
@@ -484,6 +858,33 @@ int main(void)
     RUN_TEST(test_verify_wrong_file_index);
     RUN_TEST(test_verify_wrong_block_index);
 
+    printf("\n--- f3v_verify_pattern_range() Tests ---\n");
+    RUN_TEST(test_range_matches_full);
+    RUN_TEST(test_range_first_error_offset);
+    RUN_TEST(test_range_short_tail);
+    RUN_TEST(test_range_file_across_blocks);
+
+    printf("\n--- f3v_identify_pattern() Tests ---\n");
+    RUN_TEST(test_identify_intact);
+    RUN_TEST(test_identify_high_block);
+    RUN_TEST(test_identify_corrupted);
+    RUN_TEST(test_identify_aliased);
+
+    printf("\n--- Pattern Variant Tests ---\n");
+    RUN_TEST(test_variant_zero);
+    RUN_TEST(test_variant_inverted);
+    RUN_TEST(test_variant_verify);
+    RUN_TEST(test_variant_identify);
+
+    printf("\n--- Noise Tests ---\n");
+    RUN_TEST(test_noise_ranges);
+    RUN_TEST(test_noise_distinct);
+
+    printf("\n--- f3v_vote_bytes() Tests ---\n");
+    RUN_TEST(test_vote_agreement);
+    RUN_TEST(test_vote_majority);
+    RUN_TEST(test_vote_no_majority);
+
     /* Summary */
     printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
 
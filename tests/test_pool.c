@@ -0,0 +1,325 @@
+/**
+ * @file test_pool.c
+ * @brief Unit tests for f3vita stripe-parallel pattern pool
+ *
+ * Desktop-runnable tests; the pool runs on pthreads on the host.
+ * Compile: gcc -Wall -Wextra -std=c99 -pthread -I../include -o test_pool test_pool.c ../src/pool.c ../src/pattern.c ../src/thread.c ../src/digest.c
+ * Run: ./test_pool
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "digest.h"
+#include "pattern.h"
+#include "pool.h"
+#include "thread.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Static buffers for testing (1MB each to match F3V_BLOCK_SIZE)
+ */
+static uint8_t g_buf1[F3V_BLOCK_SIZE];
+static uint8_t g_buf2[F3V_BLOCK_SIZE];
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                 \
+    do                                                        \
+    {                                                         \
+        if ((actual) != (expected))                           \
+        {                                                     \
+            printf("  FAIL: %s (expected %u, got %u)\n", msg, \
+                   (unsigned)(expected), (unsigned)(actual)); \
+            g_tests_failed++;                                 \
+            return 0;                                         \
+        }                                                     \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * PL001: Parallel Fill Matches Serial Fill
+ */
+static int test_pool_fill_matches(void)
+{
+    f3v_fill_pattern(g_buf1, 7, 300);
+    memset(g_buf2, 0, F3V_BLOCK_SIZE);
+    f3v_pool_fill(g_buf2, 7, 300);
+
+    TEST_ASSERT(memcmp(g_buf1, g_buf2, F3V_BLOCK_SIZE) == 0,
+                "Pool fill should produce the serial pattern");
+
+    return 1;
+}
+
+/**
+ * PL002: Parallel Verify Counts Every Error
+ * Errors spread over several stripes are all counted
+ */
+static int test_pool_verify_counts(void)
+{
+    uint32_t first_offset = 0;
+
+    f3v_pool_fill(g_buf1, 1, 2);
+    g_buf1[3] ^= 0x01;
+    g_buf1[F3V_STRIPE_SIZE * 5 + 17] ^= 0x80;
+    g_buf1[F3V_BLOCK_SIZE - 1] ^= 0xFF;
+
+    uint32_t corrupted = f3v_pool_verify(g_buf1, 1, 2, &first_offset);
+
+    TEST_ASSERT_EQ(corrupted, 3, "Pool verify should count all corrupted bytes");
+    TEST_ASSERT_EQ(first_offset, 3, "First error should be the lowest offset");
+
+    return 1;
+}
+
+/**
+ * PL003: Deterministic First Error
+ * Earliest error wins even when it sits in a later-claimed stripe
+ */
+static int test_pool_first_error_deterministic(void)
+{
+    f3v_pool_fill(g_buf1, 3, 4);
+    g_buf1[F3V_STRIPE_SIZE * 9 + 1] ^= 0x10;
+    g_buf1[F3V_STRIPE_SIZE * 12] ^= 0x10;
+
+    for (int run = 0; run < 50; run++)
+    {
+        uint32_t first_offset = 0;
+        uint32_t corrupted = f3v_pool_verify(g_buf1, 3, 4, &first_offset);
+
+        TEST_ASSERT_EQ(corrupted, 2, "Corruption count should be stable");
+        TEST_ASSERT_EQ(first_offset, F3V_STRIPE_SIZE * 9 + 1,
+                       "First error should not depend on thread timing");
+    }
+
+    return 1;
+}
+
+/**
+ * PL004: Null Offset Pointer
+ */
+static int test_pool_verify_null_offset(void)
+{
+    f3v_pool_fill(g_buf1, 1, 0);
+    g_buf1[100] ^= 0x01;
+
+    TEST_ASSERT_EQ(f3v_pool_verify(g_buf1, 1, 0, NULL), 1,
+                   "NULL offset pointer should be accepted");
+
+    return 1;
+}
+
+/* Concurrent submitter state for PL005 */
+typedef struct {
+    uint8_t *buf;
+    uint32_t block_idx;
+    int failures;
+} Submitter;
+
+/**
+ * PL006: Pattern Variants
+ * Variant fill and verify match the serial variant functions
+ */
+static int test_pool_variant(void)
+{
+    uint32_t first_offset = 0;
+
+    f3v_fill_variant_range(g_buf1, 4, 77, 3, 0, F3V_BLOCK_SIZE);
+    memset(g_buf2, 0, F3V_BLOCK_SIZE);
+    f3v_pool_fill_variant(g_buf2, 4, 77, 3);
+
+    TEST_ASSERT(memcmp(g_buf1, g_buf2, F3V_BLOCK_SIZE) == 0,
+                "Pool variant fill should produce the serial pattern");
+    TEST_ASSERT_EQ(f3v_pool_verify_variant(g_buf2, 4, 77, 3, NULL), 0,
+                   "Variant block should verify against its own variant");
+
+    g_buf2[F3V_STRIPE_SIZE * 9 + 5] ^= 0x04;
+    TEST_ASSERT_EQ(f3v_pool_verify_variant(g_buf2, 4, 77, 3, &first_offset), 1,
+                   "One flipped byte should be counted");
+    TEST_ASSERT_EQ(first_offset, F3V_STRIPE_SIZE * 9 + 5, "First error offset");
+
+    return 1;
+}
+
+/**
+ * PL007: Noise
+ * Noise fill and verify match the serial noise functions
+ */
+static int test_pool_noise(void)
+{
+    uint32_t first_offset = 0;
+
+    f3v_fill_noise_range(g_buf1, 0xC0FFEE, 2, 300, 0, F3V_BLOCK_SIZE);
+    memset(g_buf2, 0, F3V_BLOCK_SIZE);
+    f3v_pool_fill_noise(g_buf2, 0xC0FFEE, 2, 300);
+
+    TEST_ASSERT(memcmp(g_buf1, g_buf2, F3V_BLOCK_SIZE) == 0,
+                "Pool noise fill should produce the serial noise");
+    TEST_ASSERT_EQ(f3v_pool_verify_noise(g_buf2, 0xC0FFEE, 2, 300, NULL), 0,
+                   "Noise block should verify against its seed");
+
+    g_buf2[F3V_STRIPE_SIZE * 3 + 1] ^= 0x80;
+    g_buf2[F3V_STRIPE_SIZE * 12] ^= 0x01;
+    TEST_ASSERT_EQ(f3v_pool_verify_noise(g_buf2, 0xC0FFEE, 2, 300, &first_offset), 2,
+                   "Two flipped bytes should be counted");
+    TEST_ASSERT_EQ(first_offset, F3V_STRIPE_SIZE * 3 + 1, "First error offset");
+
+    return 1;
+}
+
+/**
+ * PL008: Hash Leaves
+ * Parallel leaf digests match the serial ones, short blocks included
+ */
+static int test_pool_hash(void)
+{
+    static const uint32_t lens[] = {F3V_BLOCK_SIZE, F3V_BLOCK_SIZE - 1, F3V_STRIPE_SIZE * 5 + 7,
+                                    F3V_STRIPE_SIZE + 1, 100};
+    uint64_t serial[F3V_DIGEST_LEAVES], pooled[F3V_DIGEST_LEAVES];
+
+    f3v_fill_noise_range(g_buf1, 77, 1, 2, 0, F3V_BLOCK_SIZE);
+    for (uint32_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+        uint32_t count = f3v_digest_leaves(g_buf1, lens[i], 48, serial);
+
+        memset(pooled, 0, sizeof(pooled));
+        TEST_ASSERT_EQ(f3v_pool_hash(g_buf1, lens[i], 48, pooled), count, "Leaf count");
+        TEST_ASSERT(memcmp(serial, pooled, count * sizeof(uint64_t)) == 0,
+                    "Pool leaves should match the serial leaves");
+    }
+
+    return 1;
+}
+
+static int submitter_main(void *arg)
+{
+    Submitter *sub = (Submitter *)arg;
+
+    for (int i = 0; i < 20; i++)
+    {
+        uint32_t first = 0;
+        f3v_pool_fill(sub->buf, 9, sub->block_idx);
+        sub->buf[sub->block_idx] ^= 0x01;
+
+        if (f3v_pool_verify(sub->buf, 9, sub->block_idx, &first) != 1 || first != sub->block_idx)
+        {
+            sub->failures++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * PL005: Concurrent Submitters
+ * Several threads (like the engine workers) share the pool safely
+ */
+static int test_pool_concurrent_submitters(void)
+{
+    static uint8_t bufs[3][F3V_BLOCK_SIZE];
+    Submitter subs[3];
+    F3vThread threads[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        subs[i].buf = bufs[i];
+        subs[i].block_idx = (uint32_t)(i * 1000 + 5);
+        subs[i].failures = 0;
+        TEST_ASSERT(f3v_thread_create(&threads[i], "submitter", submitter_main, &subs[i]) == 0,
+                    "Submitter thread should start");
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        f3v_thread_join(&threads[i]);
+        TEST_ASSERT_EQ(subs[i].failures, 0, "Every submitter should see its own result");
+    }
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Pool Module Tests ===\n");
+    printf("Stripe size: %d bytes, %d stripes per block\n", F3V_STRIPE_SIZE, F3V_POOL_STRIPES);
+
+    for (int threads = 1; threads <= 4; threads *= 2)
+    {
+        if (f3v_pool_init(threads) < 0)
+        {
+            printf("FAILED: pool init with %d thread(s)\n", threads);
+            return 1;
+        }
+
+        printf("\n--- %d thread(s) ---\n", f3v_pool_threads());
+        RUN_TEST(test_pool_fill_matches);
+        RUN_TEST(test_pool_verify_counts);
+        RUN_TEST(test_pool_first_error_deterministic);
+        RUN_TEST(test_pool_verify_null_offset);
+        RUN_TEST(test_pool_concurrent_submitters);
+        RUN_TEST(test_pool_variant);
+        RUN_TEST(test_pool_noise);
+        RUN_TEST(test_pool_hash);
+
+        f3v_pool_shutdown();
+    }
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,763 @@
+/**
+ * @file test_rotscan.c
+ * @brief Unit tests for f3vita content digests, bit-rot and surface scans
+ *
+ * Desktop-runnable tests that check the hash against reference XXH64
+ * values and run scans against a simulated file system.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -pthread -o test_rotscan test_rotscan.c ../src/rotscan.c ../src/stats.c ../src/digest.c ../src/pool.c ../src/thread.c ../src/profile.c ../src/pattern.c -lm
+ * Run: ./test_rotscan
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rotscan.h"
+#include "pool.h"
+
+/* Most directories open at once */
+#define SIM_MAX_DIRS 8
+
+/* Open directory handles */
+#define SIM_FS_EXTRA                         \
+    char dir_path[SIM_MAX_DIRS][192];        \
+    uint32_t dir_next[SIM_MAX_DIRS];         \
+    int dir_used[SIM_MAX_DIRS];              \
+    uint32_t dirs_open;
+
+#include "sim_fs.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                      \
+    do                                                             \
+    {                                                              \
+        if ((actual) != (expected))                                \
+        {                                                          \
+            printf("  FAIL: %s (expected %llu, got %llu)\n", msg,  \
+                   (unsigned long long)(expected),                 \
+                   (unsigned long long)(actual));                  \
+            g_tests_failed++;                                      \
+            return 0;                                              \
+        }                                                          \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * Simulated file system
+ *
+ * A directory lists the entries whose path is its own plus "/" and one more
+ * name. Files carry a modification time set by the test.
+ */
+static struct RotScanState g_state;
+
+/**
+ * Helper: add or replace a file with generated contents
+ */
+static void sim_file(const char *path, uint32_t size, uint32_t seed, uint64_t mtime)
+{
+    int i = sim_find(path);
+    if (i < 0)
+    {
+        i = (int)g_fs.count++;
+    }
+    else
+    {
+        free(g_fs.entry[i].data);
+    }
+
+    SimEntry *e = &g_fs.entry[i];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->data = malloc(size > 0 ? size : 1);
+    for (uint32_t b = 0; b < size; b++)
+    {
+        e->data[b] = (uint8_t)((b * 31 + seed * 7 + (b >> 11)) & 0xFF);
+    }
+    e->size = size;
+    e->mtime = mtime;
+}
+
+static void sim_dir(const char *path)
+{
+    SimEntry *e = &g_fs.entry[g_fs.count++];
+
+    memset(e, 0, sizeof(*e));
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->is_dir = 1;
+}
+
+static int sim_dir_open(void *handle, const char *path)
+{
+    (void)handle;
+    int i = sim_find(path);
+    if (i < 0 || !g_fs.entry[i].is_dir)
+    {
+        return -1;
+    }
+    for (int d = 0; d < SIM_MAX_DIRS; d++)
+    {
+        if (!g_fs.dir_used[d])
+        {
+            g_fs.dir_used[d] = 1;
+            g_fs.dir_next[d] = 0;
+            snprintf(g_fs.dir_path[d], sizeof(g_fs.dir_path[d]), "%s", path);
+            g_fs.dirs_open++;
+            return d;
+        }
+    }
+    return -1;
+}
+
+static int sim_dir_read(void *handle, int dir, RotDirEntry *entry)
+{
+    const char *prefix = g_fs.dir_path[dir];
+    size_t len = strlen(prefix);
+    /* A device root ("ux0:") lists its entries without a separator */
+    size_t sep = prefix[len - 1] == ':' ? 0 : 1;
+
+    (void)handle;
+    while (g_fs.dir_next[dir] < g_fs.count)
+    {
+        const SimEntry *e = &g_fs.entry[g_fs.dir_next[dir]++];
+        const char *name = e->path + len + sep;
+
+        if (strncmp(e->path, prefix, len) == 0 && (sep == 0 || e->path[len] == '/') &&
+            name[0] != '\0' && strchr(name, '/') == NULL)
+        {
+            snprintf(entry->name, sizeof(entry->name), "%s", name);
+            entry->is_dir = e->is_dir;
+            entry->size = e->size;
+            entry->mtime = e->mtime;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void sim_dir_close(void *handle, int dir)
+{
+    (void)handle;
+    g_fs.dir_used[dir] = 0;
+    g_fs.dirs_open--;
+}
+
+static int sim_open_read(void *handle, const char *path)
+{
+    (void)handle;
+    int i = sim_find(path);
+    return i >= 0 && !g_fs.entry[i].is_dir ? i : -1;
+}
+
+static int sim_read_at(void *handle, int fd, uint8_t *buf, uint32_t len, uint64_t offset)
+{
+    const SimEntry *e = &g_fs.entry[fd];
+
+    (void)handle;
+    if (e->unreadable ||
+        (offset < e->bad_offset + e->bad_len && e->bad_offset < offset + len))
+    {
+        return -1;
+    }
+    if (offset < e->slow_offset + e->slow_len && e->slow_offset < offset + len)
+    {
+        g_fs.clock += 5000000;
+    }
+    if (offset >= e->size)
+    {
+        return 0;
+    }
+    uint32_t n = e->size - (uint32_t)offset < len ? e->size - (uint32_t)offset : len;
+    memcpy(buf, e->data + offset, n);
+    return (int)n;
+}
+
+static void sim_close(void *handle, int fd)
+{
+    (void)handle;
+    (void)fd;
+}
+
+static int sim_write_file(void *handle, const char *path, const uint8_t *buf, uint32_t len)
+{
+    (void)handle;
+    sim_file(path, 0, 0, 0);
+
+    SimEntry *e = &g_fs.entry[sim_find(path)];
+    free(e->data);
+    e->data = malloc(len > 0 ? len : 1);
+    memcpy(e->data, buf, len);
+    e->size = len;
+    return (int)len;
+}
+
+static int sim_rename(void *handle, const char *from, const char *to)
+{
+    (void)handle;
+    int i = sim_find(from);
+    if (i < 0 || sim_find(to) >= 0)
+    {
+        return -1;
+    }
+    snprintf(g_fs.entry[i].path, sizeof(g_fs.entry[i].path), "%s", to);
+    return 0;
+}
+
+static uint64_t sim_now(void *handle)
+{
+    (void)handle;
+    g_fs.clock += 1000;
+    return g_fs.clock;
+}
+
+static const RotScanDevice g_dev = {sim_dir_open,   sim_dir_read, sim_dir_close, sim_open_read,
+                                    sim_read_at,    sim_close,    sim_write_file, sim_rename,
+                                    sim_remove,     sim_now,      NULL};
+
+#define MANIFEST "ux0:data/f3vita/digests_app.f3m"
+
+/**
+ * Helper: empty file system with the card root and test directory
+ */
+static void sim_init(void)
+{
+    sim_reset();
+    sim_dir("ux0:app");
+    sim_dir("ux0:data");
+    sim_dir("ux0:data/f3vita");
+}
+
+/**
+ * Helper: a game install with nested directories and files of every size class
+ */
+static void sim_game(void)
+{
+    sim_dir("ux0:app/PCSE00001");
+    sim_dir("ux0:app/PCSE00001/sce_sys");
+    sim_file("ux0:app/PCSE00001/eboot.bin", 2 * F3V_BLOCK_SIZE + 12345, 1, 100);
+    sim_file("ux0:app/PCSE00001/sce_sys/param.sfo", 1000, 2, 100);
+    sim_file("ux0:app/PCSE00001/sce_sys/icon0.png", F3V_BLOCK_SIZE, 3, 100);
+    sim_file("ux0:app/PCSE00001/empty.dat", 0, 4, 100);
+    sim_file("ux0:app/readme.txt", 70000, 5, 100);
+}
+
+/**
+ * Helper: run a scan to the end
+ * @return 0 when done, negative on error or if it does not finish
+ */
+static int run_scan(const char *root, const char *exclude)
+{
+    int ret = -1;
+
+    if (f3v_rotscan_init(&g_state, root, exclude, MANIFEST) < 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        ret = f3v_rotscan_step(&g_state, &g_dev);
+        if (ret <= 0)
+        {
+            break;
+        }
+    }
+    f3v_rotscan_free(&g_state, &g_dev);
+    return ret;
+}
+
+/**
+ * Helper: run a surface scan of ux0:app to the end
+ * @return 0 when done, negative on error or if it does not finish
+ */
+static int run_surface(void)
+{
+    int ret = -1;
+
+    if (f3v_rotscan_init_surface(&g_state, "ux0:app", "") < 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        ret = f3v_rotscan_step(&g_state, &g_dev);
+        if (ret <= 0)
+        {
+            break;
+        }
+    }
+    f3v_rotscan_free(&g_state, &g_dev);
+    return ret;
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * DG001: Hash Reference Values
+ * The hash matches published XXH64 outputs
+ */
+static int test_hash_vectors(void)
+{
+    static uint8_t data[1000];
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)((i * 7 + 3) & 0xFF);
+    }
+
+    TEST_ASSERT(f3v_hash64("", 0, 0) == 0xEF46DB3751D8E999ULL, "Empty input");
+    TEST_ASSERT(f3v_hash64("abc", 3, 0) == 0x44BC2CF5AD770999ULL, "Short input");
+    TEST_ASSERT(f3v_hash64(data, sizeof(data), 0x1234) == 0x606A85EAE0CDBB41ULL,
+                "Long input with a seed");
+
+    return 1;
+}
+
+/**
+ * DG002: Streaming Hash
+ * Data added in uneven pieces hashes the same as in one call
+ */
+static int test_hash_streaming(void)
+{
+    static uint8_t data[4096];
+    static const size_t pieces[] = {1, 7, 31, 32, 33, 37, 100, 4096};
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i ^ (i >> 5));
+    }
+
+    for (uint32_t p = 0; p < sizeof(pieces) / sizeof(pieces[0]); p++)
+    {
+        F3vHash64 hash;
+
+        f3v_hash64_init(&hash, 99);
+        for (size_t off = 0; off < sizeof(data); off += pieces[p])
+        {
+            size_t len = sizeof(data) - off < pieces[p] ? sizeof(data) - off : pieces[p];
+            f3v_hash64_update(&hash, data + off, len);
+        }
+        TEST_ASSERT(f3v_hash64_final(&hash) == f3v_hash64(data, sizeof(data), 99),
+                    "Pieces hash like one call");
+    }
+
+    return 1;
+}
+
+/**
+ * DG003: Tree Digest
+ * A file digest is the hash of its leaf digests; any change alters it
+ */
+static int test_tree_digest(void)
+{
+    uint32_t size = 2 * F3V_BLOCK_SIZE + 100;
+    uint8_t *data = malloc(size);
+    uint64_t leaf[3];
+    F3vHash64 hash;
+
+    TEST_ASSERT(data != NULL, "Allocate file");
+    for (uint32_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(i * 13);
+    }
+
+    /* Same as hashing every leaf in order by hand */
+    f3v_digest_begin(&hash, size);
+    for (uint32_t off = 0; off < size; off += F3V_DIGEST_LEAF)
+    {
+        uint32_t len = size - off < F3V_DIGEST_LEAF ? size - off : F3V_DIGEST_LEAF;
+        uint64_t digest = f3v_hash64(data + off, len, off / F3V_DIGEST_LEAF);
+        f3v_digest_add(&hash, &digest, 1);
+    }
+    uint64_t digest = f3v_digest_buffer(data, size);
+    TEST_ASSERT(f3v_hash64_final(&hash) == digest, "Digest of the leaf digests");
+
+    /* The last block's leaves are numbered from where the block starts */
+    TEST_ASSERT_EQ(f3v_digest_leaves(data + 2 * F3V_BLOCK_SIZE, 100, 2 * F3V_DIGEST_LEAVES, leaf),
+                   1, "One short leaf");
+    TEST_ASSERT(leaf[0] == f3v_hash64(data + 2 * F3V_BLOCK_SIZE, 100, 2 * F3V_DIGEST_LEAVES),
+                "Leaf seeded with its number");
+
+    /* One flipped bit, swapped leaves or a different length all change it */
+    data[F3V_BLOCK_SIZE + 5] ^= 0x01;
+    TEST_ASSERT(f3v_digest_buffer(data, size) != digest, "Flipped bit");
+    data[F3V_BLOCK_SIZE + 5] ^= 0x01;
+    TEST_ASSERT(f3v_digest_buffer(data, size - 1) != digest, "Shorter file");
+    memset(data, 0, 2 * F3V_DIGEST_LEAF);
+    TEST_ASSERT(f3v_digest_buffer(data, 2 * F3V_DIGEST_LEAF) !=
+                    f3v_hash64(data, 2 * F3V_DIGEST_LEAF, 0),
+                "Not a flat hash");
+    uint64_t a = f3v_digest_buffer(data, F3V_DIGEST_LEAF);
+    uint64_t b = f3v_digest_buffer(data + F3V_DIGEST_LEAF, F3V_DIGEST_LEAF);
+    TEST_ASSERT(a == b, "Identical single-leaf files match");
+
+    free(data);
+    return 1;
+}
+
+/**
+ * RS001: First Scan
+ * Every file is found, hashed and recorded; the test directory is skipped
+ */
+static int test_rotscan_first(void)
+{
+    sim_init();
+    sim_game();
+    sim_file("ux0:data/f3vita/f3vita_001.dat", 5000, 9, 100);
+    sim_dir("ux0:data/game");
+    sim_file("ux0:data/game/save.bin", 3000, 10, 100);
+
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Scan finishes");
+    const RotScanResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->manifest, 0, "No earlier manifest");
+    TEST_ASSERT_EQ(result->files, 5, "Files found");
+    TEST_ASSERT_EQ(result->bytes, 3 * F3V_BLOCK_SIZE + 12345 + 1000 + 70000, "Bytes found");
+    TEST_ASSERT_EQ(result->added, 5, "All files new");
+    TEST_ASSERT_EQ(result->matched + result->mismatched + result->changed, 0, "Nothing compared");
+    TEST_ASSERT_EQ(g_state.hashed, result->bytes, "Every byte hashed");
+    TEST_ASSERT(result->saved, "Manifest saved");
+    TEST_ASSERT(sim_find(MANIFEST) >= 0, "Manifest on the card");
+    TEST_ASSERT(sim_find(MANIFEST ".new") < 0, "Temporary file renamed");
+    TEST_ASSERT_EQ(g_fs.dirs_open, 0, "Directories closed");
+
+    /* Whole card: the test directory and its manifest are not scanned */
+    sim_remove(NULL, MANIFEST);
+    sim_dir("ux0:");
+    TEST_ASSERT_EQ(run_scan("ux0:", "ux0:data/f3vita"), 0, "Card scan finishes");
+    TEST_ASSERT_EQ(g_state.result.files, 6, "Game files and the save, not the test file");
+
+    return 1;
+}
+
+/**
+ * RS002: Clean Rescan
+ * An untouched tree matches the manifest file for file
+ */
+static int test_rotscan_clean(void)
+{
+    sim_init();
+    sim_game();
+
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "First scan");
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Second scan");
+
+    const RotScanResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->manifest, 1, "Manifest loaded");
+    TEST_ASSERT_EQ(result->matched, 5, "All files match");
+    TEST_ASSERT_EQ(result->mismatched + result->unreadable, 0, "No bad files");
+    TEST_ASSERT_EQ(result->added + result->changed + result->missing, 0, "Nothing changed");
+    TEST_ASSERT_EQ(result->bad_bytes, 0, "No bad bytes");
+    TEST_ASSERT(result->hash_usec > 0, "Hashing timed");
+
+    return 1;
+}
+
+/**
+ * RS003: Rot and Changes
+ * A silent change is reported and keeps being reported; real changes,
+ * new and missing files are only counted
+ */
+static int test_rotscan_rot(void)
+{
+    sim_init();
+    sim_game();
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "First scan");
+
+    /* Same size and time, one bit different: rot */
+    g_fs.entry[sim_find("ux0:app/PCSE00001/eboot.bin")].data[F3V_BLOCK_SIZE + 77] ^= 0x04;
+    /* Rewritten with a new time */
+    sim_file("ux0:app/PCSE00001/sce_sys/param.sfo", 1000, 20, 200);
+    sim_file("ux0:app/PCSE00001/new.bin", 500, 21, 200);
+    sim_drop(sim_find("ux0:app/readme.txt"));
+
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Second scan");
+    const RotScanResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->matched, 2, "Untouched files match");
+    TEST_ASSERT_EQ(result->mismatched, 1, "Rotten file found");
+    TEST_ASSERT_EQ(result->changed, 1, "Rewritten file");
+    TEST_ASSERT_EQ(result->added, 1, "New file");
+    TEST_ASSERT_EQ(result->missing, 1, "Deleted file");
+    TEST_ASSERT_EQ(result->bad_count, 1, "One file listed");
+    TEST_ASSERT(strcmp(result->bad[0].path, "PCSE00001/eboot.bin") == 0, "Listed by path");
+    TEST_ASSERT_EQ(result->bad[0].kind, ROT_BAD_MISMATCH, "Listed as mismatch");
+    TEST_ASSERT_EQ(result->bad_bytes, 2 * F3V_BLOCK_SIZE + 12345, "Bad bytes");
+
+    /* The manifest keeps the good digest, so the rot is not absorbed */
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Third scan");
+    TEST_ASSERT_EQ(result->mismatched, 1, "Still rotten");
+    TEST_ASSERT_EQ(result->matched, 4, "Changed and new files now match");
+    TEST_ASSERT_EQ(result->missing + result->added + result->changed, 0, "Nothing else");
+
+    /* Rewriting it (new time) accepts the new contents */
+    g_fs.entry[sim_find("ux0:app/PCSE00001/eboot.bin")].mtime = 300;
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Fourth scan");
+    TEST_ASSERT_EQ(result->changed, 1, "Rewritten");
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Fifth scan");
+    TEST_ASSERT_EQ(result->matched, 5, "Clean again");
+
+    return 1;
+}
+
+/**
+ * RS004: Damaged Manifest
+ * A manifest that fails its check is ignored and replaced
+ */
+static int test_rotscan_manifest(void)
+{
+    sim_init();
+    sim_game();
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "First scan");
+
+    SimEntry *manifest = &g_fs.entry[sim_find(MANIFEST)];
+    TEST_ASSERT(manifest->size < 5 * 40 + 24, "Compact manifest");
+    manifest->data[manifest->size / 2] ^= 0x20;
+
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Scan with a damaged manifest");
+    TEST_ASSERT_EQ(g_state.result.manifest, -1, "Reported damaged");
+    TEST_ASSERT_EQ(g_state.result.added, 5, "Everything recorded again");
+    TEST_ASSERT(g_state.result.saved, "Replaced");
+
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Scan with the new manifest");
+    TEST_ASSERT_EQ(g_state.result.manifest, 1, "Loaded");
+    TEST_ASSERT_EQ(g_state.result.matched, 5, "All match");
+
+    /* A truncated one is no better */
+    manifest = &g_fs.entry[sim_find(MANIFEST)];
+    manifest->size -= 9;
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Scan with a truncated manifest");
+    TEST_ASSERT_EQ(g_state.result.manifest, -1, "Truncation detected");
+
+    return 1;
+}
+
+/**
+ * RS005: Failures and Cancel
+ * Unreadable files are listed, a missing root stops the scan, and a
+ * cancelled scan leaves the manifest alone
+ */
+static int test_rotscan_failures(void)
+{
+    sim_init();
+    sim_game();
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "First scan");
+
+    /* A checked file that cannot be read stays in the manifest */
+    g_fs.entry[sim_find("ux0:app/PCSE00001/sce_sys/icon0.png")].unreadable = 1;
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Scan with an unreadable file");
+    TEST_ASSERT_EQ(g_state.result.unreadable, 1, "Counted");
+    TEST_ASSERT_EQ(g_state.result.matched, 4, "Others match");
+    TEST_ASSERT_EQ(g_state.result.bad[0].kind, ROT_BAD_UNREADABLE, "Listed as unreadable");
+    TEST_ASSERT_EQ(g_state.result.bad_bytes, F3V_BLOCK_SIZE, "Its size is bad");
+
+    g_fs.entry[sim_find("ux0:app/PCSE00001/sce_sys/icon0.png")].unreadable = 0;
+    TEST_ASSERT_EQ(run_scan("ux0:app", ""), 0, "Scan once readable again");
+    TEST_ASSERT_EQ(g_state.result.matched, 5, "Matches its old digest");
+
+    TEST_ASSERT(run_scan("ux0:nothere", "") < 0, "Missing root");
+    TEST_ASSERT_EQ(g_fs.dirs_open, 0, "No directory left open");
+
+    /* Stopped mid-hash: the manifest is the previous one */
+    SimEntry *manifest = &g_fs.entry[sim_find(MANIFEST)];
+    uint64_t before = f3v_hash64(manifest->data, manifest->size, 0);
+    sim_file("ux0:app/later.bin", 100, 30, 400);
+    TEST_ASSERT_EQ(f3v_rotscan_init(&g_state, "ux0:app", "", MANIFEST), 0, "Init");
+    while (g_state.stage != ROTSCAN_HASH)
+    {
+        TEST_ASSERT_EQ(f3v_rotscan_step(&g_state, &g_dev), 1, "Walking");
+    }
+    TEST_ASSERT_EQ(f3v_rotscan_step(&g_state, &g_dev), 1, "One block hashed");
+    f3v_rotscan_free(&g_state, &g_dev);
+    manifest = &g_fs.entry[sim_find(MANIFEST)];
+    TEST_ASSERT(f3v_hash64(manifest->data, manifest->size, 0) == before, "Manifest unchanged");
+    TEST_ASSERT(sim_find(MANIFEST ".new") < 0, "Nothing half-written");
+
+    return 1;
+}
+
+/**
+ * SS001: Surface Scan Reads Everything
+ * Every byte is read in large reads and timed; nothing is written
+ */
+static int test_surface_read(void)
+{
+    sim_init();
+    sim_game();
+    sim_file("ux0:app/big.bin", 10 * F3V_BLOCK_SIZE + 5, 6, 100);
+
+    TEST_ASSERT_EQ(run_surface(), 0, "Scan finishes");
+    const RotScanResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->files, 6, "Files found");
+    TEST_ASSERT_EQ(g_state.hashed, result->bytes, "Every byte read");
+    TEST_ASSERT_EQ(g_state.lat.total, 7, "Large reads: 3 for the big file, 1 per other file");
+    TEST_ASSERT_EQ(result->lat_max_us, 1000, "Reads timed");
+    TEST_ASSERT(result->read_kbs > 0, "Throughput");
+    TEST_ASSERT_EQ(result->error_regions + result->slow_regions + result->bad_count, 0,
+                   "Nothing bad");
+    TEST_ASSERT_EQ(result->added + result->matched + result->manifest, 0, "No digests");
+    TEST_ASSERT(!result->saved && sim_find(MANIFEST) < 0, "Nothing written");
+    TEST_ASSERT_EQ(g_fs.dirs_open, 0, "Directories closed");
+
+    return 1;
+}
+
+/**
+ * SS002: Unreadable Regions
+ * A failed read is narrowed to the blocks that fail and the file is read on
+ */
+static int test_surface_errors(void)
+{
+    sim_init();
+    sim_game();
+    sim_file("ux0:app/big.bin", 10 * F3V_BLOCK_SIZE + 5, 6, 100);
+    SimEntry *big = &g_fs.entry[sim_find("ux0:app/big.bin")];
+    big->bad_offset = 5 * F3V_BLOCK_SIZE + 10;
+    big->bad_len = F3V_BLOCK_SIZE + 10;
+    g_fs.entry[sim_find("ux0:app/PCSE00001/eboot.bin")].unreadable = 1;
+
+    TEST_ASSERT_EQ(run_surface(), 0, "Scan finishes");
+    const RotScanResult *result = &g_state.result;
+    uint64_t eboot = 2 * F3V_BLOCK_SIZE + 12345;
+    TEST_ASSERT_EQ(result->unreadable, 2, "Files with errors");
+    TEST_ASSERT_EQ(result->error_regions, 2, "One region each");
+    TEST_ASSERT_EQ(result->error_bytes, eboot + 2 * F3V_BLOCK_SIZE, "Unreadable bytes");
+    TEST_ASSERT_EQ(result->bad_bytes, result->error_bytes, "Counted as bad");
+    TEST_ASSERT_EQ(g_state.hashed, result->bytes - result->error_bytes, "The rest read");
+
+    TEST_ASSERT_EQ(result->bad_count, 2, "Both listed");
+    TEST_ASSERT(strcmp(result->bad[0].path, "PCSE00001/eboot.bin") == 0, "Path order");
+    TEST_ASSERT_EQ(result->bad[0].offset, 0, "Whole file");
+    TEST_ASSERT_EQ(result->bad[0].length, eboot, "Whole file length");
+    TEST_ASSERT(strcmp(result->bad[1].path, "big.bin") == 0, "Big file");
+    TEST_ASSERT_EQ(result->bad[1].kind, ROT_BAD_UNREADABLE, "Unreadable");
+    TEST_ASSERT_EQ(result->bad[1].offset, 5 * F3V_BLOCK_SIZE, "Starts at the first bad block");
+    TEST_ASSERT_EQ(result->bad[1].length, 2 * F3V_BLOCK_SIZE, "Two blocks, merged");
+
+    return 1;
+}
+
+/**
+ * SS003: Slow Regions and List Limit
+ * Slow reads merge into regions with their slowest speed; regions past
+ * the list are still counted
+ */
+static int test_surface_slow(void)
+{
+    char path[64];
+
+    sim_init();
+    sim_game();
+    sim_file("ux0:app/big.bin", 10 * F3V_BLOCK_SIZE + 5, 6, 100);
+    SimEntry *big = &g_fs.entry[sim_find("ux0:app/big.bin")];
+    big->slow_offset = F3V_BLOCK_SIZE;
+    big->slow_len = 4 * F3V_BLOCK_SIZE;
+
+    TEST_ASSERT_EQ(run_surface(), 0, "Scan finishes");
+    const RotScanResult *result = &g_state.result;
+    TEST_ASSERT_EQ(result->slow_regions, 1, "One slow region");
+    TEST_ASSERT_EQ(result->slow_bytes, 8 * F3V_BLOCK_SIZE, "Two reads");
+    TEST_ASSERT_EQ(result->bad[0].kind, ROT_BAD_SLOW, "Listed as slow");
+    TEST_ASSERT_EQ(result->bad[0].length, 8 * F3V_BLOCK_SIZE, "Merged");
+    TEST_ASSERT(result->bad[0].min_kbs > 0 && result->bad[0].min_kbs < 1024, "Slowest speed");
+    TEST_ASSERT_EQ(result->bad_bytes, 0, "Slow is not bad");
+    TEST_ASSERT(result->lat_max_us >= 5000000, "Slowest read");
+    TEST_ASSERT(result->lat_p50_us < 5000000, "Median read fast");
+
+    for (uint32_t i = 0; i < F3V_ROTSCAN_BAD + 2; i++)
+    {
+        snprintf(path, sizeof(path), "ux0:app/f%02u.bin", i);
+        sim_file(path, 100, i, 100);
+        g_fs.entry[sim_find(path)].unreadable = 1;
+    }
+    TEST_ASSERT_EQ(run_surface(), 0, "Scan with many bad files");
+    TEST_ASSERT_EQ(result->error_regions, F3V_ROTSCAN_BAD + 2, "All counted");
+    TEST_ASSERT_EQ(result->bad_count, F3V_ROTSCAN_BAD, "List full");
+    TEST_ASSERT_EQ(result->bad_lost, 3, "Past the list (two files and the slow region)");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Digest and Bit-Rot Scan Tests ===\n\n");
+
+    if (f3v_pool_init(F3V_POOL_THREADS) < 0)
+    {
+        printf("Failed to start the pool\n");
+        return 1;
+    }
+
+    printf("--- f3v_hash64() / f3v_digest_*() Tests ---\n");
+    RUN_TEST(test_hash_vectors);
+    RUN_TEST(test_hash_streaming);
+    RUN_TEST(test_tree_digest);
+
+    printf("\n--- f3v_rotscan_step() Tests ---\n");
+    RUN_TEST(test_rotscan_first);
+    RUN_TEST(test_rotscan_clean);
+    RUN_TEST(test_rotscan_rot);
+    RUN_TEST(test_rotscan_manifest);
+    RUN_TEST(test_rotscan_failures);
+
+    printf("\n--- f3v_rotscan_init_surface() Tests ---\n");
+    RUN_TEST(test_surface_read);
+    RUN_TEST(test_surface_errors);
+    RUN_TEST(test_surface_slow);
+
+    f3v_pool_shutdown();
+    sim_init();
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
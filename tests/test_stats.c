@@ -0,0 +1,257 @@
+/**
+ * @file test_stats.c
+ * @brief Unit tests for f3vita sampling statistics
+ *
+ * Desktop-runnable tests for the Wilson bound used by sampling mode and the
+ * latency histogram used by the benchmark.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_stats test_stats.c ../src/stats.c -lm
+ * Run: ./test_stats
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "stats.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_NEAR(actual, expected, tol, msg)              \
+    do                                                            \
+    {                                                             \
+        if (fabs((actual) - (expected)) > (tol))                  \
+        {                                                         \
+            printf("  FAIL: %s (expected %.6f, got %.6f)\n", msg, \
+                   (double)(expected), (double)(actual));         \
+            g_tests_failed++;                                     \
+            return 0;                                             \
+        }                                                         \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * ST001: No Samples
+ * Without samples nothing is known: the bound is 100%
+ */
+static int test_wilson_no_samples(void)
+{
+    TEST_ASSERT_NEAR(f3v_wilson_upper(0, 0, F3V_Z_95), 1.0, 1e-12,
+                     "Bound with no samples should be 1.0");
+
+    return 1;
+}
+
+/**
+ * ST002: Zero Failures
+ * With no failures the bound is z^2 / (n + z^2)
+ */
+static int test_wilson_zero_failures(void)
+{
+    double z2 = F3V_Z_95 * F3V_Z_95;
+
+    TEST_ASSERT_NEAR(f3v_wilson_upper(0, 1000, F3V_Z_95), z2 / (1000 + z2), 1e-9,
+                     "Zero-failure bound should match closed form");
+
+    return 1;
+}
+
+/**
+ * ST003: Known Value
+ * 10 failures in 100 samples at z = 1.96 gives an upper bound of ~17.44%
+ */
+static int test_wilson_known_value(void)
+{
+    TEST_ASSERT_NEAR(f3v_wilson_upper(10, 100, 1.96), 0.17436, 1e-4,
+                     "Bound should match the published Wilson interval");
+
+    return 1;
+}
+
+/**
+ * ST004: Bound Ordering
+ * The bound lies above the observed fraction, shrinks with more samples
+ * and never exceeds 1
+ */
+static int test_wilson_ordering(void)
+{
+    double small = f3v_wilson_upper(5, 100, F3V_Z_95);
+    double large = f3v_wilson_upper(50, 1000, F3V_Z_95);
+
+    TEST_ASSERT(small > 0.05, "Bound should exceed the observed fraction");
+    TEST_ASSERT(large < small, "More samples should tighten the bound");
+    TEST_ASSERT(f3v_wilson_upper(100, 100, F3V_Z_99) <= 1.0, "Bound should not exceed 1");
+    TEST_ASSERT(f3v_wilson_upper(0, 100, F3V_Z_99) > f3v_wilson_upper(0, 100, F3V_Z_95),
+                "Higher confidence should widen the bound");
+
+    return 1;
+}
+
+/**
+ * ST005: Samples Needed
+ * The returned count is the smallest that reaches the target
+ */
+static int test_samples_needed(void)
+{
+    uint64_t n = f3v_wilson_samples_needed(0.01, F3V_Z_95);
+
+    TEST_ASSERT(f3v_wilson_upper(0, n, F3V_Z_95) <= 0.01, "n samples should reach the target");
+    TEST_ASSERT(f3v_wilson_upper(0, n - 1, F3V_Z_95) > 0.01, "n - 1 samples should not");
+    TEST_ASSERT(n > 250 && n < 300, "About 268 samples expected for 1% at 95%");
+
+    return 1;
+}
+
+/* Shared histograms (too large for the test functions' stacks on small hosts) */
+static LatencyHist g_hist;
+static LatencyHist g_hist2;
+
+/**
+ * ST006: Histogram Exact Small Values
+ * Latencies below F3V_HIST_SUB are kept exactly
+ */
+static int test_hist_exact(void)
+{
+    memset(&g_hist, 0, sizeof(g_hist));
+    for (uint32_t i = 1; i <= 10; i++)
+    {
+        f3v_hist_add(&g_hist, i);
+    }
+
+    TEST_ASSERT(g_hist.total == 10, "Ten values should be counted");
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 0.5) == 5, "Median of 1..10 should be 5");
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 0.9) == 9, "p90 of 1..10 should be 9");
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 1.0) == 10, "p100 should be the maximum");
+
+    return 1;
+}
+
+/**
+ * ST007: Histogram Relative Error
+ * Large latencies are reported within one sub-bucket (6.25%) above the
+ * true value, and never above the maximum
+ */
+static int test_hist_precision(void)
+{
+    static const uint32_t values[] = {17, 100, 999, 4321, 65537, 1000000, 300000000};
+
+    for (uint32_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        memset(&g_hist, 0, sizeof(g_hist));
+        f3v_hist_add(&g_hist, values[i]);
+        f3v_hist_add(&g_hist, values[i] * 2);
+
+        uint32_t p = f3v_hist_percentile(&g_hist, 0.5);
+        TEST_ASSERT(p >= values[i], "Percentile should not be below the value");
+        TEST_ASSERT((double)p <= values[i] * (1.0 + 1.0 / F3V_HIST_SUB),
+                    "Percentile should be within one sub-bucket");
+    }
+
+    memset(&g_hist, 0, sizeof(g_hist));
+    f3v_hist_add(&g_hist, 1000);
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 0.5) == 1000, "Single value capped at the maximum");
+
+    return 1;
+}
+
+/**
+ * ST008: Histogram Tail and Merge
+ * One slow outlier in 1000 shows at p99.9 but not at p99, also after
+ * merging per-thread histograms
+ */
+static int test_hist_tail_merge(void)
+{
+    memset(&g_hist, 0, sizeof(g_hist));
+    memset(&g_hist2, 0, sizeof(g_hist2));
+    for (uint32_t i = 0; i < 999; i++)
+    {
+        f3v_hist_add(i % 2 ? &g_hist : &g_hist2, 200);
+    }
+    f3v_hist_add(&g_hist2, 50000);
+    f3v_hist_merge(&g_hist, &g_hist2);
+
+    TEST_ASSERT(g_hist.total == 1000, "Merged count should be 1000");
+    TEST_ASSERT(g_hist.max_usec == 50000, "Merged maximum should be the outlier");
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 0.99) < 220, "p99 should be near 200 us");
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 0.999) < 220, "p99.9 is the 999th value");
+    TEST_ASSERT(f3v_hist_percentile(&g_hist, 0.9995) == 50000, "Outlier should be the tail");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Stats Module Tests ===\n\n");
+
+    printf("--- f3v_wilson_upper() Tests ---\n");
+    RUN_TEST(test_wilson_no_samples);
+    RUN_TEST(test_wilson_zero_failures);
+    RUN_TEST(test_wilson_known_value);
+    RUN_TEST(test_wilson_ordering);
+
+    printf("\n--- f3v_wilson_samples_needed() Tests ---\n");
+    RUN_TEST(test_samples_needed);
+
+    printf("\n--- Latency Histogram Tests ---\n");
+    RUN_TEST(test_hist_exact);
+    RUN_TEST(test_hist_precision);
+    RUN_TEST(test_hist_tail_merge);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+/**
+ * @file test_throttle.c
+ * @brief Unit tests for the f3vita I/O rate limiter
+ *
+ * Desktop-runnable tests; time is passed in, so no clock or sleep is needed.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -o test_throttle test_throttle.c ../src/throttle.c
+ * Run: ./test_throttle
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "throttle.h"
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                 \
+    do                                                        \
+    {                                                         \
+        if ((actual) != (expected))                           \
+        {                                                     \
+            printf("  FAIL: %s (expected %u, got %u)\n", msg, \
+                   (unsigned)(expected), (unsigned)(actual)); \
+            g_tests_failed++;                                 \
+            return 0;                                         \
+        }                                                     \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+#define MB (1024 * 1024)
+#define SEC 1000000ULL
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * Transfer 1 MB blocks at blocks_per_sec, without waiting for the bucket
+ * @return Time after the last block
+ */
+static uint64_t feed(IoThrottle *t, uint64_t from, uint32_t blocks, uint32_t blocks_per_sec)
+{
+    uint64_t now = from;
+
+    for (uint32_t i = 0; i < blocks; i++)
+    {
+        f3v_throttle_take(t, MB, now);
+        now += SEC / blocks_per_sec;
+    }
+    return now;
+}
+
+/**
+ * TH001: Bucket and Debt
+ * The burst goes through at once; past it each transfer waits for its tokens
+ */
+static int test_throttle_bucket(void)
+{
+    IoThrottle t;
+
+    f3v_throttle_setup(&t, 0, 4, 0);
+    TEST_ASSERT_EQ(t.rate_bps, 0, "Rate 0 disables the limiter");
+
+    f3v_throttle_setup(&t, 10, 4, 1000);
+    TEST_ASSERT_EQ(f3v_throttle_take(&t, 4 * MB, 1000), 0, "Burst needs no wait");
+    TEST_ASSERT_EQ(f3v_throttle_take(&t, MB, 1000), SEC / 10, "1 MB at 10 MB/s");
+    TEST_ASSERT_EQ(f3v_throttle_take(&t, MB, 1000 + SEC / 10), SEC / 10,
+                   "Refill pays the last debt only");
+
+    /* A long pause refills no more than the burst */
+    TEST_ASSERT_EQ(f3v_throttle_take(&t, 4 * MB, 1000 + 60 * SEC), 0, "Full bucket after a pause");
+    TEST_ASSERT_EQ(f3v_throttle_take(&t, MB, 1000 + 60 * SEC), SEC / 10, "But no more");
+
+    return 1;
+}
+
+/**
+ * TH002: Windows at and below the Target
+ * Each window is judged over its own length once it has passed
+ */
+static int test_throttle_windows(void)
+{
+    IoThrottle t;
+    uint64_t now;
+
+    f3v_throttle_setup(&t, 10, 4, 0);
+    now = feed(&t, 0, 30, 10);
+    TEST_ASSERT_EQ(t.windows, 2, "Windows judged once over");
+    TEST_ASSERT_EQ(t.windows_missed, 0, "Target rate met");
+    TEST_ASSERT_EQ(t.window_start, 2 * SEC, "Windows one second apart");
+
+    /* Half the rate for two seconds */
+    now = feed(&t, now, 10, 5);
+    f3v_throttle_take(&t, MB, now);
+    TEST_ASSERT_EQ(t.windows, 5, "Windows judged");
+    TEST_ASSERT_EQ(t.windows_missed, 2, "Slow windows missed");
+
+    /* Under 95% */
+    f3v_throttle_setup(&t, 20, 4, 0);
+    feed(&t, 0, 18, 18);
+    f3v_throttle_take(&t, MB, SEC);
+    TEST_ASSERT_EQ(t.windows, 1, "Window judged");
+    TEST_ASSERT_EQ(t.windows_missed, 1, "18 of 20 MB misses");
+
+    return 1;
+}
+
+/**
+ * TH003: Idle Gap Longer Than a Window
+ * Windows stay on the grid; the idle ones and the one the gap ends in are
+ * not judged
+ */
+static int test_throttle_idle_gap(void)
+{
+    IoThrottle t;
+    uint64_t now;
+
+    f3v_throttle_setup(&t, 10, 4, 0);
+    feed(&t, 0, 10, 10);
+
+    /* Nothing from 0.9 s to 4.5 s */
+    now = 4 * SEC + SEC / 2;
+    f3v_throttle_take(&t, MB, now);
+    TEST_ASSERT_EQ(t.windows, 1, "Only the busy window judged");
+    TEST_ASSERT_EQ(t.windows_missed, 0, "Busy window met the target");
+    TEST_ASSERT_EQ(t.window_start, 4 * SEC, "Window advanced by whole windows");
+    TEST_ASSERT(t.window_partial, "Window the gap ends in began idle");
+
+    /* Full rate again: the half-idle window is not held against the card */
+    now = feed(&t, now + SEC / 10, 24, 10);
+    TEST_ASSERT_EQ(t.windows, 2, "Half-idle window not judged, next one is");
+    TEST_ASSERT_EQ(t.windows_missed, 0, "No window missed");
+    TEST_ASSERT_EQ(t.window_start, 6 * SEC, "Still on the grid");
+
+    /* A short pause inside a window is the card's problem */
+    now = feed(&t, now + SEC / 2, 5, 10);
+    f3v_throttle_take(&t, MB, now);
+    TEST_ASSERT(!t.window_partial, "Short pause does not discard the window");
+    TEST_ASSERT_EQ(t.windows_missed, 1, "Window with a pause missed");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Throttle Module Tests ===\n");
+    printf("Window: %d us, target %d%%\n\n", F3V_THROTTLE_WINDOW_USEC, F3V_THROTTLE_TARGET_PCT);
+
+    printf("--- f3v_throttle_take() Tests ---\n");
+    RUN_TEST(test_throttle_bucket);
+    RUN_TEST(test_throttle_windows);
+    RUN_TEST(test_throttle_idle_gap);
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
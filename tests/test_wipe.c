@@ -0,0 +1,289 @@
+/**
+ * @file test_wipe.c
+ * @brief Unit tests for f3vita wipe kernels and transfer size tuning
+ *
+ * Desktop-runnable tests for the wipe fill kernels, their verification and
+ * the transfer size tuner.
+ * Compile: gcc -Wall -Wextra -std=c99 -I../include -pthread -o test_wipe test_wipe.c ../src/wipe.c ../src/pool.c ../src/thread.c ../src/profile.c ../src/pattern.c
+ * Run: ./test_wipe
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "wipe.h"
+#include "pool.h"
+
+static uint8_t g_buf1[F3V_WIPE_MAX_BLOCKS * F3V_BLOCK_SIZE];
+static uint8_t g_buf2[F3V_BLOCK_SIZE];
+
+/*
+ * Test Statistics
+ */
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+/*
+ * Test Assertion Macros
+ */
+#define TEST_ASSERT(cond, msg)           \
+    do                                   \
+    {                                    \
+        if (!(cond))                     \
+        {                                \
+            printf("  FAIL: %s\n", msg); \
+            g_tests_failed++;            \
+            return 0;                    \
+        }                                \
+    } while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, msg)                      \
+    do                                                             \
+    {                                                              \
+        if ((actual) != (expected))                                \
+        {                                                          \
+            printf("  FAIL: %s (expected %llu, got %llu)\n", msg,  \
+                   (unsigned long long)(expected),                 \
+                   (unsigned long long)(actual));                  \
+            g_tests_failed++;                                      \
+            return 0;                                              \
+        }                                                          \
+    } while (0)
+
+/*
+ * Test Runner Macros
+ */
+#define RUN_TEST(test_func)                    \
+    do                                         \
+    {                                          \
+        printf("Running: %s... ", #test_func); \
+        g_tests_run++;                         \
+        if (test_func())                       \
+        {                                      \
+            printf("PASS\n");                  \
+            g_tests_passed++;                  \
+        }                                      \
+    } while (0)
+
+/* Fake clock: every reading is 1000 us after the previous one */
+static uint64_t g_clock;
+
+static uint64_t fake_now(void)
+{
+    g_clock += 1000;
+    return g_clock;
+}
+
+/**
+ * Helper: feed the tuner one size's worth of transfers at a speed
+ * @param kbs Speed of the transfers in KB/s
+ */
+static void tune_at(WipeTuner *tuner, uint32_t kbs)
+{
+    uint32_t bytes = f3v_wipe_tune_blocks(tuner) * F3V_BLOCK_SIZE;
+
+    for (uint64_t done = 0; done < F3V_WIPE_TUNE_BYTES; done += bytes)
+    {
+        f3v_wipe_tune_add(tuner, bytes, (uint64_t)bytes / 1024 * 1000000 / kbs);
+    }
+}
+
+/*
+ * =============================================================================
+ * Test Cases
+ * =============================================================================
+ */
+
+/**
+ * WP001: Tuning Order and Choice
+ * Sizes are tried smallest first and the fastest is kept
+ */
+static int test_tune_fastest(void)
+{
+    static const uint32_t kbs[F3V_WIPE_SIZES] = {10000, 14000, 20000, 19000};
+    WipeTuner tuner;
+
+    f3v_wipe_tune_init(&tuner);
+    for (uint32_t i = 0; i < F3V_WIPE_SIZES; i++)
+    {
+        TEST_ASSERT_EQ(f3v_wipe_tune_blocks(&tuner), 1U << i, "Sizes tried in turn");
+        tune_at(&tuner, kbs[i]);
+        TEST_ASSERT(f3v_wipe_tune_kbs(&tuner, i) >= kbs[i] - 1 &&
+                        f3v_wipe_tune_kbs(&tuner, i) <= kbs[i],
+                    "Measured speed");
+    }
+
+    TEST_ASSERT_EQ(tuner.size, F3V_WIPE_SIZES, "Tuning done");
+    TEST_ASSERT_EQ(f3v_wipe_tune_blocks(&tuner), 4, "Fastest size kept");
+
+    /* Later transfers do not change the choice */
+    f3v_wipe_tune_add(&tuner, F3V_BLOCK_SIZE, 1);
+    TEST_ASSERT_EQ(f3v_wipe_tune_blocks(&tuner), 4, "Choice stays");
+
+    return 1;
+}
+
+/**
+ * WP002: Small Gains Keep the Smaller Size
+ * A larger transfer has to beat the smaller one by the tuning margin
+ */
+static int test_tune_gain(void)
+{
+    WipeTuner tuner;
+
+    f3v_wipe_tune_init(&tuner);
+    tune_at(&tuner, 20000);
+    tune_at(&tuner, 20000 * (100 + F3V_WIPE_TUNE_GAIN_PCT - 1) / 100);
+    tune_at(&tuner, 19000);
+    tune_at(&tuner, 20000 * (100 + F3V_WIPE_TUNE_GAIN_PCT + 1) / 100);
+    TEST_ASSERT_EQ(f3v_wipe_tune_blocks(&tuner), 8, "Clear gain wins");
+
+    f3v_wipe_tune_init(&tuner);
+    tune_at(&tuner, 20000);
+    tune_at(&tuner, 20000 * (100 + F3V_WIPE_TUNE_GAIN_PCT - 1) / 100);
+    tune_at(&tuner, 20000);
+    tune_at(&tuner, 20000);
+    TEST_ASSERT_EQ(f3v_wipe_tune_blocks(&tuner), 1, "Small gain loses");
+    TEST_ASSERT_EQ(f3v_wipe_tune_kbs(&tuner, F3V_WIPE_SIZES), 0, "Out of range size");
+
+    return 1;
+}
+
+/**
+ * WP003: Kernels Agree
+ * Inline and pool kernels write the same data, and it verifies with either
+ */
+static int test_kernels_agree(void)
+{
+    for (WipeFill fill = WIPE_ZEROS; fill < WIPE_FILL_COUNT; fill++)
+    {
+        f3v_wipe_fill(g_buf1, fill, WIPE_KERNEL_INLINE, 99, 7, 40);
+        memset(g_buf2, 0xA5, F3V_BLOCK_SIZE);
+        f3v_wipe_fill(g_buf2, fill, WIPE_KERNEL_POOL, 99, 7, 40);
+
+        TEST_ASSERT(memcmp(g_buf1, g_buf2, F3V_BLOCK_SIZE) == 0, "Same data from both kernels");
+        for (WipeKernel k = WIPE_KERNEL_ONCE; k < WIPE_KERNEL_COUNT; k++)
+        {
+            TEST_ASSERT_EQ(f3v_wipe_verify(g_buf1, fill, k, 99, 7, 40, F3V_BLOCK_SIZE, NULL), 0,
+                           "Verifies with every kernel");
+        }
+    }
+
+    /* Noise is its own data; the pattern fill is the normal test pattern */
+    f3v_wipe_fill(g_buf1, WIPE_RANDOM, WIPE_KERNEL_INLINE, 99, 7, 40);
+    TEST_ASSERT(f3v_wipe_verify(g_buf1, WIPE_RANDOM, WIPE_KERNEL_POOL, 98, 7, 40, F3V_BLOCK_SIZE,
+                                NULL) > 0,
+                "Noise is tied to the seed");
+    f3v_wipe_fill(g_buf2, WIPE_PATTERN, WIPE_KERNEL_POOL, 99, 7, 40);
+    TEST_ASSERT(memcmp(g_buf1, g_buf2, 4096) != 0, "Pattern differs from the noise");
+
+    return 1;
+}
+
+/**
+ * WP004: Verify Counts and Short Blocks
+ * Mismatches are counted with the first offset, and a short last block
+ * is only checked as far as it goes
+ */
+static int test_verify(void)
+{
+    uint32_t first = 0;
+
+    for (WipeFill fill = WIPE_ZEROS; fill < WIPE_FILL_COUNT; fill++)
+    {
+        f3v_wipe_fill(g_buf1, fill, WIPE_KERNEL_INLINE, 5, 1, 2);
+        g_buf1[4100] ^= 0xFF;
+        g_buf1[900000] ^= 0x01;
+
+        first = 0;
+        TEST_ASSERT_EQ(f3v_wipe_verify(g_buf1, fill, WIPE_KERNEL_POOL, 5, 1, 2, F3V_BLOCK_SIZE,
+                                       &first),
+                       2, "Both bytes counted (pool)");
+        TEST_ASSERT_EQ(first, 4100, "First error offset (pool)");
+
+        first = 0;
+        TEST_ASSERT_EQ(f3v_wipe_verify(g_buf1, fill, WIPE_KERNEL_INLINE, 5, 1, 2, F3V_BLOCK_SIZE,
+                                       &first),
+                       2, "Both bytes counted (inline)");
+        TEST_ASSERT_EQ(first, 4100, "First error offset (inline)");
+
+        TEST_ASSERT_EQ(f3v_wipe_verify(g_buf1, fill, WIPE_KERNEL_POOL, 5, 1, 2, 500000, NULL), 1,
+                       "Short block checked up to its length");
+    }
+
+    return 1;
+}
+
+/**
+ * WP005: Kernel Choice
+ * Zeros are written once; other fills time both per-block kernels
+ */
+static int test_pick_kernel(void)
+{
+    uint32_t kbs[WIPE_KERNEL_COUNT] = {0};
+
+    memset(g_buf1, 0x5A, sizeof(g_buf1));
+    TEST_ASSERT_EQ(f3v_wipe_pick_kernel(WIPE_ZEROS, g_buf1, 1, fake_now, kbs), WIPE_KERNEL_ONCE,
+                   "Zeros filled once");
+    for (uint32_t i = 0; i < F3V_WIPE_MAX_BLOCKS; i++)
+    {
+        TEST_ASSERT_EQ(f3v_wipe_verify(g_buf1 + (size_t)i * F3V_BLOCK_SIZE, WIPE_ZEROS,
+                                       WIPE_KERNEL_ONCE, 1, 1, i, F3V_BLOCK_SIZE, NULL),
+                       0, "Whole buffer zeroed");
+    }
+    TEST_ASSERT_EQ(kbs[WIPE_KERNEL_INLINE], 0, "Nothing timed for zeros");
+
+    /* The fake clock makes both kernels equally fast: the tie stays inline */
+    TEST_ASSERT_EQ(f3v_wipe_pick_kernel(WIPE_RANDOM, g_buf1, 1, fake_now, kbs),
+                   WIPE_KERNEL_INLINE, "Tie goes to the writing thread");
+    TEST_ASSERT_EQ(kbs[WIPE_KERNEL_INLINE],
+                   F3V_WIPE_CALIBRATE_BLOCKS * (F3V_BLOCK_SIZE / 1024) * 1000, "Inline speed");
+    TEST_ASSERT_EQ(kbs[WIPE_KERNEL_POOL], kbs[WIPE_KERNEL_INLINE], "Pool speed");
+    TEST_ASSERT_EQ(strcmp(f3v_wipe_kernel_name(WIPE_KERNEL_POOL), "pool"), 0, "Kernel name");
+    TEST_ASSERT_EQ(strcmp(f3v_wipe_fill_name(WIPE_RANDOM), "Random"), 0, "Fill name");
+
+    return 1;
+}
+
+/*
+ * =============================================================================
+ * Main Test Runner
+ * =============================================================================
+ */
+
+int main(void)
+{
+    printf("\n=== f3vita Wipe Tests ===\n\n");
+
+    if (f3v_pool_init(F3V_POOL_THREADS) < 0)
+    {
+        printf("Failed to start the pool\n");
+        return 1;
+    }
+
+    printf("--- f3v_wipe_tune_*() Tests ---\n");
+    RUN_TEST(test_tune_fastest);
+    RUN_TEST(test_tune_gain);
+
+    printf("\n--- Fill Kernel Tests ---\n");
+    RUN_TEST(test_kernels_agree);
+    RUN_TEST(test_verify);
+    RUN_TEST(test_pick_kernel);
+
+    f3v_pool_shutdown();
+
+    /* Summary */
+    printf("\n=== Results: %d/%d passed ===\n", g_tests_passed, g_tests_run);
+
+    if (g_tests_failed > 0)
+    {
+        printf("FAILED: %d test(s)\n", g_tests_failed);
+        return 1;
+    }
+
+    printf("All tests passed!\n");
+    return 0;
+}
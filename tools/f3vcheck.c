@@ -0,0 +1,596 @@
+/**
+ * @file f3vcheck.c
+ * @brief Host-side verifier for f3vita test files
+ *
+ * Re-verifies f3vita_NNN.dat files copied off a card (or a raw image of a
+ * single test file) on a desktop machine, using the same pattern module
+ * as the Vita app.
+ *
+ * Two read paths are available:
+ *   - buffered: read() into a 1 MB buffer, the same path the Vita uses
+ *   - mmap:     map the file in large windows and run the verify kernel
+ *               directly on the mapping, split across worker threads
+ *
+ * It can also measure how the stripe-parallel pattern pool (pool.c) scales
+ * from 1 to N threads on the host (-S).
+ *
+ * Build: make
+ * Usage: ./f3vcheck [-m buffered|mmap] [-w window_mb] [-t threads] [-i file_idx] [-b] <file|dir>...
+ *        ./f3vcheck -S mb [-t threads]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pattern.h"
+#include "pool.h"
+
+#define DEFAULT_WINDOW_MB 256
+#define MAX_THREADS       64
+
+/* Read path selection */
+typedef enum {
+    MODE_BUFFERED,
+    MODE_MMAP
+} VerifyMode;
+
+/* Verification result for one file (or one worker's share of a window) */
+typedef struct {
+    uint64_t bytes_verified;
+    uint64_t bytes_corrupted;
+    int has_first_error;
+    uint64_t first_error_pos;   /* Absolute file offset */
+} VerifyResult;
+
+/* Work item for one mmap worker thread */
+typedef struct {
+    const uint8_t *base;        /* Start of mapped window */
+    uint64_t window_pos;        /* File offset of base */
+    uint64_t start;             /* Byte range within window (block aligned) */
+    uint64_t end;
+    uint32_t file_idx;
+    VerifyResult result;
+} StripeJob;
+
+/* Command-line options */
+static VerifyMode g_mode = MODE_BUFFERED;
+static uint64_t g_window_bytes = (uint64_t)DEFAULT_WINDOW_MB * 1024 * 1024;
+static int g_threads = 0;
+static long g_forced_index = -1;
+static int g_bench = 0;
+static uint32_t g_scaling_mb = 0;
+
+/* Peak resident set size seen during the current run */
+static uint64_t g_peak_rss = 0;
+
+/**
+ * Get monotonic time in microseconds
+ */
+static uint64_t now_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/**
+ * Sample current RSS from /proc and track the peak (0 if unavailable)
+ */
+static void sample_rss(void)
+{
+    FILE *f = fopen("/proc/self/statm", "r");
+    unsigned long size = 0, resident = 0;
+
+    if (f == NULL)
+        return;
+
+    if (fscanf(f, "%lu %lu", &size, &resident) == 2)
+    {
+        uint64_t rss = (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+        if (rss > g_peak_rss)
+            g_peak_rss = rss;
+    }
+    fclose(f);
+}
+
+/**
+ * Merge a partial result into an accumulated one
+ *
+ * The earliest first-error offset wins, so merging is independent of the
+ * order in which workers finish.
+ */
+static void merge_result(VerifyResult *into, const VerifyResult *from)
+{
+    into->bytes_verified += from->bytes_verified;
+    into->bytes_corrupted += from->bytes_corrupted;
+
+    if (from->has_first_error &&
+        (!into->has_first_error || from->first_error_pos < into->first_error_pos))
+    {
+        into->has_first_error = 1;
+        into->first_error_pos = from->first_error_pos;
+    }
+}
+
+/**
+ * Verify consecutive blocks of an in-memory region
+ * @param data Region start (file offset pos)
+ * @param pos File offset of data (must be block aligned)
+ * @param len Region length
+ */
+static void verify_region(const uint8_t *data, uint64_t pos, uint64_t len,
+                          uint32_t file_idx, VerifyResult *res)
+{
+    uint64_t done = 0;
+
+    while (done < len)
+    {
+        uint64_t abs = pos + done;
+        uint32_t block_idx = (uint32_t)(abs / F3V_BLOCK_SIZE);
+        uint32_t chunk = F3V_BLOCK_SIZE;
+        uint32_t first = 0;
+
+        if (len - done < chunk)
+            chunk = (uint32_t)(len - done);
+
+        uint32_t bad = f3v_verify_pattern_range(data + done, file_idx, block_idx,
+                                                0, chunk, &first);
+        if (bad > 0)
+        {
+            res->bytes_corrupted += bad;
+            if (!res->has_first_error)
+            {
+                res->has_first_error = 1;
+                res->first_error_pos = (uint64_t)block_idx * F3V_BLOCK_SIZE + first;
+            }
+        }
+
+        res->bytes_verified += chunk;
+        done += chunk;
+    }
+}
+
+/**
+ * Buffered path: read() into a block buffer, then verify
+ */
+static int verify_buffered(int fd, uint32_t file_idx, VerifyResult *res)
+{
+    uint8_t *buf = NULL;
+    uint64_t pos = 0;
+    uint32_t blocks = 0;
+
+    if (posix_memalign((void **)&buf, 64, F3V_BLOCK_SIZE) != 0)
+        return -1;
+
+    for (;;)
+    {
+        /* Fill a whole block unless EOF (read() may return short) */
+        size_t got = 0;
+        while (got < F3V_BLOCK_SIZE)
+        {
+            ssize_t n = read(fd, buf + got, F3V_BLOCK_SIZE - got);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                free(buf);
+                return -1;
+            }
+            if (n == 0)
+                break;
+            got += (size_t)n;
+        }
+
+        if (got == 0)
+            break;
+
+        verify_region(buf, pos, got, file_idx, res);
+        pos += got;
+
+        if ((++blocks & 63) == 0)
+            sample_rss();
+    }
+
+    sample_rss();
+    free(buf);
+    return 0;
+}
+
+/**
+ * mmap worker: verify its block-aligned share of the current window
+ */
+static void *stripe_worker(void *arg)
+{
+    StripeJob *job = (StripeJob *)arg;
+
+    verify_region(job->base + job->start, job->window_pos + job->start,
+                  job->end - job->start, job->file_idx, &job->result);
+    return NULL;
+}
+
+/**
+ * mmap path: map large windows and split each one across threads
+ */
+static int verify_mmap(int fd, uint64_t size, uint32_t file_idx, VerifyResult *res)
+{
+    pthread_t threads[MAX_THREADS];
+    int started[MAX_THREADS];
+    StripeJob jobs[MAX_THREADS];
+
+    for (uint64_t pos = 0; pos < size; pos += g_window_bytes)
+    {
+        uint64_t len = size - pos;
+        if (len > g_window_bytes)
+            len = g_window_bytes;
+
+        uint8_t *map = mmap(NULL, (size_t)len, PROT_READ, MAP_SHARED, fd, (off_t)pos);
+        if (map == MAP_FAILED)
+            return -1;
+
+        madvise(map, (size_t)len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        madvise(map, (size_t)len, MADV_HUGEPAGE); /* Best effort; ignored by most filesystems */
+#endif
+
+        /* Hand each thread a contiguous run of whole blocks */
+        uint64_t blocks = (len + F3V_BLOCK_SIZE - 1) / F3V_BLOCK_SIZE;
+        int nthreads = g_threads;
+        if ((uint64_t)nthreads > blocks)
+            nthreads = (int)blocks;
+
+        uint64_t per = blocks / (uint64_t)nthreads;
+        uint64_t extra = blocks % (uint64_t)nthreads;
+        uint64_t cursor = 0;
+
+        for (int t = 0; t < nthreads; t++)
+        {
+            uint64_t count = per + ((uint64_t)t < extra ? 1 : 0);
+
+            memset(&jobs[t], 0, sizeof(jobs[t]));
+            jobs[t].base = map;
+            jobs[t].window_pos = pos;
+            jobs[t].file_idx = file_idx;
+            jobs[t].start = cursor * F3V_BLOCK_SIZE;
+            jobs[t].end = (cursor + count) * F3V_BLOCK_SIZE;
+            if (jobs[t].end > len)
+                jobs[t].end = len;
+            cursor += count;
+
+            /* A share whose thread did not start is run inline below */
+            started[t] = t > 0 &&
+                         pthread_create(&threads[t], NULL, stripe_worker, &jobs[t]) == 0;
+        }
+
+        /* The calling thread takes the first share */
+        stripe_worker(&jobs[0]);
+
+        for (int t = 1; t < nthreads; t++)
+        {
+            if (started[t])
+                pthread_join(threads[t], NULL);
+            else
+                stripe_worker(&jobs[t]);
+        }
+
+        /* Merge in stripe order so results are deterministic */
+        for (int t = 0; t < nthreads; t++)
+            merge_result(res, &jobs[t].result);
+
+        sample_rss();
+        munmap(map, (size_t)len);
+    }
+
+    return 0;
+}
+
+/**
+ * Derive the file index from an f3vita_NNN.dat name
+ * @return Index, or -1 if the name does not match
+ */
+static long parse_file_index(const char *path)
+{
+    const char *name = strrchr(path, '/');
+    unsigned int idx = 0;
+    char ext[8];
+
+    name = name ? name + 1 : path;
+
+    if (strncmp(name, F3V_FILE_PREFIX, strlen(F3V_FILE_PREFIX)) != 0)
+        return -1;
+    if (sscanf(name + strlen(F3V_FILE_PREFIX), "%u%7s", &idx, ext) != 2)
+        return -1;
+    if (strcmp(ext, F3V_FILE_EXT) != 0)
+        return -1;
+
+    return (long)idx;
+}
+
+/**
+ * Verify one file with the selected mode and print a summary line
+ * @return 0 if clean, 1 if corrupted, -1 on error
+ */
+static int verify_file(const char *path, VerifyMode mode, uint64_t *total_bytes)
+{
+    long idx = (g_forced_index >= 0) ? g_forced_index : parse_file_index(path);
+    VerifyResult res;
+    struct stat st;
+    int ret;
+
+    if (idx < 0)
+    {
+        fprintf(stderr, "%s: not an %sNNN%s file (use -i to set the index)\n",
+                path, F3V_FILE_PREFIX, F3V_FILE_EXT);
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    /* Start cold so the two paths are compared fairly */
+    if (g_bench)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    memset(&res, 0, sizeof(res));
+
+    if (mode == MODE_MMAP)
+    {
+        ret = verify_mmap(fd, (uint64_t)st.st_size, (uint32_t)idx, &res);
+    }
+    else
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        ret = verify_buffered(fd, (uint32_t)idx, &res);
+    }
+    close(fd);
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "%s: read failed: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    *total_bytes += res.bytes_verified;
+
+    printf("%s: %llu MB verified, %llu bytes corrupted", path,
+           (unsigned long long)(res.bytes_verified / (1024 * 1024)),
+           (unsigned long long)res.bytes_corrupted);
+    if (res.has_first_error)
+    {
+        printf(" (first error: block %llu, offset %llu)",
+               (unsigned long long)(res.first_error_pos / F3V_BLOCK_SIZE),
+               (unsigned long long)(res.first_error_pos % F3V_BLOCK_SIZE));
+    }
+    printf("\n");
+
+    return res.bytes_corrupted > 0 ? 1 : 0;
+}
+
+/**
+ * Verify every f3vita test file in a directory, in index order
+ */
+static int verify_dir(const char *dir, VerifyMode mode, uint64_t *total_bytes)
+{
+    char path[4096];
+    int worst = 0;
+
+    /* Walk indices in order; test files are numbered contiguously from 1 */
+    for (unsigned int i = 1;; i++)
+    {
+        struct stat st;
+
+        snprintf(path, sizeof(path), "%s/%s%03u%s", dir, F3V_FILE_PREFIX, i, F3V_FILE_EXT);
+        if (stat(path, &st) < 0)
+        {
+            if (i == 1)
+                fprintf(stderr, "%s: no test files found\n", dir);
+            break;
+        }
+
+        int ret = verify_file(path, mode, total_bytes);
+        if (ret != 0 && worst >= 0)
+            worst = ret;
+    }
+
+    return worst;
+}
+
+/**
+ * Verify all command-line paths with one mode and report throughput
+ */
+static int run_mode(VerifyMode mode, char **paths, int count)
+{
+    uint64_t total = 0;
+    int worst = 0;
+
+    g_peak_rss = 0;
+    uint64_t start = now_usec();
+
+    for (int i = 0; i < count; i++)
+    {
+        struct stat st;
+        int ret;
+
+        if (stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode))
+            ret = verify_dir(paths[i], mode, &total);
+        else
+            ret = verify_file(paths[i], mode, &total);
+
+        if (ret != 0 && worst >= 0)
+            worst = ret;
+    }
+
+    uint64_t elapsed = now_usec() - start;
+    double mbps = elapsed ? ((double)total / (1024.0 * 1024.0)) / ((double)elapsed / 1e6) : 0.0;
+
+    printf("[%s] %llu MB in %.2f s = %.1f MB/s, peak RSS %llu MB",
+           mode == MODE_MMAP ? "mmap" : "buffered",
+           (unsigned long long)(total / (1024 * 1024)), (double)elapsed / 1e6, mbps,
+           (unsigned long long)(g_peak_rss / (1024 * 1024)));
+    if (mode == MODE_MMAP)
+        printf(", %d thread(s), %llu MB window", g_threads,
+               (unsigned long long)(g_window_bytes / (1024 * 1024)));
+    printf("\n");
+
+    return worst;
+}
+
+/**
+ * Pool scaling benchmark: fill and verify in memory at 1..N threads
+ */
+static int run_scaling(void)
+{
+    uint8_t *buf = NULL;
+    double base_fill = 0.0, base_verify = 0.0;
+    int max_threads = g_threads < F3V_POOL_MAX_THREADS ? g_threads : F3V_POOL_MAX_THREADS;
+
+    if (posix_memalign((void **)&buf, 64, F3V_BLOCK_SIZE) != 0)
+        return 2;
+
+    printf("Pool scaling: %u MB per pass, %d KB stripes\n", g_scaling_mb, F3V_STRIPE_SIZE / 1024);
+    printf("threads   fill MB/s  verify MB/s  speedup\n");
+
+    for (int t = 1; t <= max_threads; t++)
+    {
+        if (f3v_pool_init(t) < 0)
+            break;
+
+        uint64_t start = now_usec();
+        for (uint32_t b = 0; b < g_scaling_mb; b++)
+            f3v_pool_fill(buf, 1, b);
+        uint64_t fill_us = now_usec() - start;
+
+        /* Verify one block repeatedly so only the kernel is measured */
+        f3v_pool_fill(buf, 1, 0);
+        start = now_usec();
+        for (uint32_t b = 0; b < g_scaling_mb; b++)
+            f3v_pool_verify(buf, 1, 0, NULL);
+        uint64_t verify_us = now_usec() - start;
+
+        int used = f3v_pool_threads();
+        f3v_pool_shutdown();
+
+        double fill = fill_us ? g_scaling_mb / ((double)fill_us / 1e6) : 0.0;
+        double verify = verify_us ? g_scaling_mb / ((double)verify_us / 1e6) : 0.0;
+        if (t == 1)
+        {
+            base_fill = fill;
+            base_verify = verify;
+        }
+
+        printf("%7d  %10.1f  %11.1f  %.2fx / %.2fx\n", used,
+               fill, verify, base_fill > 0 ? fill / base_fill : 0.0,
+               base_verify > 0 ? verify / base_verify : 0.0);
+    }
+
+    free(buf);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <file|dir>...\n"
+            "  -m buffered|mmap  Read path (default: buffered)\n"
+            "  -w MB             mmap window size (default: %d)\n"
+            "  -t N              mmap worker threads (default: online CPUs)\n"
+            "  -i N              File index for files not named %sNNN%s\n"
+            "  -b                Benchmark: run both paths, compare MB/s and RSS\n"
+            "  -S MB             Pool scaling: fill/verify MB in memory at 1..-t threads\n",
+            prog, DEFAULT_WINDOW_MB, F3V_FILE_PREFIX, F3V_FILE_EXT);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:w:t:i:bS:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            if (strcmp(optarg, "mmap") == 0)
+                g_mode = MODE_MMAP;
+            else if (strcmp(optarg, "buffered") == 0)
+                g_mode = MODE_BUFFERED;
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'w':
+            g_window_bytes = (uint64_t)strtoul(optarg, NULL, 10) * 1024 * 1024;
+            break;
+        case 't':
+            g_threads = atoi(optarg);
+            break;
+        case 'i':
+            g_forced_index = strtol(optarg, NULL, 10);
+            break;
+        case 'b':
+            g_bench = 1;
+            break;
+        case 'S':
+            g_scaling_mb = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind >= argc && g_scaling_mb == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* Windows must stay block aligned so every block is mapped whole */
+    if (g_window_bytes < F3V_BLOCK_SIZE)
+        g_window_bytes = F3V_BLOCK_SIZE;
+    g_window_bytes -= g_window_bytes % F3V_BLOCK_SIZE;
+
+    if (g_threads <= 0)
+        g_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (g_threads <= 0)
+        g_threads = 1;
+    if (g_threads > MAX_THREADS)
+        g_threads = MAX_THREADS;
+
+    if (g_scaling_mb > 0)
+    {
+        return run_scaling();
+    }
+
+    int ret;
+    if (g_bench)
+    {
+        run_mode(MODE_BUFFERED, argv + optind, argc - optind);
+        ret = run_mode(MODE_MMAP, argv + optind, argc - optind);
+    }
+    else
+    {
+        ret = run_mode(g_mode, argv + optind, argc - optind);
+    }
+
+    /* Exit codes: 0 = clean, 1 = corruption found, 2 = usage or I/O error */
+    return ret < 0 ? 2 : ret;
+}